@@ -0,0 +1,373 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Startup benchmark - cold model preparation vs the compiled cache
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *
+ *   Usage: bench_cache <dir-or-model.mdl>... [--iterations N]
+ *
+ *   Times the startup work that --cache saves, three ways:
+ *
+ *     cold   load the model, then decode, weld and reorder every mesh of
+ *            every submodel and expand every skin to RGBA, the same as the
+ *            renderer and mdl_load_textures() do without a cache
+ *     build  load with the cache on and an empty cache directory, which
+ *            does the cold work once and writes the cache file
+ *     hit    load with a warm cache and copy every mesh and skin out of the
+ *            mapping, which is all that is left for the renderer to do
+ *
+ *   The cache directory is a fresh temporary one. An untimed cold and hit
+ *   pass then hash everything they produced, and the run fails if the cache
+ *   does not hand back exactly the meshes and pixels the cold path computes.
+ */
+
+#include "bench_util.h"
+#include "mdl/mdl_cache.h"
+#include "mdl/mdl_loader.h"
+#include "mdl/mdl_mesh.h"
+#include "mdl/mdl_palette.h"
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum { PASS_COLD, PASS_BUILD, PASS_HIT } pass_t;
+
+// Timed passes only fold a byte of each result into g_sink; the verify passes hash everything
+static bool              g_verify;
+static volatile uint64_t g_sink;
+
+static uint64_t hash_u32( uint64_t hash, uint32_t value )
+{
+    for ( int i = 0; i < 4; ++i )
+    {
+        hash ^= ( value >> ( i * 8 ) ) & 0xFF;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Field by field: the vertex struct has padding that malloc'd and mapped copies need not agree on
+static uint64_t hash_mesh( uint64_t hash, const mdl_tricmd_vertex_t *vertices, int num_vertices, const unsigned int *indices, int num_indices )
+{
+    if ( !g_verify )
+    {
+        g_sink += ( uint64_t ) vertices[num_vertices - 1].vertex + indices[num_indices - 1];
+        return hash;
+    }
+
+    for ( int i = 0; i < num_vertices; ++i )
+    {
+        const mdl_tricmd_vertex_t *v = &vertices[i];
+        hash = hash_u32( hash, ( uint32_t ) ( uint16_t ) v->vertex | ( uint32_t ) ( uint16_t ) v->normal << 16 );
+        hash = hash_u32( hash, ( uint32_t ) ( uint16_t ) v->s | ( uint32_t ) ( uint16_t ) v->t << 16 );
+        hash = hash_u32( hash, v->seam );
+    }
+    for ( int i = 0; i < num_indices; ++i )
+    {
+        hash = hash_u32( hash, indices[i] );
+    }
+    return hash;
+}
+
+static uint64_t hash_rgba( uint64_t hash, const unsigned char *rgba, size_t pixels )
+{
+    if ( !g_verify )
+    {
+        g_sink += rgba[pixels * 4 - 1];
+        return hash;
+    }
+
+    for ( size_t i = 0; i < pixels; ++i )
+    {
+        uint32_t word;
+        memcpy( &word, &rgba[i * 4], 4 );
+        hash = hash_u32( hash, word );
+    }
+    return hash;
+}
+
+// What the renderer does for one mesh without a cache
+static uint64_t cold_mesh( uint64_t hash, const unsigned char *data, const mstudiomodel_t *sub, const mstudiomesh_t *mesh )
+{
+    const int max = mdl_count_tricmd_corners( data, mesh );
+    if ( max <= 0 )
+        return hash;
+
+    mdl_tricmd_vertex_t *corners = malloc( ( size_t ) max * sizeof( *corners ) );
+    mdl_tricmd_vertex_t *unique  = malloc( ( size_t ) max * sizeof( *unique ) );
+    unsigned int        *indices = malloc( ( size_t ) max * sizeof( *indices ) );
+
+    if ( corners && unique && indices )
+    {
+        int count  = mdl_decode_tricmds( data, mesh, sub->numverts, sub->numnorms, corners, max );
+        int welded = mdl_weld_tricmd_vertices( corners, count, unique, indices );
+
+        if ( welded > 0 )
+        {
+            mdl_vcache_stats_t stats;
+
+            mdl_analyze_vertex_cache( indices, count, welded, MDL_VCACHE_SIZE, &stats );
+            if ( mdl_optimize_vertex_cache( indices, count, welded, MDL_VCACHE_SIZE ) )
+            {
+                mdl_optimize_vertex_fetch( unique, welded, indices, count );
+            }
+            mdl_analyze_vertex_cache( indices, count, welded, MDL_VCACHE_SIZE, &stats );
+
+            hash = hash_mesh( hash, unique, welded, indices, count );
+        }
+    }
+
+    free( corners );
+    free( unique );
+    free( indices );
+    return hash;
+}
+
+// Copy out of the mapping, standing in for the renderer's arena copy
+static uint64_t cached_mesh( uint64_t hash, const mdl_model_t *model, const mstudiomodel_t *sub, const mstudiomesh_t *mesh )
+{
+    mdl_cached_mesh_t cached;
+    if ( !model->cache || !mdl_cache_mesh( model->cache, model->data, mesh, sub->numverts, sub->numnorms, &cached )
+         || cached.num_vertices <= 0 )
+        return hash;
+
+    mdl_tricmd_vertex_t *vertices = malloc( ( size_t ) cached.num_vertices * sizeof( *vertices ) );
+    unsigned int        *indices  = malloc( ( size_t ) cached.num_indices * sizeof( *indices ) );
+
+    if ( vertices && indices )
+    {
+        memcpy( vertices, cached.vertices, ( size_t ) cached.num_vertices * sizeof( *vertices ) );
+        memcpy( indices, cached.indices, ( size_t ) cached.num_indices * sizeof( *indices ) );
+        hash = hash_mesh( hash, vertices, cached.num_vertices, indices, cached.num_indices );
+    }
+
+    free( vertices );
+    free( indices );
+    return hash;
+}
+
+static uint64_t prepare_meshes( uint64_t hash, const mdl_model_t *model, pass_t pass )
+{
+    const studiohdr_t   *header = model->header;
+    const unsigned char *data   = model->data;
+
+    const mstudiobodyparts_t *bodyparts = ( const mstudiobodyparts_t * ) ( data + header->bodypartindex );
+
+    for ( int bp = 0; bp < header->numbodyparts; bp++ )
+    {
+        const mstudiomodel_t *models = ( const mstudiomodel_t * ) ( data + bodyparts[bp].modelindex );
+
+        for ( int m = 0; m < bodyparts[bp].nummodels; m++ )
+        {
+            const mstudiomodel_t *sub    = &models[m];
+            const mstudiomesh_t  *meshes = ( const mstudiomesh_t * ) ( data + sub->meshindex );
+
+            for ( int i = 0; i < sub->nummesh; i++ )
+            {
+                hash = ( pass == PASS_COLD ) ? cold_mesh( hash, data, sub, &meshes[i] )
+                                             : cached_mesh( hash, model, sub, &meshes[i] );
+            }
+        }
+    }
+    return hash;
+}
+
+static uint64_t prepare_textures( uint64_t hash, const mdl_model_t *model, pass_t pass )
+{
+    // Same choice as mdl_pick_texture_header(), which lives with the GL code
+    const studiohdr_t   *header = model->header;
+    const unsigned char *file   = model->data;
+    size_t               size   = model->data_size;
+
+    if ( header->numtextures <= 0 && model->texture_header )
+    {
+        header = model->texture_header;
+        file   = model->texture_data;
+        size   = model->texture_size;
+    }
+
+    const mstudiotexture_t *textures = ( const mstudiotexture_t * ) ( file + header->textureindex );
+
+    for ( int i = 0; i < header->numtextures; i++ )
+    {
+        const mstudiotexture_t *T      = &textures[i];
+        const size_t            pixels = ( size_t ) T->width * ( size_t ) T->height;
+
+        if ( T->width <= 0 || T->height <= 0 || T->index < 0 || ( size_t ) T->index + pixels + 256 * 3 > size )
+            continue;
+
+        unsigned char *rgba = malloc( pixels * 4 );
+        if ( !rgba )
+            continue;
+
+        if ( pass == PASS_COLD )
+        {
+            const unsigned char *indices = file + T->index;
+            const unsigned char *palette = indices + pixels;
+
+            mdl_palette_lut_t lut;
+            mdl_palette_build_lut( palette, 256, false, &lut );
+            mdl_palette_expand_rgba( indices, pixels, &lut, rgba );
+            hash = hash_rgba( hash, rgba, pixels );
+        }
+        else
+        {
+            const unsigned char *cached = model->cache ? mdl_cache_texture_rgba( model->cache, i, T->width, T->height ) : NULL;
+            if ( cached )
+            {
+                memcpy( rgba, cached, pixels * 4 );
+                hash = hash_rgba( hash, rgba, pixels );
+            }
+        }
+
+        free( rgba );
+    }
+    return hash;
+}
+
+static double run_pass( pass_t pass, int iterations, int *prepared, uint64_t *checksum )
+{
+    *prepared = 0;
+    *checksum = 0;
+
+    bench_silence( );
+    double t0 = bench_now_ms( );
+
+    for ( int it = 0; it < iterations; it++ )
+    {
+        for ( int i = 0; i < g_bench_num_files; i++ )
+        {
+            mdl_model_t *model = NULL;
+            if ( create_mdl_model( g_bench_files[i], &model ) != MDL_SUCCESS )
+                continue;
+
+            uint64_t hash = 0xCBF29CE484222325ull;
+            hash          = prepare_meshes( hash, model, pass );
+            hash          = prepare_textures( hash, model, pass );
+
+            // A model that fails to load in one pass only shows up as a mismatch
+            *checksum += hash;
+            ( *prepared )++;
+            free_model( model );
+        }
+    }
+
+    double elapsed = bench_now_ms( ) - t0;
+    bench_restore( );
+    return elapsed;
+}
+
+static void remove_cache_dir( const char *dir )
+{
+    DIR *d = opendir( dir );
+    if ( d )
+    {
+        struct dirent *entry;
+        while ( ( entry = readdir( d ) ) != NULL )
+        {
+            if ( entry->d_name[0] == '.' )
+                continue;
+
+            char path[1024];
+            snprintf( path, sizeof( path ), "%s/%s", dir, entry->d_name );
+            unlink( path );
+        }
+        closedir( d );
+    }
+    rmdir( dir );
+}
+
+int main( int argc, char **argv )
+{
+    int iterations = 5;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--iterations" ) == 0 && i + 1 < argc )
+        {
+            iterations = atoi( argv[++i] );
+            if ( iterations < 1 )
+                iterations = 1;
+        }
+        else
+        {
+            bench_collect( argv[i] );
+        }
+    }
+
+    if ( g_bench_num_files == 0 )
+    {
+        fprintf( stderr, "USAGE: %s <dir-or-model.mdl>... [--iterations N]\n", argv[0] );
+        return 1;
+    }
+
+    char dir[] = "/tmp/bench_cache.XXXXXX";
+    if ( !mkdtemp( dir ) )
+    {
+        fprintf( stderr, "ERROR - Cannot create a temporary cache directory\n" );
+        return 1;
+    }
+
+    mdl_set_load_messages( false );
+
+    printf( "Models: %d, iterations: %d\n\n", g_bench_num_files, iterations );
+    printf( "  %-6s %12s %12s %10s\n", "pass", "total ms", "per model", "models" );
+
+    int      prepared;
+    uint64_t sum_cold, sum_hit;
+
+    // Warm the page cache so the passes do not pay for cold disk reads
+    run_pass( PASS_COLD, 1, &prepared, &sum_cold );
+    double ms_cold = run_pass( PASS_COLD, iterations, &prepared, &sum_cold );
+    printf( "  %-6s %12.2f %12.4f %10d\n", "cold", ms_cold, prepared ? ms_cold / prepared : 0.0, prepared / iterations );
+
+    // A single pass: only the first load of each model builds
+    mdl_cache_set_dir( dir );
+    double ms_build = run_pass( PASS_BUILD, 1, &prepared, &sum_hit );
+    printf( "  %-6s %12.2f %12.4f %10d   (one iteration)\n", "build", ms_build, prepared ? ms_build / prepared : 0.0, prepared );
+
+    double ms_hit = run_pass( PASS_HIT, iterations, &prepared, &sum_hit );
+    printf( "  %-6s %12.2f %12.4f %10d\n", "hit", ms_hit, prepared ? ms_hit / prepared : 0.0, prepared / iterations );
+
+    if ( ms_hit > 0.0 )
+        printf( "\n  warm cache: %.1fx faster than cold\n", ms_cold / ms_hit );
+
+    g_verify = true;
+    run_pass( PASS_HIT, 1, &prepared, &sum_hit );
+    mdl_cache_set_dir( NULL );
+    run_pass( PASS_COLD, 1, &prepared, &sum_cold );
+
+    remove_cache_dir( dir );
+    bench_free_files( );
+
+    if ( sum_hit != sum_cold )
+    {
+        fprintf( stderr, "\nERROR - cached meshes or skins differ from the cold path!\n" );
+        return 1;
+    }
+
+    printf( "  cached meshes and skins match the cold path\n" );
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Crowd benchmark - CPU posing throughput per animated instance
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Usage: bench_crowd <dir-or-model.mdl>... [--instances N] [--frames F] [--threads T]
+ *
+ *   Gives each of N instances its own animation state on a random embedded
+ *   sequence and frame, then per frame advances, poses and packs every
+ *   instance into 3x4 bone rows - the CPU half of a --instances crowd frame.
+ *   Posing is spread over T job system threads like the viewer's (default
+ *   1, 0 = one per core). Reports ms per frame and instances posed per ms.
+ *   The GPU half is timed by the viewer itself: run it with --instances N
+ *   and read the "Crowd:" line it logs every 600 frames and on exit.
+ */
+
+#include "bench_util.h"
+#include "mdl/mdl_animations.h"
+#include "mdl/mdl_loader.h"
+#include "utils/job_system.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Keeps the packed rows observable so the optimizer cannot drop them
+static volatile float g_sink;
+
+typedef struct {
+    mdl_animation_state_t *states;
+    mdl_model_t           *model;
+    float                 *rows;    // MAXSTUDIOBONES * 12 per instance
+} pose_job_t;
+
+// Same row layout as the viewer's palettes (axis remap and 0.1 scale folded in)
+static void pack_rows( const mat4 *bones, int numbones, float *rows )
+{
+    for ( int b = 0; b < numbones; ++b )
+    {
+        float *row = &rows[b * 12];
+        for ( int col = 0; col < 4; ++col )
+        {
+            row[0 + col] = bones[b][col][0] * 0.1f;
+            row[4 + col] = bones[b][col][2] * 0.1f;
+            row[8 + col] = -bones[b][col][1] * 0.1f;
+        }
+    }
+}
+
+static void pose_range( void *arg, int begin, int end )
+{
+    pose_job_t *job = arg;
+    mat4        bones[MAXSTUDIOBONES];
+
+    for ( int i = begin; i < end; ++i )
+    {
+        mdl_animation_calculate_bones( &job->states[i], job->model->header, job->model->data, job->model->seqgroups, bones );
+        pack_rows( ( const mat4 * ) bones, job->model->header->numbones, &job->rows[( size_t ) i * MAXSTUDIOBONES * 12] );
+    }
+}
+
+int main( int argc, char **argv )
+{
+    int count   = 1000;
+    int frames  = 60;
+    int threads = 1;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--instances" ) == 0 && i + 1 < argc )
+        {
+            count = atoi( argv[++i] );
+        }
+        else if ( strcmp( argv[i], "--frames" ) == 0 && i + 1 < argc )
+        {
+            frames = atoi( argv[++i] );
+        }
+        else if ( strcmp( argv[i], "--threads" ) == 0 && i + 1 < argc )
+        {
+            threads = atoi( argv[++i] );
+        }
+        else
+        {
+            bench_collect( argv[i] );
+        }
+    }
+
+    if ( g_bench_num_files == 0 || count <= 0 || frames <= 0 )
+    {
+        fprintf( stderr, "USAGE: %s <dir-or-model.mdl>... [--instances N] [--frames F] [--threads T]\n", argv[0] );
+        return 1;
+    }
+
+    mdl_animation_state_t *states = malloc( ( size_t ) count * sizeof( *states ) );
+    float                 *rows   = malloc( ( size_t ) count * MAXSTUDIOBONES * 12 * sizeof( *rows ) );
+    if ( !states || !rows )
+    {
+        fprintf( stderr, "ERROR - Failed to allocate %d animation states\n", count );
+        free( states );
+        free( rows );
+        return 1;
+    }
+
+    bench_silence( );
+    job_system_init( threads );
+    bench_restore( );
+
+    printf( "Instances: %d, frames: %d, threads: %d\n\n", count, frames, job_system_threads( ) );
+    printf( "  %-28s %5s %5s %10s %12s\n", "model", "bones", "seqs", "ms/frame", "instances/ms" );
+
+    double sum_ms   = 0.0;
+    int    measured = 0;
+
+    for ( int f = 0; f < g_bench_num_files; f++ )
+    {
+        mdl_model_t *model = NULL;
+
+        bench_silence( );
+        mdl_result_t result = create_mdl_model( g_bench_files[f], &model );
+        bench_restore( );
+
+        if ( result != MDL_SUCCESS )
+            continue;
+
+        studiohdr_t      *header    = model->header;
+        mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( model->data + header->seqindex );
+
+        // Embedded, animated sequences only, so nothing waits on a sequence group
+        int *playable     = malloc( ( size_t ) ( header->numseq > 0 ? header->numseq : 1 ) * sizeof( *playable ) );
+        int  num_playable = 0;
+        for ( int s = 0; playable && s < header->numseq; ++s )
+        {
+            if ( sequences[s].seqgroup == 0 && sequences[s].numframes > 1 )
+                playable[num_playable++] = s;
+        }
+
+        if ( num_playable == 0 || header->numbones <= 0 || header->numbones > MAXSTUDIOBONES )
+        {
+            free( playable );
+            bench_silence( );
+            free_model( model );
+            bench_restore( );
+            continue;
+        }
+
+        unsigned int rng = 0x2545F491u;
+
+        bench_silence( );
+        for ( int i = 0; i < count; ++i )
+        {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+
+            int seq = playable[rng % ( unsigned int ) num_playable];
+            mdl_animation_init( &states[i] );
+            mdl_animation_set_sequence( &states[i], seq, header, model->data, model->seqgroups );
+            states[i].current_frame = ( float ) ( rng % ( unsigned int ) sequences[seq].numframes );
+        }
+
+        pose_job_t job = { states, model, rows };
+
+        double t0 = bench_now_ms( );
+        for ( int frame = 0; frame < frames; ++frame )
+        {
+            for ( int i = 0; i < count; ++i )
+            {
+                mdl_animation_update( &states[i], 1.0f / 30.0f, header, model->data, model->seqgroups );
+            }
+
+            // Same grain as lm_crowd_pose()
+            job_parallel_for( "bench pose", count, 16, pose_range, &job );
+            g_sink += rows[3];
+        }
+        double ms = ( bench_now_ms( ) - t0 ) / frames;
+        bench_restore( );
+
+        const char *name = strrchr( g_bench_files[f], '/' );
+        name             = name ? name + 1 : g_bench_files[f];
+        printf( "  %-28.28s %5d %5d %10.3f %12.1f\n", name, header->numbones, num_playable, ms, count / ms );
+
+        sum_ms += ms;
+        measured++;
+
+        free( playable );
+        mdl_anim_cache_clear( );
+        bench_silence( );
+        free_model( model );
+        bench_restore( );
+    }
+
+    if ( measured > 0 )
+    {
+        printf( "\n  %d models: %.3f ms per frame on average (%.1f instances/ms)\n", measured, sum_ms / measured, count / ( sum_ms / measured ) );
+    }
+
+    bench_silence( );
+    job_system_shutdown( );
+    bench_restore( );
+
+    free( states );
+    free( rows );
+    bench_free_files( );
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Startup benchmark - fread vs mmap model loading
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Usage: bench_load <dir-or-model.mdl>... [--iterations N]
+ *
+ *   Loads every model through create_mdl_model()/free_model() once per
+ *   loader mode and reports the wall time. Each pass also touches every
+ *   cache line of the loaded files, the same as a --dump-only sweep would,
+ *   so the mmap numbers include the page faults and are not just the cost
+ *   of creating the mapping.
+ */
+
+#include "bench_util.h"
+#include "mdl/mdl_loader.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t touch( const unsigned char *data, size_t size )
+{
+    uint64_t sum = 0;
+    for ( size_t i = 0; i < size; i += 64 )
+    {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static double run_pass( mdl_load_mode_t mode, int iterations, int *loaded, size_t *bytes, uint64_t *checksum )
+{
+    mdl_set_load_mode( mode );
+
+    *loaded   = 0;
+    *bytes    = 0;
+    *checksum = 0;
+
+    bench_silence( );
+    double t0 = bench_now_ms( );
+
+    for ( int it = 0; it < iterations; it++ )
+    {
+        for ( int i = 0; i < g_bench_num_files; i++ )
+        {
+            mdl_model_t *model = NULL;
+            if ( create_mdl_model( g_bench_files[i], &model ) != MDL_SUCCESS )
+                continue;
+
+            *checksum += touch( model->data, model->data_size );
+            if ( model->texture_data )
+                *checksum += touch( model->texture_data, model->texture_size );
+            for ( int g = 1; g < model->num_seqgroups; g++ )
+            {
+                if ( model->seqgroups[g].data )
+                    *checksum += touch( model->seqgroups[g].data, model->seqgroups[g].size );
+            }
+
+            *bytes += model->data_size + model->texture_size;
+            ( *loaded )++;
+            free_model( model );
+        }
+    }
+
+    double elapsed = bench_now_ms( ) - t0;
+    bench_restore( );
+    return elapsed;
+}
+
+int main( int argc, char **argv )
+{
+    int iterations = 5;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--iterations" ) == 0 && i + 1 < argc )
+        {
+            iterations = atoi( argv[++i] );
+            if ( iterations < 1 )
+                iterations = 1;
+        }
+        else
+        {
+            bench_collect( argv[i] );
+        }
+    }
+
+    if ( g_bench_num_files == 0 )
+    {
+        fprintf( stderr, "USAGE: %s <dir-or-model.mdl>... [--iterations N]\n", argv[0] );
+        return 1;
+    }
+
+    printf( "Models: %d, iterations: %d\n\n", g_bench_num_files, iterations );
+    printf( "  %-6s %12s %12s %10s %12s\n", "mode", "total ms", "per model", "loaded", "MB/s" );
+
+    // Warm the page cache so neither mode pays for cold disk reads
+    int      loaded;
+    size_t   bytes;
+    uint64_t sum_read, sum_mmap;
+    run_pass( MDL_LOAD_MODE_READ, 1, &loaded, &bytes, &sum_read );
+
+    const mdl_load_mode_t modes[2] = { MDL_LOAD_MODE_READ, MDL_LOAD_MODE_MMAP };
+    const char           *names[2] = { "fread", "mmap" };
+
+    for ( int m = 0; m < 2; m++ )
+    {
+        uint64_t *sum = ( m == 0 ) ? &sum_read : &sum_mmap;
+        double    ms  = run_pass( modes[m], iterations, &loaded, &bytes, sum );
+        double    mbs = ( ms > 0.0 ) ? ( ( double ) bytes / ( 1024.0 * 1024.0 ) ) / ( ms / 1000.0 ) : 0.0;
+
+        printf(
+            "  %-6s %12.2f %12.4f %10d %12.1f\n",
+            names[m],
+            ms,
+            loaded ? ms / loaded : 0.0,
+            loaded / iterations,
+            mbs );
+    }
+
+    if ( sum_read != sum_mmap )
+    {
+        fprintf( stderr, "\nERROR - fread and mmap passes saw different file contents!\n" );
+        return 1;
+    }
+
+    bench_free_files( );
+
+    return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Logger benchmark - synchronous writes vs the async writer thread
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Usage: bench_log [--frames N] [--bones N] [--threads N]
+ *
+ *   Every thread logs what SetUpBonesInto() does at --trace: seven TRACE
+ *   lines per bone, every frame, into a log file in a temporary directory
+ *   (console off). Reported per mode:
+ *
+ *     call     time spent inside the logging calls, per call
+ *     frame    the slowest frame any thread saw
+ *     drain    what logger_flush() still had to write after the last call
+ *     KB       size of the log file
+ *
+ *   Modes: "sync" writes and flushes every line under the logger lock,
+ *   "async" queues every record (full queue blocks) and "async drop" uses a
+ *   small queue that drops TRACE when full. "binary" is "async" writing the
+ *   binary format, read back through the decoder's reader, and "binary sync"
+ *   the same without the writer thread. "off" runs with the global level at
+ *   INFO, the price of TRACE lines left in hot code. The runs that keep
+ *   everything must write every line, each thread's in the order it logged
+ *   them.
+ */
+
+#include "bench_util.h"
+#include "utils/log_binary.h"
+#include "utils/logger.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAX_THREADS 16
+
+typedef struct {
+    int    thread;
+    int    frames;
+    int    bones;
+    double call_ms;
+    double worst_frame_ms;
+} bench_thread_t;
+
+static void *log_frames( void *arg )
+{
+    bench_thread_t *t   = arg;
+    int             seq = 0;
+
+    for ( int f = 0; f < t->frames; f++ )
+    {
+        double start = bench_now_ms( );
+
+        for ( int b = 0; b < t->bones; b++ )
+        {
+            float pos = ( float ) b * 0.5f;
+            LOG_TRACEF( "bones", "t%d #%d   Processing bone %d/%d: Bip01 Spine%d", t->thread, seq++, b, t->bones - 1, b );
+            LOG_TRACEF( "bones", "t%d #%d     Position: (%.2f, %.2f, %.2f)", t->thread, seq++, pos, pos * 2, pos * 3 );
+            LOG_TRACEF( "bones", "t%d #%d     Rotation: (%.2f, %.2f, %.2f)", t->thread, seq++, pos, -pos, 0.0 );
+            LOG_TRACEF( "bones", "t%d #%d     Converting to quaternion", t->thread, seq++ );
+            LOG_TRACEF( "bones", "t%d #%d     Building rotation matrix", t->thread, seq++ );
+            LOG_TRACEF( "bones", "t%d #%d     Parent bone: %d", t->thread, seq++, b - 1 );
+            LOG_TRACEF( "bones", "t%d #%d     Concatenating with parent %d", t->thread, seq++, b - 1 );
+        }
+
+        double ms = bench_now_ms( ) - start;
+        t->call_ms += ms;
+        if ( ms > t->worst_frame_ms )
+            t->worst_frame_ms = ms;
+    }
+
+    return NULL;
+}
+
+// Checks one bench line's sequence number against what its thread logged before
+static bool count_line( const char *msg, int threads, int *next, bool *ordered )
+{
+    int thread, seq;
+    if ( sscanf( msg, "t%d #%d", &thread, &seq ) != 2 || thread < 0 || thread >= threads )
+        return false;
+
+    if ( seq < next[thread] )
+        *ordered = false;
+    next[thread] = seq + 1;
+    return true;
+}
+
+// Counts the bench lines and checks that each thread's sequence numbers only go up
+static long verify_log( const char *path, int threads, bool binary, bool *ordered )
+{
+    int  next[MAX_THREADS] = { 0 };
+    long lines             = 0;
+    *ordered               = true;
+
+    if ( binary )
+    {
+        t_log_bin_reader *reader = log_bin_open( path );
+        if ( !reader )
+            return 0;
+
+        static t_log_bin_entry entry;
+        int                    status;
+        while ( ( status = log_bin_next( reader, &entry ) ) == 1 )
+        {
+            lines += count_line( entry.message, threads, next, ordered );
+        }
+        log_bin_close( reader );
+
+        if ( status < 0 )
+        {
+            fprintf( stderr, "ERROR - %s: damaged binary record\n", path );
+            *ordered = false;
+        }
+        return lines;
+    }
+
+    FILE *fp = fopen( path, "rb" );
+    if ( !fp )
+        return 0;    // nothing was logged
+
+    char line[512];
+    while ( fgets( line, sizeof( line ), fp ) )
+    {
+        const char *msg = strstr( line, "| t" );
+        if ( msg )
+            lines += count_line( msg + 2, threads, next, ordered );
+    }
+
+    fclose( fp );
+    return lines;
+}
+
+static bool run_mode(
+    const char *name,
+    const char *dir,
+    int         level,
+    bool        async,
+    bool        binary,
+    int         capacity,
+    int         block_level,
+    int         frames,
+    int         bones,
+    int         threads )
+{
+    char path[256];
+    snprintf( path, sizeof( path ), "%s/%s.log", dir, name );
+    for ( char *c = path + strlen( dir ) + 1; *c; c++ )
+    {
+        if ( *c == ' ' )
+            *c = '_';
+    }
+
+    t_log_options options = {
+        .file_path         = path,
+        .console_level     = LOG_FATAL + 1,
+        .async             = async,
+        .binary            = binary,
+        .async_capacity    = capacity,
+        .async_block_level = block_level,
+    };
+    logger_init( &options );
+    logger_set_global_level( level );
+
+    bench_thread_t state[MAX_THREADS];
+    pthread_t      handles[MAX_THREADS];
+
+    double start = bench_now_ms( );
+    for ( int i = 0; i < threads; i++ )
+    {
+        state[i] = ( bench_thread_t ) { i, frames, bones, 0.0, 0.0 };
+        pthread_create( &handles[i], NULL, log_frames, &state[i] );
+    }
+    for ( int i = 0; i < threads; i++ )
+    {
+        pthread_join( handles[i], NULL );
+    }
+    double calls_done = bench_now_ms( );
+    logger_flush( );
+    double drained = bench_now_ms( );
+
+    uint64_t dropped = logger_dropped( );
+    logger_shutdown( );
+
+    double call_ms = 0.0, worst = 0.0;
+    for ( int i = 0; i < threads; i++ )
+    {
+        call_ms += state[i].call_ms;
+        if ( state[i].worst_frame_ms > worst )
+            worst = state[i].worst_frame_ms;
+    }
+
+    const long calls   = ( long ) threads * frames * bones * 7;
+    const long logged  = level <= LOG_TRACE ? calls : 0;
+    bool       ordered = false;
+    long       lines   = verify_log( path, threads, binary, &ordered );
+
+    struct stat st;
+    long        kb = stat( path, &st ) == 0 ? ( long ) ( st.st_size / 1024 ) : 0;
+    remove( path );
+
+    printf(
+        "  %-11s %10.1f %10.3f %10.2f %10.2f %10ld %10llu %10ld\n",
+        name,
+        call_ms * 1e6 / ( double ) calls,
+        worst,
+        drained - calls_done,
+        drained - start,
+        lines,
+        ( unsigned long long ) dropped,
+        kb );
+
+    if ( !ordered )
+    {
+        fprintf( stderr, "ERROR - %s: a thread's lines are out of order\n", name );
+        return false;
+    }
+    if ( lines + ( long ) dropped != logged )
+    {
+        fprintf( stderr, "ERROR - %s: %ld lines + %llu dropped, expected %ld\n", name, lines, ( unsigned long long ) dropped, logged );
+        return false;
+    }
+    return true;
+}
+
+int main( int argc, char **argv )
+{
+    int frames  = 200;
+    int bones   = 50;
+    int threads = 1;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--frames" ) == 0 && i + 1 < argc )
+            frames = atoi( argv[++i] );
+        else if ( strcmp( argv[i], "--bones" ) == 0 && i + 1 < argc )
+            bones = atoi( argv[++i] );
+        else if ( strcmp( argv[i], "--threads" ) == 0 && i + 1 < argc )
+            threads = atoi( argv[++i] );
+        else
+        {
+            fprintf( stderr, "USAGE: %s [--frames N] [--bones N] [--threads N]\n", argv[0] );
+            return 1;
+        }
+    }
+
+    if ( frames < 1 )
+        frames = 1;
+    if ( bones < 1 )
+        bones = 1;
+    if ( threads < 1 )
+        threads = 1;
+    if ( threads > MAX_THREADS )
+        threads = MAX_THREADS;
+
+    char dir[] = "/tmp/bench_log.XXXXXX";
+    if ( !mkdtemp( dir ) )
+    {
+        fprintf( stderr, "ERROR - Cannot create a temporary log directory\n" );
+        return 1;
+    }
+
+    printf( "Frames: %d, bones: %d, threads: %d, %d TRACE lines per frame per thread\n\n", frames, bones, threads, bones * 7 );
+    printf(
+        "  %-11s %10s %10s %10s %10s %10s %10s %10s\n",
+        "mode",
+        "ns/call",
+        "frame ms",
+        "drain ms",
+        "total ms",
+        "lines",
+        "dropped",
+        "KB" );
+
+    bool ok = true;
+    ok &= run_mode( "sync", dir, LOG_TRACE, false, false, 0, LOG_TRACE, frames, bones, threads );
+    ok &= run_mode( "async", dir, LOG_TRACE, true, false, 0, LOG_TRACE, frames, bones, threads );
+    ok &= run_mode( "async drop", dir, LOG_TRACE, true, false, 1024, LOG_INFO, frames, bones, threads );
+    ok &= run_mode( "binary", dir, LOG_TRACE, true, true, 0, LOG_TRACE, frames, bones, threads );
+    ok &= run_mode( "binary sync", dir, LOG_TRACE, false, true, 0, LOG_TRACE, frames, bones, threads );
+    ok &= run_mode( "off", dir, LOG_INFO, true, false, 0, LOG_TRACE, frames, bones, threads );
+
+    rmdir( dir );
+
+    if ( !ok )
+        return 1;
+
+    printf( "\n  every kept line was written, in order per thread\n" );
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Mesh benchmark - expanded vs indexed (welded) vertex streams
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Usage: bench_mesh <dir-or-model.mdl>...
+ *
+ *   Decodes every mesh of every submodel the same way the renderer does and
+ *   reports how many vertices the expanded triangle list needs versus the
+ *   welded indexed mesh, plus what that means for the per-frame VBO upload
+ *   (8 floats per vertex). Index buffers are uploaded once per topology
+ *   build and are listed separately.
+ *
+ *   The ACMR/ATVR columns simulate a MDL_VCACHE_SIZE FIFO post-transform
+ *   cache over the file's triangle order and again after the renderer's
+ *   vertex cache + vertex fetch reorder.
+ */
+
+#include "bench_util.h"
+#include "mdl/mdl_loader.h"
+#include "mdl/mdl_mesh.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VERTEX_BYTES ( 8 * sizeof( float ) )
+
+typedef struct {
+    long corners;
+    long unique;
+    long index_bytes;
+    long misses_before;
+    long misses_after;
+} mesh_stats_t;
+
+static void measure_model( const mdl_model_t *model, mesh_stats_t *stats )
+{
+    const studiohdr_t   *header = model->header;
+    const unsigned char *data   = model->data;
+
+    mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( data + header->bodypartindex );
+
+    // Same as the renderer: all meshes share one vertex buffer, so a mesh
+    // needs 32-bit indices once the running vertex count passes 0xFFFF
+    long base = 0;
+
+    for ( int bp = 0; bp < header->numbodyparts; bp++ )
+    {
+        mstudiomodel_t *models = ( mstudiomodel_t * ) ( data + bodyparts[bp].modelindex );
+
+        for ( int m = 0; m < bodyparts[bp].nummodels; m++ )
+        {
+            mstudiomodel_t *sub    = &models[m];
+            mstudiomesh_t  *meshes = ( mstudiomesh_t * ) ( data + sub->meshindex );
+
+            for ( int i = 0; i < sub->nummesh; i++ )
+            {
+                int max = mdl_count_tricmd_corners( data, &meshes[i] );
+                if ( max <= 0 )
+                    continue;
+
+                mdl_tricmd_vertex_t *corners = malloc( ( size_t ) max * sizeof( *corners ) );
+                mdl_tricmd_vertex_t *unique  = malloc( ( size_t ) max * sizeof( *unique ) );
+                unsigned int        *indices = malloc( ( size_t ) max * sizeof( *indices ) );
+
+                if ( corners && unique && indices )
+                {
+                    int count  = mdl_decode_tricmds( data, &meshes[i], sub->numverts, sub->numnorms, corners, max );
+                    int welded = mdl_weld_tricmd_vertices( corners, count, unique, indices );
+
+                    if ( welded > 0 )
+                    {
+                        mdl_vcache_stats_t cache;
+
+                        mdl_analyze_vertex_cache( indices, count, welded, MDL_VCACHE_SIZE, &cache );
+                        stats->misses_before += cache.misses;
+
+                        if ( mdl_optimize_vertex_cache( indices, count, welded, MDL_VCACHE_SIZE ) )
+                        {
+                            mdl_optimize_vertex_fetch( unique, welded, indices, count );
+                        }
+
+                        mdl_analyze_vertex_cache( indices, count, welded, MDL_VCACHE_SIZE, &cache );
+                        stats->misses_after += cache.misses;
+
+                        stats->corners += count;
+                        stats->unique += welded;
+                        stats->index_bytes += ( long ) count * ( base + welded - 1 > 0xFFFF ? 4 : 2 );
+                        base += welded;
+                    }
+                }
+
+                free( corners );
+                free( unique );
+                free( indices );
+            }
+        }
+    }
+}
+
+int main( int argc, char **argv )
+{
+    for ( int i = 1; i < argc; i++ )
+    {
+        bench_collect( argv[i] );
+    }
+
+    if ( g_bench_num_files == 0 )
+    {
+        fprintf( stderr, "USAGE: %s <dir-or-model.mdl>...\n", argv[0] );
+        return 1;
+    }
+
+    printf(
+        "  %-32s %9s %9s %7s %12s %12s %10s %15s %15s\n",
+        "model",
+        "expanded",
+        "indexed",
+        "saved",
+        "upload B/fr",
+        "indexed B/fr",
+        "index B",
+        "ACMR",
+        "ATVR" );
+
+    mesh_stats_t total  = { 0, 0, 0, 0, 0 };
+    int          models = 0;
+
+    for ( int i = 0; i < g_bench_num_files; i++ )
+    {
+        mdl_model_t *model = NULL;
+
+        mesh_stats_t stats = { 0, 0, 0, 0, 0 };
+
+        bench_silence( );
+        if ( create_mdl_model( g_bench_files[i], &model ) == MDL_SUCCESS )
+        {
+            measure_model( model, &stats );
+            free_model( model );
+        }
+        bench_restore( );
+
+        if ( stats.corners == 0 )
+            continue;
+
+        const char *name = strrchr( g_bench_files[i], '/' );
+        name             = name ? name + 1 : g_bench_files[i];
+
+        const double triangles = ( double ) stats.corners / 3.0;
+
+        printf(
+            "  %-32.32s %9ld %9ld %6.1f%% %12ld %12ld %10ld %6.3f->%6.3f %6.3f->%6.3f\n",
+            name,
+            stats.corners,
+            stats.unique,
+            100.0 * ( 1.0 - ( double ) stats.unique / ( double ) stats.corners ),
+            stats.corners * ( long ) VERTEX_BYTES,
+            stats.unique * ( long ) VERTEX_BYTES,
+            stats.index_bytes,
+            stats.misses_before / triangles,
+            stats.misses_after / triangles,
+            ( double ) stats.misses_before / ( double ) stats.unique,
+            ( double ) stats.misses_after / ( double ) stats.unique );
+
+        total.corners += stats.corners;
+        total.unique += stats.unique;
+        total.index_bytes += stats.index_bytes;
+        total.misses_before += stats.misses_before;
+        total.misses_after += stats.misses_after;
+        models++;
+    }
+
+    if ( total.corners > 0 )
+    {
+        printf(
+            "\n  %d models: %ld -> %ld vertices (%.1f%% fewer), per-frame upload %.2f MB -> %.2f MB, "
+            "one-time indices %.2f MB\n",
+            models,
+            total.corners,
+            total.unique,
+            100.0 * ( 1.0 - ( double ) total.unique / ( double ) total.corners ),
+            ( double ) total.corners * VERTEX_BYTES / ( 1024.0 * 1024.0 ),
+            ( double ) total.unique * VERTEX_BYTES / ( 1024.0 * 1024.0 ),
+            ( double ) total.index_bytes / ( 1024.0 * 1024.0 ) );
+        printf(
+            "  vertex cache (FIFO %d): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+            MDL_VCACHE_SIZE,
+            3.0 * total.misses_before / ( double ) total.corners,
+            3.0 * total.misses_after / ( double ) total.corners,
+            ( double ) total.misses_before / ( double ) total.unique,
+            ( double ) total.misses_after / ( double ) total.unique );
+    }
+
+    bench_free_files( );
+    return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Palette expansion benchmark - branchy per-byte loops vs the LUT kernels
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Usage: bench_palette <dir-or-model.mdl>... [--iterations N]
+ *
+ *   Expands every skin of every model (T.mdl skins included) to RGBA and to
+ *   RGB. "legacy" is the old per-byte loop with a branch for index 255 that
+ *   mdl_load_textures() and extract_texture_rgb() used; the other rows are
+ *   mdl_palette_expand_rgba()/_rgb() with each kernel the CPU supports, with
+ *   the lookup table built per texture as the callers do. Every kernel's
+ *   output is compared byte for byte with legacy.
+ */
+
+#include "bench_util.h"
+#include "mdl/mdl_loader.h"
+#include "mdl/mdl_palette.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const mdl_pal_isa_t g_isas[] = { MDL_PAL_ISA_SCALAR, MDL_PAL_ISA_SSSE3, MDL_PAL_ISA_AVX2 };
+#define NUM_ISAS ( int ) ( sizeof( g_isas ) / sizeof( g_isas[0] ) )
+
+typedef struct {
+    const unsigned char *indices;
+    const unsigned char *palette;
+    size_t               pixels;
+} bench_texture_t;
+
+static bench_texture_t *g_textures;
+static int              g_num_textures;
+static size_t           g_total_pixels;
+
+static void collect_textures( const mdl_model_t *model )
+{
+    // Same choice as mdl_pick_texture_header()
+    const studiohdr_t   *header = model->header;
+    const unsigned char *file   = model->data;
+    size_t               size   = model->data_size;
+
+    if ( header->numtextures <= 0 && model->texture_header )
+    {
+        header = model->texture_header;
+        file   = model->texture_data;
+        size   = model->texture_size;
+    }
+
+    if ( header->numtextures <= 0 || header->textureindex < 0
+         || ( size_t ) header->textureindex + ( size_t ) header->numtextures * sizeof( mstudiotexture_t ) > size )
+        return;
+
+    const mstudiotexture_t *textures = ( const mstudiotexture_t * ) ( file + header->textureindex );
+
+    bench_texture_t *grown = realloc( g_textures, ( size_t ) ( g_num_textures + header->numtextures ) * sizeof( *grown ) );
+    if ( !grown )
+        return;
+    g_textures = grown;
+
+    for ( int i = 0; i < header->numtextures; i++ )
+    {
+        const mstudiotexture_t *T      = &textures[i];
+        const size_t            pixels = ( size_t ) T->width * ( size_t ) T->height;
+
+        if ( T->width <= 0 || T->height <= 0 || T->index < 0 || ( size_t ) T->index + pixels + 256 * 3 > size )
+            continue;
+
+        bench_texture_t *t = &g_textures[g_num_textures++];
+        t->indices         = file + T->index;
+        t->palette         = t->indices + pixels;
+        t->pixels          = pixels;
+        g_total_pixels += pixels;
+    }
+}
+
+// The loop mdl_load_textures() had, 255 cleared to transparent black
+static void legacy_rgba( const bench_texture_t *t, unsigned char *rgba )
+{
+    for ( size_t j = 0; j < t->pixels; j++ )
+    {
+        unsigned char idx = t->indices[j];
+        if ( idx == 255 )
+        {
+            rgba[j * 4 + 0] = 0;
+            rgba[j * 4 + 1] = 0;
+            rgba[j * 4 + 2] = 0;
+            rgba[j * 4 + 3] = 0;
+        }
+        else
+        {
+            rgba[j * 4 + 0] = t->palette[idx * 3 + 0];
+            rgba[j * 4 + 1] = t->palette[idx * 3 + 1];
+            rgba[j * 4 + 2] = t->palette[idx * 3 + 2];
+            rgba[j * 4 + 3] = 255;
+        }
+    }
+}
+
+// The loop extract_texture_rgb() had
+static void legacy_rgb( const bench_texture_t *t, unsigned char *rgb )
+{
+    for ( size_t j = 0; j < t->pixels; j++ )
+    {
+        unsigned char idx = t->indices[j];
+
+        rgb[j * 3 + 0] = t->palette[idx * 3 + 0];
+        rgb[j * 3 + 1] = t->palette[idx * 3 + 1];
+        rgb[j * 3 + 2] = t->palette[idx * 3 + 2];
+
+        if ( idx == 255 )
+        {
+            rgb[j * 3 + 0] = 0;
+            rgb[j * 3 + 1] = 0;
+            rgb[j * 3 + 2] = 0;
+        }
+    }
+}
+
+static void kernel_rgba( const bench_texture_t *t, unsigned char *rgba )
+{
+    mdl_palette_lut_t lut;
+    mdl_palette_build_lut( t->palette, 256, false, &lut );
+    mdl_palette_expand_rgba( t->indices, t->pixels, &lut, rgba );
+}
+
+static void kernel_rgb( const bench_texture_t *t, unsigned char *rgb )
+{
+    mdl_palette_lut_t lut;
+    mdl_palette_build_lut( t->palette, 256, false, &lut );
+    mdl_palette_expand_rgb( t->indices, t->pixels, &lut, rgb );
+}
+
+typedef void ( *expand_fn )( const bench_texture_t *t, unsigned char *dst );
+
+// Every texture into its own slice of `out`; returns the best pass in ms
+static double run( expand_fn fn, int bytes_per_pixel, unsigned char *out, int iterations )
+{
+    double best = 0.0;
+
+    for ( int it = 0; it < iterations; it++ )
+    {
+        double         t0  = bench_now_ms( );
+        unsigned char *dst = out;
+
+        for ( int i = 0; i < g_num_textures; i++ )
+        {
+            fn( &g_textures[i], dst );
+            dst += g_textures[i].pixels * ( size_t ) bytes_per_pixel;
+        }
+
+        double ms = bench_now_ms( ) - t0;
+        if ( it == 0 || ms < best )
+            best = ms;
+    }
+    return best;
+}
+
+static void print_row( const char *name, double ms, double legacy_ms, bool match )
+{
+    printf(
+        "    %-8s %10.3f %10.1f %8.2fx %8s\n",
+        name,
+        ms,
+        ms > 0.0 ? ( double ) g_total_pixels / ( ms * 1000.0 ) : 0.0,
+        ms > 0.0 ? legacy_ms / ms : 0.0,
+        match ? "yes" : "NO" );
+}
+
+int main( int argc, char **argv )
+{
+    int iterations = 20;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--iterations" ) == 0 && i + 1 < argc )
+        {
+            iterations = atoi( argv[++i] );
+            if ( iterations < 1 )
+                iterations = 1;
+        }
+        else
+        {
+            bench_collect( argv[i] );
+        }
+    }
+
+    if ( g_bench_num_files == 0 )
+    {
+        fprintf( stderr, "USAGE: %s <dir-or-model.mdl>... [--iterations N]\n", argv[0] );
+        return 1;
+    }
+
+    // Models stay loaded: the textures point into their file data
+    mdl_model_t **models = calloc( ( size_t ) g_bench_num_files, sizeof( *models ) );
+    if ( !models )
+        return 1;
+
+    mdl_set_load_messages( false );
+    bench_silence( );
+    for ( int i = 0; i < g_bench_num_files; i++ )
+    {
+        if ( create_mdl_model( g_bench_files[i], &models[i] ) == MDL_SUCCESS )
+            collect_textures( models[i] );
+    }
+    bench_restore( );
+
+    unsigned char *reference = malloc( g_total_pixels * 4 + 1 );
+    unsigned char *output    = malloc( g_total_pixels * 4 + 1 );
+    if ( g_num_textures == 0 || !reference || !output )
+    {
+        fprintf( stderr, "ERROR - No textures found\n" );
+        return 1;
+    }
+
+    bool available[NUM_ISAS];
+    printf( "Kernels:" );
+    for ( int k = 0; k < NUM_ISAS; ++k )
+    {
+        available[k] = mdl_pal_set_isa( g_isas[k] );
+        printf( " %s%s", mdl_pal_isa_name( g_isas[k] ), available[k] ? "" : " (unsupported)" );
+    }
+    printf(
+        "\nTextures: %d (%.2f MPix), best of %d passes\n",
+        g_num_textures,
+        ( double ) g_total_pixels / 1e6,
+        iterations );
+
+    const char     *formats[2] = { "RGBA", "RGB" };
+    const expand_fn legacy[2]  = { legacy_rgba, legacy_rgb };
+    const expand_fn kernels[2] = { kernel_rgba, kernel_rgb };
+    bool            all_match  = true;
+
+    for ( int f = 0; f < 2; f++ )
+    {
+        const int    bpp   = ( f == 0 ) ? 4 : 3;
+        const size_t bytes = g_total_pixels * ( size_t ) bpp;
+
+        printf( "\n  %s\n    %-8s %10s %10s %9s %8s\n", formats[f], "kernel", "ms", "MPix/s", "speedup", "match" );
+
+        const double legacy_ms = run( legacy[f], bpp, reference, iterations );
+        print_row( "legacy", legacy_ms, legacy_ms, true );
+
+        for ( int k = 0; k < NUM_ISAS; ++k )
+        {
+            if ( !available[k] )
+                continue;
+
+            mdl_pal_set_isa( g_isas[k] );
+            memset( output, 0xCD, bytes );
+
+            const double ms    = run( kernels[f], bpp, output, iterations );
+            const bool   match = memcmp( reference, output, bytes ) == 0;
+            all_match          = all_match && match;
+            print_row( mdl_pal_isa_name( g_isas[k] ), ms, legacy_ms, match );
+        }
+    }
+
+    free( reference );
+    free( output );
+    free( g_textures );
+
+    bench_silence( );
+    for ( int i = 0; i < g_bench_num_files; i++ )
+    {
+        if ( models[i] )
+            free_model( models[i] );
+    }
+    bench_restore( );
+    free( models );
+    bench_free_files( );
+
+    if ( !all_match )
+    {
+        fprintf( stderr, "\nERROR - a kernel's output differs from the legacy loop!\n" );
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Skinning microbenchmark - per-vertex mat4 vs bucketed SIMD kernels
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Usage: bench_skin <dir-or-model.mdl>... [--min-verts N]
+ *
+ *   Poses each model with SetUpBones() and skins the first submodel of every
+ *   bodypart, positions and normals, the way a frame does. "legacy" is the
+ *   old per-vertex VectorTransforms/TransformNormalByBone loop; the other
+ *   columns are mdl_skin_positions()/mdl_skin_normals() with each kernel the
+ *   CPU supports. Times are microseconds per frame. Every kernel's output is
+ *   checked against legacy.
+ */
+
+#include "bench_util.h"
+#include "mdl/bone_system.h"
+#include "mdl/mdl_loader.h"
+#include "mdl/mdl_skinning.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PARTS MAXSTUDIOBODYPARTS
+
+static const mdl_skin_isa_t g_isas[] = { MDL_SKIN_ISA_SCALAR, MDL_SKIN_ISA_SSE41, MDL_SKIN_ISA_AVX2 };
+#define NUM_ISAS ( int ) ( sizeof( g_isas ) / sizeof( g_isas[0] ) )
+
+typedef struct {
+    studiohdr_t    *header;
+    unsigned char  *data;
+    mstudiomodel_t *parts[MAX_PARTS];
+    int             num_parts;
+    int             verts;
+    int             norms;
+} skin_job_t;
+
+static vec3 g_pos_ref[MAXSTUDIOVERTS], g_nrm_ref[MAXSTUDIOVERTS];
+static vec3 g_pos_out[MAXSTUDIOVERTS], g_nrm_out[MAXSTUDIOVERTS];
+
+static void skin_legacy( const skin_job_t *job, vec3 *pos, vec3 *nrm )
+{
+    for ( int p = 0; p < job->num_parts; ++p )
+    {
+        const mstudiomodel_t *model   = job->parts[p];
+        const vec3_t         *verts   = ( const vec3_t * ) ( job->data + model->vertindex );
+        const vec3_t         *normals = ( const vec3_t * ) ( job->data + model->normindex );
+        const unsigned char  *v2bone  = job->data + model->vertinfoindex;
+        const unsigned char  *n2bone  = job->data + model->norminfoindex;
+
+        for ( int i = 0; i < model->numverts; ++i )
+        {
+            int bone = v2bone[i] < job->header->numbones ? v2bone[i] : 0;
+            VectorTransforms( verts[i], g_bonetransformations[bone], pos[i] );
+        }
+
+        for ( int i = 0; i < model->numnorms; ++i )
+        {
+            int bone = n2bone[i] < job->header->numbones ? n2bone[i] : 0;
+            TransformNormalByBone( g_bonetransformations[bone], normals[i], nrm[i] );
+        }
+    }
+}
+
+static void skin_kernel( const skin_job_t *job, vec3 *pos, vec3 *nrm )
+{
+    for ( int p = 0; p < job->num_parts; ++p )
+    {
+        mdl_skin_positions( job->header, job->data, job->parts[p], ( const mat4 * ) g_bonetransformations, pos );
+        mdl_skin_normals( job->header, job->data, job->parts[p], ( const mat4 * ) g_bonetransformations, nrm );
+    }
+}
+
+// Microseconds per call, best of 5 runs
+static double time_us( void ( *fn )( const skin_job_t *, vec3 *, vec3 * ), const skin_job_t *job, int iterations )
+{
+    double best = 1e30;
+
+    for ( int run = 0; run < 5; ++run )
+    {
+        double t0 = bench_now_ms( );
+        for ( int it = 0; it < iterations; ++it )
+        {
+            fn( job, g_pos_out, g_nrm_out );
+        }
+        double us = ( bench_now_ms( ) - t0 ) * 1000.0 / iterations;
+        if ( us < best )
+            best = us;
+    }
+
+    return best;
+}
+
+static float max_error( const vec3 *a, const vec3 *b, int count )
+{
+    float err = 0.0f;
+    for ( int i = 0; i < count; ++i )
+    {
+        for ( int k = 0; k < 3; ++k )
+        {
+            float d = fabsf( a[i][k] - b[i][k] );
+            if ( d > err )
+                err = d;
+        }
+    }
+    return err;
+}
+
+int main( int argc, char **argv )
+{
+    int min_verts = 0;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--min-verts" ) == 0 && i + 1 < argc )
+        {
+            min_verts = atoi( argv[++i] );
+        }
+        else
+        {
+            bench_collect( argv[i] );
+        }
+    }
+
+    if ( g_bench_num_files == 0 )
+    {
+        fprintf( stderr, "USAGE: %s <dir-or-model.mdl>... [--min-verts N]\n", argv[0] );
+        return 1;
+    }
+
+    bool available[NUM_ISAS];
+    printf( "Kernels:" );
+    for ( int k = 0; k < NUM_ISAS; ++k )
+    {
+        available[k] = mdl_skin_set_isa( g_isas[k] );
+        printf( " %s%s", mdl_skin_isa_name( g_isas[k] ), available[k] ? "" : " (unsupported)" );
+    }
+    printf( "\n\n  %-28s %6s %6s %9s", "model", "verts", "norms", "legacy" );
+    for ( int k = 0; k < NUM_ISAS; ++k )
+    {
+        if ( available[k] )
+            printf( " %9s", mdl_skin_isa_name( g_isas[k] ) );
+    }
+    printf( " %8s %10s\n", "speedup", "max error" );
+
+    double sum_legacy = 0.0, sum_best = 0.0;
+    int    measured   = 0;
+
+    for ( int f = 0; f < g_bench_num_files; f++ )
+    {
+        mdl_model_t *model = NULL;
+
+        bench_silence( );
+        mdl_result_t result = create_mdl_model( g_bench_files[f], &model );
+        bench_restore( );
+
+        if ( result != MDL_SUCCESS )
+            continue;
+
+        skin_job_t job = { 0 };
+        job.header     = model->header;
+        job.data       = model->data;
+
+        mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( job.data + job.header->bodypartindex );
+        for ( int b = 0; b < job.header->numbodyparts && job.num_parts < MAX_PARTS; ++b )
+        {
+            mstudiomodel_t *sub = ( mstudiomodel_t * ) ( job.data + bodyparts[b].modelindex );
+            if ( bodyparts[b].nummodels > 0 && sub->numverts > 0 && sub->numverts <= MAXSTUDIOVERTS
+                 && sub->numnorms <= MAXSTUDIOVERTS )
+            {
+                job.parts[job.num_parts++] = sub;
+                job.verts += sub->numverts;
+                job.norms += sub->numnorms;
+            }
+        }
+
+        if ( job.num_parts == 0 || job.verts < min_verts || job.header->numbones <= 0 )
+        {
+            bench_silence( );
+            free_model( model );
+            bench_restore( );
+            continue;
+        }
+
+        bench_silence( );
+        SetUpBones( job.header, job.data );
+        bench_restore( );
+
+        const int iterations = 2000000 / ( job.verts + job.norms ) + 20;
+
+        // Parts overwrite each other's slots; compare the last part, which is what survives
+        const mstudiomodel_t *last = job.parts[job.num_parts - 1];
+
+        skin_legacy( &job, g_pos_ref, g_nrm_ref );
+        double legacy = time_us( skin_legacy, &job, iterations );
+        double best   = legacy;
+        float  error  = 0.0f;
+
+        const char *name = strrchr( g_bench_files[f], '/' );
+        name             = name ? name + 1 : g_bench_files[f];
+        printf( "  %-28.28s %6d %6d %9.2f", name, job.verts, job.norms, legacy );
+
+        for ( int k = 0; k < NUM_ISAS; ++k )
+        {
+            if ( !available[k] )
+                continue;
+
+            mdl_skin_set_isa( g_isas[k] );
+            skin_kernel( &job, g_pos_out, g_nrm_out );
+
+            float e = max_error( g_pos_ref, g_pos_out, last->numverts );
+            float n = max_error( g_nrm_ref, g_nrm_out, last->numnorms );
+            if ( e > error )
+                error = e;
+            if ( n > error )
+                error = n;
+
+            double us = time_us( skin_kernel, &job, iterations );
+            if ( us < best )
+                best = us;
+            printf( " %9.2f", us );
+        }
+
+        printf( " %7.2fx %10.2e\n", legacy / best, error );
+
+        sum_legacy += legacy;
+        sum_best += best;
+        measured++;
+
+        mdl_skin_plans_clear( );
+        bench_silence( );
+        free_model( model );
+        bench_restore( );
+    }
+
+    if ( measured > 0 )
+    {
+        printf(
+            "\n  %d models: legacy %.1f us, best kernel %.1f us per frame in total (%.2fx)\n",
+            measured,
+            sum_legacy,
+            sum_best,
+            sum_legacy / sum_best );
+    }
+
+    bench_free_files( );
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Shared helpers for the bench/ programs
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "bench_util.h"
+#include "mdl/mdl_loader.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+char *g_bench_files[MAX_BENCH_FILES];
+int   g_bench_num_files = 0;
+
+double bench_now_ms( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec * 1000.0 + ( double ) ts.tv_nsec / 1.0e6;
+}
+
+static void add_file( const char *path )
+{
+    if ( g_bench_num_files < MAX_BENCH_FILES )
+    {
+        g_bench_files[g_bench_num_files++] = strdup( path );
+    }
+}
+
+void bench_collect( const char *path )
+{
+    DIR *dir = opendir( path );
+    if ( !dir )
+    {
+        add_file( path );
+        return;
+    }
+
+    struct dirent *ent;
+    while ( ( ent = readdir( dir ) ) != NULL )
+    {
+        if ( mdl_is_main_model_file( path, ent->d_name ) )
+        {
+            char full[1024];
+            snprintf( full, sizeof( full ), "%s/%s", path, ent->d_name );
+            add_file( full );
+        }
+    }
+    closedir( dir );
+}
+
+void bench_free_files( void )
+{
+    for ( int i = 0; i < g_bench_num_files; i++ )
+    {
+        free( g_bench_files[i] );
+    }
+    g_bench_num_files = 0;
+}
+
+static int g_saved_out = -1, g_saved_err = -1;
+
+void bench_silence( void )
+{
+    fflush( stdout );
+    fflush( stderr );
+    g_saved_out = dup( fileno( stdout ) );
+    g_saved_err = dup( fileno( stderr ) );
+    FILE *null_fp = fopen( "/dev/null", "w" );
+    if ( null_fp )
+    {
+        dup2( fileno( null_fp ), fileno( stdout ) );
+        dup2( fileno( null_fp ), fileno( stderr ) );
+        fclose( null_fp );
+    }
+}
+
+void bench_restore( void )
+{
+    fflush( stdout );
+    fflush( stderr );
+    dup2( g_saved_out, fileno( stdout ) );
+    dup2( g_saved_err, fileno( stderr ) );
+    close( g_saved_out );
+    close( g_saved_err );
+}
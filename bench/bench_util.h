@@ -0,0 +1,23 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdint.h>
+
+#define MAX_BENCH_FILES 4096
+
+extern char *g_bench_files[MAX_BENCH_FILES];
+extern int   g_bench_num_files;
+
+// Adds a model file, or every standalone model in a directory (T.mdl / NN.mdl companions are skipped)
+void bench_collect( const char *path );
+
+void bench_free_files( void );
+
+double bench_now_ms( void );
+
+// Park stdout/stderr on /dev/null while timing so loader chatter is not measured
+void bench_silence( void );
+
+void bench_restore( void );
+
+#endif    // BENCH_UTIL_H
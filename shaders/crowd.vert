@@ -0,0 +1,46 @@
+// crowd.vert
+#version 410 core
+layout( location = 0 ) in vec3 aPos;       // model space, straight from the MDL
+layout( location = 1 ) in vec3 aNormal;    // model space, straight from the MDL
+layout( location = 2 ) in vec2 aUV;
+layout( location = 3 ) in uvec2 aBones;    // x = vertex bone, y = normal bone
+
+// Every crowd member's bones as 3x4 rows, one RGBA32F texel per row. A
+// member's block starts at paletteBase + gl_InstanceID * bonesPerInstance * 3.
+// The viewer's axis remap, scale and the member's origin are already folded
+// in on the CPU.
+uniform samplerBuffer bonePalette;
+uniform int           bonesPerInstance;
+uniform int           paletteBase;
+
+uniform mat4 model, view, projection;
+
+out vec3 vNormal;
+out vec3 vWorldPos;
+out vec2 vUV;
+
+int bone_texel( uint bone ) {
+    return paletteBase + ( gl_InstanceID * bonesPerInstance + int( bone ) ) * 3;
+}
+
+void main( ) {
+    int  v  = bone_texel( aBones.x );
+    vec4 r0 = texelFetch( bonePalette, v + 0 );
+    vec4 r1 = texelFetch( bonePalette, v + 1 );
+    vec4 r2 = texelFetch( bonePalette, v + 2 );
+
+    int  n  = bone_texel( aBones.y );
+    vec3 n0 = texelFetch( bonePalette, n + 0 ).xyz;
+    vec3 n1 = texelFetch( bonePalette, n + 1 ).xyz;
+    vec3 n2 = texelFetch( bonePalette, n + 2 ).xyz;
+
+    vec4 h       = vec4( aPos, 1.0 );
+    vec3 skinned = vec3( dot( r0, h ), dot( r1, h ), dot( r2, h ) );
+    vec3 normal  = normalize( vec3( dot( n0, aNormal ), dot( n1, aNormal ), dot( n2, aNormal ) ) );
+
+    vec4 world  = model * vec4( skinned, 1.0 );
+    vWorldPos   = world.xyz;
+    vNormal     = mat3( model ) * normal;
+    vUV         = aUV;
+    gl_Position = projection * view * world;
+}
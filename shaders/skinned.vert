@@ -0,0 +1,40 @@
+// skinned.vert
+#version 410 core
+layout( location = 0 ) in vec3 aPos;       // model space, straight from the MDL
+layout( location = 1 ) in vec3 aNormal;    // model space, straight from the MDL
+layout( location = 2 ) in vec2 aUV;
+layout( location = 3 ) in uvec2 aBones;    // x = vertex bone, y = normal bone
+
+// One 3x4 affine matrix per bone as three row vectors (MAXSTUDIOBONES = 128).
+// The viewer's axis remap and scale are already folded in on the CPU.
+layout( std140 ) uniform Bones {
+    vec4 boneRows[128 * 3];
+};
+
+uniform mat4 model, view, projection;
+
+out vec3 vNormal;
+out vec3 vWorldPos;
+out vec2 vUV;
+
+vec3 bone_point( uint bone, vec3 p ) {
+    vec4 h = vec4( p, 1.0 );
+    return vec3( dot( boneRows[bone * 3u + 0u], h ), dot( boneRows[bone * 3u + 1u], h ), dot( boneRows[bone * 3u + 2u], h ) );
+}
+
+vec3 bone_vector( uint bone, vec3 n ) {
+    return vec3( dot( boneRows[bone * 3u + 0u].xyz, n ),
+                 dot( boneRows[bone * 3u + 1u].xyz, n ),
+                 dot( boneRows[bone * 3u + 2u].xyz, n ) );
+}
+
+void main( ) {
+    vec3 skinned = bone_point( aBones.x, aPos );
+    vec3 normal  = normalize( bone_vector( aBones.y, aNormal ) );
+
+    vec4 world  = model * vec4( skinned, 1.0 );
+    vWorldPos   = world.xyz;
+    vNormal     = mat3( model ) * normal;
+    vUV         = aUV;
+    gl_Position = projection * view * world;
+}
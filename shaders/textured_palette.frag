@@ -0,0 +1,35 @@
+// textured_palette.frag
+#version 410 core
+in vec3 vNormal;
+in vec3 vWorldPos;
+in vec2 vUV;
+
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform sampler2D tex;        // GL_R8 palette indices, GL_NEAREST
+uniform sampler2D palette;    // 256x1 RGBA, index 255 transparent black
+uniform bool masked;          // STUDIO_NF_MASKED: index 255 is cut out
+
+out vec4 FragColor;
+
+vec4 lookup(float index) {
+  return texelFetch(palette, ivec2(int(index * 255.0 + 0.5), 0), 0);
+}
+
+void main() {
+  // Bilinear by hand: look up the 2x2 footprint's colours, then blend them,
+  // which is what GL_LINEAR does on the RGBA textures
+  vec2 f = fract(vUV * vec2(textureSize(tex, 0)) - 0.5);
+  vec4 idx = textureGather(tex, vUV, 0);    // (0,1) (1,1) (1,0) (0,0)
+  vec4 texel = mix(mix(lookup(idx.w), lookup(idx.z), f.x),
+                   mix(lookup(idx.x), lookup(idx.y), f.x), f.y);
+  if (masked && texel.a < 0.5)
+    discard;
+
+  vec3 N = normalize(vNormal);
+  vec3 L = normalize(lightPos - vWorldPos);
+  float diff = max(dot(N, L), 0.0);
+  // simple lambert + a little ambient
+  vec3 color = texel.rgb * (0.2 + 0.8 * diff);
+  FragColor = vec4(color, 1.0);
+}
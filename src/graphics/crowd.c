@@ -0,0 +1,727 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Instanced crowd rendering - many animated copies of one model
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "crowd.h"
+
+#include "../mdl/bone_system.h"
+#include "../utils/job_system.h"
+#include "../utils/logger.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern float zoom;
+extern float rotation_x;
+
+// Same scale the renderer applies to every model
+#define CROWD_VIEWER_SCALE 0.1f
+
+// Log the throughput counters every this many drawn frames
+#define CROWD_REPORT_FRAMES 600
+
+// Fixed seed so a given --instances count always builds the same crowd
+#define CROWD_SEED 0x2545F491u
+
+// Members per pose job at least; one member is a few microseconds of work
+#define CROWD_POSE_GRAIN 16
+
+static unsigned int crowd_random( unsigned int *state )
+{
+    // xorshift32
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static float crowd_random_unit( unsigned int *state )
+{
+    return ( float ) ( crowd_random( state ) >> 8 ) / ( float ) ( 1u << 24 );
+}
+
+static mstudioseqdesc_t *crowd_sequences( const lm_crowd_t *crowd )
+{
+    return ( mstudioseqdesc_t * ) ( crowd->data + crowd->header->seqindex );
+}
+
+// Embedded sequences always play; external groups only if present and loadable
+static bool crowd_sequence_playable( const lm_crowd_t *crowd, int seq_index )
+{
+    mstudioseqdesc_t *seq = &crowd_sequences( crowd )[seq_index];
+
+    if ( seq->numframes <= 1 )
+    {
+        return false;
+    }
+
+    if ( seq->seqgroup == 0 )
+    {
+        return true;
+    }
+
+    if ( !crowd->seqgroups || seq->seqgroup >= crowd->num_seqgroups )
+    {
+        return false;
+    }
+
+    mdl_seqgroup_status_t status = mdl_seqgroup_status( &crowd->seqgroups[seq->seqgroup] );
+    return status != MDL_SEQGROUP_MISSING && status != MDL_SEQGROUP_FAILED;
+}
+
+// Number of distinct (bodygroup, skin) pairs, saturated at LM_CROWD_MAX_VARIANTS
+static int crowd_variant_space( const studiohdr_t *header, const unsigned char *data )
+{
+    const mstudiobodyparts_t *bodyparts = ( const mstudiobodyparts_t * ) ( data + header->bodypartindex );
+    int                       space     = header->numskinfamilies > 1 ? header->numskinfamilies : 1;
+
+    for ( int b = 0; b < header->numbodyparts && space < LM_CROWD_MAX_VARIANTS; ++b )
+    {
+        if ( bodyparts[b].nummodels > 1 )
+        {
+            space *= bodyparts[b].nummodels;
+        }
+    }
+
+    return space < LM_CROWD_MAX_VARIANTS ? space : LM_CROWD_MAX_VARIANTS;
+}
+
+static void crowd_pick_variants( lm_crowd_t *crowd, unsigned int *rng )
+{
+    const studiohdr_t        *header    = crowd->header;
+    const mstudiobodyparts_t *bodyparts = ( const mstudiobodyparts_t * ) ( crowd->data + header->bodypartindex );
+    const int                 wanted    = crowd_variant_space( header, crowd->data );
+
+    // The first variant is what the single-model viewer shows
+    crowd->variants[0].bodygroup = 0;
+    crowd->variants[0].skin      = 0;
+    crowd->num_variants          = 1;
+
+    for ( int attempt = 0; crowd->num_variants < wanted && attempt < wanted * 16; ++attempt )
+    {
+        int bodygroup = 0;
+        for ( int b = 0; b < header->numbodyparts; ++b )
+        {
+            if ( bodyparts[b].nummodels > 1 )
+            {
+                bodygroup += ( int ) ( crowd_random( rng ) % ( unsigned int ) bodyparts[b].nummodels ) * bodyparts[b].base;
+            }
+        }
+
+        int skin = header->numskinfamilies > 1 ? ( int ) ( crowd_random( rng ) % ( unsigned int ) header->numskinfamilies ) : 0;
+
+        bool seen = false;
+        for ( int v = 0; v < crowd->num_variants && !seen; ++v )
+        {
+            seen = crowd->variants[v].bodygroup == bodygroup && crowd->variants[v].skin == skin;
+        }
+
+        if ( !seen )
+        {
+            crowd->variants[crowd->num_variants].bodygroup = bodygroup;
+            crowd->variants[crowd->num_variants].skin      = skin;
+            crowd->num_variants++;
+        }
+    }
+}
+
+/*
+ * Members are stored grouped by variant (a counting sort of random picks),
+ * so each variant's palettes are one contiguous block an instanced draw can
+ * walk with gl_InstanceID.
+ */
+static void crowd_assign_variants( lm_crowd_t *crowd, unsigned int *rng )
+{
+    int counts[LM_CROWD_MAX_VARIANTS] = { 0 };
+
+    for ( int i = 0; i < crowd->num_members; ++i )
+    {
+        counts[crowd_random( rng ) % ( unsigned int ) crowd->num_variants]++;
+    }
+
+    int first = 0;
+    for ( int v = 0; v < crowd->num_variants; ++v )
+    {
+        crowd->variants[v].first = first;
+        crowd->variants[v].count = counts[v];
+
+        for ( int i = first; i < first + counts[v]; ++i )
+        {
+            crowd->members[i].variant = v;
+        }
+
+        first += counts[v];
+    }
+}
+
+static void crowd_assign_sequences( lm_crowd_t *crowd, unsigned int *rng )
+{
+    int *playable     = NULL;
+    int  num_playable = 0;
+
+    if ( crowd->header->numseq > 0 )
+    {
+        playable = malloc( ( size_t ) crowd->header->numseq * sizeof( *playable ) );
+    }
+
+    for ( int s = 0; playable && s < crowd->header->numseq; ++s )
+    {
+        if ( crowd_sequence_playable( crowd, s ) )
+        {
+            playable[num_playable++] = s;
+        }
+    }
+
+    for ( int i = 0; i < crowd->num_members; ++i )
+    {
+        lm_crowd_member_t *member = &crowd->members[i];
+        mdl_animation_init( &member->anim );
+
+        if ( crowd->header->numseq <= 0 )
+        {
+            continue;
+        }
+
+        int seq = num_playable > 0 ? playable[crowd_random( rng ) % ( unsigned int ) num_playable] : 0;
+        mdl_animation_set_sequence( &member->anim, seq, crowd->header, crowd->data, crowd->seqgroups );
+
+        // Random phase so the crowd does not move in lockstep
+        int numframes = crowd_sequences( crowd )[seq].numframes;
+        if ( numframes > 1 )
+        {
+            member->anim.current_frame = crowd_random_unit( rng ) * ( float ) ( numframes - 1 );
+        }
+    }
+
+    free( playable );
+}
+
+/*
+ * Square grid on the ground plane, one cell per member with a quarter of the
+ * model's footprint as a gap. Cells are handed out in shuffled order so the
+ * variants (stored contiguously) end up mixed.
+ */
+static void crowd_layout_grid( lm_crowd_t *crowd, unsigned int *rng )
+{
+    const studiohdr_t *header = crowd->header;
+
+    // Hull box if the model has one, else the clipping box, else a player-sized 32 units
+    float footprint = 0.0f;
+    for ( int axis = 0; axis < 2; ++axis )
+    {
+        float hull = header->max[axis] - header->min[axis];
+        float clip = header->bbmax[axis] - header->bbmin[axis];
+        footprint  = fmaxf( footprint, fmaxf( hull, clip ) );
+    }
+    if ( !( footprint > 0.0f ) )
+    {
+        footprint = 32.0f;
+    }
+
+    const float extent = footprint * CROWD_VIEWER_SCALE * 1.25f;
+
+    int side = ( int ) ceil( sqrt( ( double ) crowd->num_members ) );
+
+    int *cells = malloc( ( size_t ) crowd->num_members * sizeof( *cells ) );
+    if ( !cells )
+    {
+        return;
+    }
+
+    for ( int i = 0; i < crowd->num_members; ++i )
+    {
+        cells[i] = i;
+    }
+    for ( int i = crowd->num_members - 1; i > 0; --i )
+    {
+        int j    = ( int ) ( crowd_random( rng ) % ( unsigned int ) ( i + 1 ) );
+        int t    = cells[i];
+        cells[i] = cells[j];
+        cells[j] = t;
+    }
+
+    const float center = ( float ) ( side - 1 ) * 0.5f;
+    for ( int i = 0; i < crowd->num_members; ++i )
+    {
+        crowd->members[i].origin[0] = ( ( float ) ( cells[i] % side ) - center ) * extent;
+        crowd->members[i].origin[1] = 0.0f;
+        crowd->members[i].origin[2] = ( ( float ) ( cells[i] / side ) - center ) * extent;
+    }
+
+    free( cells );
+
+    // Pull the camera back until the whole grid fits and tilt it so the rows do not hide each other
+    float fit = 5.0f / ( ( float ) side * extent * 1.5f );
+    if ( fit < zoom )
+    {
+        zoom = fit < 0.01f ? 0.01f : fit;
+    }
+    rotation_x = 0.5f;
+}
+
+static bool crowd_create_palette( lm_crowd_t *crowd )
+{
+    crowd->palette_bytes = ( size_t ) crowd->num_members * ( size_t ) crowd->palette_bones * 12 * sizeof( float );
+
+    crowd->palette = malloc( crowd->palette_bytes );
+    if ( !crowd->palette )
+    {
+        fprintf( stderr, "ERROR - Failed to allocate %zu bytes of crowd bone palettes!\n", crowd->palette_bytes );
+        return false;
+    }
+
+    // Region size is a whole number of RGBA32F texels, so every region offset is a texel index
+    if ( !stream_buffer_create( &crowd->palette_stream, crowd->palette_bytes ) )
+    {
+        fprintf( stderr, "ERROR - Failed to create the crowd palette buffer!\n" );
+        return false;
+    }
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    glGenTextures( 1, &crowd->palette_texture );
+    glBindTexture( GL_TEXTURE_BUFFER, crowd->palette_texture );
+    glTexBuffer( GL_TEXTURE_BUFFER, GL_RGBA32F, crowd->palette_stream.buffer );
+    glBindTexture( GL_TEXTURE_BUFFER, 0 );
+
+    glGenQueries( LM_CROWD_TIMER_QUERIES, crowd->timer_queries );
+    return true;
+}
+
+lm_crowd_t *lm_crowd_create(
+    lm_render_context_t *ctx,
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups,
+    int                  count,
+    bool                 grid )
+{
+    if ( !header || !data || count <= 0 )
+    {
+        LOG_ERRORF( "crowd", "Invalid crowd parameters" );
+        return NULL;
+    }
+
+    if ( !ctx->crowd_program )
+    {
+        fprintf( stderr, "ERROR - Instanced crowds need crowd.vert, which failed to load!\n" );
+        return NULL;
+    }
+
+    const int bones = header->numbones < 1 ? 1 : ( header->numbones > MAXSTUDIOBONES ? MAXSTUDIOBONES : header->numbones );
+
+    // Every ring region must fit in the texture buffer, three rows (texels) per bone
+    GLint max_texels = 0;
+    glGetIntegerv( GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels );
+    long long fit = ( long long ) max_texels / ( STREAM_BUFFER_REGIONS * bones * 3 );
+    if ( fit < 1 )
+    {
+        fprintf( stderr, "ERROR - Texture buffers are too small for a bone palette!\n" );
+        return NULL;
+    }
+    if ( count > fit )
+    {
+        LOG_WARNF( "crowd", "GL_MAX_TEXTURE_BUFFER_SIZE (%d texels) limits the crowd to %lld instances", max_texels, fit );
+        count = ( int ) fit;
+    }
+
+    if ( ctx->crowd )
+    {
+        lm_crowd_destroy( ctx, ctx->crowd );
+    }
+
+    lm_crowd_t *crowd = calloc( 1, sizeof( *crowd ) );
+    if ( !crowd )
+    {
+        fprintf( stderr, "ERROR - Failed to allocate the crowd!\n" );
+        return NULL;
+    }
+
+    crowd->header        = header;
+    crowd->data          = data;
+    crowd->seqgroups     = seqgroups;
+    crowd->num_seqgroups = num_seqgroups;
+    crowd->num_members   = count;
+    crowd->palette_bones = bones;
+    crowd->animated      = header->numseq > 0;
+    ctx->crowd           = crowd;
+
+    crowd->members = calloc( ( size_t ) count, sizeof( *crowd->members ) );
+    if ( !crowd->members )
+    {
+        fprintf( stderr, "ERROR - Failed to allocate %d crowd members!\n", count );
+        lm_crowd_destroy( ctx, crowd );
+        return NULL;
+    }
+
+    unsigned int rng = CROWD_SEED;
+
+    crowd_pick_variants( crowd, &rng );
+    crowd_assign_variants( crowd, &rng );
+    crowd_assign_sequences( crowd, &rng );
+    if ( grid )
+    {
+        crowd_layout_grid( crowd, &rng );
+    }
+
+    // Members whose sequence cannot play stand in the bind pose
+    SetUpBonesInto( header, data, crowd->bind_pose );
+
+    if ( !crowd_create_palette( crowd ) )
+    {
+        lm_crowd_destroy( ctx, crowd );
+        return NULL;
+    }
+
+    // One detached instance per variant holds its topology and textures
+    for ( int v = 0; v < crowd->num_variants; ++v )
+    {
+        lm_crowd_variant_t  *variant = &crowd->variants[v];
+        lm_model_instance_t *inst    = lm_instance_create_detached(
+            ctx, header, data, tex_header, tex_data, seqgroups, num_seqgroups );
+
+        if ( !inst )
+        {
+            lm_crowd_destroy( ctx, crowd );
+            return NULL;
+        }
+
+        variant->topology = inst;
+        lm_instance_set_bodygroup( inst, variant->bodygroup );
+        lm_instance_set_skin( inst, variant->skin );
+
+        if ( !lm_instance_prepare_instanced( ctx, inst ) )
+        {
+            LOG_WARNF( "crowd", "Variant %d (bodygroup %d, skin %d) has nothing to draw", v, variant->bodygroup, variant->skin );
+        }
+    }
+
+    LOG_INFOF(
+        "crowd",
+        "Crowd: %d instances, %d variants, %d bones each, %.1f KB of palettes per frame",
+        crowd->num_members,
+        crowd->num_variants,
+        crowd->palette_bones,
+        ( double ) crowd->palette_bytes / 1024.0 );
+
+    return crowd;
+}
+
+static void crowd_report( const lm_crowd_t *crowd )
+{
+    if ( crowd->pose_frames == 0 )
+    {
+        return;
+    }
+
+    double pose_ms = crowd->pose_ms / crowd->pose_frames;
+    double gpu_ms  = crowd->gpu_frames > 0 ? crowd->gpu_ms / crowd->gpu_frames : 0.0;
+
+    LOG_INFOF(
+        "crowd",
+        "Crowd: %d instances - CPU pose %.3f ms/frame (%.1f instances/ms), GPU %.3f ms/frame (%.1f instances/ms)",
+        crowd->num_members,
+        pose_ms,
+        pose_ms > 0.0 ? crowd->num_members / pose_ms : 0.0,
+        gpu_ms,
+        gpu_ms > 0.0 ? crowd->num_members / gpu_ms : 0.0 );
+}
+
+void lm_crowd_destroy( lm_render_context_t *ctx, lm_crowd_t *crowd )
+{
+    if ( !crowd )
+        return;
+
+    crowd_report( crowd );
+
+    if ( ctx->crowd == crowd )
+    {
+        ctx->crowd = NULL;
+    }
+
+    for ( int v = 0; v < crowd->num_variants; ++v )
+    {
+        lm_instance_destroy( ctx, crowd->variants[v].topology );
+    }
+
+    if ( crowd->timer_queries[0] )
+        glDeleteQueries( LM_CROWD_TIMER_QUERIES, crowd->timer_queries );
+    if ( crowd->palette_texture )
+        glDeleteTextures( 1, &crowd->palette_texture );
+    stream_buffer_destroy( &crowd->palette_stream );
+
+    free( crowd->palette );
+    free( crowd->members );
+    free( crowd );
+}
+
+bool lm_crowd_is_playing( const lm_crowd_t *crowd )
+{
+    if ( !crowd->animated )
+    {
+        return false;
+    }
+
+    mstudioseqdesc_t *sequences = crowd_sequences( crowd );
+
+    for ( int i = 0; i < crowd->num_members; ++i )
+    {
+        const mdl_animation_state_t *anim = &crowd->members[i].anim;
+        const mstudioseqdesc_t      *seq  = &sequences[anim->current_sequence];
+
+        if ( seq->numframes > 1 && seq->fps > 0.0f
+             && ( anim->is_looping || anim->current_frame < ( float ) ( seq->numframes - 1 ) ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void lm_crowd_advance( lm_crowd_t *crowd, float delta_time )
+{
+    for ( int i = 0; i < crowd->num_members; ++i )
+    {
+        mdl_animation_update( &crowd->members[i].anim, delta_time, crowd->header, crowd->data, crowd->seqgroups );
+    }
+}
+
+/*
+ * Same packing as the renderer's PackBoneRows(): 3x4 rows with the Z-up ->
+ * Y-up remap and scale folded in, plus the member's origin on the
+ * translation column.
+ */
+static void crowd_pack_rows( const lm_crowd_t *crowd, const mat4 *bones, const vec3 origin, float *rows )
+{
+    for ( int b = 0; b < crowd->palette_bones; ++b )
+    {
+        float *row = &rows[b * 12];
+
+        // cglm is column-major: row r of the affine part is m[0..3][r]
+        for ( int col = 0; col < 4; ++col )
+        {
+            row[0 + col] = bones[b][col][0] * CROWD_VIEWER_SCALE;
+            row[4 + col] = bones[b][col][2] * CROWD_VIEWER_SCALE;
+            row[8 + col] = -bones[b][col][1] * CROWD_VIEWER_SCALE;
+        }
+
+        row[3] += origin[0];
+        row[7] += origin[1];
+        row[11] += origin[2];
+    }
+}
+
+// Job body: poses and packs members [begin, end) with its own bone scratch
+static void crowd_pose_range( void *arg, int begin, int end )
+{
+    lm_crowd_t *crowd = arg;
+    mat4        scratch[MAXSTUDIOBONES];
+
+    for ( int i = begin; i < end; ++i )
+    {
+        lm_crowd_member_t *member = &crowd->members[i];
+        const mat4        *bones  = ( const mat4 * ) crowd->bind_pose;
+
+        if ( crowd->animated
+             && mdl_animation_calculate_bones( &member->anim, crowd->header, crowd->data, crowd->seqgroups, scratch )
+                    == MDL_SUCCESS )
+        {
+            bones = ( const mat4 * ) scratch;
+        }
+
+        crowd_pack_rows( crowd, bones, member->origin, &crowd->palette[( size_t ) i * crowd->palette_bones * 12] );
+    }
+}
+
+void lm_crowd_pose( lm_crowd_t *crowd )
+{
+    // A crowd without sequences never moves; its palette is packed once
+    if ( !crowd->animated && crowd->pose_frames > 0 )
+    {
+        return;
+    }
+
+    double start = glfwGetTime( );
+
+    // Members are independent, each writes only its own palette block
+    job_parallel_for( "crowd pose", crowd->num_members, CROWD_POSE_GRAIN, crowd_pose_range, crowd );
+
+    crowd->pose_ms += ( glfwGetTime( ) - start ) * 1000.0;
+    crowd->pose_frames++;
+}
+
+// Collects finished GL_TIME_ELAPSED results without waiting on the GPU
+static void crowd_collect_timers( lm_crowd_t *crowd )
+{
+    for ( int q = 0; q < LM_CROWD_TIMER_QUERIES; ++q )
+    {
+        if ( !crowd->timer_pending[q] )
+            continue;
+
+        GLuint available = 0;
+        glGetQueryObjectuiv( crowd->timer_queries[q], GL_QUERY_RESULT_AVAILABLE, &available );
+        if ( !available )
+            continue;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v( crowd->timer_queries[q], GL_QUERY_RESULT, &ns );
+        crowd->gpu_ms += ( double ) ns / 1.0e6;
+        crowd->gpu_frames++;
+        crowd->timer_pending[q] = false;
+    }
+}
+
+void lm_crowd_draw(
+    const lm_render_context_t *ctx, lm_crowd_t *crowd, mat4 scene, mat4 view, mat4 projection, vec3 camera_pos )
+{
+    crowd_collect_timers( crowd );
+
+    void *dst = stream_buffer_map( &crowd->palette_stream, crowd->palette_bytes );
+    if ( !dst )
+    {
+        return;
+    }
+    memcpy( dst, crowd->palette, crowd->palette_bytes );
+    stream_buffer_unmap( &crowd->palette_stream );
+
+    // A query still in flight from LM_CROWD_TIMER_QUERIES frames ago is skipped, not waited on
+    const int  query    = crowd->timer_next;
+    const bool timed    = !crowd->timer_pending[query];
+    crowd->timer_next = ( crowd->timer_next + 1 ) % LM_CROWD_TIMER_QUERIES;
+    if ( timed )
+    {
+        glBeginQuery( GL_TIME_ELAPSED, crowd->timer_queries[query] );
+    }
+
+    // Every variant's textures were loaded in the same mode
+    const bool   palettized = crowd->num_variants > 0 && crowd->variants[0].topology->textures.mode == MDL_TEXTURE_PALETTE;
+    const GLuint program    = palettized ? ctx->crowd_palette_program : ctx->crowd_program;
+    glUseProgram( program );
+
+    GLint uModel = glGetUniformLocation( program, "model" );
+    GLint uView  = glGetUniformLocation( program, "view" );
+    GLint uProj  = glGetUniformLocation( program, "projection" );
+    if ( uModel != -1 )
+        glUniformMatrix4fv( uModel, 1, GL_FALSE, ( const float * ) scene );
+    if ( uView != -1 )
+        glUniformMatrix4fv( uView, 1, GL_FALSE, ( const float * ) view );
+    if ( uProj != -1 )
+        glUniformMatrix4fv( uProj, 1, GL_FALSE, ( const float * ) projection );
+
+    vec3  lightPos = { 3.0f, 5.0f, 4.0f };
+    GLint uLight   = glGetUniformLocation( program, "lightPos" );
+    GLint uViewP   = glGetUniformLocation( program, "viewPos" );
+    if ( uLight != -1 )
+        glUniform3fv( uLight, 1, ( const float * ) lightPos );
+    if ( uViewP != -1 )
+        glUniform3fv( uViewP, 1, ( const float * ) camera_pos );
+
+    GLint uTex     = glGetUniformLocation( program, "tex" );
+    GLint uPalette = glGetUniformLocation( program, "bonePalette" );
+    GLint uBones   = glGetUniformLocation( program, "bonesPerInstance" );
+    GLint uBase    = glGetUniformLocation( program, "paletteBase" );
+    if ( uTex != -1 )
+        glUniform1i( uTex, 0 );
+    if ( uPalette != -1 )
+        glUniform1i( uPalette, 1 );
+    if ( uBones != -1 )
+        glUniform1i( uBones, crowd->palette_bones );
+
+    GLint uColors = glGetUniformLocation( program, "palette" );
+    GLint uMasked = glGetUniformLocation( program, "masked" );
+    if ( uColors != -1 )
+        glUniform1i( uColors, LM_PALETTE_TEXTURE_UNIT );
+
+    glActiveTexture( GL_TEXTURE1 );
+    glBindTexture( GL_TEXTURE_BUFFER, crowd->palette_texture );
+
+    // The region offset is a multiple of 16 bytes, i.e. a whole texel
+    const GLint region_texel = ( GLint ) ( stream_buffer_offset( &crowd->palette_stream ) / ( 4 * sizeof( float ) ) );
+
+    for ( int v = 0; v < crowd->num_variants; ++v )
+    {
+        const lm_crowd_variant_t  *variant = &crowd->variants[v];
+        const lm_model_instance_t *inst    = variant->topology;
+
+        if ( variant->count == 0 || inst->num_vertices == 0 )
+            continue;
+
+        // GLSL 4.1 has no gl_BaseInstance, so each variant's first member is passed explicitly
+        if ( uBase != -1 )
+            glUniform1i( uBase, region_texel + variant->first * crowd->palette_bones * 3 );
+
+        glBindVertexArray( inst->skinned_vao );
+
+        const SkinBinding *skins = lm_instance_skins( inst );
+
+        for ( int r = 0; r < inst->num_ranges; ++r )
+        {
+            const DrawRange   *range = &inst->ranges[r];
+            const SkinBinding *skin  = &skins[range->skinref];
+            if ( palettized )
+            {
+                glActiveTexture( GL_TEXTURE0 + LM_PALETTE_TEXTURE_UNIT );
+                glBindTexture( GL_TEXTURE_2D, skin->palette ? skin->palette : ctx->white_palette );
+                if ( uMasked != -1 )
+                    glUniform1i( uMasked, skin->masked );
+            }
+            glActiveTexture( GL_TEXTURE0 );
+            glBindTexture( GL_TEXTURE_2D, skin->tex ? skin->tex : ctx->white_tex );
+
+            if ( inst->indexed )
+            {
+                glDrawElementsInstanced(
+                    GL_TRIANGLES, range->count, range->index_type, ( const void * ) range->index_offset, variant->count );
+            }
+            else
+            {
+                glDrawArraysInstanced( GL_TRIANGLES, range->first, range->count, variant->count );
+            }
+        }
+    }
+
+    glBindVertexArray( 0 );
+    glActiveTexture( GL_TEXTURE1 );
+    glBindTexture( GL_TEXTURE_BUFFER, 0 );
+    glActiveTexture( GL_TEXTURE0 );
+
+    if ( timed )
+    {
+        glEndQuery( GL_TIME_ELAPSED );
+        crowd->timer_pending[query] = true;
+    }
+
+    // The ring region these draws read is off limits until the GPU passes this point
+    stream_buffer_fence( &crowd->palette_stream );
+
+    if ( ++crowd->report_frames == CROWD_REPORT_FRAMES )
+    {
+        crowd_report( crowd );
+        crowd->report_frames = 0;
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#include "../studio.h"
+#include "../mdl/mdl_animations.h"
+#include "../mdl/mdl_loader.h"
+#include "gl_platform.h"
+#include "render_context.h"
+#include "stream_buffer.h"
+
+#include <cglm/cglm.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Instanced crowd (--instances N): many copies of one model, each with its
+ * own animation clock, sequence, frame offset, bodygroup and skin, drawn
+ * with one glDrawElementsInstanced per texture range and variant.
+ *
+ * Members that share a (bodygroup, skin) pair share one variant: a detached
+ * lm_model_instance_t that holds the GPU-skinned topology and textures.
+ * Members are kept sorted by variant so each variant's palettes are one
+ * contiguous run. Every member's 3x4 bone rows, origin included, go into a
+ * single texture buffer streamed through a fenced stream_buffer_t ring.
+ */
+#define LM_CROWD_MAX_VARIANTS 16
+#define LM_CROWD_TIMER_QUERIES 4
+
+typedef struct {
+    mdl_animation_state_t anim;
+    int                   variant;
+    vec3                  origin;    // viewer space, after the axis remap and scale
+} lm_crowd_member_t;
+
+typedef struct {
+    int                  bodygroup;
+    int                  skin;
+    lm_model_instance_t *topology;    // detached, owned by the crowd
+    int                  first;       // first member using this variant
+    int                  count;
+} lm_crowd_variant_t;
+
+typedef struct lm_crowd_s {
+    studiohdr_t         *header;
+    unsigned char       *data;
+    mdl_seqgroup_blob_t *seqgroups;
+    int                  num_seqgroups;
+
+    lm_crowd_member_t *members;
+    int                num_members;
+    lm_crowd_variant_t variants[LM_CROWD_MAX_VARIANTS];
+    int                num_variants;
+    bool               animated;
+
+    // numbones * 12 floats per member, rebuilt by lm_crowd_pose()
+    int             palette_bones;
+    float          *palette;
+    size_t          palette_bytes;
+    stream_buffer_t palette_stream;
+    GLuint          palette_texture;
+    mat4            bind_pose[MAXSTUDIOBONES];    // fallback while a sequence cannot play
+
+    // GL_TIME_ELAPSED queries, read back a few frames late so they never stall
+    GLuint timer_queries[LM_CROWD_TIMER_QUERIES];
+    bool   timer_pending[LM_CROWD_TIMER_QUERIES];
+    int    timer_next;
+
+    // Throughput counters, logged periodically and on destroy
+    int    pose_frames;
+    double pose_ms;
+    int    gpu_frames;
+    double gpu_ms;
+    int    report_frames;
+} lm_crowd_t;
+
+/*
+ * Creates `count` members of the model and makes the crowd the context's
+ * (ctx->crowd). With `grid` the members stand on a square grid sized from the
+ * model's bounding box; otherwise they all share the origin. Returns NULL on
+ * failure, e.g. without the crowd shader or texture buffer support.
+ */
+lm_crowd_t *lm_crowd_create(
+    lm_render_context_t *ctx,
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups,
+    int                  count,
+    bool                 grid );
+
+void lm_crowd_destroy( lm_render_context_t *ctx, lm_crowd_t *crowd );
+
+bool lm_crowd_is_playing( const lm_crowd_t *crowd );
+void lm_crowd_advance( lm_crowd_t *crowd, float delta_time );
+
+// CPU only: poses every member and packs the palettes, spread over the job system
+void lm_crowd_pose( lm_crowd_t *crowd );
+
+// GL thread: streams the palettes and draws every variant instanced
+void lm_crowd_draw(
+    const lm_render_context_t *ctx,
+    lm_crowd_t                *crowd,
+    mat4                       scene,
+    mat4                       view,
+    mat4                       projection,
+    vec3                       camera_pos );
+
+#endif    // CROWD_H
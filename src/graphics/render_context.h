@@ -0,0 +1,253 @@
+#ifndef RENDER_CONTEXT_H
+#define RENDER_CONTEXT_H
+
+#include "../studio.h"
+#include "../mdl/mdl_animations.h"
+#include "../mdl/mdl_loader.h"
+#include "../mdl/mdl_mesh.h"
+#include "gl_platform.h"
+#include "stream_buffer.h"
+#include "textures.h"
+
+#include <cglm/cglm.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Per-model renderer state.
+ *
+ * An lm_model_instance_t owns everything one drawn model needs: its pose,
+ * animation clock, decoded topology, skinning output and GL objects. The
+ * lm_render_context_t owns what every instance shares (shader programs,
+ * fallback texture, draw options) and the list of instances it draws each
+ * frame. The model data itself stays owned by the caller's mdl_model_t and
+ * must outlive the instance.
+ *
+ * lm_instance_pose() is pure CPU work on the instance (bones, topology,
+ * skinning) and touches no GL state; lm_instance_draw() does the uploads and
+ * draw calls and must run on the thread that owns the GL context.
+ */
+
+// Texture unit of a palettized texture's palette (unit 1 holds the crowd's bone palettes)
+#define LM_PALETTE_TEXTURE_UNIT 2
+
+// What one skinref draws with under one skin family
+typedef struct {
+    GLuint tex;        // GL texture to bind
+    GLuint palette;    // its palette texture (palettized textures), else 0
+    bool   masked;     // STUDIO_NF_MASKED: the palette shader cuts out index 255
+    int    texture;    // index into the instance's texture set, -1 for the white fallback
+} SkinBinding;
+
+typedef struct {
+    int    skinref;         // column of the instance's skin bindings, resolved at draw time
+    int    first;           // first vertex in the big VBO (glDrawArrays)
+    int    count;           // how many vertices / indices to draw
+    GLenum index_type;      // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT (indexed)
+    size_t index_offset;    // byte offset into the EBO (indexed)
+} DrawRange;
+
+typedef struct {
+    short vertex;
+    short normal;
+    float u;
+    float v;
+} RenderCorner;
+
+typedef struct {
+    mstudiomodel_t *model;         // selected submodel for this bodypart
+    int             first;         // first corner
+    int             count;         // corners belonging to the submodel
+    int             first_vert;    // slice of skinned_positions holding model->numverts
+    int             first_norm;    // slice of skinned_normals holding model->numnorms
+} RenderPart;
+
+typedef struct {
+    float         pos[3];
+    float         normal[3];
+    float         uv[2];
+    unsigned char bones[4];    // vertex bone, normal bone, unused, unused
+} SkinnedVertex;
+
+typedef struct {
+    unsigned char *block;
+    size_t         capacity;
+    size_t         used;
+} RenderArena;
+
+typedef struct {
+    // Model data, owned by the caller
+    studiohdr_t         *header;
+    unsigned char       *data;
+    studiohdr_t         *tex_header;    // may be NULL
+    unsigned char       *tex_data;      // may be NULL
+    mdl_seqgroup_blob_t *seqgroups;
+    int                  num_seqgroups;
+
+    mdl_texture_set_t textures;
+
+    /*
+     * Skin families x skinrefs, built with the textures: the draw resolves
+     * each range through the row of the current family, so switching skins
+     * only rebuilds the topology when some family's skin differs in size (or
+     * atlas rectangle), which would move the UVs.
+     */
+    SkinBinding *skin_bindings;
+    int          skin_families;
+    int          skin_columns;      // skinrefs (or textures, if more) + the white fallback
+    bool         skin_uv_shared;    // no family changes the UVs
+
+    // Placement, submodel and skin selection
+    vec3 origin;            // added after the viewer's axis remap and scale
+    int  bodygroup;         // packed per-bodypart submodel choice, as in studio models
+    int  skin;              // skin family, clamped to the model's numskinfamilies
+    bool skinned_layout;    // always build the GPU-skinned layout (instanced crowds)
+
+    // Animation and pose
+    mdl_animation_state_t anim;
+    bool                  animation_enabled;
+    mat4                  bones[MAXSTUDIOBONES];
+
+    // Decoded topology, rebuilt whenever processed is cleared
+    bool                 processed;
+    RenderArena          arena;    // backs every pointer below up to skinned_vertices
+    DrawRange           *ranges;
+    int                  num_ranges;
+    RenderCorner        *corners;
+    int                  corner_capacity;
+    int                  num_vertices;
+    RenderPart           parts[MAXSTUDIOBODYPARTS];
+    int                  num_parts;
+    mdl_tricmd_vertex_t *tricmd_scratch;    // the largest mesh, decoded
+    mdl_tricmd_vertex_t *weld_unique;
+    unsigned int        *weld_indices;
+    int                  scratch_capacity;
+    unsigned char       *index_data;
+    size_t               index_capacity;    // bytes
+    size_t               index_bytes;
+    int                  num_indices;
+    bool                 indexed;        // what the topology was built as
+    bool                 gpu_skinned;    // ...
+    mdl_vcache_stats_t   vcache_before;
+    mdl_vcache_stats_t   vcache_after;
+
+    // Skinning output
+    vec3          *skinned_positions;    // every selected submodel's numverts, one slice per part
+    vec3          *skinned_normals;      // ... and numnorms
+    float         *vertices;             // 3 pos + 3 normal + 2 uv per corner
+    SkinnedVertex *skinned_vertices;     // per corner, GPU-skinned topologies only
+    float          bone_rows[MAXSTUDIOBONES * 12];
+    bool           vertices_dirty;
+    bool           skinned_vertices_dirty;
+    bool           bone_rows_dirty;
+    bool           indices_dirty;
+
+    // GL objects, each VAO configured once at creation
+    GLuint          vbo;    // CPU-skinned vertices that stay put (static models, paused)
+    GLuint          vao;
+    GLuint          ebo;
+    GLuint          stream_vao;    // same layout as vao, sourced from stream
+    GLuint          skinned_vbo;
+    GLuint          skinned_vao;
+    GLuint          bone_ubo;    // 0 without the skinning program
+    stream_buffer_t stream;
+    size_t          vbo_capacity;    // bytes allocated in vbo
+    GLuint          draw_vao;        // vao or stream_vao, whichever holds the latest vertices
+    GLint           draw_base_vertex;
+} lm_model_instance_t;
+
+typedef struct {
+    GLuint shader_program;
+    GLuint skinned_program;    // 0 if unavailable
+    GLuint crowd_program;      // crowd.vert + textured.frag, 0 if unavailable
+    GLuint white_tex;
+
+    // textured_palette.frag twins of the programs above, all 0 if unavailable
+    GLuint palette_program;
+    GLuint skinned_palette_program;
+    GLuint crowd_palette_program;
+    GLuint white_palette;    // 256x1 all white, drawn with white_tex
+
+    bool indexed_draw;       // --no-index turns it off
+    bool vcache_optimize;    // --no-vcache-opt turns it off
+    bool gpu_skinning;       // --gpu-skinning
+    bool palette_textures;   // --palette-textures, for instances created afterwards
+    bool atlas_textures;     // --atlas, likewise; --palette-textures wins over it
+
+    lm_model_instance_t **instances;    // drawn in order every frame
+    int                   num_instances;
+    int                   instance_capacity;
+    lm_model_instance_t  *active;    // target of the keyboard animation controls
+
+    struct lm_crowd_s *crowd;    // drawn after the instances, NULL outside crowd mode
+} lm_render_context_t;
+
+// The window's context; valid between init_renderer() and cleanup_renderer()
+lm_render_context_t *lm_render_context( void );
+
+/*
+ * Loads the instance's textures, creates its GL objects and starts its first
+ * sequence. The new instance is appended to the context's draw list and
+ * becomes the active one. Returns NULL on failure.
+ */
+lm_model_instance_t *lm_instance_create(
+    lm_render_context_t *ctx,
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups );
+
+/*
+ * Same as lm_instance_create(), but the instance is not added to the draw
+ * list and never becomes active. The caller draws it (see crowd.c) and
+ * destroys it with lm_instance_destroy().
+ */
+lm_model_instance_t *lm_instance_create_detached(
+    lm_render_context_t *ctx,
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups );
+
+void lm_instance_destroy( lm_render_context_t *ctx, lm_model_instance_t *inst );
+
+void lm_instance_set_origin( lm_model_instance_t *inst, vec3 origin );
+void lm_instance_set_bodygroup( lm_model_instance_t *inst, int bodygroup );
+void lm_instance_set_skin( lm_model_instance_t *inst, int skin );
+
+// The skin bindings of the instance's current family, indexed by DrawRange.skinref
+const SkinBinding *lm_instance_skins( const lm_model_instance_t *inst );
+
+// True while lm_instance_advance() would still move the pose
+bool lm_instance_is_playing( const lm_model_instance_t *inst );
+void lm_instance_advance( lm_model_instance_t *inst, float delta_time );
+
+// CPU only: (re)builds the topology if needed, then poses and skins the instance
+void lm_instance_pose( const lm_render_context_t *ctx, lm_model_instance_t *inst );
+
+/*
+ * GL thread: uploads what lm_instance_pose() changed and issues the draws.
+ * `scene` is the viewer's model rotation; the instance origin is applied
+ * on top of it.
+ */
+void lm_instance_draw(
+    const lm_render_context_t *ctx,
+    lm_model_instance_t       *inst,
+    mat4                       scene,
+    mat4                       view,
+    mat4                       projection,
+    vec3                       camera_pos );
+
+/*
+ * GL thread: builds the instance's topology in the GPU-skinned layout and
+ * uploads its static vertex and index buffers, for callers that draw
+ * skinned_vao themselves with their own bone palettes. Returns false if the
+ * model has nothing to draw.
+ */
+bool lm_instance_prepare_instanced( const lm_render_context_t *ctx, lm_model_instance_t *inst );
+
+#endif    // RENDER_CONTEXT_H
@@ -22,84 +22,83 @@
 
 #include "renderer.h"
 
+#include "../graphics/crowd.h"
 #include "../graphics/gl_platform.h"
+#include "../graphics/render_context.h"
+#include "../graphics/stream_buffer.h"
 #include "../graphics/textures.h"
-#include "../mdl/bodypart_manager.h"
 #include "../mdl/bone_system.h"
 #include "../mdl/mdl_animations.h"
+#include "../mdl/mdl_cache.h"
+#include "../mdl/mdl_mesh.h"
+#include "../mdl/mdl_skinning.h"
+#include "../utils/job_system.h"
 #include "../utils/logger.h"
 #include "../shaders/shader.h"
 
 #include <cglm/cglm.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>    // For getcwd
 
-#define MAX_DRAW_RANGES 4096
-
-typedef struct {
-    mstudiomodel_t *model;
-    vec3_t         *vertices;
-    vec3_t         *normals;
-    int             vertex_count;
-    int             normal_count;
-} current_model_data_t;
-
-
-
-typedef struct {
-    GLuint tex;      // GL texture to bind
-    int    first;    // first vertex in the big VBO
-    int    count;    // how many vertices to draw
-} DrawRange;
-
-static DrawRange g_ranges[MAX_DRAW_RANGES];
-static int       g_num_ranges = 0;
-
-static current_model_data_t g_current;
-
-static GLuint g_white_tex = 0;
-
-static vec3 skinned_positions[MAXSTUDIOVERTS];
-static bool have_skinned_positions = false;
+/*
+ * Everything per model lives in lm_model_instance_t (render_context.h); the
+ * context holds the shared programs and options plus the instances drawn
+ * each frame. What remains file-scope here belongs to the one window: input,
+ * camera and the render-on-demand clock.
+ */
+static lm_render_context_t g_context = { .indexed_draw = true, .vcache_optimize = true };
 
 GLFWwindow *window            = NULL;
 static bool wireframe_enabled = false;
 
-static unsigned int VBO             = 0;
-static unsigned int VAO             = 0;
-static unsigned int EBO             = 0;    // Element Buffer Object for indices
-static unsigned int shader_program  = 0;
 static unsigned int current_texture = 0;    // Currently bound texture
 
 extern float rotation_x;
 extern float rotation_y;
 extern float zoom;
 
-static bool bone_system_initialized = false;
-
-// PRE-ALLOCATED BUFFERS (NO MALLOC IN RENDER LOOP)
-#define MAX_RENDER_VERTICES 32768
-static float render_vertex_buffer[MAX_RENDER_VERTICES * 8];    // 3 pos + 3 normal + 2 uv
-static int   total_render_vertices = 0;
-static bool  model_processed       = false;
+/*
+ * Every per-topology array (draw ranges, corners, decode scratch, indices,
+ * vertex streams, skinned positions/normals) is carved out of one arena per
+ * instance. BuildMeshTopology() sizes it exactly from a pre-pass over the
+ * selected submodels' triangle commands, so nothing is clipped and memory
+ * follows the model instead of a worst case. It is only reallocated
+ * (geometrically) when a bodygroup change needs more, never in the render
+ * loop, and is released with the instance.
+ */
+#define RENDER_ARENA_ALIGN 16
 
-static studiohdr_t   *global_header = NULL;
-static unsigned char *global_data   = NULL;
+#define RENDER_VERTEX_SIZE ( 8 * sizeof( float ) )
 
-static studiohdr_t   *global_tex_header = NULL;
-static unsigned char *global_tex_data   = NULL;
+/*
+ * An instance's vertices reach the GPU one of two ways. While animating they
+ * are rewritten every frame and go into the next region of its stream ring,
+ * drawn with a base vertex so the VAO never has to be re-pointed. Otherwise
+ * they are copied into its VBO once per change and drawn from there until
+ * they change again.
+ *
+ * GPU skinning: the VBO holds model-space vertices plus their bone ids and is
+ * uploaded once per topology build. Each frame only the bone palette (three
+ * vec4 rows per bone, std140) goes into the instance's bone UBO.
+ */
+#define BONE_UBO_BINDING 0
 
-static mdl_texture_set_t g_textures = { NULL, 0 };
+static double g_last_frame_time = 0.0;
 
-// ANIMATIONS
-static mdl_animation_state_t g_anim_state;
-static bool                  g_animation_enabled = false;
-static double                g_last_frame_time   = 0.0;
+/*
+ * Render-on-demand: render_loop() only draws when g_redraw_requested is set
+ * (input, window refresh, model or option changes) or while an animation is
+ * playing, and otherwise sleeps in glfwWaitEventsTimeout(). --continuous
+ * restores the old draw-every-iteration loop.
+ */
+#define ANIM_REDRAW_INTERVAL ( 1.0 / 60.0 )    // animated frames are paced to at most this rate
+#define IDLE_WAIT_TIMEOUT    0.5               // seconds an idle loop sleeps between wakeups
 
-// SEQGROUPS -- > newly added for testing animations
-static mdl_seqgroup_blob_t *global_seqgroups     = NULL;
-static int                  global_num_seqgroups = 0;
+static bool g_render_on_demand = true;
+static bool g_redraw_requested = true;
 
 // Camera controls
 float rotation_x = 0.0f;
@@ -110,14 +109,14 @@ static bool   mouse_pressed = false;
 static double last_x = 400, last_y = 225;
 
 // Helper function to check if a sequence is available (has loaded sequence group data)
-static bool is_sequence_available( int seq_index )
+static bool is_sequence_available( const lm_model_instance_t *inst, int seq_index )
 {
-    if ( !global_header || !global_data || seq_index < 0 || seq_index >= global_header->numseq )
+    if ( !inst || seq_index < 0 || seq_index >= inst->header->numseq )
     {
         return false;
     }
 
-    mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( global_data + global_header->seqindex );
+    mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( inst->data + inst->header->seqindex );
     mstudioseqdesc_t *seq       = &sequences[seq_index];
     int               seqgroup  = seq->seqgroup;
 
@@ -127,13 +126,14 @@ static bool is_sequence_available( int seq_index )
         return true;
     }
 
-    // Check if external sequence group is loaded
-    if ( !global_seqgroups || seqgroup >= global_num_seqgroups )
+    // Check if external sequence group is loaded (or can still be loaded on demand)
+    if ( !inst->seqgroups || seqgroup >= inst->num_seqgroups )
     {
         return false;
     }
 
-    return ( global_seqgroups[seqgroup].data != NULL );
+    mdl_seqgroup_status_t status = mdl_seqgroup_status( &inst->seqgroups[seqgroup] );
+    return ( status != MDL_SEQGROUP_MISSING && status != MDL_SEQGROUP_FAILED );
 }
 
 static void glfw_mouse_callback( GLFWwindow *window, double xpos, double ypos )
@@ -145,6 +145,7 @@ static void glfw_mouse_callback( GLFWwindow *window, double xpos, double ypos )
 
         rotation_y += xoffset * 0.01f;
         rotation_x -= yoffset * 0.01f;
+        request_redraw( );
     }
 
     last_x = xpos;
@@ -166,6 +167,22 @@ static void glfw_scroll_callback( GLFWwindow *window, double xoffset, double yof
         zoom = 0.01f;
     if ( zoom > 2.0f )
         zoom = 2.0f;
+
+    request_redraw( );
+}
+
+static void glfw_refresh_callback( GLFWwindow *window )
+{
+    ( void ) window;
+    request_redraw( );
+}
+
+static void glfw_framebuffer_size_callback( GLFWwindow *window, int width, int height )
+{
+    ( void ) window;
+    ( void ) width;
+    ( void ) height;
+    request_redraw( );
 }
 
 static void glfw_error_callback( int error, const char *description )
@@ -173,6 +190,12 @@ static void glfw_error_callback( int error, const char *description )
     fprintf( stderr, "GLFW ERROR %d: %s\n", error, description );
 }
 
+// Skin family the instance draws with, clamped to the model's
+static int SkinFamily( const lm_model_instance_t *inst )
+{
+    return ( inst->skin > 0 && inst->skin < inst->skin_families ) ? inst->skin : 0;
+}
+
 static void glfw_key_callback( GLFWwindow *window, int key, int scancode, int action, int mods )
 {
     ( void ) scancode;    // Suppress unused parameter warning
@@ -186,6 +209,11 @@ static void glfw_key_callback( GLFWwindow *window, int key, int scancode, int ac
     // Camera controls
     if ( action == GLFW_PRESS || action == GLFW_REPEAT )
     {
+        // Every binding below changes the camera, the polygon mode, the skin or the animation
+        request_redraw( );
+
+        lm_model_instance_t *inst = g_context.active;
+
         switch ( key )
         {
         case GLFW_KEY_W:
@@ -236,26 +264,27 @@ static void glfw_key_callback( GLFWwindow *window, int key, int scancode, int ac
         */
 
         case GLFW_KEY_SPACE:
-            g_animation_enabled = !g_animation_enabled;
+            if ( inst )
+                inst->animation_enabled = !inst->animation_enabled;
             break;
 
         case GLFW_KEY_LEFT:
-            if ( global_header && g_anim_state.current_sequence > 0 )
+            if ( inst && inst->anim.current_sequence > 0 )
             {
                 // Try to find previous available sequence
-                int target_seq = g_anim_state.current_sequence - 1;
+                int target_seq = inst->anim.current_sequence - 1;
                 int attempts   = 0;
 
-                while ( target_seq >= 0 && !is_sequence_available( target_seq ) && attempts < global_header->numseq )
+                while ( target_seq >= 0 && !is_sequence_available( inst, target_seq )
+                        && attempts < inst->header->numseq )
                 {
                     target_seq--;
                     attempts++;
                 }
 
-                if ( target_seq >= 0 && is_sequence_available( target_seq ) )
+                if ( target_seq >= 0 && is_sequence_available( inst, target_seq ) )
                 {
-                    mdl_animation_set_sequence(
-                        &g_anim_state, target_seq, global_header, global_data, global_seqgroups );
+                    mdl_animation_set_sequence( &inst->anim, target_seq, inst->header, inst->data, inst->seqgroups );
                 }
             }
             else
@@ -264,24 +293,23 @@ static void glfw_key_callback( GLFWwindow *window, int key, int scancode, int ac
             }
             break;
         case GLFW_KEY_RIGHT:
-            if ( global_header && g_anim_state.current_sequence < global_header->numseq - 1 )
+            if ( inst && inst->anim.current_sequence < inst->header->numseq - 1 )
             {
                 // Try to find next available sequence
-                int target_seq = g_anim_state.current_sequence + 1;
+                int target_seq = inst->anim.current_sequence + 1;
                 int attempts   = 0;
 
-                while ( target_seq < global_header->numseq && !is_sequence_available( target_seq )
-                        && attempts < global_header->numseq )
+                while ( target_seq < inst->header->numseq && !is_sequence_available( inst, target_seq )
+                        && attempts < inst->header->numseq )
                 {
                     target_seq++;
                     attempts++;
                 }
 
-                if ( target_seq < global_header->numseq && is_sequence_available( target_seq ) )
+                if ( target_seq < inst->header->numseq && is_sequence_available( inst, target_seq ) )
                 {
-                    mdl_animation_set_sequence(
-                        &g_anim_state, target_seq, global_header, global_data, global_seqgroups );
-                    model_processed = false;    // Force reprocess
+                    mdl_animation_set_sequence( &inst->anim, target_seq, inst->header, inst->data, inst->seqgroups );
+                    inst->processed = false;    // Force reprocess
                 }
             }
             else
@@ -290,29 +318,41 @@ static void glfw_key_callback( GLFWwindow *window, int key, int scancode, int ac
             }
             break;
 
+        case GLFW_KEY_K:    // Next skin family
+            if ( inst && inst->skin_families > 1 )
+            {
+                lm_instance_set_skin( inst, ( SkinFamily( inst ) + 1 ) % inst->skin_families );
+                LOG_INFOF( "renderer", "Skin family %d/%d", SkinFamily( inst ), inst->skin_families - 1 );
+            }
+            break;
+
         case GLFW_KEY_L:    // Toggle looping
-            g_anim_state.is_looping = !g_anim_state.is_looping;
+            if ( inst )
+                inst->anim.is_looping = !inst->anim.is_looping;
             break;
 
         case GLFW_KEY_0:    // Reset to first frame
-            g_anim_state.current_frame = 0.0f;
-            model_processed            = false;
+            if ( inst )
+            {
+                inst->anim.current_frame = 0.0f;
+                inst->processed          = false;
+            }
             break;
         case GLFW_KEY_I:    // Print animation info
-            if ( global_header && global_header->numseq > 0 )
+            if ( inst && inst->header->numseq > 0 )
             {
-                mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( global_data + global_header->seqindex );
-                mstudioseqdesc_t *seq       = &sequences[g_anim_state.current_sequence];
+                mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( inst->data + inst->header->seqindex );
+                mstudioseqdesc_t *seq       = &sequences[inst->anim.current_sequence];
 
                 printf( "\n═══════════════════════════════════════\n" );
                 printf( "📊 ANIMATION INFO\n" );
                 printf( "═══════════════════════════════════════\n" );
-                printf( "Sequence:       %d/%d\n", g_anim_state.current_sequence, global_header->numseq - 1 );
+                printf( "Sequence:       %d/%d\n", inst->anim.current_sequence, inst->header->numseq - 1 );
                 printf( "Name:           %s\n", seq->label );
-                printf( "Current Frame:  %.2f/%d\n", g_anim_state.current_frame, seq->numframes - 1 );
+                printf( "Current Frame:  %.2f/%d\n", inst->anim.current_frame, seq->numframes - 1 );
                 printf( "FPS:            %.1f\n", seq->fps );
-                printf( "Looping:        %s\n", g_anim_state.is_looping ? "Yes" : "No" );
-                printf( "Animation:      %s\n", g_animation_enabled ? "ENABLED" : "DISABLED" );
+                printf( "Looping:        %s\n", inst->anim.is_looping ? "Yes" : "No" );
+                printf( "Animation:      %s\n", inst->animation_enabled ? "ENABLED" : "DISABLED" );
                 printf( "═══════════════════════════════════════\n\n" );
             }
             break;
@@ -320,64 +360,54 @@ static void glfw_key_callback( GLFWwindow *window, int key, int scancode, int ac
     }
 }
 
-float vertices[] = {
-    -0.5f,
-    -0.5f,
-    0.0f,    // Bottom left
-
-    0.5f,
-    -0.5f,
-    0.0f,    // Bottom right
-
-    0.0f,
-    0.5f,
-    0.0f    // Top center
-};
-
 // DIAGNOSTIC FUNCTION TO UNDERSTAND THE MODEL DATA
 void dump_complete_mdl_structure( void )
 {
-    if ( !global_header || !global_data )
+    const lm_model_instance_t *inst = g_context.active;
+    if ( !inst )
         return;
 
+    studiohdr_t   *header = inst->header;
+    unsigned char *data   = inst->data;
+
     printf( "\n===============================================\n" );
     printf( "COMPLETE MDL STRUCTURE DIAGNOSTIC\n" );
     printf( "===============================================\n" );
 
     // 1. Header info
     printf( "\n1. HEADER INFO:\n" );
-    printf( "   Model name: %s\n", global_header->name );
-    printf( "   File size: %d bytes\n", global_header->length );
+    printf( "   Model name: %s\n", header->name );
+    printf( "   File size: %d bytes\n", header->length );
     printf(
         "   Bounding box: (%.2f,%.2f,%.2f) to (%.2f,%.2f,%.2f)\n",
-        global_header->bbmin[0],
-        global_header->bbmin[1],
-        global_header->bbmin[2],
-        global_header->bbmax[0],
-        global_header->bbmax[1],
-        global_header->bbmax[2] );
+        header->bbmin[0],
+        header->bbmin[1],
+        header->bbmin[2],
+        header->bbmax[0],
+        header->bbmax[1],
+        header->bbmax[2] );
     printf(
         "   BBox dimensions: %.2f x %.2f x %.2f\n",
-        global_header->bbmax[0] - global_header->bbmin[0],
-        global_header->bbmax[1] - global_header->bbmin[1],
-        global_header->bbmax[2] - global_header->bbmin[2] );
+        header->bbmax[0] - header->bbmin[0],
+        header->bbmax[1] - header->bbmin[1],
+        header->bbmax[2] - header->bbmin[2] );
 
     // 2. Bodyparts
-    printf( "\n2. BODYPARTS (%d total):\n", global_header->numbodyparts );
-    mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( global_data + global_header->bodypartindex );
+    printf( "\n2. BODYPARTS (%d total):\n", header->numbodyparts );
+    mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( data + header->bodypartindex );
 
-    for ( int bp = 0; bp < global_header->numbodyparts && bp < 2; bp++ )
+    for ( int bp = 0; bp < header->numbodyparts && bp < 2; bp++ )
     {
         printf( "\n   Bodypart %d: '%s'\n", bp, bodyparts[bp].name );
         printf( "      Models: %d\n", bodyparts[bp].nummodels );
 
-        mstudiomodel_t *models = ( mstudiomodel_t * ) ( global_data + bodyparts[bp].modelindex );
+        mstudiomodel_t *models = ( mstudiomodel_t * ) ( data + bodyparts[bp].modelindex );
         mstudiomodel_t *model  = &models[0];
         printf( "      Model 0: '%s'\n", model->name );
         printf( "         Vertices: %d at offset 0x%X\n", model->numverts, model->vertindex );
 
         // Check actual vertex data
-        vec3_t *verts = ( vec3_t * ) ( global_data + model->vertindex );
+        vec3_t *verts = ( vec3_t * ) ( data + model->vertindex );
 
         // Find min/max of raw vertices
         float min_x = 10000, max_x = -10000;
@@ -413,7 +443,7 @@ void dump_complete_mdl_structure( void )
         }
 
         // Check hex data
-        unsigned char *as_bytes = ( unsigned char * ) ( global_data + model->vertindex );
+        unsigned char *as_bytes = ( unsigned char * ) ( data + model->vertindex );
         printf( "         First 12 bytes at vertex offset: " );
         for ( int i = 0; i < 12; i++ )
         {
@@ -425,537 +455,1156 @@ void dump_complete_mdl_structure( void )
     printf( "\n===============================================\n" );
 }
 
-void UpdateBonesForCurrentFrame( void )
+/*
+ * Decoded mesh topology.
+ *
+ * The triangle commands of every selected submodel are expanded once into
+ * inst->corners (vertex/normal index plus final UVs) and per-texture draw
+ * ranges. Animating only has to re-skin: SkinInstance() walks the corners
+ * linearly and writes positions/normals into inst->vertices. The topology is
+ * rebuilt whenever inst->processed is cleared (bodygroup, model or texture
+ * changes).
+ */
+
+// Upper bounds gathered by MeasureMeshTopology() before anything is decoded
+typedef struct {
+    int corners;             // decoded corners over all selected meshes
+    int max_mesh_corners;    // corners of the largest single mesh
+    int meshes;
+    int verts;               // numverts over all selected submodels
+    int norms;               // ... and numnorms
+} TopologySizes;
+
+static size_t ArenaAlignUp( size_t bytes )
 {
-    if ( !global_header || !global_data )
-    {
-        return;
-    }
+    return ( bytes + RENDER_ARENA_ALIGN - 1 ) & ~( size_t ) ( RENDER_ARENA_ALIGN - 1 );
+}
 
-    if ( g_animation_enabled && global_header->numseq > 0 )
+// Makes room for `bytes` and starts carving from the beginning again
+static bool ArenaReset( RenderArena *arena, size_t bytes )
+{
+    arena->used = 0;
+
+    if ( bytes <= arena->capacity )
     {
-        // Calculate animated bone transforms directly into g_bonetransformations
-        mdl_animation_calculate_bones(
-            &g_anim_state, global_header, global_data, global_seqgroups, g_bonetransformations );
+        return true;
     }
-    else
+
+    size_t capacity = arena->capacity + arena->capacity / 2;
+    if ( capacity < bytes )
     {
-        // No animation - use static T-pose
-        SetUpBones( global_header, global_data );
+        capacity = bytes;
     }
 
-    // Re-transform ALL vertices with updated bones
-    mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( global_data + global_header->bodypartindex );
+    // Contents are rebuilt from scratch, no need to realloc
+    free( arena->block );
+    arena->block    = malloc( capacity );
+    arena->capacity = arena->block ? capacity : 0;
 
-    for ( int bp = 0; bp < global_header->numbodyparts; ++bp )
+    if ( !arena->block )
     {
-        mstudiobodyparts_t *bpRec                = &bodyparts[bp];
-        mstudiomodel_t     *models               = ( mstudiomodel_t * ) ( global_data + bpRec->modelindex );
-        int                 selected_model_index = bodypart_get_model_index( bp );
-
-        if ( selected_model_index < 0 || selected_model_index >= bpRec->nummodels )
-        {
-            selected_model_index = 0;
-        }
+        fprintf( stderr, "ERROR - Failed to allocate %zu byte render arena!\n", capacity );
+        return false;
+    }
 
-        mstudiomodel_t *model = &models[selected_model_index];
+    return true;
+}
 
-        // Transform vertices with updated bone matrices
-        TransformVertices( global_header, global_data, model, skinned_positions );
-        have_skinned_positions = true;
-    }
+static void *ArenaTake( RenderArena *arena, size_t bytes )
+{
+    void *ptr = arena->block + arena->used;
+    arena->used += ArenaAlignUp( bytes );
+    return ptr;
 }
 
-// Updated ProcessModelForRendering to extract normals and UVs
-void ProcessModelForRendering( void )
+static void ArenaRelease( RenderArena *arena )
 {
-    LOG_INFOF( "renderer", "Processing model for rendering" );
+    free( arena->block );
+    memset( arena, 0, sizeof( *arena ) );
+}
 
-    if ( !global_header || !global_data )
+// Same decoding of the packed bodygroup value as bodypart_get_model_index()
+static int BodygroupModelIndex( const lm_model_instance_t *inst, const mstudiobodyparts_t *bodypart )
+{
+    if ( bodypart->nummodels <= 0 || bodypart->base <= 0 )
     {
-        LOG_FATALF(
-            "renderer",
-            "FATAL - Cannot process NULL model data! header=%p data=%p",
-            ( void * ) global_header,
-            ( void * ) global_data );
-        fprintf( stderr, "ERROR - Invalid argument pointers value passed!\n" );
-        return;
+        return 0;
     }
 
-    LOG_DEBUGF(
-        "renderer",
-        "  Header: bones=%d, bodyparts=%d, sequences=%d",
-        global_header->numbones,
-        global_header->numbodyparts,
-        global_header->numseq );
-    fflush( stdout );    // Force flush!
+    int index = ( inst->bodygroup / bodypart->base ) % bodypart->nummodels;
+    return ( index >= 0 && index < bodypart->nummodels ) ? index : 0;
+}
 
-    LOG_DEBUGF( "renderer", "  Bodypart index offset: 0x%X", global_header->bodypartindex );
-    fflush( stdout );
+static mstudiomodel_t *SelectedSubmodel( const lm_model_instance_t *inst, int bodypart )
+{
+    mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( inst->data + inst->header->bodypartindex );
+    mstudiomodel_t     *models    = ( mstudiomodel_t * ) ( inst->data + bodyparts[bodypart].modelindex );
 
-    total_render_vertices = 0;
-    g_num_ranges          = 0;
+    return &models[BodygroupModelIndex( inst, &bodyparts[bodypart] )];
+}
 
-    LOG_DEBUGF( "renderer", "  Getting bodyparts pointer..." );
-    fflush( stdout );
-    mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( global_data + global_header->bodypartindex );
-    LOG_DEBUGF( "renderer", "  Bodyparts pointer obtained: %p", ( void * ) bodyparts );
-    fflush( stdout );
+static void MeasureMeshTopology( const lm_model_instance_t *inst, TopologySizes *sizes )
+{
+    memset( sizes, 0, sizeof( *sizes ) );
 
-    LOG_DEBUGF( "renderer", "  Setting up T-pose bones..." );
-    fflush( stdout );
-    /*
-     * We set the T-Pose initially and then if we want animations that is rendered
-     * in a seperate function right.
-     */
+    for ( int bp = 0; bp < inst->header->numbodyparts && bp < MAXSTUDIOBODYPARTS; ++bp )
+    {
+        const mstudiomodel_t *model  = SelectedSubmodel( inst, bp );
+        const mstudiomesh_t  *meshes = ( const mstudiomesh_t * ) ( inst->data + model->meshindex );
 
-    SetUpBones( global_header, global_data );
-    LOG_DEBUGF( "renderer", "  T-pose bones completed" );
-    fflush( stdout );
+        sizes->verts += model->numverts;
+        sizes->norms += model->numnorms;
 
-    // Iterate through all bodyparts
-    for ( int bp = 0; bp < global_header->numbodyparts; ++bp )
-    {
-        LOG_TRACEF( "renderer", "  Processing bodypart %d/%d", bp, global_header->numbodyparts - 1 );
+        for ( int mesh = 0; mesh < model->nummesh; ++mesh )
+        {
+            int corners = mdl_count_tricmd_corners( inst->data, &meshes[mesh] );
+
+            sizes->corners += corners;
+            if ( corners > sizes->max_mesh_corners )
+                sizes->max_mesh_corners = corners;
+        }
 
-        mstudiobodyparts_t *bpRec  = &bodyparts[bp];
-        mstudiomodel_t     *models = ( mstudiomodel_t * ) ( global_data + bpRec->modelindex );
+        sizes->meshes += model->nummesh;
+    }
+}
 
-        LOG_TRACEF( "renderer", "    Bodypart '%s': %d models", bpRec->name, bpRec->nummodels );
+/*
+ * Carves every per-topology array out of the instance arena for the given
+ * sizes. The index buffer reserves 32 bits per corner plus alignment padding
+ * per range, enough for any mix of 16- and 32-bit ranges.
+ */
+static bool LayoutRenderArena( lm_model_instance_t *inst, const TopologySizes *sizes )
+{
+    const size_t corners = ( size_t ) sizes->corners;
+    const size_t scratch = ( size_t ) sizes->max_mesh_corners;
+    const size_t indices = corners * sizeof( GLuint ) + ( size_t ) sizes->meshes * sizeof( GLuint );
+
+    size_t bytes = ArenaAlignUp( ( size_t ) sizes->meshes * sizeof( DrawRange ) )
+                 + ArenaAlignUp( corners * sizeof( RenderCorner ) )
+                 + ArenaAlignUp( corners * RENDER_VERTEX_SIZE )
+                 + ArenaAlignUp( indices )
+                 + ArenaAlignUp( scratch * sizeof( mdl_tricmd_vertex_t ) ) * 2
+                 + ArenaAlignUp( scratch * sizeof( unsigned int ) )
+                 + ArenaAlignUp( ( size_t ) sizes->verts * sizeof( vec3 ) )
+                 + ArenaAlignUp( ( size_t ) sizes->norms * sizeof( vec3 ) );
+    if ( inst->gpu_skinned )
+    {
+        bytes += ArenaAlignUp( corners * sizeof( SkinnedVertex ) );
+    }
 
-        // GET ONLY THE SELECTED MODEL FOR THIS BODYPART
-        int selected_model_index = bodypart_get_model_index( bp );
+    RenderArena *arena = &inst->arena;
+    if ( !ArenaReset( arena, bytes ) )
+    {
+        return false;
+    }
 
-        LOG_TRACEF( "renderer", "    Selected model index: %d", selected_model_index );
+    inst->ranges            = ArenaTake( arena, ( size_t ) sizes->meshes * sizeof( DrawRange ) );
+    inst->corners           = ArenaTake( arena, corners * sizeof( RenderCorner ) );
+    inst->vertices          = ArenaTake( arena, corners * RENDER_VERTEX_SIZE );
+    inst->index_data        = ArenaTake( arena, indices );
+    inst->tricmd_scratch    = ArenaTake( arena, scratch * sizeof( mdl_tricmd_vertex_t ) );
+    inst->weld_unique       = ArenaTake( arena, scratch * sizeof( mdl_tricmd_vertex_t ) );
+    inst->weld_indices      = ArenaTake( arena, scratch * sizeof( unsigned int ) );
+    inst->skinned_positions = ArenaTake( arena, ( size_t ) sizes->verts * sizeof( vec3 ) );
+    inst->skinned_normals   = ArenaTake( arena, ( size_t ) sizes->norms * sizeof( vec3 ) );
+    inst->skinned_vertices  = inst->gpu_skinned ? ArenaTake( arena, corners * sizeof( SkinnedVertex ) ) : NULL;
+
+    inst->corner_capacity  = sizes->corners;
+    inst->scratch_capacity = sizes->max_mesh_corners;
+    inst->index_capacity   = indices;
+
+    return true;
+}
 
-        // Safety check
-        if ( selected_model_index < 0 || selected_model_index >= bpRec->nummodels )
-        {
-            LOG_WARNF(
-                "renderer",
-                "    Invalid model index %d (max: %d), using 0",
-                selected_model_index,
-                bpRec->nummodels - 1 );
-            selected_model_index = 0;    // Fallback to first model
-        }
+static float texel_to_uv( int texel, int size )
+{
+    /* s,t are 16-bit *texel* coords for THIS texture */
+    float uv = ( ( float ) texel + 0.5f ) / ( float ) size;
 
-        // Get ONLY the selected model (not all of them!)
-        mstudiomodel_t *model = &models[selected_model_index];
+    /* Optional safety clamp */
+    if ( uv < 0.0f )
+        uv = 0.0f;
+    else if ( uv > 1.0f )
+        uv = 1.0f;
 
-        LOG_TRACEF(
-            "renderer", "    Model '%s': vertices=%d, meshes=%d", model->name, model->numverts, model->nummesh );
+    return uv;
+}
 
-        g_current.model        = model;
-        g_current.vertices     = ( vec3_t * ) ( global_data + model->vertindex );
-        g_current.normals      = ( vec3_t * ) ( global_data + model->normindex );
-        g_current.vertex_count = model->numverts;
-        g_current.normal_count = model->numnorms;
+/*
+ * Where a mesh's skin is sampled from: the whole of its own texture, or its
+ * rectangle of the model's atlas (MDL_TEXTURE_ATLAS).
+ */
+typedef struct {
+    int   width;    // the skin's own size in texels
+    int   height;
+    float offset_u;
+    float offset_v;
+    float scale_u;
+    float scale_v;
+} TextureRect;
+
+static void StoreCorner( RenderCorner *out, const mdl_tricmd_vertex_t *in, const TextureRect *rect )
+{
+    // ON-SEAM rule: back-facing half of the skin sits width/2 to the right;
+    // the atlas remap comes after, so the seam stays inside the skin's rectangle
+    int s = in->s + ( in->seam ? rect->width / 2 : 0 );
+
+    out->vertex = in->vertex;
+    out->normal = in->normal;
+    out->u      = rect->offset_u + texel_to_uv( s, rect->width ) * rect->scale_u;
+    out->v      = rect->offset_v + texel_to_uv( in->t, rect->height ) * rect->scale_v;
+}
 
-        // Skin this model's vertices (fills skinned_positions[])
-        LOG_TRACEF( "renderer", "    Transforming %d vertices", model->numverts );
-        TransformVertices( global_header, global_data, model, skinned_positions );
-        LOG_TRACEF( "renderer", "    Vertices transformed successfully" );
-        have_skinned_positions = true;
+static void SkinRect( const lm_model_instance_t *inst, const SkinBinding *skin, TextureRect *rect )
+{
+    const TextureRect whole = { 2, 2, 0.0f, 0.0f, 1.0f, 1.0f };
+    *rect                   = whole;
 
-        // All meshes for this model
-        mstudiomesh_t *meshes = ( mstudiomesh_t * ) ( global_data + model->meshindex );
+    if ( skin->texture < 0 )
+    {
+        return;
+    }
 
-        LOG_TRACEF( "renderer", "    Processing %d meshes", model->nummesh );
+    const mdl_gl_texture_t *texture = &inst->textures.textures[skin->texture];
 
-        // Skin table
-        const short *skin_table  = ( const short * ) ( global_data + global_header->skinindex );
-        const int    numskinref  = global_header->numskinref;
-        const int    skin_family = 0;
+    rect->width  = texture->width > 0 ? texture->width : 1;
+    rect->height = texture->height > 0 ? texture->height : 1;
 
-        for ( int mesh = 0; mesh < model->nummesh; ++mesh )
-        {
-            const int norm_base = meshes[mesh].normindex;
-            const int v_count   = g_current.vertex_count;
-            const int n_count   = g_current.normal_count;
+    if ( inst->textures.mode == MDL_TEXTURE_ATLAS )
+    {
+        const float atlas_w = ( float ) inst->textures.atlas_width;
+        const float atlas_h = ( float ) inst->textures.atlas_height;
 
-            // Resolve texture index via skin table
-            int tex_index = meshes[mesh].skinref;
-            if ( skin_table && numskinref > 0 && tex_index >= 0 && tex_index < numskinref )
-            {
-                tex_index = skin_table[skin_family * numskinref + tex_index];
-            }
+        rect->offset_u = ( float ) texture->atlas_x / atlas_w;
+        rect->offset_v = ( float ) texture->atlas_y / atlas_h;
+        rect->scale_u  = ( float ) rect->width / atlas_w;
+        rect->scale_v  = ( float ) rect->height / atlas_h;
+    }
+}
 
-            // GL texture + size
-            GLuint gl_tex = 0;
-            int    texW = 1, texH = 1;
-            if ( tex_index >= 0 && tex_index < g_textures.count )
-            {
-                gl_tex = g_textures.textures[tex_index].gl_id;
-                texW   = g_textures.textures[tex_index].width;
-                texH   = g_textures.textures[tex_index].height;
-
-                if ( texW <= 0 )
-                    texW = 1;
-                if ( texH <= 0 )
-                    texH = 1;
-            }
-            if ( !gl_tex && g_white_tex )
-            {
-                gl_tex = g_white_tex;
-                texW   = 2;
-                texH   = 2;
-            }
+static bool SameRect( const TextureRect *a, const TextureRect *b )
+{
+    return a->width == b->width && a->height == b->height && a->offset_u == b->offset_u && a->offset_v == b->offset_v
+        && a->scale_u == b->scale_u && a->scale_v == b->scale_v;
+}
 
-            short *ptricmds = ( short * ) ( global_data + meshes[mesh].triindex );
+/*
+ * Resolves every skinref of every skin family to its texture once, the way
+ * the skin table says: column c of family f is skin_table[f * numskinref + c],
+ * skinrefs past the table name a texture directly, and the last column is the
+ * white fallback for anything without a texture.
+ */
+static bool BuildSkinBindings( const lm_render_context_t *ctx, lm_model_instance_t *inst )
+{
+    const studiohdr_t *header     = inst->header;
+    const short       *skin_table = ( const short * ) ( inst->data + header->skinindex );
+    const int          numskinref = header->numskinref > 0 ? header->numskinref : 0;
+    const int          families   = header->numskinfamilies > 0 ? header->numskinfamilies : 1;
+    const int          refs       = numskinref > inst->textures.count ? numskinref : inst->textures.count;
+    const int          columns    = refs + 1;
+
+    inst->skin_bindings = calloc( ( size_t ) families * ( size_t ) columns, sizeof( *inst->skin_bindings ) );
+    if ( !inst->skin_bindings )
+    {
+        return false;
+    }
+    inst->skin_families = families;
+    inst->skin_columns  = columns;
 
-            const int start_first = total_render_vertices;
+    const SkinBinding white = { ctx->white_tex, ctx->white_palette, false, -1 };
 
-            int s_min = 32767, s_max = -32768;
-            int t_min = 32767, t_max = -32768;
-            int dbg_count = 0;
+    for ( int f = 0; f < families; ++f )
+    {
+        SkinBinding *row = &inst->skin_bindings[f * columns];
 
-            int i;
-            while ( ( i = *( ptricmds++ ) ) )
-            {
-                if ( i < 0 )
-                {
-                    // -------- triangle fan --------
-                    i = -i;
-
-                    // read first 2 vertices
-                    short v0 = ptricmds[0];
-                    short n0 = ptricmds[1];
-                    short s0 = ptricmds[2];
-                    short t0 = ptricmds[3];
-                    ptricmds = ( short * ) ( ( char * ) ptricmds + 4 * sizeof( short ) );
-
-                    short v1 = ptricmds[0];
-                    short n1 = ptricmds[1];
-                    short s1 = ptricmds[2];
-                    short t1 = ptricmds[3];
-                    ptricmds = ( short * ) ( ( char * ) ptricmds + 4 * sizeof( short ) );
-
-                    // >>> FIX: apply ON-SEAM rule and clear high bit on normal index
-                    if ( n0 & 0x8000 )
-                    {
-                        s0 = ( short ) ( s0 + texW / 2 );
-                    }
-                    n0 &= 0x7FFF;
-                    if ( n1 & 0x8000 )
-                    {
-                        s1 = ( short ) ( s1 + texW / 2 );
-                    }
-                    n1 &= 0x7FFF;
-
-                    // norm indices are relative to this mesh's block
-                    n0 = ( short ) ( n0 + norm_base );
-                    n1 = ( short ) ( n1 + norm_base );
-
-                    for ( int j = 2; j < i; ++j )
-                    {
-                        short v2 = ptricmds[0];
-                        short n2 = ptricmds[1];
-                        short s2 = ptricmds[2];
-                        short t2 = ptricmds[3];
-                        ptricmds = ( short * ) ( ( char * ) ptricmds + 4 * sizeof( short ) );
-
-                        // >>> FIX: apply ON-SEAM rule and clear high bit
-                        if ( n2 & 0x8000 )
-                        {
-                            s2 = ( short ) ( s2 + texW / 2 );
-                        }
-                        n2 &= 0x7FFF;
-
-                        // update min/max + quick sample printf
-                        s_min = ( s0 < s_min ) ? s0 : s_min;
-                        s_max = ( s0 > s_max ) ? s0 : s_max;
-                        t_min = ( t0 < t_min ) ? t0 : t_min;
-                        t_max = ( t0 > t_max ) ? t0 : t_max;
-
-                        // normals block offset
-                        n2 = ( short ) ( n2 + norm_base );
-
-                        // bounds guards
-                        if ( v0 >= 0 && v0 < v_count && n0 >= 0 && n0 < n_count && v1 >= 0 && v1 < v_count && n1 >= 0
-                             && n1 < n_count && v2 >= 0 && v2 < v_count && n2 >= 0 && n2 < n_count )
-                        {
-                            AddVertexToBuffer( v0, n0, s0, t0, ( float ) texW, ( float ) texH );
-                            AddVertexToBuffer( v1, n1, s1, t1, ( float ) texW, ( float ) texH );
-                            AddVertexToBuffer( v2, n2, s2, t2, ( float ) texW, ( float ) texH );
-                        }
-
-                        // roll forward
-                        v1 = v2;
-                        n1 = n2;
-                        s1 = s2;
-                        t1 = t2;
-                    }
-                }
-                else
-                {
-                    // -------- triangle strip --------
-
-                    // read first 2 vertices
-                    short v0 = ptricmds[0];
-                    short n0 = ptricmds[1];
-                    short s0 = ptricmds[2];
-                    short t0 = ptricmds[3];
-                    ptricmds = ( short * ) ( ( char * ) ptricmds + 4 * sizeof( short ) );
-
-                    short v1 = ptricmds[0];
-                    short n1 = ptricmds[1];
-                    short s1 = ptricmds[2];
-                    short t1 = ptricmds[3];
-                    ptricmds = ( short * ) ( ( char * ) ptricmds + 4 * sizeof( short ) );
-
-                    // >>> FIX: seam + clear high bit
-                    if ( n0 & 0x8000 )
-                    {
-                        s0 = ( short ) ( s0 + texW / 2 );
-                    }
-                    n0 &= 0x7FFF;
-                    if ( n1 & 0x8000 )
-                    {
-                        s1 = ( short ) ( s1 + texW / 2 );
-                    }
-                    n1 &= 0x7FFF;
-
-                    n0 = ( short ) ( n0 + norm_base );
-                    n1 = ( short ) ( n1 + norm_base );
-
-                    for ( int j = 2; j < i; ++j )
-                    {
-                        short v2 = ptricmds[0];
-                        short n2 = ptricmds[1];
-                        short s2 = ptricmds[2];
-                        short t2 = ptricmds[3];
-                        ptricmds = ( short * ) ( ( char * ) ptricmds + 4 * sizeof( short ) );
-
-                        // >>> FIX: seam + clear high bit
-                        if ( n2 & 0x8000 )
-                        {
-                            s2 = ( short ) ( s2 + texW / 2 );
-                        }
-                        n2 &= 0x7FFF;
-
-                        s_min = ( s0 < s_min ) ? s0 : s_min;
-                        s_max = ( s0 > s_max ) ? s0 : s_max;
-                        t_min = ( t0 < t_min ) ? t0 : t_min;
-                        t_max = ( t0 > t_max ) ? t0 : t_max;
-
-                        n2 = ( short ) ( n2 + norm_base );
-
-                        // two-triangle parity
-                        if ( ( j - 2 ) % 2 == 0 )
-                        {
-                            if ( v0 >= 0 && v0 < v_count && n0 >= 0 && n0 < n_count && v1 >= 0 && v1 < v_count
-                                 && n1 >= 0 && n1 < n_count && v2 >= 0 && v2 < v_count && n2 >= 0 && n2 < n_count )
-                            {
-                                AddVertexToBuffer( v0, n0, s0, t0, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v1, n1, s1, t1, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v2, n2, s2, t2, ( float ) texW, ( float ) texH );
-                            }
-                        }
-                        else
-                        {
-                            if ( v0 >= 0 && v0 < v_count && n0 >= 0 && n0 < n_count && v1 >= 0 && v1 < v_count
-                                 && n1 >= 0 && n1 < n_count && v2 >= 0 && v2 < v_count && n2 >= 0 && n2 < n_count )
-                            {
-                                AddVertexToBuffer( v1, n1, s1, t1, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v0, n0, s0, t0, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v2, n2, s2, t2, ( float ) texW, ( float ) texH );
-                            }
-                        }
-
-                        // roll forward
-                        v0 = v1;
-                        n0 = n1;
-                        s0 = s1;
-                        t0 = t1;
-                        v1 = v2;
-                        n1 = n2;
-                        s1 = s2;
-                        t1 = t2;
-                    }
-                }
-            }
+        for ( int c = 0; c < refs; ++c )
+        {
+            const int tex_index = ( numskinref > 0 && c < numskinref && f < header->numskinfamilies )
+                                    ? skin_table[f * numskinref + c]
+                                    : c;
 
-            // One draw range for this mesh
-            if ( g_num_ranges < MAX_DRAW_RANGES )
+            row[c] = white;
+            if ( tex_index >= 0 && tex_index < inst->textures.count && inst->textures.textures[tex_index].gl_id )
             {
-                g_ranges[g_num_ranges].tex   = gl_tex;
-                g_ranges[g_num_ranges].first = start_first;
-                g_ranges[g_num_ranges].count = total_render_vertices - start_first;
-                g_num_ranges++;
+                const mdl_gl_texture_t *texture = &inst->textures.textures[tex_index];
+
+                row[c].tex     = texture->gl_id;
+                row[c].palette = texture->palette_id;
+                row[c].masked  = inst->textures.mode == MDL_TEXTURE_PALETTE && ( texture->flags & STUDIO_NF_MASKED ) != 0;
+                row[c].texture = tex_index;
             }
         }
+        row[refs] = white;
     }
 
-    model_processed = true;
-
-    LOG_DEBUGF( "renderer", "  Processing complete:" );
-    LOG_DEBUGF( "renderer", "    Total vertices: %d", total_render_vertices );
-    LOG_DEBUGF( "renderer", "    Draw ranges: %d", g_num_ranges );
-
-    if ( g_num_ranges == 0 )
+    // UVs are baked for the family the topology was built with; they fit every family only if no rect moves
+    inst->skin_uv_shared = true;
+    for ( int c = 0; c < refs && inst->skin_uv_shared; ++c )
     {
-        LOG_WARNF( "renderer", "  WARNING - No draw ranges created!" );
+        TextureRect first;
+        SkinRect( inst, &inst->skin_bindings[c], &first );
+
+        for ( int f = 1; f < families; ++f )
+        {
+            TextureRect rect;
+            SkinRect( inst, &inst->skin_bindings[f * columns + c], &rect );
+            if ( !SameRect( &first, &rect ) )
+            {
+                inst->skin_uv_shared = false;
+                break;
+            }
+        }
     }
 
-    if ( total_render_vertices == 0 )
+    if ( families > 1 )
     {
-        LOG_WARNF( "renderer", "  WARNING - No vertices generated!" );
+        LOG_DEBUGF(
+            "renderer",
+            "  Skin bindings: %d families x %d skinrefs, switching %s",
+            families,
+            refs,
+            inst->skin_uv_shared ? "is free" : "rebuilds the topology" );
     }
+    return true;
+}
+
+const SkinBinding *lm_instance_skins( const lm_model_instance_t *inst )
+{
+    return &inst->skin_bindings[SkinFamily( inst ) * inst->skin_columns];
+}
 
-    if ( total_render_vertices > MAX_RENDER_VERTICES )
+// Two columns draw with the same textures under every family
+static bool SameSkinEveryFamily( const lm_model_instance_t *inst, int a, int b )
+{
+    for ( int f = 0; f < inst->skin_families; ++f )
     {
-        LOG_ERRORF(
-            "renderer", "  ERROR - Vertex buffer overflow! %d > %d", total_render_vertices, MAX_RENDER_VERTICES );
+        const SkinBinding *row = &inst->skin_bindings[f * inst->skin_columns];
+        if ( row[a].tex != row[b].tex || row[a].palette != row[b].palette || row[a].masked != row[b].masked )
+        {
+            return false;
+        }
     }
-
-    LOG_INFOF( "renderer", "Model processing COMPLETE" );
+    return true;
 }
 
-void AddVertexToBuffer( int vertex_index, int normal_index, short s, short t, float texW, float texH )
+static void AccumulateCacheStats(
+    const lm_model_instance_t *inst, mdl_vcache_stats_t *total, int corners, int unique )
 {
-    if ( total_render_vertices >= MAX_RENDER_VERTICES )
-        return;
+    mdl_vcache_stats_t mesh;
+    mdl_analyze_vertex_cache( inst->weld_indices, corners, unique, MDL_VCACHE_SIZE, &mesh );
 
-    const int base = total_render_vertices * 8;
+    total->triangles += mesh.triangles;
+    total->vertices += mesh.vertices;
+    total->misses += mesh.misses;
+}
 
-    /* ----- POSITION (your skinning path) ----- */
-    vec3 P;
-    if ( have_skinned_positions )
-    {
-        glm_vec3_copy( skinned_positions[vertex_index], P );
-    }
-    else
+/*
+ * Appends a welded mesh's unique vertices to inst->corners and its indices to
+ * inst->index_data. Ranges whose indices all fit in 16 bits use
+ * GL_UNSIGNED_SHORT.
+ */
+static void EmitIndexedMesh(
+    lm_model_instance_t       *inst,
+    DrawRange                 *range,
+    const mdl_tricmd_vertex_t *unique_vertices,
+    int                        unique,
+    const unsigned int        *indices,
+    int                        corners,
+    const TextureRect         *rect )
+{
+    const int base = inst->num_vertices;
+    for ( int u = 0; u < unique; ++u )
     {
-        glm_vec3_copy( g_current.vertices[vertex_index], P );
+        StoreCorner( &inst->corners[inst->num_vertices++], &unique_vertices[u], rect );
     }
 
-    const float viewer_scale  = 0.1f;
-    P[0]                     *= viewer_scale;
-    P[1]                     *= viewer_scale;
-    P[2]                     *= viewer_scale;
+    const bool   wide       = ( base + unique - 1 ) > 0xFFFF;
+    const size_t index_size = wide ? sizeof( GLuint ) : sizeof( GLushort );
 
-    /* ----- NORMAL (your bone transform) ----- */
-    unsigned char *v2bone = ( unsigned char * ) ( global_data + g_current.model->vertinfoindex );
-    int            bone   = v2bone ? v2bone[vertex_index] : 0;
-    if ( bone < 0 || bone >= global_header->numbones )
-        bone = 0;
+    inst->index_bytes = ( inst->index_bytes + index_size - 1 ) & ~( index_size - 1 );
 
-    vec3 Nfile = {
-        g_current.normals[normal_index][0], g_current.normals[normal_index][1], g_current.normals[normal_index][2] };
-    vec3 Nrot;
-    TransformNormalByBone( g_bonetransformations[bone], Nfile, Nrot );
+    range->index_type   = wide ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    range->index_offset = inst->index_bytes;
+    range->count        = corners;
 
-    /* ----- AXIS REMAP (unchanged) ----- */
-    float x  = P[0];
-    float y  = P[1];
-    float z  = P[2];
-    float nx = Nrot[0];
-    float ny = Nrot[1];
-    float nz = Nrot[2];
+    for ( int c = 0; c < corners; ++c )
+    {
+        unsigned int index = ( unsigned int ) base + indices[c];
 
-    float Py = z;     // Z -> Y
-    float Pz = -y;    // -Y -> Z
-    float Ny = nz;
-    float Nz = -ny;
+        if ( wide )
+        {
+            GLuint v = index;
+            memcpy( &inst->index_data[inst->index_bytes], &v, sizeof( v ) );
+        }
+        else
+        {
+            GLushort v = ( GLushort ) index;
+            memcpy( &inst->index_data[inst->index_bytes], &v, sizeof( v ) );
+        }
+        inst->index_bytes += index_size;
+    }
 
-    /* write position */
-    render_vertex_buffer[base + 0] = x;
-    render_vertex_buffer[base + 1] = Py;
-    render_vertex_buffer[base + 2] = Pz;
+    inst->num_indices += corners;
+}
 
-    /* write normal */
-    render_vertex_buffer[base + 3] = nx;
-    render_vertex_buffer[base + 4] = Ny;
-    render_vertex_buffer[base + 5] = Nz;
+/*
+ * Welds the mesh decoded into inst->tricmd_scratch and appends it. Unless
+ * disabled, triangles are first reordered for the post-transform cache and
+ * vertices renumbered in fetch order. Returns false if the mesh does not fit.
+ */
+static bool AppendIndexedMesh(
+    const lm_render_context_t *ctx, lm_model_instance_t *inst, DrawRange *range, int corners, const TextureRect *rect )
+{
+    int unique = mdl_weld_tricmd_vertices( inst->tricmd_scratch, corners, inst->weld_unique, inst->weld_indices );
 
-    /* s,t are 16-bit *texel* coords for THIS texture */
-    float u = ( ( float ) s + 0.5f ) / ( float ) texW;
-    float v = ( ( float ) t + 0.5f ) / ( float ) texH;
+    if ( unique < 0 || inst->num_vertices + unique > inst->corner_capacity )
+    {
+        return false;
+    }
 
-    // v = 1.0f - v;
+    AccumulateCacheStats( inst, &inst->vcache_before, corners, unique );
 
-    /* Optional safety clamp */
-    if ( u < 0.0f )
-        u = 0.0f;
-    else if ( u > 1.0f )
-        u = 1.0f;
-    if ( v < 0.0f )
-        v = 0.0f;
-    else if ( v > 1.0f )
-        v = 1.0f;
+    if ( ctx->vcache_optimize && mdl_optimize_vertex_cache( inst->weld_indices, corners, unique, MDL_VCACHE_SIZE ) )
+    {
+        mdl_optimize_vertex_fetch( inst->weld_unique, unique, inst->weld_indices, corners );
+    }
 
-    render_vertex_buffer[base + 6] = u;
-    render_vertex_buffer[base + 7] = v;
+    AccumulateCacheStats( inst, &inst->vcache_after, corners, unique );
 
-    total_render_vertices++;
+    EmitIndexedMesh( inst, range, inst->weld_unique, unique, inst->weld_indices, corners, rect );
+    return true;
 }
 
-void setup_triangle( void )
+// Same result as AppendIndexedMesh() with the optimizer on, already welded in the compiled cache
+static bool AppendCachedMesh(
+    lm_model_instance_t *inst, DrawRange *range, const mdl_cached_mesh_t *mesh, const TextureRect *rect )
 {
-    glGenBuffers( 1, &VBO );
-    glBindBuffer( GL_ARRAY_BUFFER, VBO );
-    glBufferData( GL_ARRAY_BUFFER, sizeof( vertices ), vertices, GL_STATIC_DRAW );
+    if ( inst->num_vertices + mesh->num_vertices > inst->corner_capacity
+         || ( size_t ) mesh->num_indices * sizeof( GLuint ) > inst->index_capacity - inst->index_bytes )
+    {
+        return false;
+    }
 
-    glGenVertexArrays( 1, &VAO );
-    glBindVertexArray( VAO );
-    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof( float ), ( void * ) 0 );
-    glEnableVertexAttribArray( 0 );
+    inst->vcache_before.triangles += mesh->before.triangles;
+    inst->vcache_before.vertices += mesh->before.vertices;
+    inst->vcache_before.misses += mesh->before.misses;
+    inst->vcache_after.triangles += mesh->after.triangles;
+    inst->vcache_after.vertices += mesh->after.vertices;
+    inst->vcache_after.misses += mesh->after.misses;
+
+    EmitIndexedMesh( inst, range, mesh->vertices, mesh->num_vertices, mesh->indices, mesh->num_indices, rect );
+    return true;
 }
 
-static char *read_shader_source( const char *filename )
+/*
+ * Writes the static VBO for GPU skinning: model-space position and normal
+ * per decoded corner with the bones the vertex shader skins them by.
+ */
+static void FillSkinnedVertices( lm_model_instance_t *inst )
 {
-    
-    char fullpath[512];
-    snprintf(fullpath, sizeof(fullpath), "%s/%s", SHADER_DIR, filename);
-    
-    FILE *file = fopen( fullpath, "rb" );
-    if ( !file )
+    for ( int p = 0; p < inst->num_parts; ++p )
     {
-        fprintf( stderr, "ERROR - Failed to open the shader file: '%s' \n", fullpath );
-        return NULL;
+        const RenderPart     *part     = &inst->parts[p];
+        const mstudiomodel_t *model    = part->model;
+        const vec3_t         *vertices = ( const vec3_t * ) ( inst->data + model->vertindex );
+        const vec3_t         *normals  = ( const vec3_t * ) ( inst->data + model->normindex );
+        const unsigned char  *v2bone   = ( const unsigned char * ) ( inst->data + model->vertinfoindex );
+        const unsigned char  *n2bone   = ( const unsigned char * ) ( inst->data + model->norminfoindex );
+
+        for ( int c = part->first; c < part->first + part->count; ++c )
+        {
+            const RenderCorner *corner = &inst->corners[c];
+            SkinnedVertex      *dst    = &inst->skinned_vertices[c];
+
+            int vbone = v2bone[corner->vertex];
+            int nbone = n2bone[corner->normal];
+            if ( vbone >= inst->header->numbones )
+                vbone = 0;
+            if ( nbone >= inst->header->numbones )
+                nbone = 0;
+
+            memcpy( dst->pos, vertices[corner->vertex], sizeof( dst->pos ) );
+            memcpy( dst->normal, normals[corner->normal], sizeof( dst->normal ) );
+            dst->uv[0]    = corner->u;
+            dst->uv[1]    = corner->v;
+            dst->bones[0] = ( unsigned char ) vbone;
+            dst->bones[1] = ( unsigned char ) nbone;
+            dst->bones[2] = 0;
+            dst->bones[3] = 0;
+        }
     }
 
-    fseek( file, 0, SEEK_END );
-    size_t length = ftell( file );
-    rewind( file );
-
-    char *buffer = malloc( ( length + 1 ) * sizeof( char ) );
+    inst->skinned_vertices_dirty = true;
+}
 
-    if ( !buffer )
+/*
+ * Folds each run of ranges that bind the same textures under every skin
+ * family and follow each other in the vertex or index buffer into one draw.
+ * Meshes sharing a skin merge anywhere; with an atlas, every mesh of the
+ * model usually ends up in one draw call (a 16 -> 32-bit index switch still
+ * splits it).
+ */
+static void MergeDrawRanges( lm_model_instance_t *inst )
+{
+    if ( inst->num_ranges == 0 )
     {
-        fprintf( stderr, "ERROR - Failed to allocate memory for shader file buffer!\n" );
-        fclose( file );
-        return NULL;
+        return;
     }
 
-    fread( buffer, 1, length, file );
-    buffer[length] = '\0';    // Null terminate
-    fclose( file );
+    const int meshes = inst->num_ranges;
+    int       merged = 0;
 
-    return buffer;
-}
+    for ( int r = 1; r < meshes; ++r )
+    {
+        DrawRange       *last  = &inst->ranges[merged];
+        const DrawRange *range = &inst->ranges[r];
 
-static GLuint compile_shader( const char *source, GLenum type )
-{
-    GLuint shader = glCreateShader( type );
-    glShaderSource( shader, 1, &source, NULL );
-    glCompileShader( shader );
+        if ( range->count == 0 )
+        {
+            continue;
+        }
 
-    GLint success;
-    glGetShaderiv( shader, GL_COMPILE_STATUS, &success );
+        bool follows;
+        if ( inst->indexed )
+        {
+            const size_t index_size = last->index_type == GL_UNSIGNED_INT ? sizeof( GLuint ) : sizeof( GLushort );
+            follows = range->index_type == last->index_type
+                   && range->index_offset == last->index_offset + ( size_t ) last->count * index_size;
+        }
+        else
+        {
+            follows = range->first == last->first + last->count;
+        }
 
-    if ( !success )
-    {
-        char shader_info[512];
-        glGetShaderInfoLog( shader, 512, NULL, shader_info );
-        fprintf( stderr, "ERROR - Failed to compile shaders: \n%s\n", shader_info );
-        return ( 0 );
+        if ( follows && ( range->skinref == last->skinref || SameSkinEveryFamily( inst, range->skinref, last->skinref ) ) )
+        {
+            last->count += range->count;
+        }
+        else
+        {
+            inst->ranges[++merged] = *range;
+        }
     }
 
-    return shader;
+    inst->num_ranges = merged + 1;
+
+    LOG_DEBUGF( "renderer", "  %d meshes in %d draw calls", meshes, inst->num_ranges );
 }
 
-static GLuint create_shader_program( GLuint vertexShader, GLuint fragmentShader )
+static void BuildMeshTopology( const lm_render_context_t *ctx, lm_model_instance_t *inst )
+{
+    studiohdr_t   *header = inst->header;
+    unsigned char *data   = inst->data;
+
+    inst->num_vertices = 0;
+    inst->num_ranges   = 0;
+    inst->num_parts    = 0;
+    inst->num_indices  = 0;
+    inst->index_bytes  = 0;
+    inst->indexed      = ctx->indexed_draw && inst->ebo != 0;
+    inst->gpu_skinned  = inst->skinned_layout || ( ctx->gpu_skinning && ctx->skinned_program != 0 && inst->bone_ubo != 0 );
+
+    memset( &inst->vcache_before, 0, sizeof( inst->vcache_before ) );
+    memset( &inst->vcache_after, 0, sizeof( inst->vcache_after ) );
+
+    TopologySizes sizes;
+    MeasureMeshTopology( inst, &sizes );
+
+    if ( !LayoutRenderArena( inst, &sizes ) )
+    {
+        LOG_ERRORF( "renderer", "  No memory for a %d corner topology", sizes.corners );
+        return;
+    }
+
+    LOG_DEBUGF(
+        "renderer",
+        "  Render arena: %zu KB used of %zu KB (%d corners, %d meshes)",
+        inst->arena.used / 1024,
+        inst->arena.capacity / 1024,
+        sizes.corners,
+        sizes.meshes );
+
+    mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( data + header->bodypartindex );
+
+    // Skinrefs resolve through the bindings; the UVs follow the current family's skins
+    const SkinBinding *skins = lm_instance_skins( inst );
+
+    // Welded meshes come straight from the compiled model cache when there is
+    // one; it only holds the vertex cache optimized order
+    const mdl_model_cache_t *cache = ( inst->indexed && ctx->vcache_optimize ) ? mdl_cache_find( data ) : NULL;
+
+    // Each part skins into its own slice so the parts can be skinned concurrently
+    int skinned_verts = 0;
+    int skinned_norms = 0;
+
+    for ( int bp = 0; bp < header->numbodyparts && bp < MAXSTUDIOBODYPARTS; ++bp )
+    {
+        mstudiomodel_t *model  = SelectedSubmodel( inst, bp );
+        mstudiomesh_t  *meshes = ( mstudiomesh_t * ) ( data + model->meshindex );
+
+        LOG_TRACEF(
+            "renderer",
+            "    Bodypart '%s' -> model '%s': vertices=%d, meshes=%d",
+            bodyparts[bp].name,
+            model->name,
+            model->numverts,
+            model->nummesh );
+
+        RenderPart *part = &inst->parts[inst->num_parts++];
+        part->model      = model;
+        part->first      = inst->num_vertices;
+        part->first_vert = skinned_verts;
+        part->first_norm = skinned_norms;
+
+        skinned_verts += model->numverts;
+        skinned_norms += model->numnorms;
+
+        for ( int mesh = 0; mesh < model->nummesh; ++mesh )
+        {
+            // Skinrefs past the table still name a texture; anything else draws white
+            int skinref = meshes[mesh].skinref;
+            if ( skinref < 0 || skinref >= inst->skin_columns - 1 )
+            {
+                skinref = inst->skin_columns - 1;
+            }
+
+            TextureRect rect;
+            SkinRect( inst, &skins[skinref], &rect );
+
+            DrawRange *range = &inst->ranges[inst->num_ranges];
+            memset( range, 0, sizeof( *range ) );
+            range->skinref = skinref;
+            range->first = inst->num_vertices;
+
+            mdl_cached_mesh_t cached;
+            const bool        from_cache = cache
+                                            && mdl_cache_mesh( cache, data, &meshes[mesh], model->numverts, model->numnorms, &cached );
+
+            const int corners = from_cache ? 0 : mdl_decode_tricmds(
+                data, &meshes[mesh], model->numverts, model->numnorms, inst->tricmd_scratch, inst->scratch_capacity );
+
+            if ( inst->indexed )
+            {
+                const bool fits = from_cache ? AppendCachedMesh( inst, range, &cached, &rect )
+                                             : AppendIndexedMesh( ctx, inst, range, corners, &rect );
+                if ( !fits )
+                {
+                    LOG_ERRORF( "renderer", "  Mesh %d of '%s' does not fit the vertex buffer", mesh, model->name );
+                    continue;
+                }
+            }
+            else
+            {
+                for ( int c = 0; c < corners; ++c )
+                {
+                    StoreCorner( &inst->corners[inst->num_vertices++], &inst->tricmd_scratch[c], &rect );
+                }
+                range->count = corners;
+            }
+
+            // One draw range for this mesh
+            inst->num_ranges++;
+        }
+
+        part->count = inst->num_vertices - part->first;
+    }
+
+    MergeDrawRanges( inst );
+
+    if ( inst->indexed )
+    {
+        inst->indices_dirty = true;
+
+        LOG_INFOF(
+            "renderer",
+            "  Indexed mesh: %d vertices for %d corners (%.1f%% fewer), %zu vs %zu bytes/frame upload",
+            inst->num_vertices,
+            inst->num_indices,
+            inst->num_indices ? 100.0 * ( 1.0 - ( double ) inst->num_vertices / ( double ) inst->num_indices ) : 0.0,
+            ( size_t ) inst->num_vertices * 8 * sizeof( float ),
+            ( size_t ) inst->num_indices * 8 * sizeof( float ) );
+
+        if ( inst->vcache_before.triangles > 0 && inst->vcache_before.vertices > 0 )
+        {
+            LOG_INFOF(
+                "renderer",
+                "  Vertex cache (FIFO %d)%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+                MDL_VCACHE_SIZE,
+                ctx->vcache_optimize ? "" : " [optimization off]",
+                ( double ) inst->vcache_before.misses / inst->vcache_before.triangles,
+                ( double ) inst->vcache_after.misses / inst->vcache_after.triangles,
+                ( double ) inst->vcache_before.misses / inst->vcache_before.vertices,
+                ( double ) inst->vcache_after.misses / inst->vcache_after.vertices );
+        }
+    }
+
+    if ( inst->gpu_skinned )
+    {
+        FillSkinnedVertices( inst );
+
+        LOG_INFOF(
+            "renderer",
+            "  GPU skinning: %zu byte static VBO, %zu bytes/frame bone palette",
+            ( size_t ) inst->num_vertices * sizeof( SkinnedVertex ),
+            ( size_t ) header->numbones * 12 * sizeof( float ) );
+    }
+}
+
+// Options change how topologies are built; every instance rebuilds on its next frame
+static void InvalidateInstances( void )
+{
+    for ( int i = 0; i < g_context.num_instances; ++i )
+    {
+        g_context.instances[i]->processed = false;
+    }
+    request_redraw( );
+}
+
+void set_indexed_drawing( bool enabled )
+{
+    g_context.indexed_draw = enabled;
+    InvalidateInstances( );
+}
+
+void set_vertex_cache_optimization( bool enabled )
+{
+    g_context.vcache_optimize = enabled;
+    InvalidateInstances( );
+}
+
+void set_gpu_skinning( bool enabled )
+{
+    g_context.gpu_skinning = enabled;
+    InvalidateInstances( );
+}
+
+void set_palette_textures( bool enabled )
+{
+    if ( enabled && !g_context.palette_program )
+    {
+        LOG_WARNF( "renderer", "Palette shader unavailable - textures stay RGBA" );
+    }
+    g_context.palette_textures = enabled;
+}
+
+void set_atlas_textures( bool enabled )
+{
+    if ( enabled && g_context.palette_textures && g_context.palette_program )
+    {
+        LOG_WARNF( "renderer", "Palettized textures are not atlased - --atlas has no effect" );
+    }
+    g_context.atlas_textures = enabled;
+}
+
+/*
+ * Packs the instance's bone matrices into the 3x4 row layout skinned.vert
+ * reads, with the viewer's Z-up -> Y-up remap and scale folded into each
+ * matrix.
+ */
+static void PackBoneRows( lm_model_instance_t *inst, float viewer_scale )
+{
+    const int numbones = inst->header->numbones < MAXSTUDIOBONES ? inst->header->numbones : MAXSTUDIOBONES;
+
+    for ( int b = 0; b < numbones; ++b )
+    {
+        float *row = &inst->bone_rows[b * 12];
+
+        // cglm is column-major: row r of the affine part is m[0..3][r]
+        for ( int col = 0; col < 4; ++col )
+        {
+            row[0 + col] = inst->bones[b][col][0] * viewer_scale;
+            row[4 + col] = inst->bones[b][col][2] * viewer_scale;
+            row[8 + col] = -inst->bones[b][col][1] * viewer_scale;
+        }
+    }
+
+    inst->bone_rows_dirty = true;
+}
+
+/*
+ * CPU skinning of one part, in three steps: skin the submodel's unique
+ * vertices, skin its unique normals (both into the part's own slice of the
+ * skinned arrays), then gather them per corner into the interleaved
+ * pos/normal/uv stream.
+ */
+static void SkinPartPositions( lm_model_instance_t *inst, const RenderPart *part )
+{
+    mdl_skin_positions(
+        inst->header, inst->data, part->model, ( const mat4 * ) inst->bones, inst->skinned_positions + part->first_vert );
+}
+
+static void SkinPartNormals( lm_model_instance_t *inst, const RenderPart *part )
+{
+    mdl_skin_normals(
+        inst->header, inst->data, part->model, ( const mat4 * ) inst->bones, inst->skinned_normals + part->first_norm );
+}
+
+static void GatherPartVertices( lm_model_instance_t *inst, const RenderPart *part )
+{
+    const float viewer_scale = 0.1f;
+
+    vec3 *positions = inst->skinned_positions + part->first_vert;
+    vec3 *normals   = inst->skinned_normals + part->first_norm;
+
+    for ( int c = part->first; c < part->first + part->count; ++c )
+    {
+        const RenderCorner *corner = &inst->corners[c];
+        float              *dst    = &inst->vertices[c * 8];
+
+        const float *P    = positions[corner->vertex];
+        const float *Nrot = normals[corner->normal];
+
+        /* ----- AXIS REMAP: Z -> Y, -Y -> Z ----- */
+        dst[0] = P[0] * viewer_scale;
+        dst[1] = P[2] * viewer_scale;
+        dst[2] = -P[1] * viewer_scale;
+
+        dst[3] = Nrot[0];
+        dst[4] = Nrot[2];
+        dst[5] = -Nrot[1];
+
+        dst[6] = corner->u;
+        dst[7] = corner->v;
+    }
+}
+
+// Below this many unique vertices + normals waking the workers costs more than it saves
+#define SKIN_JOBS_MIN_ELEMENTS 4096
+
+typedef struct {
+    lm_model_instance_t *inst;
+    const RenderPart    *part;
+    job_t                positions;
+    job_t                normals;
+    job_t                gather;    // depends on both
+} SkinPartJobs;
+
+static void SkinPositionsJob( void *arg )
+{
+    SkinPartJobs *jobs = arg;
+    SkinPartPositions( jobs->inst, jobs->part );
+}
+
+static void SkinNormalsJob( void *arg )
+{
+    SkinPartJobs *jobs = arg;
+    SkinPartNormals( jobs->inst, jobs->part );
+}
+
+static void GatherVerticesJob( void *arg )
+{
+    SkinPartJobs *jobs = arg;
+    GatherPartVertices( jobs->inst, jobs->part );
+}
+
+/*
+ * Skins every part with the instance's current bones and writes the
+ * interleaved pos/normal/uv stream for all decoded corners. With GPU
+ * skinning only the bone palette is refreshed. Big enough instances run
+ * as a job graph, every part's gather waiting on its two skinning jobs.
+ */
+static void SkinInstance( lm_model_instance_t *inst )
+{
+    const float viewer_scale = 0.1f;
+
+    if ( inst->gpu_skinned )
+    {
+        PackBoneRows( inst, viewer_scale );
+        return;
+    }
+
+    int elements = 0;
+    for ( int p = 0; p < inst->num_parts; ++p )
+    {
+        elements += inst->parts[p].model->numverts + inst->parts[p].model->numnorms;
+    }
+
+    if ( job_system_threads( ) > 1 && elements >= SKIN_JOBS_MIN_ELEMENTS )
+    {
+        SkinPartJobs jobs[MAXSTUDIOBODYPARTS];
+
+        for ( int p = 0; p < inst->num_parts; ++p )
+        {
+            jobs[p].inst = inst;
+            jobs[p].part = &inst->parts[p];
+
+            job_init( &jobs[p].positions, "skin positions", SkinPositionsJob, &jobs[p] );
+            job_init( &jobs[p].normals, "skin normals", SkinNormalsJob, &jobs[p] );
+            job_init( &jobs[p].gather, "skin gather", GatherVerticesJob, &jobs[p] );
+
+            job_add_dependency( &jobs[p].gather, &jobs[p].positions );
+            job_add_dependency( &jobs[p].gather, &jobs[p].normals );
+        }
+
+        for ( int p = 0; p < inst->num_parts; ++p )
+        {
+            job_submit( &jobs[p].gather );
+            job_submit( &jobs[p].normals );
+            job_submit( &jobs[p].positions );
+        }
+
+        for ( int p = 0; p < inst->num_parts; ++p )
+        {
+            job_wait( &jobs[p].gather );
+        }
+    }
+    else
+    {
+        for ( int p = 0; p < inst->num_parts; ++p )
+        {
+            SkinPartPositions( inst, &inst->parts[p] );
+            SkinPartNormals( inst, &inst->parts[p] );
+            GatherPartVertices( inst, &inst->parts[p] );
+        }
+    }
+
+    inst->vertices_dirty = true;
+}
+
+// Animated pose into inst->bones, or the bind pose when there is nothing (yet) to play
+static void PoseInstance( lm_model_instance_t *inst )
+{
+    if ( inst->animation_enabled && inst->header->numseq > 0 )
+    {
+        mdl_result_t anim_result = mdl_animation_calculate_bones(
+            &inst->anim, inst->header, inst->data, inst->seqgroups, inst->bones );
+
+        // Group missing or still loading in the background - show the T-pose meanwhile.
+        // The error was already printed in mdl_animation_calculate_bones.
+        if ( anim_result == MDL_SUCCESS )
+        {
+            return;
+        }
+    }
+
+    SetUpBonesInto( inst->header, inst->data, inst->bones );
+}
+
+static void ProcessInstance( const lm_render_context_t *ctx, lm_model_instance_t *inst )
+{
+    LOG_INFOF( "renderer", "Processing model for rendering" );
+
+    LOG_DEBUGF(
+        "renderer",
+        "  Header: bones=%d, bodyparts=%d, sequences=%d",
+        inst->header->numbones,
+        inst->header->numbodyparts,
+        inst->header->numseq );
+
+    /*
+     * We set the T-Pose initially and then if we want animations that is rendered
+     * in a seperate function right.
+     */
+    SetUpBonesInto( inst->header, inst->data, inst->bones );
+
+    // Decode the triangle commands once, then skin them into the vertex buffer
+    BuildMeshTopology( ctx, inst );
+    SkinInstance( inst );
+
+    inst->processed = true;
+
+    LOG_DEBUGF( "renderer", "  Processing complete:" );
+    LOG_DEBUGF( "renderer", "    Total vertices: %d", inst->num_vertices );
+    LOG_DEBUGF( "renderer", "    Draw ranges: %d", inst->num_ranges );
+
+    if ( inst->num_ranges == 0 )
+    {
+        LOG_WARNF( "renderer", "  WARNING - No draw ranges created!" );
+    }
+
+    if ( inst->num_vertices == 0 )
+    {
+        LOG_WARNF( "renderer", "  WARNING - No vertices generated!" );
+    }
+
+    LOG_INFOF( "renderer", "Model processing COMPLETE" );
+}
+
+void lm_instance_pose( const lm_render_context_t *ctx, lm_model_instance_t *inst )
+{
+    // ONE-TIME: Build mesh topology
+    if ( !inst->processed )
+    {
+        ProcessInstance( ctx, inst );
+    }
+
+    // EVERY FRAME: Update bones and re-skin vertices if animating
+    if ( inst->animation_enabled && inst->num_vertices > 0 )
+    {
+        PoseInstance( inst );
+
+        // Topology is decoded once; only positions/normals change per frame
+        SkinInstance( inst );
+    }
+}
+
+// The functions below act on the active instance, as the single-model renderer did
+
+void SkinMeshTopology( void )
+{
+    if ( g_context.active && g_context.active->processed )
+    {
+        SkinInstance( g_context.active );
+    }
+}
+
+void UpdateBonesForCurrentFrame( void )
+{
+    if ( g_context.active && g_context.active->processed )
+    {
+        PoseInstance( g_context.active );
+        SkinInstance( g_context.active );
+    }
+}
+
+void ProcessModelForRendering( void )
+{
+    if ( !g_context.active )
+    {
+        LOG_FATALF( "renderer", "FATAL - Cannot process a model before set_model_data()!" );
+        fprintf( stderr, "ERROR - Invalid argument pointers value passed!\n" );
+        return;
+    }
+
+    ProcessInstance( &g_context, g_context.active );
+}
+
+// 3 pos + 3 normal + 2 uv from whatever is bound to GL_ARRAY_BUFFER
+static void ConfigureRenderVertexAttribs( void )
+{
+    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, RENDER_VERTEX_SIZE, ( void * ) ( 0 ) );
+    glEnableVertexAttribArray( 0 );
+    glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, RENDER_VERTEX_SIZE, ( void * ) ( 3 * sizeof( float ) ) );
+    glEnableVertexAttribArray( 1 );
+    glVertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, RENDER_VERTEX_SIZE, ( void * ) ( 6 * sizeof( float ) ) );
+    glEnableVertexAttribArray( 2 );
+}
+
+static void ConfigureSkinnedVertexAttribs( void )
+{
+    const GLsizei stride = sizeof( SkinnedVertex );
+    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, stride, ( void * ) offsetof( SkinnedVertex, pos ) );
+    glEnableVertexAttribArray( 0 );
+    glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, stride, ( void * ) offsetof( SkinnedVertex, normal ) );
+    glEnableVertexAttribArray( 1 );
+    glVertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, stride, ( void * ) offsetof( SkinnedVertex, uv ) );
+    glEnableVertexAttribArray( 2 );
+    glVertexAttribIPointer( 3, 2, GL_UNSIGNED_BYTE, stride, ( void * ) offsetof( SkinnedVertex, bones ) );
+    glEnableVertexAttribArray( 3 );
+}
+
+static void CreateInstanceBuffers( const lm_render_context_t *ctx, lm_model_instance_t *inst )
+{
+    glGenBuffers( 1, &inst->vbo );
+
+    // Index buffer is part of the VAO state; every VAO below shares it
+    glGenBuffers( 1, &inst->ebo );
+
+    // Attribute layouts never change, so each VAO is configured exactly once here
+    glGenVertexArrays( 1, &inst->vao );
+    glBindVertexArray( inst->vao );
+    glBindBuffer( GL_ARRAY_BUFFER, inst->vbo );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, inst->ebo );
+    ConfigureRenderVertexAttribs( );
+
+    // The ring is sized per model on first use; see EnsureStreamCapacity()
+    glGenVertexArrays( 1, &inst->stream_vao );
+    glBindVertexArray( inst->stream_vao );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, inst->ebo );
+
+    glGenBuffers( 1, &inst->skinned_vbo );
+    glGenVertexArrays( 1, &inst->skinned_vao );
+    glBindVertexArray( inst->skinned_vao );
+    glBindBuffer( GL_ARRAY_BUFFER, inst->skinned_vbo );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, inst->ebo );
+    ConfigureSkinnedVertexAttribs( );
+
+    glBindVertexArray( 0 );
+    inst->draw_vao = inst->vao;
+
+    if ( ctx->skinned_program )
+    {
+        glGenBuffers( 1, &inst->bone_ubo );
+        glBindBuffer( GL_UNIFORM_BUFFER, inst->bone_ubo );
+        glBufferData( GL_UNIFORM_BUFFER, sizeof( inst->bone_rows ), NULL, GL_DYNAMIC_DRAW );
+        glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+    }
+}
+
+static void DeleteInstanceBuffers( lm_model_instance_t *inst )
+{
+    stream_buffer_destroy( &inst->stream );
+
+    if ( inst->vao )
+        glDeleteVertexArrays( 1, &inst->vao );
+    if ( inst->stream_vao )
+        glDeleteVertexArrays( 1, &inst->stream_vao );
+    if ( inst->skinned_vao )
+        glDeleteVertexArrays( 1, &inst->skinned_vao );
+    if ( inst->vbo )
+        glDeleteBuffers( 1, &inst->vbo );
+    if ( inst->skinned_vbo )
+        glDeleteBuffers( 1, &inst->skinned_vbo );
+    if ( inst->ebo )
+        glDeleteBuffers( 1, &inst->ebo );
+    if ( inst->bone_ubo )
+        glDeleteBuffers( 1, &inst->bone_ubo );
+}
+
+static char *read_shader_source( const char *filename )
+{
+    
+    char fullpath[512];
+    snprintf(fullpath, sizeof(fullpath), "%s/%s", SHADER_DIR, filename);
+    
+    FILE *file = fopen( fullpath, "rb" );
+    if ( !file )
+    {
+        fprintf( stderr, "ERROR - Failed to open the shader file: '%s' \n", fullpath );
+        return NULL;
+    }
+
+    fseek( file, 0, SEEK_END );
+    size_t length = ftell( file );
+    rewind( file );
+
+    char *buffer = malloc( ( length + 1 ) * sizeof( char ) );
+
+    if ( !buffer )
+    {
+        fprintf( stderr, "ERROR - Failed to allocate memory for shader file buffer!\n" );
+        fclose( file );
+        return NULL;
+    }
+
+    fread( buffer, 1, length, file );
+    buffer[length] = '\0';    // Null terminate
+    fclose( file );
+
+    return buffer;
+}
+
+static GLuint compile_shader( const char *source, GLenum type )
+{
+    GLuint shader = glCreateShader( type );
+    glShaderSource( shader, 1, &source, NULL );
+    glCompileShader( shader );
+
+    GLint success;
+    glGetShaderiv( shader, GL_COMPILE_STATUS, &success );
+
+    if ( !success )
+    {
+        char shader_info[512];
+        glGetShaderInfoLog( shader, 512, NULL, shader_info );
+        fprintf( stderr, "ERROR - Failed to compile shaders: \n%s\n", shader_info );
+        return ( 0 );
+    }
+
+    return shader;
+}
+
+static GLuint create_shader_program( GLuint vertexShader, GLuint fragmentShader )
 {
     GLuint program = glCreateProgram( );
     glAttachShader( program, vertexShader );
@@ -1017,9 +1666,9 @@ static int load_shaders( void )
         return ( -1 );
     }
 
-    shader_program = create_shader_program( vertexShader, fragmentShader );
+    g_context.shader_program = create_shader_program( vertexShader, fragmentShader );
 
-    if ( shader_program == 0 )
+    if ( g_context.shader_program == 0 )
     {
         fprintf( stderr, "ERROR - Failed to create properly a shader program!\n" );
         return ( -1 );
@@ -1028,6 +1677,115 @@ static int load_shaders( void )
     return ( 0 );
 }
 
+// Compiles and links one program from two files in SHADER_DIR; 0 on failure
+static GLuint load_program( const char *vertex_file, const char *fragment_file )
+{
+    char *vertex_shader_file   = read_shader_source( vertex_file );
+    char *fragment_shader_file = read_shader_source( fragment_file );
+
+    if ( !vertex_shader_file || !fragment_shader_file )
+    {
+        free( vertex_shader_file );
+        free( fragment_shader_file );
+        return 0;
+    }
+
+    GLuint vertexShader   = compile_shader( vertex_shader_file, GL_VERTEX_SHADER );
+    GLuint fragmentShader = compile_shader( fragment_shader_file, GL_FRAGMENT_SHADER );
+
+    free( vertex_shader_file );
+    free( fragment_shader_file );
+
+    if ( vertexShader == 0 || fragmentShader == 0 )
+    {
+        return 0;
+    }
+
+    return create_shader_program( vertexShader, fragmentShader );
+}
+
+/*
+ * Optional GPU skinning program. Failing here is not fatal - the renderer
+ * keeps skinning on the CPU and --gpu-skinning is ignored.
+ */
+static GLuint load_skinning_shader( const char *fragment_file )
+{
+    GLuint program = load_program( "skinned.vert", fragment_file );
+    if ( program == 0 )
+    {
+        return 0;
+    }
+
+    // GLSL 4.1 has no layout(binding), so the block binding is set here
+    GLuint block = glGetUniformBlockIndex( program, "Bones" );
+    if ( block == GL_INVALID_INDEX )
+    {
+        fprintf( stderr, "ERROR - skinned.vert has no 'Bones' uniform block!\n" );
+        glDeleteProgram( program );
+        return 0;
+    }
+    glUniformBlockBinding( program, block, BONE_UBO_BINDING );
+
+    // Each instance brings its own bone UBO, bound to BONE_UBO_BINDING for its draws
+    return program;
+}
+
+/*
+ * Optional instanced crowd program (--instances). Bone palettes come from a
+ * texture buffer instead of a uniform block, so there is no block binding.
+ */
+static GLuint load_crowd_shader( const char *fragment_file )
+{
+    return load_program( "crowd.vert", fragment_file );
+}
+
+/*
+ * Optional textured_palette.frag variants of the programs above, for
+ * --palette-textures. All or nothing: a model's textures are either all
+ * palettized or all RGBA, so every program it may be drawn with must have a
+ * palette twin. Also creates the all-white palette the fallback texture is
+ * drawn with.
+ */
+static int load_palette_shaders( void )
+{
+    g_context.palette_program = load_program( "textured.vert", "textured_palette.frag" );
+    if ( g_context.skinned_program )
+        g_context.skinned_palette_program = load_skinning_shader( "textured_palette.frag" );
+    if ( g_context.crowd_program )
+        g_context.crowd_palette_program = load_crowd_shader( "textured_palette.frag" );
+
+    if ( !g_context.palette_program || ( g_context.skinned_program && !g_context.skinned_palette_program )
+         || ( g_context.crowd_program && !g_context.crowd_palette_program ) )
+    {
+        if ( g_context.palette_program )
+            glDeleteProgram( g_context.palette_program );
+        if ( g_context.skinned_palette_program )
+            glDeleteProgram( g_context.skinned_palette_program );
+        if ( g_context.crowd_palette_program )
+            glDeleteProgram( g_context.crowd_palette_program );
+
+        g_context.palette_program         = 0;
+        g_context.skinned_palette_program = 0;
+        g_context.crowd_palette_program   = 0;
+        return ( -1 );
+    }
+
+    unsigned char white[256 * 4];
+    memset( white, 255, sizeof( white ) );
+
+    glGenTextures( 1, &g_context.white_palette );
+    glBindTexture( GL_TEXTURE_2D, g_context.white_palette );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    return ( 0 );
+}
+
 int init_renderer( int width, int height, const char *title )
 {
     LOG_INFOF( "renderer", "Initializing renderer: %dx%d", width, height );
@@ -1143,6 +1901,8 @@ int init_renderer( int width, int height, const char *title )
     glfwSetCursorPosCallback( window, glfw_mouse_callback );
     glfwSetMouseButtonCallback( window, glfw_mouse_button_callback );
     glfwSetScrollCallback( window, glfw_scroll_callback );
+    glfwSetWindowRefreshCallback( window, glfw_refresh_callback );
+    glfwSetFramebufferSizeCallback( window, glfw_framebuffer_size_callback );
 
     // ═══════════════════════════════════════════════════════════════
     // OpenGL state setup
@@ -1158,10 +1918,8 @@ int init_renderer( int width, int height, const char *title )
     glPointSize( 5.0f );
 
     // ═══════════════════════════════════════════════════════════════
-    // Initialize scene geometry and shaders
+    // Initialize shaders (geometry lives with each model instance)
     // ═══════════════════════════════════════════════════════════════
-    setup_triangle( );
-
     if ( load_shaders( ) != 0 )
     {
         LOG_FATALF( "renderer", "Failed to load shaders" );
@@ -1169,11 +1927,28 @@ int init_renderer( int width, int height, const char *title )
         return -1;
     }
 
+    g_context.skinned_program = load_skinning_shader( "textured.frag" );
+    if ( g_context.skinned_program == 0 )
+    {
+        LOG_WARNF( "renderer", "GPU skinning shader unavailable - skinning stays on the CPU" );
+    }
+
+    g_context.crowd_program = load_crowd_shader( "textured.frag" );
+    if ( g_context.crowd_program == 0 )
+    {
+        LOG_WARNF( "renderer", "Crowd shader unavailable - --instances is disabled" );
+    }
+
+    if ( load_palette_shaders( ) != 0 )
+    {
+        LOG_WARNF( "renderer", "Palette shader unavailable - --palette-textures is ignored" );
+    }
+
     // ═══════════════════════════════════════════════════════════════
     // Create fallback white texture (so meshes always draw)
     // ═══════════════════════════════════════════════════════════════
-    glGenTextures( 1, &g_white_tex );
-    glBindTexture( GL_TEXTURE_2D, g_white_tex );
+    glGenTextures( 1, &g_context.white_tex );
+    glBindTexture( GL_TEXTURE_2D, g_context.white_tex );
 
     unsigned char white[] = { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255 };
 
@@ -1203,6 +1978,7 @@ int init_renderer( int width, int height, const char *title )
     printf( "║ RENDER MODES                       ║\n" );
     printf( "║   F          : Toggle wireframe    ║\n" );
     printf( "║   P          : Points mode         ║\n" );
+    printf( "║   K          : Next skin family    ║\n" );
     printf( "╠════════════════════════════════════╣\n" );
     printf( "║ ANIMATION CONTROLS                 ║\n" );
     printf( "║   SPACE      : Toggle animation    ║\n" );
@@ -1220,43 +1996,149 @@ int init_renderer( int width, int height, const char *title )
     return 0;
 }
 
-void cleanup_renderer( void )
+void cleanup_renderer( void )
+{
+    if ( g_context.crowd )
+    {
+        lm_crowd_destroy( &g_context, g_context.crowd );
+    }
+
+    while ( g_context.num_instances > 0 )
+    {
+        lm_instance_destroy( &g_context, g_context.instances[g_context.num_instances - 1] );
+    }
+    free( g_context.instances );
+    g_context.instances         = NULL;
+    g_context.instance_capacity = 0;
+
+    mdl_anim_cache_clear( );
+    mdl_skin_plans_clear( );
+
+    if ( g_context.shader_program )
+        glDeleteProgram( g_context.shader_program );
+    if ( g_context.skinned_program )
+        glDeleteProgram( g_context.skinned_program );
+    if ( g_context.crowd_program )
+        glDeleteProgram( g_context.crowd_program );
+    if ( g_context.palette_program )
+        glDeleteProgram( g_context.palette_program );
+    if ( g_context.skinned_palette_program )
+        glDeleteProgram( g_context.skinned_palette_program );
+    if ( g_context.crowd_palette_program )
+        glDeleteProgram( g_context.crowd_palette_program );
+    if ( g_context.white_tex )
+        glDeleteTextures( 1, &g_context.white_tex );
+    if ( g_context.white_palette )
+        glDeleteTextures( 1, &g_context.white_palette );
+
+    g_context.shader_program          = 0;
+    g_context.skinned_program         = 0;
+    g_context.crowd_program           = 0;
+    g_context.palette_program         = 0;
+    g_context.skinned_palette_program = 0;
+    g_context.crowd_palette_program   = 0;
+    g_context.white_tex               = 0;
+    g_context.white_palette           = 0;
+
+    if ( window )
+    {
+        glfwDestroyWindow( window );
+    }
+
+    glfwTerminate( );
+    return;
+}
+
+void clear_screen( void )
+{
+    glClearColor( 0.1f, 0.2f, 0.45f, 1.0f );
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
+}
+
+bool should_close_window( void )
+{
+    return glfwWindowShouldClose( window );
+}
+
+void request_redraw( void )
+{
+    g_redraw_requested = true;
+}
+
+void set_render_on_demand( bool enabled )
+{
+    g_render_on_demand = enabled;
+    g_redraw_requested = true;
+}
+
+lm_render_context_t *lm_render_context( void )
+{
+    return &g_context;
+}
+
+// True while mdl_animation_update() would still move the pose
+bool lm_instance_is_playing( const lm_model_instance_t *inst )
 {
-    if ( VAO )
-        glDeleteVertexArrays( 1, &VAO );
-    if ( VBO )
-        glDeleteBuffers( 1, &VBO );
-    if ( EBO )
-        glDeleteBuffers( 1, &EBO );
-    if ( shader_program )
-        glDeleteProgram( shader_program );
+    if ( !inst->animation_enabled || inst->header->numseq <= 0 )
+    {
+        return false;
+    }
 
-    if ( window )
+    mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( inst->data + inst->header->seqindex );
+    mstudioseqdesc_t *seq       = &sequences[inst->anim.current_sequence];
+
+    if ( seq->numframes <= 1 || seq->fps <= 0.0f )
     {
-        glfwDestroyWindow( window );
+        return false;
     }
 
-    glfwTerminate( );
-    return;
+    return inst->anim.is_looping || inst->anim.current_frame < ( float ) ( seq->numframes - 1 );
 }
 
-void clear_screen( void )
+void lm_instance_advance( lm_model_instance_t *inst, float delta_time )
 {
-    glClearColor( 0.1f, 0.2f, 0.45f, 1.0f );
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
+    mdl_animation_update( &inst->anim, delta_time, inst->header, inst->data, inst->seqgroups );
 }
 
-bool should_close_window( void )
+void lm_instance_set_origin( lm_model_instance_t *inst, vec3 origin )
 {
-    return glfwWindowShouldClose( window );
+    glm_vec3_copy( origin, inst->origin );
+    request_redraw( );
+}
+
+void lm_instance_set_bodygroup( lm_model_instance_t *inst, int bodygroup )
+{
+    if ( inst->bodygroup != bodygroup )
+    {
+        inst->bodygroup = bodygroup;
+        inst->processed = false;
+        request_redraw( );
+    }
+}
+
+void lm_instance_set_skin( lm_model_instance_t *inst, int skin )
+{
+    if ( inst->skin != skin )
+    {
+        const int family = SkinFamily( inst );
+        inst->skin       = skin;
+
+        // Same UVs under every family: the next draw just reads another row of bindings
+        if ( !inst->skin_uv_shared && SkinFamily( inst ) != family )
+        {
+            inst->processed = false;
+        }
+        request_redraw( );
+    }
 }
 
 void render_loop( void )
 {
-    LOG_INFOF( "renderer", "Entering render loop" );
+    LOG_INFOF( "renderer", "Entering render loop (%s)", g_render_on_demand ? "on demand" : "continuous" );
 
-    double last_time   = glfwGetTime( );
-    int    frame_count = 0;
+    int    frame_count  = 0;
+    int    idle_wakeups = 0;
+    double last_draw    = 0.0;
 
     g_last_frame_time = glfwGetTime( );    // Initialize to current time
 
@@ -1264,11 +2146,9 @@ void render_loop( void )
     {
         LOG_TRACEF( "renderer", "=== Frame %d START ===", frame_count );
 
-        // CRITICAL: Check for NULL before ANYTHING
-        if ( !global_header || !global_data )
+        if ( g_context.num_instances == 0 && !g_context.crowd )
         {
-            LOG_ERRORF(
-                "renderer", "NULL model data! header=%p data=%p", ( void * ) global_header, ( void * ) global_data );
+            LOG_ERRORF( "renderer", "No model to render - call set_model_data() first" );
             break;
         }
 
@@ -1291,46 +2171,83 @@ void render_loop( void )
 
         LOG_TRACEF( "renderer", "Frame %d: Delta time = %.4f", frame_count, delta_time );
 
+        bool animating   = false;
+        bool unprocessed = false;
+
         // Update animation state
-        if ( g_animation_enabled && global_header && global_data )
+        for ( int i = 0; i < g_context.num_instances; ++i )
         {
-            LOG_TRACEF( "renderer", "Frame %d: Updating animation", frame_count );
-            mdl_animation_update( &g_anim_state, delta_time, global_header, global_data, global_seqgroups );
+            lm_model_instance_t *inst = g_context.instances[i];
+
+            if ( lm_instance_is_playing( inst ) )
+            {
+                lm_instance_advance( inst, delta_time );
+                animating = true;
+            }
+            unprocessed |= !inst->processed;
         }
 
-        // Clear and render
-        LOG_TRACEF( "renderer", "Frame %d: Clearing screen", frame_count );
-        clear_screen( );
+        if ( g_context.crowd && lm_crowd_is_playing( g_context.crowd ) )
+        {
+            lm_crowd_advance( g_context.crowd, delta_time );
+            animating = true;
+        }
 
-        if ( global_header && global_data )
+        if ( !g_render_on_demand || g_redraw_requested || animating || unprocessed )
         {
+            g_redraw_requested = false;
+
+            // Clear and render
+            LOG_TRACEF( "renderer", "Frame %d: Clearing screen", frame_count );
+            clear_screen( );
+
             LOG_TRACEF( "renderer", "Frame %d: Calling render_model", frame_count );
-            render_model( global_header, global_data );
+            render_model( NULL, NULL );
             LOG_TRACEF( "renderer", "Frame %d: render_model returned", frame_count );
-        }
 
-        LOG_TRACEF( "renderer", "Frame %d: Swapping buffers", frame_count );
-        glfwSwapBuffers( window );
+            LOG_TRACEF( "renderer", "Frame %d: Swapping buffers", frame_count );
+            glfwSwapBuffers( window );
 
-        LOG_TRACEF( "renderer", "Frame %d: Polling events", frame_count );
-        glfwPollEvents( );
+            last_draw = current_time;
+            frame_count++;
 
-        frame_count++;
+            if ( frame_count % 60 == 0 )
+            {
+                LOG_DEBUGF( "renderer", "Rendered %d frames", frame_count );
+            }
+        }
 
-        if ( frame_count % 60 == 0 )
+        LOG_TRACEF( "renderer", "Frame %d: Polling events", frame_count );
+        if ( !g_render_on_demand )
+        {
+            glfwPollEvents( );
+        }
+        else if ( animating )
         {
-            LOG_DEBUGF( "renderer", "Rendered %d frames", frame_count );
+            // Sleep until the next animation frame is due, input wakes us early
+            double wait = last_draw + ANIM_REDRAW_INTERVAL - glfwGetTime( );
+            if ( wait > 0.0 )
+                glfwWaitEventsTimeout( wait );
+            else
+                glfwPollEvents( );
+        }
+        else
+        {
+            // Nothing moves: block until an event (or the timeout) arrives
+            glfwWaitEventsTimeout( IDLE_WAIT_TIMEOUT );
+            idle_wakeups++;
         }
 
         LOG_TRACEF( "renderer", "=== Frame %d END ===", frame_count - 1 );
     }
 
-    LOG_INFOF( "renderer", "Exiting render loop after %d frames", frame_count );
+    LOG_INFOF( "renderer", "Exiting render loop after %d frames (%d idle waits)", frame_count, idle_wakeups );
 }
 
 void set_wireframe_mode( bool enabled )
 {
     wireframe_enabled = enabled;    // Now it's used
+    request_redraw( );
 
     if ( wireframe_enabled )
     {
@@ -1347,225 +2264,267 @@ void set_current_texture( unsigned int texture_id )
     current_texture = texture_id;
 }
 
-void render_model( studiohdr_t *header, unsigned char *data )
+/*
+ * (Re)creates the instance's ring when a region cannot hold `bytes`, growing
+ * by half again so a few bodygroup switches do not each reallocate. Its
+ * stream VAO is re-pointed only then.
+ */
+static bool EnsureStreamCapacity( lm_model_instance_t *inst, size_t bytes )
 {
-    LOG_TRACEF( "renderer", "render_model() START" );
+    stream_buffer_t *stream = &inst->stream;
 
-    ( void ) header;
-    ( void ) data;
+    if ( stream->buffer && bytes <= stream->region_size )
+    {
+        return true;
+    }
 
-    // ONE-TIME: Build mesh topology
-    if ( !model_processed )
+    size_t region = stream->region_size + stream->region_size / 2;
+    if ( region < bytes )
     {
-        LOG_DEBUGF( "renderer", "First frame - processing model" );
-        ProcessModelForRendering( );
-        LOG_DEBUGF(
-            "renderer", "Model processing complete - %d vertices, %d ranges", total_render_vertices, g_num_ranges );
+        region = bytes;
     }
+    region = ( region + RENDER_VERTEX_SIZE - 1 ) / RENDER_VERTEX_SIZE * RENDER_VERTEX_SIZE;
 
-    if ( total_render_vertices == 0 )
+    stream_buffer_destroy( stream );
+    if ( !inst->stream_vao || !stream_buffer_create( stream, region ) )
     {
-        LOG_WARNF( "renderer", "No vertices to render!" );
-        return;
+        return false;
     }
 
-    LOG_TRACEF(
-        "renderer",
-        "render_model: animated=%d, vertices=%d, ranges=%d",
-        g_animation_enabled,
-        total_render_vertices,
-        g_num_ranges );
+    glBindVertexArray( inst->stream_vao );
+    glBindBuffer( GL_ARRAY_BUFFER, stream->buffer );
+    ConfigureRenderVertexAttribs( );
+    glBindVertexArray( 0 );
 
-    // EVERY FRAME: Update bones and re-skin vertices if animating
-    if ( g_animation_enabled && global_header && global_data )
-    {
-        // Calculate animated bone transforms directly into g_bonetransformations
-        mdl_result_t anim_result = mdl_animation_calculate_bones(
-            &g_anim_state, global_header, global_data, global_seqgroups, g_bonetransformations );
+    return true;
+}
+
+/*
+ * Hands the freshly skinned inst->vertices to the GPU and points
+ * draw_vao/draw_base_vertex at them. Animated frames go through the ring so
+ * the GPU can still be drawing the previous ones; anything else is uploaded
+ * into the instance VBO once and drawn from there for as long as it stays
+ * unchanged.
+ */
+static void UploadRenderVertices( lm_model_instance_t *inst )
+{
+    const size_t bytes = ( size_t ) inst->num_vertices * RENDER_VERTEX_SIZE;
+
+    inst->vertices_dirty = false;
 
-        // CRITICAL FIX: If sequence group is missing, fall back to T-pose
-        if ( anim_result == MDL_ERROR_SEQUENCE_GROUP_MISSING )
+    if ( inst->animation_enabled && bytes > 0 && EnsureStreamCapacity( inst, bytes ) )
+    {
+        void *dst = stream_buffer_map( &inst->stream, bytes );
+        if ( dst )
         {
-            // Fallback to T-pose by using static bone setup
-            SetUpBones( global_header, global_data );
+            memcpy( dst, inst->vertices, bytes );
+            stream_buffer_unmap( &inst->stream );
 
-            // Don't spam the console - this error was already printed in mdl_animation_calculate_bones
-            // Just continue rendering with T-pose
+            inst->draw_vao         = inst->stream_vao;
+            inst->draw_base_vertex = ( GLint ) ( stream_buffer_offset( &inst->stream ) / RENDER_VERTEX_SIZE );
+            return;
         }
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, inst->vbo );
+    if ( bytes > inst->vbo_capacity )
+    {
+        glBufferData( GL_ARRAY_BUFFER, ( GLsizeiptr ) bytes, inst->vertices, GL_STATIC_DRAW );
+        inst->vbo_capacity = bytes;
+    }
+    else
+    {
+        glBufferSubData( GL_ARRAY_BUFFER, 0, ( GLsizeiptr ) bytes, inst->vertices );
+    }
 
-        // Re-transform vertices with new bone positions
-        mstudiobodyparts_t *bodyparts = ( mstudiobodyparts_t * ) ( global_data + global_header->bodypartindex );
+    inst->draw_vao         = inst->vao;
+    inst->draw_base_vertex = 0;
+}
 
-        // CRITICAL: Re-build the vertex buffer with new skinned positions
-        // We need to rebuild the render buffer because AddVertexToBuffer reads from skinned_positions
-        total_render_vertices = 0;
-        g_num_ranges          = 0;
+// GPU-skinned vertices and indices only change when the topology is rebuilt
+static void UploadStaticBuffers( lm_model_instance_t *inst )
+{
+    if ( inst->gpu_skinned && inst->skinned_vertices_dirty )
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, inst->skinned_vbo );
+        glBufferData(
+            GL_ARRAY_BUFFER,
+            ( GLsizeiptr ) ( inst->num_vertices * sizeof( SkinnedVertex ) ),
+            inst->skinned_vertices,
+            GL_STATIC_DRAW );
+        inst->skinned_vertices_dirty = false;
+    }
 
-        // Rebuild vertex data with updated skinned positions
-        for ( int bp = 0; bp < global_header->numbodyparts; ++bp )
-        {
-            mstudiobodyparts_t *bpRec                = &bodyparts[bp];
-            mstudiomodel_t     *models               = ( mstudiomodel_t * ) ( global_data + bpRec->modelindex );
-            int                 selected_model_index = bodypart_get_model_index( bp );
+    if ( inst->indexed && inst->indices_dirty )
+    {
+        // The EBO is VAO state; binding it outside a VAO would not stick
+        glBindVertexArray( inst->vao );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, inst->ebo );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, ( GLsizeiptr ) inst->index_bytes, inst->index_data, GL_STATIC_DRAW );
+        glBindVertexArray( 0 );
+        inst->indices_dirty = false;
+    }
+}
 
-            if ( selected_model_index < 0 || selected_model_index >= bpRec->nummodels )
-            {
-                selected_model_index = 0;
-            }
+bool lm_instance_prepare_instanced( const lm_render_context_t *ctx, lm_model_instance_t *inst )
+{
+    if ( !inst->skinned_layout )
+    {
+        inst->skinned_layout = true;
+        inst->processed      = false;
+    }
+
+    if ( !inst->processed )
+    {
+        ProcessInstance( ctx, inst );
+    }
 
-            mstudiomodel_t *model = &models[selected_model_index];
+    UploadStaticBuffers( inst );
+    return inst->num_vertices > 0 && inst->num_ranges > 0;
+}
 
-            TransformVertices( global_header, global_data, model, skinned_positions );
-            have_skinned_positions = true;
+void lm_instance_draw(
+    const lm_render_context_t *ctx, lm_model_instance_t *inst, mat4 scene, mat4 view, mat4 projection, vec3 camera_pos )
+{
+    if ( inst->num_vertices == 0 )
+    {
+        LOG_WARNF( "renderer", "No vertices to render!" );
+        return;
+    }
 
-            g_current.model        = model;
-            g_current.vertices     = ( vec3_t * ) ( global_data + model->vertindex );
-            g_current.normals      = ( vec3_t * ) ( global_data + model->normindex );
-            g_current.vertex_count = model->numverts;
-            g_current.normal_count = model->numnorms;
+    LOG_TRACEF(
+        "renderer",
+        "lm_instance_draw: animated=%d, vertices=%d, ranges=%d",
+        inst->animation_enabled,
+        inst->num_vertices,
+        inst->num_ranges );
 
-            mstudiomesh_t *meshes      = ( mstudiomesh_t * ) ( global_data + model->meshindex );
-            const short   *skin_table  = ( const short * ) ( global_data + global_header->skinindex );
-            const int      numskinref  = global_header->numskinref;
-            const int      skin_family = 0;
+    const bool   palettized = inst->textures.mode == MDL_TEXTURE_PALETTE;
+    const GLuint program    = inst->gpu_skinned ? ( palettized ? ctx->skinned_palette_program : ctx->skinned_program )
+                                                : ( palettized ? ctx->palette_program : ctx->shader_program );
+    glUseProgram( program );
 
-            for ( int mesh = 0; mesh < model->nummesh; ++mesh )
-            {
-                const int norm_base = meshes[mesh].normindex;
+    mat4 M;
+    glm_mat4_copy( scene, M );
+    glm_translate( M, inst->origin );
 
-                int tex_index = meshes[mesh].skinref;
-                if ( skin_table && numskinref > 0 && tex_index >= 0 && tex_index < numskinref )
-                {
-                    tex_index = skin_table[skin_family * numskinref + tex_index];
-                }
+    GLint uModel = glGetUniformLocation( program, "model" );
+    GLint uView  = glGetUniformLocation( program, "view" );
+    GLint uProj  = glGetUniformLocation( program, "projection" );
+    if ( uModel != -1 )
+        glUniformMatrix4fv( uModel, 1, GL_FALSE, ( const float * ) M );
+    if ( uView != -1 )
+        glUniformMatrix4fv( uView, 1, GL_FALSE, ( const float * ) view );
+    if ( uProj != -1 )
+        glUniformMatrix4fv( uProj, 1, GL_FALSE, ( const float * ) projection );
 
-                GLuint gl_tex = 0;
-                int    texW = 1, texH = 1;
-                if ( tex_index >= 0 && tex_index < g_textures.count )
-                {
-                    gl_tex = g_textures.textures[tex_index].gl_id;
-                    texW   = g_textures.textures[tex_index].width;
-                    texH   = g_textures.textures[tex_index].height;
-                    if ( texW <= 0 )
-                        texW = 1;
-                    if ( texH <= 0 )
-                        texH = 1;
-                }
-                if ( !gl_tex && g_white_tex )
-                {
-                    gl_tex = g_white_tex;
-                    texW   = 2;
-                    texH   = 2;
-                }
+    vec3  lightPos = { 3.0f, 5.0f, 4.0f };
+    GLint uLight   = glGetUniformLocation( program, "lightPos" );
+    GLint uViewP   = glGetUniformLocation( program, "viewPos" );
+    if ( uLight != -1 )
+        glUniform3fv( uLight, 1, ( const float * ) lightPos );
+    if ( uViewP != -1 )
+        glUniform3fv( uViewP, 1, ( const float * ) camera_pos );
 
-                short    *ptricmds    = ( short * ) ( global_data + meshes[mesh].triindex );
-                const int start_first = total_render_vertices;
+    GLuint vao         = inst->draw_vao;
+    GLint  base_vertex = inst->draw_base_vertex;
+    bool   streamed    = false;
 
-                int i;
-                while ( ( i = *( ptricmds++ ) ) )
-                {
-                    if ( i < 0 )
-                    {
-                        // Triangle fan
-                        i        = -i;
-                        short v0 = ptricmds[0], n0 = ptricmds[1], s0 = ptricmds[2], t0 = ptricmds[3];
-                        ptricmds += 4;
-                        short v1 = ptricmds[0], n1 = ptricmds[1], s1 = ptricmds[2], t1 = ptricmds[3];
-                        ptricmds += 4;
-
-                        if ( n0 & 0x8000 )
-                            s0 += texW / 2;
-                        n0 &= 0x7FFF;
-                        if ( n1 & 0x8000 )
-                            s1 += texW / 2;
-                        n1 &= 0x7FFF;
-                        n0 += norm_base;
-                        n1 += norm_base;
-
-                        for ( int j = 2; j < i; ++j )
-                        {
-                            short v2 = ptricmds[0], n2 = ptricmds[1], s2 = ptricmds[2], t2 = ptricmds[3];
-                            ptricmds += 4;
-                            if ( n2 & 0x8000 )
-                                s2 += texW / 2;
-                            n2 &= 0x7FFF;
-                            n2 += norm_base;
-
-                            AddVertexToBuffer( v0, n0, s0, t0, ( float ) texW, ( float ) texH );
-                            AddVertexToBuffer( v1, n1, s1, t1, ( float ) texW, ( float ) texH );
-                            AddVertexToBuffer( v2, n2, s2, t2, ( float ) texW, ( float ) texH );
-
-                            v1 = v2;
-                            n1 = n2;
-                            s1 = s2;
-                            t1 = t2;
-                        }
-                    }
-                    else
-                    {
-                        // Triangle strip
-                        short v0 = ptricmds[0], n0 = ptricmds[1], s0 = ptricmds[2], t0 = ptricmds[3];
-                        ptricmds += 4;
-                        short v1 = ptricmds[0], n1 = ptricmds[1], s1 = ptricmds[2], t1 = ptricmds[3];
-                        ptricmds += 4;
-
-                        if ( n0 & 0x8000 )
-                            s0 += texW / 2;
-                        n0 &= 0x7FFF;
-                        if ( n1 & 0x8000 )
-                            s1 += texW / 2;
-                        n1 &= 0x7FFF;
-                        n0 += norm_base;
-                        n1 += norm_base;
-
-                        for ( int j = 2; j < i; ++j )
-                        {
-                            short v2 = ptricmds[0], n2 = ptricmds[1], s2 = ptricmds[2], t2 = ptricmds[3];
-                            ptricmds += 4;
-                            if ( n2 & 0x8000 )
-                                s2 += texW / 2;
-                            n2 &= 0x7FFF;
-                            n2 += norm_base;
-
-                            if ( ( j - 2 ) % 2 == 0 )
-                            {
-                                AddVertexToBuffer( v0, n0, s0, t0, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v1, n1, s1, t1, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v2, n2, s2, t2, ( float ) texW, ( float ) texH );
-                            }
-                            else
-                            {
-                                AddVertexToBuffer( v1, n1, s1, t1, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v0, n0, s0, t0, ( float ) texW, ( float ) texH );
-                                AddVertexToBuffer( v2, n2, s2, t2, ( float ) texW, ( float ) texH );
-                            }
-
-                            v0 = v1;
-                            n0 = n1;
-                            s0 = s1;
-                            t0 = t1;
-                            v1 = v2;
-                            n1 = n2;
-                            s1 = s2;
-                            t1 = t2;
-                        }
-                    }
-                }
+    UploadStaticBuffers( inst );
 
-                if ( g_num_ranges < MAX_DRAW_RANGES )
-                {
-                    g_ranges[g_num_ranges].tex   = gl_tex;
-                    g_ranges[g_num_ranges].first = start_first;
-                    g_ranges[g_num_ranges].count = total_render_vertices - start_first;
-                    g_num_ranges++;
-                }
-            }
+    if ( inst->gpu_skinned )
+    {
+        if ( inst->bone_rows_dirty )
+        {
+            glBindBuffer( GL_UNIFORM_BUFFER, inst->bone_ubo );
+            glBufferSubData(
+                GL_UNIFORM_BUFFER,
+                0,
+                ( GLsizeiptr ) ( inst->header->numbones * 12 * sizeof( float ) ),
+                inst->bone_rows );
+            glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+            inst->bone_rows_dirty = false;
+        }
+
+        glBindBufferBase( GL_UNIFORM_BUFFER, BONE_UBO_BINDING, inst->bone_ubo );
+
+        vao         = inst->skinned_vao;
+        base_vertex = 0;
+    }
+    else if ( inst->vertices_dirty )
+    {
+        UploadRenderVertices( inst );
+        vao         = inst->draw_vao;
+        base_vertex = inst->draw_base_vertex;
+    }
+
+    streamed = !inst->gpu_skinned && vao == inst->stream_vao;
+    glBindVertexArray( vao );
+
+    GLint uTex     = glGetUniformLocation( program, "tex" );
+    GLint uPalette = glGetUniformLocation( program, "palette" );
+    GLint uMasked  = glGetUniformLocation( program, "masked" );
+    if ( uTex != -1 )
+        glUniform1i( uTex, 0 );
+    if ( uPalette != -1 )
+        glUniform1i( uPalette, LM_PALETTE_TEXTURE_UNIT );
+
+    const SkinBinding *skins = lm_instance_skins( inst );
+
+    for ( int r = 0; r < inst->num_ranges; ++r )
+    {
+        const DrawRange   *range       = &inst->ranges[r];
+        const SkinBinding *skin        = &skins[range->skinref];
+        GLuint             tex_to_bind = skin->tex ? skin->tex : ctx->white_tex;
+        if ( palettized )
+        {
+            glActiveTexture( GL_TEXTURE0 + LM_PALETTE_TEXTURE_UNIT );
+            glBindTexture( GL_TEXTURE_2D, skin->palette ? skin->palette : ctx->white_palette );
+            if ( uMasked != -1 )
+                glUniform1i( uMasked, skin->masked );
+        }
+        glActiveTexture( GL_TEXTURE0 );
+        glBindTexture( GL_TEXTURE_2D, tex_to_bind );
+        if ( inst->indexed )
+        {
+            glDrawElementsBaseVertex(
+                GL_TRIANGLES, range->count, range->index_type, ( const void * ) range->index_offset, base_vertex );
+        }
+        else
+        {
+            glDrawArrays( GL_TRIANGLES, base_vertex + range->first, range->count );
         }
     }
 
-    glUseProgram( shader_program );
+    // The ring region these draws read is off limits until the GPU passes this point
+    if ( streamed )
+    {
+        stream_buffer_fence( &inst->stream );
+    }
+}
+
+/*
+ * Draws every instance of the context, then the crowd if there is one, with
+ * the current camera. The header and data arguments are left over from the
+ * single-model renderer and are ignored; each instance carries its own.
+ */
+void render_model( studiohdr_t *header, unsigned char *data )
+{
+    LOG_TRACEF( "renderer", "render_model() START" );
+
+    ( void ) header;
+    ( void ) data;
+
+    // Pose everything first so the CPU work stays separate from the GL calls
+    for ( int i = 0; i < g_context.num_instances; ++i )
+    {
+        lm_instance_pose( &g_context, g_context.instances[i] );
+    }
+    if ( g_context.crowd )
+    {
+        lm_crowd_pose( g_context.crowd );
+    }
 
-    // Rest of your existing render code...
     int fbw, fbh;
     glfwGetFramebufferSize( window, &fbw, &fbh );
     float aspect = ( fbh > 0 ) ? ( float ) fbw / ( float ) fbh : 1.0f;
@@ -1585,99 +2544,194 @@ void render_model( studiohdr_t *header, unsigned char *data )
     mat4 P;
     glm_perspective( glm_rad( 50.0f ), aspect, 0.01f, 1000.0f, P );
 
-    GLint uModel = glGetUniformLocation( shader_program, "model" );
-    GLint uView  = glGetUniformLocation( shader_program, "view" );
-    GLint uProj  = glGetUniformLocation( shader_program, "projection" );
-    if ( uModel != -1 )
-        glUniformMatrix4fv( uModel, 1, GL_FALSE, ( const float * ) M );
-    if ( uView != -1 )
-        glUniformMatrix4fv( uView, 1, GL_FALSE, ( const float * ) V );
-    if ( uProj != -1 )
-        glUniformMatrix4fv( uProj, 1, GL_FALSE, ( const float * ) P );
+    for ( int i = 0; i < g_context.num_instances; ++i )
+    {
+        lm_instance_draw( &g_context, g_context.instances[i], M, V, P, camPos );
+    }
+    if ( g_context.crowd )
+    {
+        lm_crowd_draw( &g_context, g_context.crowd, M, V, P, camPos );
+    }
+}
 
-    vec3  lightPos = { 3.0f, 5.0f, 4.0f };
-    GLint uLight   = glGetUniformLocation( shader_program, "lightPos" );
-    GLint uViewP   = glGetUniformLocation( shader_program, "viewPos" );
-    if ( uLight != -1 )
-        glUniform3fv( uLight, 1, ( const float * ) lightPos );
-    if ( uViewP != -1 )
-        glUniform3fv( uViewP, 1, ( const float * ) camPos );
+static lm_model_instance_t *CreateInstance(
+    lm_render_context_t *ctx,
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups )
+{
+    if ( !header || !data )
+    {
+        LOG_ERRORF( "renderer", "NULL model data passed to renderer!" );
+        return NULL;
+    }
 
-    glBindVertexArray( VAO );
-    glBindBuffer( GL_ARRAY_BUFFER, VBO );
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        ( GLsizeiptr ) ( total_render_vertices * 8 * sizeof( float ) ),
-        render_vertex_buffer,
-        GL_STATIC_DRAW );
+    lm_model_instance_t *inst = calloc( 1, sizeof( *inst ) );
+    if ( !inst )
+    {
+        fprintf( stderr, "ERROR - Failed to allocate a model instance!\n" );
+        return NULL;
+    }
 
-    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof( float ), ( void * ) ( 0 ) );
-    glEnableVertexAttribArray( 0 );
-    glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof( float ), ( void * ) ( 3 * sizeof( float ) ) );
-    glEnableVertexAttribArray( 1 );
-    glVertexAttribPointer( 2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof( float ), ( void * ) ( 6 * sizeof( float ) ) );
-    glEnableVertexAttribArray( 2 );
+    inst->header        = header;
+    inst->data          = data;
+    inst->tex_header    = tex_header;
+    inst->tex_data      = tex_data;
+    inst->seqgroups     = seqgroups;
+    inst->num_seqgroups = num_seqgroups;
 
-    GLint uTex = glGetUniformLocation( shader_program, "tex" );
-    if ( uTex != -1 )
-        glUniform1i( uTex, 0 );
+    // Pick which header to use (embedded or T.mdl)
+    const studiohdr_t *texHdr = mdl_pick_texture_header( header, tex_header );
+    if ( texHdr )
+    {
+        const mdl_texture_mode_t mode = ( ctx->palette_textures && ctx->palette_program ) ? MDL_TEXTURE_PALETTE
+                                      : ctx->atlas_textures                               ? MDL_TEXTURE_ATLAS
+                                                                                          : MDL_TEXTURE_RGBA;
+        mdl_load_textures( texHdr, ( texHdr == header ) ? data : tex_data, mode, &inst->textures );
+    }
 
-    for ( int r = 0; r < g_num_ranges; ++r )
+    if ( !BuildSkinBindings( ctx, inst ) )
     {
-        GLuint tex_to_bind = g_ranges[r].tex ? g_ranges[r].tex : g_white_tex;
-        glActiveTexture( GL_TEXTURE0 );
-        glBindTexture( GL_TEXTURE_2D, tex_to_bind );
-        glDrawArrays( GL_TRIANGLES, g_ranges[r].first, g_ranges[r].count );
+        fprintf( stderr, "ERROR - Failed to allocate the skin bindings!\n" );
+        mdl_free_texture( &inst->textures );
+        free( inst );
+        return NULL;
+    }
+
+    CreateInstanceBuffers( ctx, inst );
+
+    mdl_animation_init( &inst->anim );
+    if ( header->numseq > 0 )
+    {
+        mdl_animation_set_sequence( &inst->anim, 0, header, data, seqgroups );
+        inst->animation_enabled = true;
     }
+
+    return inst;
 }
-void set_model_data( studiohdr_t *header, unsigned char *data, studiohdr_t *tex_header, unsigned char *tex_data, mdl_seqgroup_blob_t *seqgroups, int num_seqgroups )
+
+lm_model_instance_t *lm_instance_create_detached(
+    lm_render_context_t *ctx,
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups )
 {
-    
-    LOG_INFOF("renderer", "Setting model data");
-    
-    if (!header || !data) {
-        LOG_ERRORF("renderer", "NULL model data passed to renderer!");
+    return CreateInstance( ctx, header, data, tex_header, tex_data, seqgroups, num_seqgroups );
+}
+
+lm_model_instance_t *lm_instance_create(
+    lm_render_context_t *ctx,
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups )
+{
+    if ( ctx->num_instances == ctx->instance_capacity )
+    {
+        int                   capacity  = ctx->instance_capacity ? ctx->instance_capacity * 2 : 4;
+        lm_model_instance_t **instances = realloc( ctx->instances, ( size_t ) capacity * sizeof( *instances ) );
+        if ( !instances )
+        {
+            fprintf( stderr, "ERROR - Failed to grow the renderer instance list!\n" );
+            return NULL;
+        }
+        ctx->instances         = instances;
+        ctx->instance_capacity = capacity;
+    }
+
+    lm_model_instance_t *inst = CreateInstance( ctx, header, data, tex_header, tex_data, seqgroups, num_seqgroups );
+    if ( !inst )
+    {
+        return NULL;
+    }
+
+    ctx->instances[ctx->num_instances++] = inst;
+    ctx->active                          = inst;
+
+    request_redraw( );
+    return inst;
+}
+
+void lm_instance_destroy( lm_render_context_t *ctx, lm_model_instance_t *inst )
+{
+    if ( !inst )
+        return;
+
+    for ( int i = 0; i < ctx->num_instances; ++i )
+    {
+        if ( ctx->instances[i] == inst )
+        {
+            memmove( &ctx->instances[i], &ctx->instances[i + 1], ( size_t ) ( ctx->num_instances - i - 1 ) * sizeof( inst ) );
+            ctx->num_instances--;
+            break;
+        }
+    }
+
+    if ( ctx->active == inst )
+    {
+        ctx->active = ctx->num_instances > 0 ? ctx->instances[ctx->num_instances - 1] : NULL;
+    }
+
+    DeleteInstanceBuffers( inst );
+    ArenaRelease( &inst->arena );
+
+    if ( inst->textures.textures )
+    {
+        mdl_free_texture( &inst->textures );
+    }
+
+    free( inst->skin_bindings );
+    free( inst );
+    request_redraw( );
+}
+
+/*
+ * Single-model entry point: replaces whatever the renderer draws with one
+ * instance of this model. Use lm_instance_create() to draw several.
+ */
+void set_model_data(
+    studiohdr_t         *header,
+    unsigned char       *data,
+    studiohdr_t         *tex_header,
+    unsigned char       *tex_data,
+    mdl_seqgroup_blob_t *seqgroups,
+    int                  num_seqgroups )
+{
+    LOG_INFOF( "renderer", "Setting model data" );
+
+    if ( !header || !data )
+    {
+        LOG_ERRORF( "renderer", "NULL model data passed to renderer!" );
         return;
     }
-    
-    LOG_DEBUGF("renderer", "  Bones: %d", header->numbones);
-    LOG_DEBUGF("renderer", "  Bodyparts: %d", header->numbodyparts);
-    LOG_DEBUGF("renderer", "  Sequences: %d", header->numseq);
-    
-    global_header     = header;
-    global_data       = data;
-    global_tex_header = tex_header;    // may be NULL
-    global_tex_data   = tex_data;      // may be NULL
-    global_seqgroups  = seqgroups;
-    global_num_seqgroups = num_seqgroups;
 
-    model_processed         = false;
-    bone_system_initialized = false;
-    total_render_vertices   = 0;
+    LOG_DEBUGF( "renderer", "  Bones: %d", header->numbones );
+    LOG_DEBUGF( "renderer", "  Bodyparts: %d", header->numbodyparts );
+    LOG_DEBUGF( "renderer", "  Sequences: %d", header->numseq );
 
-    // Free old textures
-    if ( g_textures.textures )
+    while ( g_context.num_instances > 0 )
     {
-        mdl_free_texture( &g_textures );
+        lm_instance_destroy( &g_context, g_context.instances[g_context.num_instances - 1] );
     }
 
-    // Pick which header to use (embedded or T.mdl)
-    const studiohdr_t *texHdr = mdl_pick_texture_header( header, tex_header );
-    if ( texHdr )
+    if ( !lm_instance_create( &g_context, header, data, tex_header, tex_data, seqgroups, num_seqgroups ) )
     {
-        mdl_load_textures( texHdr, ( texHdr == header ) ? data : tex_data, &g_textures );
+        return;
     }
-    
-    // Adding animations initializing
-    mdl_animation_init(&g_anim_state);
-    
-    if (header && header->numseq > 0) {
-        mdl_animation_set_sequence(&g_anim_state, 0, header, data, global_seqgroups );
-        g_animation_enabled = true;
-        g_last_frame_time = glfwGetTime();
+
+    if ( header->numseq > 0 )
+    {
+        g_last_frame_time = glfwGetTime( );
     }
-    
-    
-    LOG_DEBUGF("renderer", "  Textures: %d", tex_header ? tex_header->numtextures : 0);
-    LOG_INFOF("renderer", "Model data set successfully");
+
+    LOG_DEBUGF( "renderer", "  Textures: %d", tex_header ? tex_header->numtextures : 0 );
+    LOG_INFOF( "renderer", "Model data set successfully" );
 }
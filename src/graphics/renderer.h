@@ -4,6 +4,7 @@
 #include "../studio.h"
 #include "../mdl/mdl_loader.h"  // <-- Need this for mdl_seqgroup_blob_tS
 #include "../graphics/gl_platform.h"
+#include "../graphics/render_context.h"
 #include <stdbool.h>
 
 
@@ -23,12 +24,19 @@ void cleanup_renderer(void);
 
 void render_loop(void);
 bool should_close_window(void);
+void set_render_on_demand(bool enabled);
+void request_redraw(void);
 
 
 
 void render_model(studiohdr_t *header, unsigned char *data);
 void set_wireframe_mode(bool enabled);
 void set_current_texture(unsigned int texture_id);
+void set_indexed_drawing(bool enabled);
+void set_vertex_cache_optimization(bool enabled);
+void set_gpu_skinning(bool enabled);
+void set_palette_textures(bool enabled);
+void set_atlas_textures(bool enabled);
 
 void set_model_data(
     studiohdr_t *header,
@@ -45,7 +53,7 @@ void clear_screen(void);
 
 void UpdateBonesForCurrentFrame(void);
 void ProcessModelForRendering(void);
-void AddVertexToBuffer(int vIndex, int nIndex, short s, short t, float texW, float texH);
+void SkinMeshTopology(void);
 
 
 #endif 
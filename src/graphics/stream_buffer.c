@@ -0,0 +1,201 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Fenced ring buffer for per-frame vertex streaming
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "stream_buffer.h"
+
+#include "../utils/logger.h"
+
+#include <string.h>
+
+// How long one glClientWaitSync() call may block before we ask again
+#define STREAM_FENCE_TIMEOUT_NS 1000000ull
+
+// GL 4.4 core or ARB_buffer_storage; never true against the macOS 4.1 headers
+static bool buffer_storage_supported( void )
+{
+#if defined( GL_MAP_PERSISTENT_BIT )
+    GLint major = 0, minor = 0;
+    glGetIntegerv( GL_MAJOR_VERSION, &major );
+    glGetIntegerv( GL_MINOR_VERSION, &minor );
+
+    if ( major > 4 || ( major == 4 && minor >= 4 ) )
+        return true;
+
+    GLint count = 0;
+    glGetIntegerv( GL_NUM_EXTENSIONS, &count );
+    for ( GLint i = 0; i < count; ++i )
+    {
+        const char *ext = ( const char * ) glGetStringi( GL_EXTENSIONS, ( GLuint ) i );
+        if ( ext && strcmp( ext, "GL_ARB_buffer_storage" ) == 0 )
+            return true;
+    }
+#endif
+    return false;
+}
+
+bool stream_buffer_create( stream_buffer_t *sb, size_t region_size )
+{
+    memset( sb, 0, sizeof( *sb ) );
+
+    if ( region_size == 0 )
+        return false;
+
+    const size_t total = region_size * STREAM_BUFFER_REGIONS;
+
+    sb->region_size = region_size;
+    sb->region      = STREAM_BUFFER_REGIONS - 1;    // first map() lands on region 0
+
+    glGenBuffers( 1, &sb->buffer );
+    glBindBuffer( GL_ARRAY_BUFFER, sb->buffer );
+
+#if defined( GL_MAP_PERSISTENT_BIT )
+    if ( buffer_storage_supported( ) )
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage( GL_ARRAY_BUFFER, ( GLsizeiptr ) total, NULL, flags );
+        sb->persistent = ( unsigned char * ) glMapBufferRange( GL_ARRAY_BUFFER, 0, ( GLsizeiptr ) total, flags );
+
+        if ( sb->persistent )
+        {
+            LOG_INFOF(
+                "renderer",
+                "Vertex streaming: persistent-mapped ring, %d x %zu KB",
+                STREAM_BUFFER_REGIONS,
+                region_size / 1024 );
+            return true;
+        }
+
+        // Immutable storage cannot be respecified, start over with a plain buffer
+        LOG_WARNF( "renderer", "Persistent mapping failed, falling back to per-frame maps" );
+        glDeleteBuffers( 1, &sb->buffer );
+        glGenBuffers( 1, &sb->buffer );
+        glBindBuffer( GL_ARRAY_BUFFER, sb->buffer );
+    }
+#endif
+
+    glBufferData( GL_ARRAY_BUFFER, ( GLsizeiptr ) total, NULL, GL_STREAM_DRAW );
+
+    LOG_INFOF(
+        "renderer",
+        "Vertex streaming: unsynchronized map ring (no buffer storage), %d x %zu KB",
+        STREAM_BUFFER_REGIONS,
+        region_size / 1024 );
+    return true;
+}
+
+void stream_buffer_destroy( stream_buffer_t *sb )
+{
+    for ( int r = 0; r < STREAM_BUFFER_REGIONS; ++r )
+    {
+        if ( sb->fences[r] )
+            glDeleteSync( sb->fences[r] );
+    }
+
+    if ( sb->buffer )
+    {
+        if ( sb->persistent )
+        {
+            glBindBuffer( GL_ARRAY_BUFFER, sb->buffer );
+            glUnmapBuffer( GL_ARRAY_BUFFER );
+        }
+        glDeleteBuffers( 1, &sb->buffer );
+    }
+
+    if ( sb->stalls > 0 )
+    {
+        LOG_DEBUGF( "renderer", "Vertex stream waited on the GPU %d times", sb->stalls );
+    }
+
+    memset( sb, 0, sizeof( *sb ) );
+}
+
+// Blocks until the GPU is done with the draws fenced on this region
+static void wait_region( stream_buffer_t *sb, int region )
+{
+    GLsync fence = sb->fences[region];
+    if ( !fence )
+        return;
+
+    GLenum status = glClientWaitSync( fence, 0, 0 );
+    if ( status == GL_TIMEOUT_EXPIRED )
+    {
+        sb->stalls++;
+        do
+        {
+            status = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_FENCE_TIMEOUT_NS );
+        } while ( status == GL_TIMEOUT_EXPIRED );
+    }
+
+    if ( status == GL_WAIT_FAILED )
+    {
+        LOG_ERRORF( "renderer", "glClientWaitSync failed on stream region %d", region );
+    }
+
+    glDeleteSync( fence );
+    sb->fences[region] = NULL;
+}
+
+void *stream_buffer_map( stream_buffer_t *sb, size_t bytes )
+{
+    if ( !sb->buffer || bytes > sb->region_size )
+        return NULL;
+
+    sb->region = ( sb->region + 1 ) % STREAM_BUFFER_REGIONS;
+    wait_region( sb, sb->region );
+
+    if ( sb->persistent )
+        return sb->persistent + stream_buffer_offset( sb );
+
+    glBindBuffer( GL_ARRAY_BUFFER, sb->buffer );
+    return glMapBufferRange(
+        GL_ARRAY_BUFFER,
+        ( GLintptr ) stream_buffer_offset( sb ),
+        ( GLsizeiptr ) ( bytes > 0 ? bytes : 1 ),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+}
+
+void stream_buffer_unmap( stream_buffer_t *sb )
+{
+    glBindBuffer( GL_ARRAY_BUFFER, sb->buffer );
+
+    // Coherent persistent mappings need no flush or unmap
+    if ( !sb->persistent )
+        glUnmapBuffer( GL_ARRAY_BUFFER );
+}
+
+size_t stream_buffer_offset( const stream_buffer_t *sb )
+{
+    return ( size_t ) sb->region * sb->region_size;
+}
+
+void stream_buffer_fence( stream_buffer_t *sb )
+{
+    if ( !sb->buffer )
+        return;
+
+    // A region drawn again on a later frame must not be released by its older fence
+    if ( sb->fences[sb->region] )
+        glDeleteSync( sb->fences[sb->region] );
+
+    sb->fences[sb->region] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
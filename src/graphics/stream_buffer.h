@@ -0,0 +1,51 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include "gl_platform.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Ring of STREAM_BUFFER_REGIONS equally sized regions in one GL buffer for
+ * data that is rewritten every frame. The CPU fills region N while the GPU may
+ * still be reading N-1 and N-2; a fence per region keeps it from overwriting
+ * anything in flight.
+ *
+ * With GL 4.4 / ARB_buffer_storage the buffer is immutable and mapped once
+ * (persistent + coherent). Otherwise (macOS stops at 4.1) each region is
+ * mapped unsynchronized for the write and unmapped again; the fences make
+ * that just as safe.
+ */
+#define STREAM_BUFFER_REGIONS 3
+
+typedef struct {
+    GLuint         buffer;
+    size_t         region_size;
+    int            region;        // region handed out by the last stream_buffer_map()
+    unsigned char *persistent;    // whole-buffer mapping, NULL on the fallback path
+    GLsync         fences[STREAM_BUFFER_REGIONS];
+    int            stalls;        // maps that had to wait for the GPU
+} stream_buffer_t;
+
+/*
+ * Creates the buffer, left bound to GL_ARRAY_BUFFER. Keep region_size a
+ * multiple of the vertex stride so every region starts on a whole vertex.
+ */
+bool stream_buffer_create( stream_buffer_t *sb, size_t region_size );
+
+void stream_buffer_destroy( stream_buffer_t *sb );
+
+// Moves to the next region and returns a write pointer to it, or NULL if bytes > region_size
+void *stream_buffer_map( stream_buffer_t *sb, size_t bytes );
+
+// Ends the write started by stream_buffer_map(). Leaves the buffer bound to GL_ARRAY_BUFFER.
+void stream_buffer_unmap( stream_buffer_t *sb );
+
+// Byte offset of the current region within the buffer
+size_t stream_buffer_offset( const stream_buffer_t *sb );
+
+// Call after the draws that read the current region have been issued
+void stream_buffer_fence( stream_buffer_t *sb );
+
+#endif    // STREAM_BUFFER_H
@@ -24,6 +24,9 @@
 #include "textures.h"
 
 #include "../graphics/gl_platform.h"
+#include "../mdl/mdl_cache.h"
+#include "../mdl/mdl_palette.h"
+#include "../utils/job_system.h"
 #include "../utils/logger.h"
 #include <stdint.h>
 #include <stdio.h>
@@ -57,21 +60,12 @@ bool mdl_pal8_to_rgba(
     if ( palette_size == 0 || palette_size > 256 )
         return false;
 
-    const int px = w * h;
-
     // MDL palettes are effectively RGB (R,G,B).
     // Do NOT swap unless you verify otherwise.
-    for ( int i = 0; i < px; ++i )
-    {
-        const unsigned idx  = indices[i];
-        const unsigned p    = ( idx < ( unsigned ) palette_size ) ? idx : 0;
-        const unsigned base = p * 3;
-
-        dst[i * 4 + 0] = palette_rgb[base + 0];       // R
-        dst[i * 4 + 1] = palette_rgb[base + 1];       // G
-        dst[i * 4 + 2] = palette_rgb[base + 2];       // B
-        dst[i * 4 + 3] = ( idx == 255 ) ? 0 : 255;    // 255 is transparent in many GoldSrc MDLs
-    }
+    // 255 is transparent in many GoldSrc MDLs; its colour is kept under alpha 0
+    mdl_palette_lut_t lut;
+    mdl_palette_build_lut( palette_rgb, ( int ) palette_size, true, &lut );
+    mdl_palette_expand_rgba( indices, ( size_t ) w * ( size_t ) h, &lut, dst );
     return true;
 }
 
@@ -127,7 +121,335 @@ static bool parse_paletted_block(
     return true;
 }
 
-mdl_result_t mdl_load_textures( const studiohdr_t *header, const unsigned char *file_data, mdl_texture_set_t *out_set )
+/*
+ * Texture decode jobs: every texture's palette indices are expanded to RGBA
+ * on the job system, then the GL uploads run in order on the calling (GL)
+ * thread. Textures already in the compiled model cache keep their mapped
+ * pixels and are skipped. A NULL entry in `upload` means an allocation failed.
+ */
+typedef struct {
+    const mstudiotexture_t *textures;
+    const unsigned char    *file_data;
+    unsigned char         **rgba;      // buffers owned by the decode
+    const unsigned char   **upload;    // what gets uploaded: rgba[i] or cached pixels
+} texture_decode_t;
+
+static void decode_texture_range( void *arg, int begin, int end )
+{
+    const texture_decode_t *decode = arg;
+
+    for ( int i = begin; i < end; i++ )
+    {
+        const mstudiotexture_t *T = &decode->textures[i];
+
+        if ( decode->upload[i] )
+        {
+            continue;
+        }
+
+        // T->index is an absolute offset from file start
+        const unsigned char *indices = decode->file_data + T->index;
+
+        // Calculate pixel data size
+        const int pixel_count = T->width * T->height;
+
+        const unsigned char *palette  = indices + pixel_count;
+        const int            pal_size = 256;
+
+        // Allocate RGBA buffer
+        unsigned char *rgba = ( unsigned char * ) malloc( ( size_t ) pixel_count * 4u );
+        decode->rgba[i]     = rgba;
+        decode->upload[i]   = rgba;
+        if ( !rgba )
+        {
+            continue;
+        }
+        /* NOTE(Karlo):
+        // 
+        // Convert palette indices to RGBA
+        // Need to modify this to detect if it is RGBA or BGR or something else
+        // RIght now issue is happening because some models maybe store things
+        // differently so it is not quite RGB, most of them are RGB but some are 
+        // as it seems quite obvious when I was testing models not quite right so 
+        // we need to add that as well.
+        // 
+        */
+        // Index 255 is transparent in Half-Life (all four bytes cleared)
+        mdl_palette_lut_t lut;
+        mdl_palette_build_lut( palette, pal_size, false, &lut );
+        mdl_palette_expand_rgba( indices, ( size_t ) pixel_count, &lut, rgba );
+    }
+}
+
+/*
+ * Palette mode: the indices go up as they are in the file, so nothing is
+ * decoded; each skin only gets its 256-entry palette built. Returns the
+ * bytes uploaded.
+ */
+static size_t upload_palette_texture( const mstudiotexture_t *T, const unsigned char *file_data, mdl_gl_texture_t *item )
+{
+    const unsigned char *indices = file_data + T->index;
+    const unsigned char *palette = indices + ( size_t ) T->width * ( size_t ) T->height;
+
+    mdl_palette_lut_t lut;
+    mdl_palette_build_lut( palette, 256, false, &lut );
+
+    GLuint ids[2] = { 0, 0 };
+    glGenTextures( 2, ids );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+    // Indices must not be blended; textured_palette.frag filters after the lookup
+    glBindTexture( GL_TEXTURE_2D, ids[0] );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_R8, T->width, T->height, 0, GL_RED, GL_UNSIGNED_BYTE, indices );
+
+    glBindTexture( GL_TEXTURE_2D, ids[1] );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, lut.rgba );
+
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    GLenum err = glGetError( );
+    if ( err != GL_NO_ERROR )
+    {
+        LOG_WARNF( "textures", "OpenGL error 0x%x creating texture %s", err, T->name );
+    }
+    else
+    {
+        LOG_TRACEF( "textures", "Created GL textures %u (indices) and %u (palette) for %s", ids[0], ids[1], T->name );
+    }
+
+    item->gl_id      = ids[0];
+    item->palette_id = ids[1];
+    return ( size_t ) T->width * ( size_t ) T->height + sizeof( lut.rgba );
+}
+
+static void fill_texture_info( const mstudiotexture_t *T, mdl_gl_texture_t *item )
+{
+    item->width  = T->width;
+    item->height = T->height;
+    item->flags  = T->flags;
+    strncpy( item->name, T->name, sizeof( item->name ) - 1 );
+    item->name[sizeof( item->name ) - 1] = '\0';
+}
+
+/*
+ * Atlas mode: skins are placed on shelves, tallest first. Widths are tried in
+ * steps of 16 texels up to GL_MAX_TEXTURE_SIZE and the one with the smallest
+ * area wins. Every skin takes a 1 texel border on each side.
+ */
+typedef struct {
+    int index;
+    int width;     // border included
+    int height;
+} atlas_slot_t;
+
+static int compare_atlas_slots( const void *a, const void *b )
+{
+    const atlas_slot_t *sa = a;
+    const atlas_slot_t *sb = b;
+    if ( sa->height != sb->height )
+        return sb->height - sa->height;
+    if ( sa->width != sb->width )
+        return sb->width - sa->width;
+    return sa->index - sb->index;
+}
+
+// Lays the sorted slots out in rows of `width`; returns the height used
+static int shelf_pack( const atlas_slot_t *slots, int count, int width, mdl_gl_texture_t *items )
+{
+    int x = 0, y = 0, shelf = 0;
+    for ( int k = 0; k < count; k++ )
+    {
+        if ( x + slots[k].width > width )
+        {
+            y += shelf;
+            x     = 0;
+            shelf = 0;
+        }
+        if ( items )
+        {
+            items[slots[k].index].atlas_x = x + 1;
+            items[slots[k].index].atlas_y = y + 1;
+        }
+        x += slots[k].width;
+        if ( slots[k].height > shelf )
+            shelf = slots[k].height;
+    }
+    return y + shelf;
+}
+
+static bool pack_atlas(
+    const mstudiotexture_t *textures, int count, int max_size, mdl_gl_texture_t *items, int *out_w, int *out_h )
+{
+    atlas_slot_t *slots = ( atlas_slot_t * ) malloc( ( size_t ) count * sizeof( *slots ) );
+    if ( !slots )
+        return false;
+
+    size_t area   = 0;
+    int    widest = 0;
+    for ( int i = 0; i < count; i++ )
+    {
+        slots[i].index  = i;
+        slots[i].width  = textures[i].width + 2;
+        slots[i].height = textures[i].height + 2;
+        area += ( size_t ) slots[i].width * ( size_t ) slots[i].height;
+        if ( slots[i].width > widest )
+            widest = slots[i].width;
+    }
+    qsort( slots, ( size_t ) count, sizeof( *slots ), compare_atlas_slots );
+
+    int    best_w = 0, best_h = 0;
+    size_t best_area = SIZE_MAX;
+
+    for ( int width = ( widest + 15 ) & ~15; width <= max_size; width += 16 )
+    {
+        if ( ( size_t ) width * ( size_t ) width > area * 4 && best_w )
+            break;    // twice as wide as a square: only flatter, emptier strips from here
+
+        const int height = shelf_pack( slots, count, width, NULL );
+        if ( height <= max_size && ( size_t ) width * ( size_t ) height < best_area )
+        {
+            best_w    = width;
+            best_h    = height;
+            best_area = ( size_t ) width * ( size_t ) height;
+        }
+    }
+
+    if ( best_w )
+    {
+        shelf_pack( slots, count, best_w, items );
+        *out_w = best_w;
+        *out_h = best_h;
+        free( slots );
+        return true;
+    }
+
+    free( slots );
+    return false;
+}
+
+typedef struct {
+    const mstudiotexture_t *textures;
+    const unsigned char   **upload;
+    const mdl_gl_texture_t *items;
+    unsigned char          *atlas;
+    int                     atlas_width;
+} atlas_blit_t;
+
+// Copies each skin into place with its border: the row/column from the opposite edge, as GL_REPEAT samples it
+static void blit_atlas_range( void *arg, int begin, int end )
+{
+    const atlas_blit_t *blit = arg;
+
+    for ( int i = begin; i < end; i++ )
+    {
+        const int            w   = blit->textures[i].width;
+        const int            h   = blit->textures[i].height;
+        const unsigned char *src = blit->upload[i];
+
+        for ( int y = -1; y <= h; y++ )
+        {
+            const unsigned char *row = src + ( size_t ) ( ( y + h ) % h ) * ( size_t ) w * 4u;
+            unsigned char       *dst = blit->atlas
+                               + ( ( size_t ) ( blit->items[i].atlas_y + y ) * ( size_t ) blit->atlas_width
+                                   + ( size_t ) blit->items[i].atlas_x )
+                                     * 4u;
+
+            memcpy( dst, row, ( size_t ) w * 4u );
+            memcpy( dst - 4, row + ( size_t ) ( w - 1 ) * 4u, 4 );
+            memcpy( dst + ( size_t ) w * 4u, row, 4 );
+        }
+    }
+}
+
+/*
+ * Uploads the decoded skins as one atlas and points every item at it.
+ * Returns false, leaving nothing created, if the skins do not fit.
+ */
+static bool upload_atlas(
+    const mstudiotexture_t *textures,
+    int                     count,
+    const unsigned char   **upload,
+    mdl_gl_texture_t       *items,
+    mdl_texture_set_t      *set )
+{
+    for ( int i = 0; i < count; i++ )
+    {
+        if ( textures[i].width <= 0 || textures[i].height <= 0 )
+            return false;
+    }
+
+    GLint max_size = 0;
+    glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+
+    int width = 0, height = 0;
+    if ( !pack_atlas( textures, count, max_size, items, &width, &height ) )
+    {
+        LOG_WARNF( "textures", "Skins do not fit a %dx%d atlas - uploading them separately", max_size, max_size );
+        return false;
+    }
+
+    unsigned char *atlas = ( unsigned char * ) calloc( ( size_t ) width * ( size_t ) height, 4u );
+    if ( !atlas )
+        return false;
+
+    atlas_blit_t blit = { textures, upload, items, atlas, width };
+    job_parallel_for( "texture atlas", count, 1, blit_atlas_range, &blit );
+
+    // The borders stand in for GL_REPEAT; nothing samples past them
+    GLuint tex = 0;
+    glGenTextures( 1, &tex );
+    glBindTexture( GL_TEXTURE_2D, tex );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+    free( atlas );
+
+    GLenum err = glGetError( );
+    if ( err != GL_NO_ERROR )
+    {
+        LOG_WARNF( "textures", "OpenGL error 0x%x creating the %dx%d texture atlas", err, width, height );
+    }
+
+    size_t used = 0;
+    for ( int i = 0; i < count; i++ )
+    {
+        items[i].gl_id = tex;
+        fill_texture_info( &textures[i], &items[i] );
+        used += ( size_t ) textures[i].width * ( size_t ) textures[i].height;
+    }
+
+    LOG_DEBUGF(
+        "textures",
+        "Packed %d textures into a %dx%d atlas (%.1f%% used), %zu KB",
+        count,
+        width,
+        height,
+        100.0 * ( double ) used / ( ( double ) width * ( double ) height ),
+        ( size_t ) width * ( size_t ) height * 4u / 1024 );
+
+    set->atlas_id     = tex;
+    set->atlas_width  = width;
+    set->atlas_height = height;
+    return true;
+}
+
+mdl_result_t mdl_load_textures(
+    const studiohdr_t   *header,
+    const unsigned char *file_data,
+    mdl_texture_mode_t   mode,
+    mdl_texture_set_t   *out_set )
 {
     // debug_texture_data( header, file_data );
 
@@ -137,7 +459,11 @@ mdl_result_t mdl_load_textures( const studiohdr_t *header, const unsigned char *
     }
 
     out_set->textures = NULL;
-    out_set->count    = 0;
+    out_set->count        = 0;
+    out_set->mode         = mode;
+    out_set->atlas_id     = 0;
+    out_set->atlas_width  = 0;
+    out_set->atlas_height = 0;
 
     if ( !header || !file_data )
     {
@@ -150,67 +476,87 @@ mdl_result_t mdl_load_textures( const studiohdr_t *header, const unsigned char *
 
     const mstudiotexture_t *textures   = ( const mstudiotexture_t * ) ( file_data + header->textureindex );
     const int               n_textures = header->numtextures;
+    size_t                  uploaded   = 0;
 
-    mdl_gl_texture_t *items = ( mdl_gl_texture_t * ) calloc( ( size_t ) n_textures, sizeof( *items ) );
-    if ( !items )
+    if ( mode == MDL_TEXTURE_PALETTE )
     {
-        return MDL_ERROR_MEMORY_ALLOCATION;
+        mdl_gl_texture_t *items = ( mdl_gl_texture_t * ) calloc( ( size_t ) n_textures, sizeof( *items ) );
+        if ( !items )
+        {
+            return MDL_ERROR_MEMORY_ALLOCATION;
+        }
+
+        for ( int i = 0; i < n_textures; i++ )
+        {
+            uploaded += upload_palette_texture( &textures[i], file_data, &items[i] );
+            fill_texture_info( &textures[i], &items[i] );
+        }
+
+        LOG_DEBUGF( "textures", "Uploaded %d palettized textures, %zu KB", n_textures, uploaded / 1024 );
+
+        out_set->textures = items;
+        out_set->count    = n_textures;
+        return MDL_SUCCESS;
     }
 
-    for ( int i = 0; i < n_textures; i++ )
+    mdl_gl_texture_t     *items  = ( mdl_gl_texture_t * ) calloc( ( size_t ) n_textures, sizeof( *items ) );
+    unsigned char       **pixels = ( unsigned char ** ) calloc( ( size_t ) n_textures, sizeof( *pixels ) );
+    const unsigned char **upload = ( const unsigned char ** ) calloc( ( size_t ) n_textures, sizeof( *upload ) );
+    if ( !items || !pixels || !upload )
     {
-        const mstudiotexture_t *T = &textures[i];
-
-        // T->index is an absolute offset from file start
-        const unsigned char *indices = file_data + T->index;
+        free( items );
+        free( pixels );
+        free( upload );
+        return MDL_ERROR_MEMORY_ALLOCATION;
+    }
 
-        // Calculate pixel data size
-        const int pixel_count = T->width * T->height;
+    const mdl_model_cache_t *cache = mdl_cache_find( file_data );
+    for ( int i = 0; cache && i < n_textures; i++ )
+    {
+        upload[i] = mdl_cache_texture_rgba( cache, i, textures[i].width, textures[i].height );
+    }
 
-        const unsigned char *palette  = indices + pixel_count;
-        const int            pal_size = 256;
+    texture_decode_t decode = { textures, file_data, pixels, upload };
+    job_parallel_for( "texture decode", n_textures, 1, decode_texture_range, &decode );
 
-        // Allocate RGBA buffer
-        unsigned char *rgba = ( unsigned char * ) malloc( ( size_t ) pixel_count * 4u );
-        if ( !rgba )
+    for ( int i = 0; i < n_textures; i++ )
+    {
+        if ( !upload[i] )
         {
+            for ( int j = 0; j < n_textures; j++ )
+            {
+                free( pixels[j] );
+            }
+            free( pixels );
+            free( upload );
             free( items );
             return MDL_ERROR_MEMORY_ALLOCATION;
         }
-        /* NOTE(Karlo):
-        // 
-        // Convert palette indices to RGBA
-        // Need to modify this to detect if it is RGBA or BGR or something else
-        // RIght now issue is happening because some models maybe store things
-        // differently so it is not quite RGB, most of them are RGB but some are 
-        // as it seems quite obvious when I was testing models not quite right so 
-        // we need to add that as well.
-        // 
-        */
-        for ( int j = 0; j < pixel_count; j++ )
-        {
-            unsigned char idx = indices[j];
+    }
 
-            // Handle transparency - index 255 is transparent in Half-Life
-            if ( idx == 255 )
-            {
-                rgba[j * 4 + 0] = 0;    // R
-                rgba[j * 4 + 1] = 0;    // G
-                rgba[j * 4 + 2] = 0;    // B
-                rgba[j * 4 + 3] = 0;    // A (transparent)
-            }
-            else
-            {
-                // Clamp index to palette size
-                if ( idx >= pal_size )
-                    idx = 0;
-
-                rgba[j * 4 + 0] = palette[idx * 3 + 0];    // R
-                rgba[j * 4 + 1] = palette[idx * 3 + 1];    // G
-                rgba[j * 4 + 2] = palette[idx * 3 + 2];    // B
-                rgba[j * 4 + 3] = 255;                     // A (opaque)
-            }
+    if ( mode == MDL_TEXTURE_ATLAS )
+    {
+        const bool packed = upload_atlas( textures, n_textures, upload, items, out_set );
+
+        for ( int i = 0; packed && i < n_textures; i++ )
+        {
+            free( pixels[i] );
         }
+        if ( packed )
+        {
+            free( pixels );
+            free( upload );
+            out_set->textures = items;
+            out_set->count    = n_textures;
+            return MDL_SUCCESS;
+        }
+        out_set->mode = MDL_TEXTURE_RGBA;
+    }
+
+    for ( int i = 0; i < n_textures; i++ )
+    {
+        const mstudiotexture_t *T    = &textures[i];
+        const unsigned char    *rgba = upload[i];
 
         // Create OpenGL texture
         GLuint tex = 0;
@@ -242,18 +588,20 @@ mdl_result_t mdl_load_textures( const studiohdr_t *header, const unsigned char *
         // Unbind texture
         glBindTexture( GL_TEXTURE_2D, 0 );
 
-        // Free temporary RGBA buffer
-        free( rgba );
+        // Free temporary RGBA buffer (cached pixels stay mapped)
+        free( pixels[i] );
 
         // Store texture info
-        items[i].gl_id  = tex;
-        items[i].width  = T->width;
-        items[i].height = T->height;
-        items[i].flags  = T->flags;
-        strncpy( items[i].name, T->name, sizeof( items[i].name ) - 1 ); 
-        items[i].name[sizeof( items[i].name ) - 1] = '\0';
+        items[i].gl_id = tex;
+        fill_texture_info( T, &items[i] );
+        uploaded += ( size_t ) T->width * ( size_t ) T->height * 4u;
     }
 
+    free( pixels );
+    free( upload );
+
+    LOG_DEBUGF( "textures", "Uploaded %d RGBA textures, %zu KB", n_textures, uploaded / 1024 );
+
     out_set->textures = items;
     out_set->count    = n_textures;
 
@@ -267,16 +615,28 @@ void mdl_free_texture( mdl_texture_set_t *set )
         return;
     }
 
+    if ( set->atlas_id )
+    {
+        GLuint id = set->atlas_id;
+        glDeleteTextures( 1, &id );
+    }
+
     for ( int i = 0; i < set->count; i++ )
     {
-        if ( set->textures[i].gl_id )
+        if ( set->textures[i].gl_id && set->textures[i].gl_id != set->atlas_id )
         {
             GLuint id = set->textures[i].gl_id;
             glDeleteTextures( 1, &id );
         }
+        if ( set->textures[i].palette_id )
+        {
+            GLuint id = set->textures[i].palette_id;
+            glDeleteTextures( 1, &id );
+        }
     }
 
     free( set->textures );
     set->textures = NULL;
     set->count    = 0;
+    set->atlas_id = 0;
 }
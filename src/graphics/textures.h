@@ -8,23 +8,49 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/*
+ * RGBA expands every skin to GL_RGBA8. PALETTE keeps the file's 8-bit
+ * indices as a GL_R8 texture plus a 256x1 GL_RGBA8 palette per skin, a
+ * quarter of the memory and upload; shaders/textured_palette.frag does the
+ * lookup and filtering. ATLAS packs every RGBA skin of the model, all skin
+ * families included, into one texture so a whole model draws with a single
+ * bind; each skin keeps a 1 texel border copied from its opposite edge so
+ * GL_LINEAR blends across it exactly as GL_REPEAT would. A model too large
+ * for GL_MAX_TEXTURE_SIZE falls back to RGBA.
+ */
+typedef enum {
+    MDL_TEXTURE_RGBA = 0,
+    MDL_TEXTURE_PALETTE,
+    MDL_TEXTURE_ATLAS,
+} mdl_texture_mode_t;
+
 typedef struct {
-    unsigned int gl_id;    // 0 meaning it is not created
+    unsigned int gl_id;         // 0 meaning it is not created
+    unsigned int palette_id;    // 256x1 palette in MDL_TEXTURE_PALETTE mode, else 0
     int          width;
     int          height;
+    int          atlas_x;       // top-left texel in the atlas (MDL_TEXTURE_ATLAS)
+    int          atlas_y;
     char         name[64];
     int          flags;
 } mdl_gl_texture_t;
 
 typedef struct {
-    mdl_gl_texture_t *textures;
-    int               count;
+    mdl_gl_texture_t  *textures;
+    int                count;
+    mdl_texture_mode_t mode;
+    unsigned int       atlas_id;    // every gl_id in MDL_TEXTURE_ATLAS mode, else 0
+    int                atlas_width;
+    int                atlas_height;
 } mdl_texture_set_t;
 
 const studiohdr_t *mdl_pick_texture_header( const studiohdr_t *main_header, const studiohdr_t *text_header );
 
-mdl_result_t
-mdl_load_textures( const studiohdr_t *main_header, const unsigned char *texture_data, mdl_texture_set_t *out_set );
+mdl_result_t mdl_load_textures(
+    const studiohdr_t   *main_header,
+    const unsigned char *texture_data,
+    mdl_texture_mode_t   mode,
+    mdl_texture_set_t   *out_set );
 
 void mdl_free_texture( mdl_texture_set_t *set );
 
@@ -22,23 +22,31 @@
 
 #include "main.h"
 
+#include "graphics/crowd.h"
 #include "graphics/renderer.h"
+#include "mdl/mdl_animations.h"
+#include "mdl/mdl_batch.h"
+#include "mdl/mdl_cache.h"
 #include "mdl/mdl_loader.h"
 #include "mdl/mdl_report.h"
 #include "studio.h"
 #include "utils/args.h"
+#include "utils/job_system.h"
 #include "utils/logger.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
 t_log_options log_options = {
-    .file_path     = "../logs/viewer.log",
-    .max_bytes     = 0,
-    .max_files     = 0,
-    .use_colors    = true,
-    .json_lines    = false,
-    .console_level = LOG_ERROR    // Default to ERROR (quiet)
+    .file_path         = "../logs/viewer.log",
+    .max_bytes         = 0,
+    .max_files         = 0,
+    .use_colors        = true,
+    .json_lines        = false,
+    .console_level     = LOG_ERROR,    // Default to ERROR (quiet)
+    .async             = true,
+    .async_capacity    = 0,
+    .async_block_level = LOG_INFO    // a flood of TRACE/DEBUG may be dropped, never INFO and up
 };
 
 int main( int argc, char const *argv[] )
@@ -49,8 +57,12 @@ int main( int argc, char const *argv[] )
         return 1;    // Error already printed by parse_args
     }
 
-    // Show banner ALWAYS (Valve copyright)
-    print_banner( );
+    // Show banner ALWAYS (Valve copyright), except in --batch mode where
+    // stdout is the JSON-lines stream
+    if ( !args.batch_dir )
+    {
+        print_banner( );
+    }
 
     // Show version if requested
     if ( args.show_version )
@@ -95,11 +107,26 @@ int main( int argc, char const *argv[] )
         break;
     }
 
+    // Same for the console logger, which also writes to stdout; the log file
+    // still gets everything
+    if ( args.batch_dir )
+    {
+        log_options.console_level = LOG_FATAL + 1;
+        log_options.use_colors    = false;
+    }
+
     // Use log file if specified
     if ( args.log_file )
     {
         log_options.file_path = args.log_file;
     }
+    if ( args.log_binary )
+    {
+        log_options.file_path = args.log_binary;
+        log_options.binary    = true;
+    }
+
+    log_options.async = !args.log_sync;
 
     logger_init( &log_options );
 
@@ -141,17 +168,49 @@ int main( int argc, char const *argv[] )
         logger_set_category_level( "seqgroup", LOG_TRACE );
     }
 
+    mdl_cache_set_dir( args.cache_dir );
+
+    if ( args.batch_dir )
+    {
+        mdl_set_load_mode( args.use_mmap ? MDL_LOAD_MODE_MMAP : MDL_LOAD_MODE_READ );
+        mdl_set_lazy_seqgroups( false );
+        mdl_set_load_messages( false );
+        job_system_init( args.threads );
+
+        int failed = mdl_batch_analyze( args.batch_dir, stdout );
+        if ( failed > 0 )
+        {
+            LOG_WARNF( "app", "Batch: %d models failed to load", failed );
+        }
+
+        job_system_shutdown( );
+        logger_shutdown( );
+        return failed < 0 ? 1 : 0;
+    }
+
     if ( !args.quiet )
     {
         LOG_INFOF( "app", "Loading model: %s", args.model_path );
     }
 
+    mdl_set_load_mode( args.use_mmap ? MDL_LOAD_MODE_MMAP : MDL_LOAD_MODE_READ );
+
+    // The viewer reads NN.mdl sequence groups when an animation first needs them;
+    // dumps still want every group resolved up front
+    mdl_set_lazy_seqgroups( args.dump_level == DUMP_NONE );
+
+    mdl_anim_cache_set_budget( ( size_t ) args.anim_cache_mb * 1024u * 1024u );
+
+    // Loading already fans out over the pool (sequence groups, texture decode)
+    job_system_init( args.threads );
+
     mdl_model_t *model  = NULL;
     mdl_result_t result = create_mdl_model( args.model_path, &model );
 
     if ( result != MDL_SUCCESS )
     {
         fprintf( stderr, "ERROR: Failed to load model '%s' (error code: %d)\n", args.model_path, result );
+        job_system_shutdown( );
         logger_shutdown( );
         return 1;
     }
@@ -189,6 +248,7 @@ int main( int argc, char const *argv[] )
             LOG_INFOF( "app", "Dump complete. Exiting (--dump-only mode)" );
         }
         free_model( model );
+        job_system_shutdown( );
         logger_shutdown( );
         return 0;    // Exit without opening viewer
     }
@@ -202,19 +262,60 @@ int main( int argc, char const *argv[] )
     {
         fprintf( stderr, "ERROR: Failed to initialize renderer\n" );
         free_model( model );
+        job_system_shutdown( );
         logger_shutdown( );
         return 1;
     }
 
-    // Pass model data to renderer
-    set_model_data(
-        model->header,
-        model->data,
-        model->texture_header,
-        model->texture_data,
-        model->seqgroups,
-        model->num_seqgroups
-    );
+    set_indexed_drawing( !args.no_index );
+    set_vertex_cache_optimization( !args.no_vcache_opt );
+    set_gpu_skinning( args.gpu_skinning );
+    set_palette_textures( args.palette_textures );
+    set_atlas_textures( args.atlas_textures );
+    set_render_on_demand( !args.continuous );
+
+    // Pass model data to renderer, as a crowd with --instances
+    if ( args.instances <= 0
+         || !lm_crowd_create(
+             lm_render_context( ),
+             model->header,
+             model->data,
+             model->texture_header,
+             model->texture_data,
+             model->seqgroups,
+             model->num_seqgroups,
+             args.instances,
+             args.grid ) )
+    {
+        if ( args.instances > 0 )
+        {
+            LOG_WARNF( "renderer", "Instanced crowd unavailable, showing a single model" );
+        }
+
+        set_model_data(
+            model->header,
+            model->data,
+            model->texture_header,
+            model->texture_data,
+            model->seqgroups,
+            model->num_seqgroups
+        );
+    }
+
+    // Crowd members pick their own skins
+    lm_model_instance_t *active = lm_render_context( )->active;
+    if ( args.skin > 0 && active )
+    {
+        if ( args.skin < model->header->numskinfamilies )
+        {
+            lm_instance_set_skin( active, args.skin );
+        }
+        else
+        {
+            LOG_WARNF(
+                "renderer", "Model has %d skin families - ignoring --skin %d", model->header->numskinfamilies, args.skin );
+        }
+    }
     
     if (!args.quiet) {
         LOG_INFOF("renderer", "Starting render loop...");
@@ -229,6 +330,7 @@ int main( int argc, char const *argv[] )
     
     cleanup_renderer();
     free_model(model);
+    job_system_shutdown();
     logger_shutdown();
     
     return 0;
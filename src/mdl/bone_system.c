@@ -21,6 +21,7 @@
  */
 
 #include "bone_system.h"
+#include "mdl_skinning.h"
 
 
 #include "../utils/logger.h"
@@ -136,9 +137,13 @@ void TransformNormalByBone( const mat4 boneAbs, const vec3 in, vec3 out )
 }
 
 void SetUpBones( studiohdr_t *header, unsigned char *data )
+{
+    SetUpBonesInto( header, data, g_bonetransformations );
+}
+
+void SetUpBonesInto( studiohdr_t *header, unsigned char *data, mat4 *bone_transformations )
 {
     LOG_DEBUGF("bones", "SetUpBones START: %d bones", header->numbones);
-    fflush(stdout);
     
     if (!header || !data) {
         LOG_ERRORF("bones", "NULL parameters to SetUpBones!");
@@ -152,12 +157,10 @@ void SetUpBones( studiohdr_t *header, unsigned char *data )
     }
     
     LOG_DEBUGF("bones", "Getting bones pointer at offset 0x%X", header->boneindex);
-    fflush(stdout);
     
     mstudiobone_t *bones = ( mstudiobone_t * ) ( data + header->boneindex );
     
     LOG_DEBUGF("bones", "Bones pointer: %p", (void*)bones);
-    fflush(stdout);
 
     for ( int i = 0; i < header->numbones; i++ )
     {
@@ -196,40 +199,33 @@ void SetUpBones( studiohdr_t *header, unsigned char *data )
             }
             
             LOG_TRACEF("bones", "    Concatenating with parent %d", bones[i].parent);
-            R_ConcatTransforms( g_bonetransformations[bones[i].parent], local, g_bonetransformations[i] );
+            R_ConcatTransforms( bone_transformations[bones[i].parent], local, bone_transformations[i] );
         }
         else
         {
             LOG_TRACEF("bones", "    Root bone, copying local transform");
-            Mat4Copy( local, g_bonetransformations[i] );
+            Mat4Copy( local, bone_transformations[i] );
         }
         
         // Log every 5th bone to avoid spam
         if (i % 5 == 0 || i == header->numbones - 1) {
             LOG_DEBUGF("bones", "  Processed bone %d/%d", i, header->numbones - 1);
-            fflush(stdout);
         }
     }
     
     LOG_DEBUGF("bones", "SetUpBones COMPLETE: %d bones processed", header->numbones);
-    fflush(stdout);
 }
 
 void TransformVertices( studiohdr_t *header, unsigned char *data, mstudiomodel_t *model, vec3 *out_vertices )
 {
-    vec3 *vertices = ( vec3 * ) ( data + model->vertindex );
-
-    unsigned char *v2bone = ( unsigned char * ) ( data + model->vertinfoindex );
+    // Bone-bucketed SIMD kernel; out-of-range bones fall back to bone 0 as before
+    mdl_skin_positions( header, data, model, ( const mat4 * ) g_bonetransformations, out_vertices );
+}
 
-    for ( int i = 0; i < model->numverts; i++ )
-    {
-        int bone = v2bone[i];
-        if ( bone < 0 || bone >= header->numbones )
-        {
-            bone = 0;
-        }
-        VectorTransforms( vertices[i], g_bonetransformations[bone], out_vertices[i] );
-    }
+void TransformNormals( studiohdr_t *header, unsigned char *data, mstudiomodel_t *model, vec3 *out_normals )
+{
+    // One rotate + normalize per unique normal, bone taken from norminfoindex
+    mdl_skin_normals( header, data, model, ( const mat4 * ) g_bonetransformations, out_normals );
 }
 
 // NOTE: SetUpBonesFromAnimation was removed because it had incorrect matrix conversion logic.
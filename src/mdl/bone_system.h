@@ -7,10 +7,16 @@
 
 extern mat4 g_bonetransformations[MAXSTUDIOBONES];
 
+// Bind pose of every bone into g_bonetransformations
 void SetUpBones( studiohdr_t *header, unsigned char *data );
 
+// Same, into a caller-owned MAXSTUDIOBONES palette
+void SetUpBonesInto( studiohdr_t *header, unsigned char *data, mat4 *bone_transformations );
+
 void TransformVertices( studiohdr_t *header, unsigned char *data, mstudiomodel_t *model, vec3 *out_vertices );
 
+void TransformNormals( studiohdr_t *header, unsigned char *data, mstudiomodel_t *model, vec3 *out_normals );
+
 void TransformNormalByBone( const mat4 boneAbs, const vec3 in, vec3 out );
 
 void AngleQuaternion( const vec3 angles, versor q );
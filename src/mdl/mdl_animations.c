@@ -28,10 +28,56 @@
 
 #include <cglm/cglm.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+static void reset_anim_cursors( mdl_animation_state_t *state )
+{
+    state->cursor_anims = NULL;
+    memset( state->cursors, 0, sizeof( state->cursors ) );
+}
+
+/*
+ * Finds the span of `channel` that contains `frame` and the offset k of the
+ * frame inside it. With a cursor the walk starts at the span it remembers,
+ * unless we moved backwards (wrap, seek), in which case it restarts at
+ * frame 0 like the plain walk.
+ */
+static const mstudioanimvalue_t *
+SeekAnimSpan( const mstudioanim_t *panim, int channel, int frame, mdl_anim_cursor_t *cursor, int *k )
+{
+    const mstudioanimvalue_t *panimvalue =
+        ( const mstudioanimvalue_t * ) ( ( const unsigned char * ) panim + panim->offset[channel] );
+    int base = 0;
+
+    if ( cursor && cursor->span && frame >= cursor->base )
+    {
+        panimvalue = cursor->span;
+        base       = cursor->base;
+    }
+
+    int offset = frame - base;
+
+    while ( panimvalue->num.total <= offset )
+    {
+        offset -= panimvalue->num.total;
+        panimvalue += panimvalue->num.valid + 1;
+    }
+
+    if ( cursor )
+    {
+        cursor->span = panimvalue;
+        cursor->base = frame - offset;
+    }
+
+    *k = offset;
+    return panimvalue;
+}
+
 void mdl_animation_init( mdl_animation_state_t *state )
 {
     memset( state, 0, sizeof( *state ) );
@@ -110,7 +156,7 @@ void build_bone_matrix( vec3_t position, vec3_t rotation, float matrix[3][4] )
 }
 
 void CalcBoneQuaternion( int frame, float s, const mstudiobone_t *pbone, const mstudioanim_t *panim,
-                         versor q )
+                         mdl_anim_cursor_t *cursor, versor q )
 {
     vec3_t angle1, angle2;
     
@@ -124,17 +170,9 @@ void CalcBoneQuaternion( int frame, float s, const mstudiobone_t *pbone, const m
         
         if (panim->offset[j + 3]) 
         {
-            const unsigned char *animBase = (const unsigned char *)panim;
-            const mstudioanimvalue_t *panimvalue = (const mstudioanimvalue_t *)
-                                                    (animBase + panim->offset[j + 3]);
-            
-            int k = frame;
-            
-            while (panimvalue->num.total <= k)
-            {
-                k -= panimvalue->num.total;
-                panimvalue += panimvalue->num.valid + 1;
-            }   
+            int k;
+            const mstudioanimvalue_t *panimvalue =
+                SeekAnimSpan( panim, j + 3, frame, cursor ? &cursor[j + 3] : NULL, &k );
             
                                                                          
             
@@ -192,7 +230,7 @@ void CalcBoneQuaternion( int frame, float s, const mstudiobone_t *pbone, const m
 
 
 void CalcBonePosition( int frame, float s, mstudiobone_t *pbone, mstudioanim_t *panim,
-                      vec3_t pos )
+                      mdl_anim_cursor_t *cursor, vec3_t pos )
 {
     // Process all 3 position channels (X, Y, Z)
     for ( int j = 0; j < 3; j++ )
@@ -201,16 +239,10 @@ void CalcBonePosition( int frame, float s, mstudiobone_t *pbone, mstudioanim_t *
 
         if ( panim->offset[j] != 0 )
         {
-            const unsigned char *animBase = (const unsigned char *)panim;
-            const mstudioanimvalue_t *panimvalue =
-                (const mstudioanimvalue_t *)(animBase + panim->offset[j]);            int k = frame;
-
             // Find span of values that includes the frame we want
-            while ( panimvalue->num.total <= k )
-            {
-                k -= panimvalue->num.total;
-                panimvalue += panimvalue->num.valid + 1;
-            }
+            int k;
+            const mstudioanimvalue_t *panimvalue =
+                SeekAnimSpan( panim, j, frame, cursor ? &cursor[j] : NULL, &k );
 
             // If we're inside the span
             if ( panimvalue->num.valid > k )
@@ -242,6 +274,343 @@ void CalcBonePosition( int frame, float s, mstudiobone_t *pbone, mstudioanim_t *
     }
 }
 
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Decoded animation cache
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * The RLE streams are expanded once per sequence into dense per-frame
+ * arrays: positions[frame][bone] and rotations[frame][bone] (quaternions),
+ * kept in two separate streams so one frame's bones sit next to each other.
+ * Sampling a bone is then a lookup plus one slerp/lerp instead of a span
+ * walk from frame 0 and two AngleQuaternion calls.
+ *
+ * Entries are keyed by the sequence's mstudioanim_t pointer and evicted
+ * least-recently-used once the byte budget is exceeded. A sequence that is
+ * bigger than the whole budget is never cached and keeps using the RLE path.
+ *
+ * Bones are evaluated from job system threads (crowd members), so the table
+ * is guarded by a mutex. A caller gets a copy of the entry's arrays (entries
+ * move when the table is compacted) and pins it; pinned entries are never
+ * evicted, and anim_cache_release() drops the pin once the bones are built.
+ */
+#define ANIM_CACHE_MAX_ENTRIES 512
+
+typedef struct {
+    const mstudioanim_t *key;
+    int                  numbones;
+    int                  numframes;
+    vec3                *positions;    // numframes * numbones
+    versor              *rotations;    // numframes * numbones
+    size_t               bytes;
+    uint64_t             last_used;
+    int                  pins;
+} anim_cache_entry_t;
+
+// What a caller holds on to while it samples a pinned entry
+typedef struct {
+    int     numbones;
+    int     numframes;
+    vec3   *positions;
+    versor *rotations;
+} anim_track_t;
+
+static anim_cache_entry_t g_anim_cache[ANIM_CACHE_MAX_ENTRIES];
+static int                g_anim_cache_count  = 0;
+static size_t             g_anim_cache_bytes  = 0;
+static size_t             g_anim_cache_budget = MDL_ANIM_CACHE_DEFAULT_BUDGET;
+static uint64_t           g_anim_cache_tick   = 0;
+static pthread_mutex_t    g_anim_cache_mtx    = PTHREAD_MUTEX_INITIALIZER;
+
+static void anim_cache_remove( int index )
+{
+    anim_cache_entry_t *e = &g_anim_cache[index];
+
+    g_anim_cache_bytes -= e->bytes;
+    free( e->positions );
+    free( e->rotations );
+
+    g_anim_cache[index] = g_anim_cache[--g_anim_cache_count];
+}
+
+// False when every entry is pinned
+static bool anim_cache_evict_lru( void )
+{
+    int oldest = -1;
+    for ( int i = 0; i < g_anim_cache_count; i++ )
+    {
+        if ( g_anim_cache[i].pins == 0 && ( oldest < 0 || g_anim_cache[i].last_used < g_anim_cache[oldest].last_used ) )
+        {
+            oldest = i;
+        }
+    }
+
+    if ( oldest < 0 )
+    {
+        return false;
+    }
+
+    anim_cache_remove( oldest );
+    return true;
+}
+
+void mdl_anim_cache_set_budget( size_t bytes )
+{
+    pthread_mutex_lock( &g_anim_cache_mtx );
+
+    g_anim_cache_budget = bytes;
+
+    while ( g_anim_cache_count > 0 && g_anim_cache_bytes > g_anim_cache_budget && anim_cache_evict_lru( ) )
+    {
+    }
+
+    pthread_mutex_unlock( &g_anim_cache_mtx );
+}
+
+size_t mdl_anim_cache_get_usage( void )
+{
+    pthread_mutex_lock( &g_anim_cache_mtx );
+    size_t bytes = g_anim_cache_bytes;
+    pthread_mutex_unlock( &g_anim_cache_mtx );
+
+    return bytes;
+}
+
+void mdl_anim_cache_clear( void )
+{
+    pthread_mutex_lock( &g_anim_cache_mtx );
+
+    // A pinned entry is still being sampled: unkey it so nothing finds it
+    // again, and let anim_cache_release() free it
+    for ( int i = g_anim_cache_count - 1; i >= 0; i-- )
+    {
+        if ( g_anim_cache[i].pins == 0 )
+        {
+            anim_cache_remove( i );
+        }
+        else
+        {
+            g_anim_cache[i].key = NULL;
+        }
+    }
+
+    pthread_mutex_unlock( &g_anim_cache_mtx );
+}
+
+/*
+ * Expands one RLE channel into out[0..numframes) with the given stride.
+ * Frame k of a span is value[k + 1] while k < valid, after that the last
+ * valid value repeats until total - the same rule CalcBonePosition uses.
+ */
+static void DecodeAnimChannel( const mstudioanim_t *panim, int channel, int numframes, float base, float scale,
+                               float *out, int stride )
+{
+    if ( panim->offset[channel] == 0 )
+    {
+        for ( int f = 0; f < numframes; f++ )
+        {
+            out[f * stride] = base;
+        }
+        return;
+    }
+
+    const mstudioanimvalue_t *panimvalue =
+        ( const mstudioanimvalue_t * ) ( ( const unsigned char * ) panim + panim->offset[channel] );
+
+    int   frame = 0;
+    float last  = base;
+
+    while ( frame < numframes && panimvalue->num.total > 0 )
+    {
+        int total = panimvalue->num.total;
+        int valid = panimvalue->num.valid;
+
+        for ( int k = 0; k < total && frame < numframes; k++, frame++ )
+        {
+            int index = ( k < valid ) ? k + 1 : valid;
+
+            last              = base + panimvalue[index].value * scale;
+            out[frame * stride] = last;
+        }
+
+        panimvalue += valid + 1;
+    }
+
+    // Truncated stream - hold the last value
+    for ( ; frame < numframes; frame++ )
+    {
+        out[frame * stride] = last;
+    }
+}
+
+// Expands every bone's channels into a new entry. Caller holds the lock and made room.
+static anim_cache_entry_t *anim_cache_decode(
+    const mstudioanim_t *anims, const mstudiobone_t *bones, int numbones, int numframes, size_t count, size_t bytes )
+{
+    vec3   *positions = malloc( count * sizeof( vec3 ) );
+    versor *rotations = malloc( count * sizeof( versor ) );
+    float  *angles    = malloc( count * sizeof( vec3 ) );
+
+    if ( !positions || !rotations || !angles )
+    {
+        free( positions );
+        free( rotations );
+        free( angles );
+        return NULL;
+    }
+
+    for ( int b = 0; b < numbones; b++ )
+    {
+        const mstudiobone_t *bone  = &bones[b];
+        const mstudioanim_t *panim = &anims[b];
+
+        for ( int j = 0; j < 3; j++ )
+        {
+            DecodeAnimChannel( panim, j, numframes, bone->value[j], bone->scale[j], &positions[b][j], numbones * 3 );
+            DecodeAnimChannel(
+                panim, j + 3, numframes, bone->value[j + 3], bone->scale[j + 3], &angles[b * 3 + j], numbones * 3 );
+        }
+    }
+
+    for ( size_t i = 0; i < count; i++ )
+    {
+        AngleQuaternion( &angles[i * 3], rotations[i] );
+    }
+    free( angles );
+
+    anim_cache_entry_t *e = &g_anim_cache[g_anim_cache_count++];
+    e->key                = anims;
+    e->numbones           = numbones;
+    e->numframes          = numframes;
+    e->positions          = positions;
+    e->rotations          = rotations;
+    e->bytes              = bytes;
+    e->last_used          = 0;
+    e->pins               = 0;
+
+    g_anim_cache_bytes += bytes;
+
+    return e;
+}
+
+/*
+ * Finds or decodes the track and pins it into *track. Decoding happens under
+ * the lock, so two threads asking for the same new sequence decode it once.
+ * Returns false if the cache is off, the track does not fit or every entry
+ * that would have to go is pinned; the caller then walks the RLE streams.
+ */
+static bool anim_cache_acquire(
+    const mstudioanim_t *anims, const mstudiobone_t *bones, int numbones, int numframes, anim_track_t *track )
+{
+    if ( numframes <= 0 || numbones <= 0 )
+    {
+        return false;
+    }
+
+    pthread_mutex_lock( &g_anim_cache_mtx );
+
+    anim_cache_entry_t *e = NULL;
+
+    for ( int i = 0; i < g_anim_cache_count && !e; i++ )
+    {
+        if ( g_anim_cache[i].key == anims && g_anim_cache[i].numbones == numbones && g_anim_cache[i].numframes == numframes )
+        {
+            e = &g_anim_cache[i];
+        }
+    }
+
+    size_t count = ( size_t ) numframes * ( size_t ) numbones;
+    size_t bytes = count * ( sizeof( vec3 ) + sizeof( versor ) );
+
+    if ( !e && g_anim_cache_budget > 0 && bytes <= g_anim_cache_budget )
+    {
+        while ( g_anim_cache_count > 0
+                && ( g_anim_cache_bytes + bytes > g_anim_cache_budget || g_anim_cache_count == ANIM_CACHE_MAX_ENTRIES )
+                && anim_cache_evict_lru( ) )
+        {
+        }
+
+        if ( g_anim_cache_bytes + bytes <= g_anim_cache_budget && g_anim_cache_count < ANIM_CACHE_MAX_ENTRIES )
+        {
+            e = anim_cache_decode( anims, bones, numbones, numframes, count, bytes );
+        }
+    }
+
+    if ( e )
+    {
+        e->last_used = ++g_anim_cache_tick;
+        e->pins++;
+
+        track->numbones  = e->numbones;
+        track->numframes = e->numframes;
+        track->positions = e->positions;
+        track->rotations = e->rotations;
+    }
+
+    pthread_mutex_unlock( &g_anim_cache_mtx );
+    return e != NULL;
+}
+
+static void anim_cache_release( const anim_track_t *track )
+{
+    pthread_mutex_lock( &g_anim_cache_mtx );
+
+    for ( int i = 0; i < g_anim_cache_count; i++ )
+    {
+        if ( g_anim_cache[i].positions == track->positions )
+        {
+            if ( --g_anim_cache[i].pins == 0 && !g_anim_cache[i].key )
+            {
+                anim_cache_remove( i );    // cleared while pinned
+            }
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &g_anim_cache_mtx );
+}
+
+/*
+ * Resolves where a sequence's mstudioanim_t block lives, or NULL if its
+ * sequence group is not resident (yet).
+ */
+static mstudioanim_t *
+sequence_anims( studiohdr_t *header, unsigned char *data, mdl_seqgroup_blob_t *seqgroups, mstudioseqdesc_t *seq )
+{
+    if ( seq->seqgroup == 0 )
+    {
+        return ( mstudioanim_t * ) ( data + seq->animindex );
+    }
+
+    if ( !seqgroups || seq->seqgroup < 0 || seq->seqgroup >= header->numseqgroups
+         || mdl_seqgroup_status( &seqgroups[seq->seqgroup] ) != MDL_SEQGROUP_READY )
+    {
+        return NULL;
+    }
+
+    return ( mstudioanim_t * ) ( seqgroups[seq->seqgroup].data + seq->animindex );
+}
+
+/*
+ * Start reading the external group a sequence lives in, if it is deferred.
+ * Group 0 and groups that are already resident are left alone.
+ */
+static void prefetch_sequence_group( studiohdr_t *header, unsigned char *data, mdl_seqgroup_blob_t *seqgroups, int sequence_index )
+{
+    if ( !seqgroups || sequence_index < 0 || sequence_index >= header->numseq )
+    {
+        return;
+    }
+
+    mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( data + header->seqindex );
+    int               seqgroup  = sequences[sequence_index].seqgroup;
+
+    if ( seqgroup > 0 && seqgroup < header->numseqgroups )
+    {
+        mdl_seqgroup_request( &seqgroups[seqgroup] );
+    }
+}
+
 mdl_result_t
 mdl_animation_set_sequence( mdl_animation_state_t *state, int sequence_index, studiohdr_t *header, unsigned char *data, mdl_seqgroup_blob_t *seqgroups )
 {
@@ -262,6 +631,23 @@ mdl_animation_set_sequence( mdl_animation_state_t *state, int sequence_index, st
     state->current_sequence = sequence_index;
     state->current_frame    = 0.0f;
     state->is_looping       = ( seq->flags & 0x01 );
+    reset_anim_cursors( state );
+
+    // The requested group first, then the ones LEFT/RIGHT would step into next
+    prefetch_sequence_group( header, data, seqgroups, sequence_index );
+    prefetch_sequence_group( header, data, seqgroups, sequence_index + 1 );
+    prefetch_sequence_group( header, data, seqgroups, sequence_index - 1 );
+
+    // Decode the tracks now if the data is already resident, otherwise
+    // mdl_animation_calculate_bones() does it once the group arrives
+    mstudioanim_t *anims = sequence_anims( header, data, seqgroups, seq );
+    anim_track_t track;
+    if ( anims
+         && anim_cache_acquire(
+             anims, ( mstudiobone_t * ) ( data + header->boneindex ), header->numbones, seq->numframes, &track ) )
+    {
+        anim_cache_release( &track );
+    }
 
     printf(
         "Set animation to sequence %d: '%s' (%d frames @ %.1f fps)\n",
@@ -326,6 +712,11 @@ void mdl_animation_update( mdl_animation_state_t *state, float delta_time, studi
         // It wraps smoothly at (numframes - 1) for ALL frames
         
         float wrap_point = (float)( seq->numframes - 1 );
+        if ( state->current_frame >= wrap_point )
+        {
+            // Back to the start of the streams
+            reset_anim_cursors( state );
+        }
         state->current_frame -= (int)( state->current_frame / wrap_point ) * wrap_point;
         
         // For non-looping animations, clamp to last frame
@@ -356,6 +747,11 @@ mdl_result_t mdl_animation_calculate_bones(
         return MDL_ERROR_INVALID_PARAMETER;
     }
 
+    if ( header->numbones > MAXSTUDIOBONES )
+    {
+        return MDL_ERROR_TOO_MANY_BONES;
+    }
+
     mstudiobone_t *bones = ( mstudiobone_t * ) ( data + header->boneindex );
 
     mstudioseqdesc_t *sequences = ( mstudioseqdesc_t * ) ( data + header->seqindex );
@@ -386,7 +782,7 @@ mdl_result_t mdl_animation_calculate_bones(
                 fprintf(stderr, "       Falling back to T-pose. External files may be missing!\n");
                 warned_no_seqgroups = true;
             }
-            return MDL_INFO_SEQUENCE_GROUP_FILE;
+            return MDL_ERROR_SEQUENCE_GROUP_MISSING;
         }
         
         // NOTE(Karlo): CRITICAL FIX: Validate array bounds
@@ -403,7 +799,10 @@ mdl_result_t mdl_animation_calculate_bones(
         }
         
     // NOTE(Karlo): CRITICAL FIX: Check if this specific group's data is loaded
-    if (!seqgroups[seqgroup].data)
+    // Deferred groups get queued here; the caller shows the T-pose until READY
+    mdl_seqgroup_status_t group_status = mdl_seqgroup_request( &seqgroups[seqgroup] );
+
+    if (group_status == MDL_SEQGROUP_MISSING || group_status == MDL_SEQGROUP_FAILED)
     {
         static bool warned_missing_data = false;
         if (!warned_missing_data) {
@@ -413,14 +812,19 @@ mdl_result_t mdl_animation_calculate_bones(
             fprintf(stderr, "          Falling back to T-pose\n");
             warned_missing_data = true;
         }
-        return MDL_INFO_SEQUENCE_GROUP_FILE;
+        return MDL_ERROR_SEQUENCE_GROUP_MISSING;
+    }
+
+    if (group_status != MDL_SEQGROUP_READY)
+    {
+        return MDL_ERROR_SEQUENCE_GROUP_MISSING;
     }
         
         animBase = seqgroups[seqgroup].data;
     }
     
     
-    if (seqgroups[seqgroup].sequence_header)
+    if (seqgroup > 0 && seqgroups[seqgroup].sequence_header)
     {
         if (seqgroups[seqgroup].sequence_header->id != IDSEQGRPHEADER)
         {
@@ -436,6 +840,32 @@ mdl_result_t mdl_animation_calculate_bones(
     int   frame = ( int ) state->current_frame;
     float s     = state->current_frame - ( float ) frame;
 
+    // Pinned until the bones are built, so another thread cannot evict it meanwhile
+    anim_track_t cached;
+    const bool   track = anim_cache_acquire( anims, bones, header->numbones, seq->numframes, &cached );
+
+    // Dense rows for this frame and the next (clamped at the last frame)
+    const vec3   *pos0 = NULL, *pos1 = NULL;
+    const versor *rot0 = NULL, *rot1 = NULL;
+
+    if ( track )
+    {
+        int f0 = frame < 0 ? 0 : ( frame >= cached.numframes ? cached.numframes - 1 : frame );
+        int f1 = ( f0 + 1 < cached.numframes ) ? f0 + 1 : f0;
+
+        pos0 = &cached.positions[f0 * cached.numbones];
+        pos1 = &cached.positions[f1 * cached.numbones];
+        rot0 = &cached.rotations[f0 * cached.numbones];
+        rot1 = &cached.rotations[f1 * cached.numbones];
+    }
+
+    // Cursors remember spans of one specific anim block
+    if ( !track && state->cursor_anims != anims )
+    {
+        reset_anim_cursors( state );
+        state->cursor_anims = anims;
+    }
+
     // Process each bone
     for ( int i = 0; i < header->numbones; i++ )
     {
@@ -450,8 +880,24 @@ mdl_result_t mdl_animation_calculate_bones(
         vec3_t pos;
         // Calculate bone position using linear interpolation
 
-        CalcBoneQuaternion( frame, s, bone, panim, q );
-        CalcBonePosition( frame, s, bone, panim, pos );
+        if ( track )
+        {
+            if ( glm_vec4_eqv_eps( ( float * ) rot0[i], ( float * ) rot1[i] ) )
+            {
+                glm_vec4_copy( ( float * ) rot0[i], q );
+            }
+            else
+            {
+                QuaternionSlerp( rot0[i], rot1[i], s, q );
+            }
+
+            glm_vec3_lerp( ( float * ) pos0[i], ( float * ) pos1[i], s, pos );
+        }
+        else
+        {
+            CalcBoneQuaternion( frame, s, bone, panim, state->cursors[i], q );
+            CalcBonePosition( frame, s, bone, panim, state->cursors[i], pos );
+        }
 
 
         // Convert quaternion to rotation matrix
@@ -475,6 +921,11 @@ mdl_result_t mdl_animation_calculate_bones(
         }
     }
 
+    if ( track )
+    {
+        anim_cache_release( &cached );
+    }
+
     return MDL_SUCCESS;
 }
 
@@ -4,15 +4,49 @@
 #include "../studio.h"
 #include "mdl_loader.h"
 #include <cglm/cglm.h>
+#include <stddef.h>
+
+/*
+ * Resume point into one channel's RLE stream: the span that holds the last
+ * decoded frame and the frame number that span starts at. Lets sequential
+ * playback continue from there instead of walking from frame 0.
+ */
+typedef struct {
+    const mstudioanimvalue_t *span;
+    int                       base;
+} mdl_anim_cursor_t;
 
 typedef struct {
     int   current_sequence;
     float current_frame;
     bool  is_looping;
+
+    // Uncached decode path only: cursors[bone][channel] into cursor_anims
+    const mstudioanim_t *cursor_anims;
+    mdl_anim_cursor_t    cursors[MAXSTUDIOBONES][6];
 } mdl_animation_state_t;
 
 void mdl_animation_init( mdl_animation_state_t *state );
 
+/*
+ * Decoded animation cache. Sequences are expanded into dense per-frame
+ * position/quaternion arrays the first time they are played and reused
+ * until evicted (LRU) to stay under the budget. A budget of 0 disables it.
+ * Call mdl_anim_cache_clear() before freeing the model data it points into
+ * (cleanup_renderer() does); a pinned entry is freed when its last pin goes.
+ *
+ * The cache is locked, so several threads may build bones at once (the crowd
+ * poses its members on the job system); a single mdl_animation_state_t still
+ * belongs to one thread at a time.
+ */
+#define MDL_ANIM_CACHE_DEFAULT_BUDGET ( 64u * 1024u * 1024u )
+
+void mdl_anim_cache_set_budget( size_t bytes );
+
+size_t mdl_anim_cache_get_usage( void );
+
+void mdl_anim_cache_clear( void );
+
 mdl_result_t mdl_animation_set_sequence(
     mdl_animation_state_t *state, int sequence_index, studiohdr_t *header, unsigned char *data, mdl_seqgroup_blob_t *seqgroups );
 
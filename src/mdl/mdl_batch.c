@@ -0,0 +1,197 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Parallel batch analysis of a model directory tree
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "mdl_batch.h"
+
+#include "../utils/job_system.h"
+#include "mdl_loader.h"
+#include "mdl_report.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// Models analysed between two flushes of the output, so records stream out
+// while a large tree is still being worked through
+#define BATCH_WINDOW    256
+
+// Guards against symlink loops
+#define BATCH_MAX_DEPTH 32
+
+typedef struct {
+    char **paths;
+    int    count;
+    int    capacity;
+} batch_files_t;
+
+typedef struct {
+    mdl_result_t        result;
+    mdl_model_summary_t summary;
+    double              load_ms;
+} batch_result_t;
+
+typedef struct {
+    char *const    *paths;
+    batch_result_t *results;
+} batch_window_t;
+
+static double batch_now_ms( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec * 1000.0 + ( double ) ts.tv_nsec / 1.0e6;
+}
+
+static bool add_file( batch_files_t *files, const char *path )
+{
+    if ( files->count == files->capacity )
+    {
+        int    capacity = files->capacity ? files->capacity * 2 : 256;
+        char **paths    = realloc( files->paths, ( size_t ) capacity * sizeof( *paths ) );
+        if ( !paths )
+            return false;
+
+        files->paths    = paths;
+        files->capacity = capacity;
+    }
+
+    files->paths[files->count] = strdup( path );
+    if ( !files->paths[files->count] )
+        return false;
+
+    files->count++;
+    return true;
+}
+
+static bool collect_models( batch_files_t *files, const char *dir, int depth )
+{
+    DIR *d = opendir( dir );
+    if ( !d )
+    {
+        // Only the root is fatal; an unreadable subdirectory is skipped
+        fprintf( stderr, "%s - Cannot read directory '%s'\n", depth > 0 ? "WARNING" : "ERROR", dir );
+        return depth > 0;
+    }
+
+    bool           ok = true;
+    struct dirent *ent;
+    while ( ok && ( ent = readdir( d ) ) != NULL )
+    {
+        if ( ent->d_name[0] == '.' )
+            continue;    // ".", ".." and hidden entries
+
+        char path[1024];
+        if ( snprintf( path, sizeof( path ), "%s/%s", dir, ent->d_name ) >= ( int ) sizeof( path ) )
+            continue;
+
+        struct stat st;
+        if ( stat( path, &st ) != 0 )
+            continue;
+
+        if ( S_ISDIR( st.st_mode ) )
+        {
+            if ( depth < BATCH_MAX_DEPTH )
+                ok = collect_models( files, path, depth + 1 );
+        }
+        else if ( S_ISREG( st.st_mode ) && mdl_is_main_model_file( dir, ent->d_name ) )
+        {
+            ok = add_file( files, path );
+        }
+    }
+
+    closedir( d );
+    return ok;
+}
+
+static int compare_paths( const void *a, const void *b )
+{
+    return strcmp( *( char *const * ) a, *( char *const * ) b );
+}
+
+static void analyze_range( void *arg, int begin, int end )
+{
+    batch_window_t *window = arg;
+
+    for ( int i = begin; i < end; ++i )
+    {
+        batch_result_t *out   = &window->results[i];
+        mdl_model_t    *model = NULL;
+
+        double t0   = batch_now_ms( );
+        out->result = create_mdl_model( window->paths[i], &model );
+        out->load_ms = batch_now_ms( ) - t0;
+
+        if ( out->result == MDL_SUCCESS )
+        {
+            mdl_summarize_model( model, &out->summary );
+            free_model( model );
+        }
+    }
+}
+
+int mdl_batch_analyze( const char *dir, FILE *output )
+{
+    batch_files_t files = { 0 };
+
+    if ( !collect_models( &files, dir, 0 ) )
+    {
+        for ( int i = 0; i < files.count; ++i )
+            free( files.paths[i] );
+        free( files.paths );
+        return -1;
+    }
+
+    qsort( files.paths, ( size_t ) files.count, sizeof( *files.paths ), compare_paths );
+
+    batch_result_t results[BATCH_WINDOW];
+    int            failed = 0;
+
+    for ( int first = 0; first < files.count; first += BATCH_WINDOW )
+    {
+        int            count  = files.count - first < BATCH_WINDOW ? files.count - first : BATCH_WINDOW;
+        batch_window_t window = { &files.paths[first], results };
+
+        job_parallel_for( "batch model", count, 1, analyze_range, &window );
+
+        for ( int i = 0; i < count; ++i )
+        {
+            if ( results[i].result == MDL_SUCCESS )
+            {
+                print_model_summary_json( output, files.paths[first + i], &results[i].summary, results[i].load_ms );
+            }
+            else
+            {
+                print_model_error_json( output, files.paths[first + i], results[i].result, results[i].load_ms );
+                failed++;
+            }
+        }
+        fflush( output );
+    }
+
+    for ( int i = 0; i < files.count; ++i )
+        free( files.paths[i] );
+    free( files.paths );
+
+    return failed;
+}
@@ -0,0 +1,16 @@
+#ifndef MDL_BATCH_H
+#define MDL_BATCH_H
+
+#include <stdio.h>
+
+/*
+ * Walks `dir` recursively for standalone models (T.mdl texture companions and
+ * NN.mdl sequence groups are skipped), loads and summarizes them on the job
+ * system and writes one JSON line per model to `output`, sorted by path.
+ *
+ * Returns the number of models that failed to load, or -1 if `dir` could not
+ * be read.
+ */
+int mdl_batch_analyze( const char *dir, FILE *output );
+
+#endif    // MDL_BATCH_H
@@ -0,0 +1,790 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Compiled model cache (welded meshes and RGBA skins on disk)
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "mdl_cache.h"
+#include "mdl_palette.h"
+
+#include "../utils/job_system.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define MDL_CACHE_MAGIC   0x43444D4C    // "LMDC"
+#define MDL_CACHE_VERSION 2
+#define MDL_CACHE_ALIGN   16
+
+/*
+ * File layout: header, mesh table (sorted by mesh offset), texture table,
+ * then the vertex, index and pixel blobs, each 16-byte aligned. Everything
+ * is in native byte order; the sizes in the header reject a file written by
+ * a build with a different layout.
+ */
+typedef struct {
+    int32_t  magic;
+    int32_t  version;
+    int32_t  header_size;
+    int32_t  vertex_size;     // sizeof( mdl_tricmd_vertex_t )
+    int32_t  vcache_size;     // FIFO size the meshes were optimized for
+    int32_t  num_meshes;
+    int32_t  num_textures;
+    int32_t  reserved;
+
+    // Source key
+    uint64_t main_size;
+    uint64_t texture_size;    // 0 without a T.mdl
+    uint64_t content_hash;    // of both files' bytes
+
+    uint64_t mesh_table;
+    uint64_t texture_table;
+    uint64_t file_size;
+    char     source[1024];
+} cache_header_t;
+
+typedef struct {
+    uint32_t mesh_offset;     // of the mstudiomesh_t in the model file
+    int32_t  num_vertices;
+    int32_t  num_indices;
+    int32_t  triangles;
+    int32_t  before_vertices, before_misses;
+    int32_t  after_vertices, after_misses;
+    uint64_t vertices;
+    uint64_t indices;
+} cache_mesh_t;
+
+typedef struct {
+    int32_t  width;           // 0 when the texture was not cached
+    int32_t  height;
+    uint64_t rgba;
+} cache_texture_t;
+
+struct mdl_model_cache_s {
+    unsigned char         *mapping;
+    size_t                 size;
+    const cache_header_t  *header;
+    const cache_mesh_t    *meshes;
+    const cache_texture_t *textures;
+
+    // Keys for mdl_cache_find()
+    const unsigned char *model_data;
+    const unsigned char *texture_data;
+
+    // Set when a mesh fails validation; the file is then not trusted again
+    atomic_bool stale;
+    char        path[1024];
+
+    struct mdl_model_cache_s *next;
+};
+
+static char g_cache_dir[512];
+
+// Open caches, looked up by file data pointer
+static pthread_mutex_t    g_open_mtx = PTHREAD_MUTEX_INITIALIZER;
+static mdl_model_cache_t *g_open;
+
+void mdl_cache_set_dir( const char *dir )
+{
+    snprintf( g_cache_dir, sizeof( g_cache_dir ), "%s", dir ? dir : "" );
+}
+
+const char *mdl_cache_get_dir( void )
+{
+    return g_cache_dir[0] ? g_cache_dir : NULL;
+}
+
+static int compare_mesh_offsets( const void *a, const void *b )
+{
+    const uint32_t x = ( ( const cache_mesh_t * ) a )->mesh_offset;
+    const uint32_t y = ( ( const cache_mesh_t * ) b )->mesh_offset;
+    return ( x > y ) - ( x < y );
+}
+
+#ifndef _WIN32
+
+static size_t align_up( size_t bytes )
+{
+    return ( bytes + MDL_CACHE_ALIGN - 1 ) & ~( size_t ) ( MDL_CACHE_ALIGN - 1 );
+}
+
+// FNV-1a over 64-bit words; only has to tell an edited file from the original
+static uint64_t hash_bytes( uint64_t hash, const unsigned char *bytes, size_t size )
+{
+    size_t i = 0;
+    for ( ; i + 8 <= size; i += 8 )
+    {
+        uint64_t word;
+        memcpy( &word, bytes + i, sizeof( word ) );
+        hash = ( hash ^ word ) * 0x100000001B3ull;
+    }
+    for ( ; i < size; ++i )
+    {
+        hash = ( hash ^ bytes[i] ) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static uint64_t content_hash( const mdl_model_t *model )
+{
+    uint64_t hash = hash_bytes( 0xCBF29CE484222325ull, model->data, model->data_size );
+    if ( model->texture_data )
+        hash = hash_bytes( hash, model->texture_data, model->texture_size );
+    return hash;
+}
+
+static const mstudiotexture_t *cached_texture_table( const mdl_model_t *model, const unsigned char **file, size_t *size, int *count )
+{
+    // Same choice as mdl_pick_texture_header()
+    const studiohdr_t *header = NULL;
+    if ( model->header->numtextures > 0 )
+    {
+        header = model->header;
+        *file  = model->data;
+        *size  = model->data_size;
+    }
+    else if ( model->texture_header && model->texture_header->numtextures > 0 )
+    {
+        header = model->texture_header;
+        *file  = model->texture_data;
+        *size  = model->texture_size;
+    }
+
+    if ( !header || header->textureindex < 0
+         || ( size_t ) header->textureindex + ( size_t ) header->numtextures * sizeof( mstudiotexture_t ) > *size )
+    {
+        *count = 0;
+        return NULL;
+    }
+
+    *count = header->numtextures;
+    return ( const mstudiotexture_t * ) ( *file + header->textureindex );
+}
+
+/* ─── Building ───────────────────────────────────────────────────────────── */
+
+typedef struct {
+    const unsigned char *data;
+    const mstudiomesh_t *mesh;
+    int                  numverts;
+    int                  numnorms;
+
+    mdl_tricmd_vertex_t *vertices;
+    unsigned int        *indices;
+    int                  num_vertices;
+    int                  num_indices;
+    mdl_vcache_stats_t   before, after;
+    bool                 failed;
+} mesh_build_t;
+
+typedef struct {
+    const mstudiotexture_t *textures;
+    const unsigned char    *file;
+    size_t                  file_size;
+    unsigned char         **rgba;
+} texture_build_t;
+
+// The same decode, weld and reorder AppendIndexedMesh() does in the renderer
+static void build_mesh_range( void *arg, int begin, int end )
+{
+    mesh_build_t *builds = arg;
+
+    for ( int i = begin; i < end; ++i )
+    {
+        mesh_build_t *b        = &builds[i];
+        const int     capacity = mdl_count_tricmd_corners( b->data, b->mesh );
+        const size_t  slots    = ( size_t ) ( capacity > 0 ? capacity : 1 );
+
+        mdl_tricmd_vertex_t *corners = malloc( slots * sizeof( *corners ) );
+        b->vertices                  = malloc( slots * sizeof( *b->vertices ) );
+        b->indices                   = malloc( slots * sizeof( *b->indices ) );
+        if ( !corners || !b->vertices || !b->indices )
+        {
+            free( corners );
+            b->failed = true;
+            continue;
+        }
+
+        const int count  = mdl_decode_tricmds( b->data, b->mesh, b->numverts, b->numnorms, corners, capacity );
+        const int unique = mdl_weld_tricmd_vertices( corners, count, b->vertices, b->indices );
+        free( corners );
+
+        if ( unique < 0 )
+        {
+            b->failed = true;
+            continue;
+        }
+
+        mdl_analyze_vertex_cache( b->indices, count, unique, MDL_VCACHE_SIZE, &b->before );
+        if ( mdl_optimize_vertex_cache( b->indices, count, unique, MDL_VCACHE_SIZE ) )
+        {
+            mdl_optimize_vertex_fetch( b->vertices, unique, b->indices, count );
+        }
+        mdl_analyze_vertex_cache( b->indices, count, unique, MDL_VCACHE_SIZE, &b->after );
+
+        b->num_vertices = unique;
+        b->num_indices  = count;
+    }
+}
+
+// The same expansion as mdl_load_textures(); textures that run past the file stay uncached
+static void build_texture_range( void *arg, int begin, int end )
+{
+    texture_build_t *build = arg;
+
+    for ( int i = begin; i < end; ++i )
+    {
+        const mstudiotexture_t *T      = &build->textures[i];
+        const size_t            pixels = ( size_t ) T->width * ( size_t ) T->height;
+
+        if ( T->width <= 0 || T->height <= 0 || T->index < 0
+             || ( size_t ) T->index + pixels + 256 * 3 > build->file_size )
+            continue;
+
+        const unsigned char *indices = build->file + T->index;
+        const unsigned char *palette = indices + pixels;
+        unsigned char       *rgba    = malloc( pixels * 4 );
+        build->rgba[i]               = rgba;
+        if ( !rgba )
+            continue;
+
+        mdl_palette_lut_t lut;
+        mdl_palette_build_lut( palette, 256, false, &lut );
+        mdl_palette_expand_rgba( indices, pixels, &lut, rgba );
+    }
+}
+
+// Every mesh of every submodel, so any bodygroup can be served from the cache
+static int collect_meshes( const mdl_model_t *model, mesh_build_t *out )
+{
+    const studiohdr_t   *header = model->header;
+    const unsigned char *data   = model->data;
+    const size_t         size   = model->data_size;
+    int                  count  = 0;
+
+    if ( header->numbodyparts <= 0 || header->bodypartindex < 0
+         || ( size_t ) header->bodypartindex + ( size_t ) header->numbodyparts * sizeof( mstudiobodyparts_t ) > size )
+        return 0;
+
+    const mstudiobodyparts_t *bodyparts = ( const mstudiobodyparts_t * ) ( data + header->bodypartindex );
+    for ( int bp = 0; bp < header->numbodyparts; ++bp )
+    {
+        const int nummodels = bodyparts[bp].nummodels;
+        if ( nummodels <= 0 || bodyparts[bp].modelindex < 0
+             || ( size_t ) bodyparts[bp].modelindex + ( size_t ) nummodels * sizeof( mstudiomodel_t ) > size )
+            continue;
+
+        const mstudiomodel_t *models = ( const mstudiomodel_t * ) ( data + bodyparts[bp].modelindex );
+        for ( int m = 0; m < nummodels; ++m )
+        {
+            const int nummesh = models[m].nummesh;
+            if ( nummesh <= 0 || models[m].meshindex < 0
+                 || ( size_t ) models[m].meshindex + ( size_t ) nummesh * sizeof( mstudiomesh_t ) > size )
+                continue;
+
+            const mstudiomesh_t *meshes = ( const mstudiomesh_t * ) ( data + models[m].meshindex );
+            for ( int k = 0; k < nummesh; ++k )
+            {
+                if ( out )
+                {
+                    out[count].data     = data;
+                    out[count].mesh     = &meshes[k];
+                    out[count].numverts = models[m].numverts;
+                    out[count].numnorms = models[m].numnorms;
+                }
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+// Writes to a temporary name first so a reader never maps a half-written file
+static bool write_cache_file( const char *path, const unsigned char *bytes, size_t size )
+{
+    static atomic_uint serial;
+
+    char tmp[1200];
+    snprintf( tmp, sizeof( tmp ), "%s.%ld.%u.tmp", path, ( long ) getpid( ), atomic_fetch_add( &serial, 1 ) );
+
+    FILE *fp = fopen( tmp, "wb" );
+    if ( !fp )
+        return false;
+
+    bool ok = fwrite( bytes, 1, size, fp ) == size;
+    ok      = ( fclose( fp ) == 0 ) && ok;
+
+    if ( !ok || rename( tmp, path ) != 0 )
+    {
+        remove( tmp );
+        return false;
+    }
+    return true;
+}
+
+static bool build_cache( const char *path, const char *source, const mdl_model_t *model )
+{
+    const int     num_meshes = collect_meshes( model, NULL );
+    mesh_build_t *meshes     = calloc( ( size_t ) ( num_meshes > 0 ? num_meshes : 1 ), sizeof( *meshes ) );
+
+    const unsigned char    *texture_file = NULL;
+    size_t                  texture_size = 0;
+    int                     num_textures = 0;
+    const mstudiotexture_t *textures     = cached_texture_table( model, &texture_file, &texture_size, &num_textures );
+    unsigned char         **rgba         = calloc( ( size_t ) ( num_textures > 0 ? num_textures : 1 ), sizeof( *rgba ) );
+
+    cache_mesh_t    *mesh_table    = calloc( ( size_t ) ( num_meshes > 0 ? num_meshes : 1 ), sizeof( *mesh_table ) );
+    cache_texture_t *texture_table = calloc( ( size_t ) ( num_textures > 0 ? num_textures : 1 ), sizeof( *texture_table ) );
+    unsigned char   *bytes         = NULL;
+    bool             ok            = meshes && rgba && mesh_table && texture_table;
+
+    if ( ok )
+    {
+        collect_meshes( model, meshes );
+        job_parallel_for( "cache meshes", num_meshes, 4, build_mesh_range, meshes );
+
+        texture_build_t texture_build = { textures, texture_file, texture_size, rgba };
+        job_parallel_for( "cache textures", num_textures, 1, build_texture_range, &texture_build );
+    }
+
+    // Lay the file out
+    size_t offset = align_up( sizeof( cache_header_t ) );
+    size_t tables = offset;
+    offset += align_up( ( size_t ) num_meshes * sizeof( cache_mesh_t ) );
+    offset += align_up( ( size_t ) num_textures * sizeof( cache_texture_t ) );
+
+    for ( int i = 0; ok && i < num_meshes; ++i )
+    {
+        const mesh_build_t *b = &meshes[i];
+        cache_mesh_t       *m = &mesh_table[i];
+        if ( b->failed )
+        {
+            ok = false;
+            break;
+        }
+
+        m->mesh_offset     = ( uint32_t ) ( ( const unsigned char * ) b->mesh - model->data );
+        m->num_vertices    = b->num_vertices;
+        m->num_indices     = b->num_indices;
+        m->triangles       = b->before.triangles;
+        m->before_vertices = b->before.vertices;
+        m->before_misses   = b->before.misses;
+        m->after_vertices  = b->after.vertices;
+        m->after_misses    = b->after.misses;
+
+        m->vertices = offset;
+        offset += align_up( ( size_t ) b->num_vertices * sizeof( mdl_tricmd_vertex_t ) );
+        m->indices = offset;
+        offset += align_up( ( size_t ) b->num_indices * sizeof( unsigned int ) );
+    }
+
+    for ( int i = 0; ok && i < num_textures; ++i )
+    {
+        if ( !rgba[i] )
+            continue;
+
+        texture_table[i].width  = textures[i].width;
+        texture_table[i].height = textures[i].height;
+        texture_table[i].rgba   = offset;
+        offset += align_up( ( size_t ) textures[i].width * ( size_t ) textures[i].height * 4 );
+    }
+
+    if ( ok )
+    {
+        bytes = calloc( 1, offset );
+        ok    = bytes != NULL;
+    }
+
+    if ( ok )
+    {
+        cache_header_t *header = ( cache_header_t * ) bytes;
+        header->magic          = MDL_CACHE_MAGIC;
+        header->version        = MDL_CACHE_VERSION;
+        header->header_size    = ( int32_t ) sizeof( cache_header_t );
+        header->vertex_size    = ( int32_t ) sizeof( mdl_tricmd_vertex_t );
+        header->vcache_size    = MDL_VCACHE_SIZE;
+        header->num_meshes     = num_meshes;
+        header->num_textures   = num_textures;
+        header->content_hash   = content_hash( model );
+        header->mesh_table     = tables;
+        header->texture_table  = tables + align_up( ( size_t ) num_meshes * sizeof( cache_mesh_t ) );
+        header->file_size      = offset;
+        header->main_size      = model->data_size;
+        header->texture_size   = model->texture_data ? model->texture_size : 0;
+        snprintf( header->source, sizeof( header->source ), "%s", source );
+
+        for ( int i = 0; i < num_meshes; ++i )
+        {
+            memcpy( bytes + mesh_table[i].vertices, meshes[i].vertices, ( size_t ) meshes[i].num_vertices * sizeof( mdl_tricmd_vertex_t ) );
+            memcpy( bytes + mesh_table[i].indices, meshes[i].indices, ( size_t ) meshes[i].num_indices * sizeof( unsigned int ) );
+        }
+        for ( int i = 0; i < num_textures; ++i )
+        {
+            if ( rgba[i] )
+                memcpy( bytes + texture_table[i].rgba, rgba[i], ( size_t ) textures[i].width * ( size_t ) textures[i].height * 4 );
+        }
+
+        qsort( mesh_table, ( size_t ) num_meshes, sizeof( *mesh_table ), compare_mesh_offsets );
+        memcpy( bytes + header->mesh_table, mesh_table, ( size_t ) num_meshes * sizeof( *mesh_table ) );
+        memcpy( bytes + header->texture_table, texture_table, ( size_t ) num_textures * sizeof( *texture_table ) );
+
+        ok = write_cache_file( path, bytes, offset );
+    }
+
+    for ( int i = 0; meshes && i < num_meshes; ++i )
+    {
+        free( meshes[i].vertices );
+        free( meshes[i].indices );
+    }
+    for ( int i = 0; rgba && i < num_textures; ++i )
+    {
+        free( rgba[i] );
+    }
+    free( meshes );
+    free( rgba );
+    free( mesh_table );
+    free( texture_table );
+    free( bytes );
+
+    return ok;
+}
+
+/* ─── Opening ────────────────────────────────────────────────────────────── */
+
+static mdl_model_cache_t *map_cache( const char *path )
+{
+    int fd = open( path, O_RDONLY );
+    if ( fd < 0 )
+        return NULL;
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 || st.st_size < ( off_t ) sizeof( cache_header_t ) )
+    {
+        close( fd );
+        return NULL;
+    }
+
+    const size_t size    = ( size_t ) st.st_size;
+    void        *mapping = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    if ( mapping == MAP_FAILED )
+        return NULL;
+
+    mdl_model_cache_t *cache = calloc( 1, sizeof( *cache ) );
+    if ( !cache )
+    {
+        munmap( mapping, size );
+        return NULL;
+    }
+
+    cache->mapping = mapping;
+    cache->size    = size;
+    cache->header  = mapping;
+    return cache;
+}
+
+static void unmap_cache( mdl_model_cache_t *cache )
+{
+    munmap( cache->mapping, cache->size );
+    free( cache );
+}
+
+static bool in_file( const mdl_model_cache_t *cache, uint64_t offset, size_t bytes )
+{
+    return offset <= cache->size && bytes <= cache->size - offset;
+}
+
+// Rejects files from another build or cut short; every blob must lie inside the mapping
+static bool check_layout( mdl_model_cache_t *cache )
+{
+    const cache_header_t *h = cache->header;
+
+    if ( h->magic != MDL_CACHE_MAGIC || h->version != MDL_CACHE_VERSION || h->header_size != ( int32_t ) sizeof( *h )
+         || h->vertex_size != ( int32_t ) sizeof( mdl_tricmd_vertex_t ) || h->vcache_size != MDL_VCACHE_SIZE
+         || h->file_size != cache->size || h->num_meshes < 0 || h->num_textures < 0
+         || !in_file( cache, h->mesh_table, ( size_t ) h->num_meshes * sizeof( cache_mesh_t ) )
+         || !in_file( cache, h->texture_table, ( size_t ) h->num_textures * sizeof( cache_texture_t ) ) )
+        return false;
+
+    cache->meshes   = ( const cache_mesh_t * ) ( cache->mapping + h->mesh_table );
+    cache->textures = ( const cache_texture_t * ) ( cache->mapping + h->texture_table );
+
+    for ( int i = 0; i < h->num_meshes; ++i )
+    {
+        const cache_mesh_t *m = &cache->meshes[i];
+        if ( m->num_vertices < 0 || m->num_indices < 0
+             || !in_file( cache, m->vertices, ( size_t ) m->num_vertices * sizeof( mdl_tricmd_vertex_t ) )
+             || !in_file( cache, m->indices, ( size_t ) m->num_indices * sizeof( unsigned int ) ) )
+            return false;
+    }
+
+    for ( int i = 0; i < h->num_textures; ++i )
+    {
+        const cache_texture_t *t = &cache->textures[i];
+        if ( t->width < 0 || t->height < 0
+             || !in_file( cache, t->rgba, ( size_t ) t->width * ( size_t ) t->height * 4 ) )
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * The model at the same path with the same bytes. The content hash is always
+ * compared: a copy that keeps the mtime (cp -p, rsync -t, tar) or a rewrite
+ * within the same second would get past a size and mtime check, and the
+ * hash costs little next to the decode the cache saves.
+ */
+static bool check_source( const mdl_model_cache_t *cache, const char *source, const mdl_model_t *model )
+{
+    const cache_header_t *h = cache->header;
+
+    return strcmp( h->source, source ) == 0 && h->main_size == model->data_size
+           && h->texture_size == ( model->texture_data ? model->texture_size : 0 )
+           && h->content_hash == content_hash( model );
+}
+
+static void register_cache( mdl_model_cache_t *cache, const char *path, const mdl_model_t *model )
+{
+    cache->model_data   = model->data;
+    cache->texture_data = model->texture_data;
+    atomic_init( &cache->stale, false );
+    snprintf( cache->path, sizeof( cache->path ), "%s", path );
+
+    pthread_mutex_lock( &g_open_mtx );
+    cache->next = g_open;
+    g_open      = cache;
+    pthread_mutex_unlock( &g_open_mtx );
+}
+
+#endif    // !_WIN32
+
+mdl_model_cache_t *mdl_cache_open( const char *model_path, const mdl_model_t *model, bool *rebuilt )
+{
+    if ( rebuilt )
+        *rebuilt = false;
+
+#ifdef _WIN32
+    // No mapping on Windows yet (see map_mdl_file())
+    ( void ) model_path;
+    ( void ) model;
+    return NULL;
+#else
+    if ( !g_cache_dir[0] || !model_path || !model || !model->header || !model->data )
+        return NULL;
+
+    // Keyed by the canonical path so ./a.mdl and ../x/a.mdl share one file
+    char        resolved[PATH_MAX];
+    const char *source = realpath( model_path, resolved ) ? resolved : model_path;
+
+    char path[1024];
+    snprintf(
+        path,
+        sizeof( path ),
+        "%s/%016llx.lmc",
+        g_cache_dir,
+        ( unsigned long long ) hash_bytes( 0xCBF29CE484222325ull, ( const unsigned char * ) source, strlen( source ) ) );
+
+    mdl_model_cache_t *cache = map_cache( path );
+    if ( cache && check_layout( cache ) && check_source( cache, source, model ) )
+    {
+        register_cache( cache, path, model );
+        return cache;
+    }
+
+    if ( cache )
+        unmap_cache( cache );
+
+    if ( mkdir( g_cache_dir, 0755 ) != 0 && errno != EEXIST )
+    {
+        fprintf( stderr, "WARNING - Cannot create model cache directory '%s'\n", g_cache_dir );
+        return NULL;
+    }
+
+    if ( !build_cache( path, source, model ) )
+    {
+        fprintf( stderr, "WARNING - Failed to write model cache '%s'\n", path );
+        return NULL;
+    }
+
+    cache = map_cache( path );
+    if ( !cache || !check_layout( cache ) )
+    {
+        if ( cache )
+            unmap_cache( cache );
+        return NULL;
+    }
+
+    if ( rebuilt )
+        *rebuilt = true;
+
+    register_cache( cache, path, model );
+    return cache;
+#endif
+}
+
+void mdl_cache_close( mdl_model_cache_t *cache )
+{
+    if ( !cache )
+        return;
+
+#ifndef _WIN32
+    pthread_mutex_lock( &g_open_mtx );
+    for ( mdl_model_cache_t **link = &g_open; *link; link = &( *link )->next )
+    {
+        if ( *link == cache )
+        {
+            *link = cache->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock( &g_open_mtx );
+
+    unmap_cache( cache );
+#endif
+}
+
+const mdl_model_cache_t *mdl_cache_find( const unsigned char *data )
+{
+    if ( !data )
+        return NULL;
+
+    pthread_mutex_lock( &g_open_mtx );
+    const mdl_model_cache_t *cache = g_open;
+    while ( cache && cache->model_data != data && cache->texture_data != data )
+    {
+        cache = cache->next;
+    }
+    pthread_mutex_unlock( &g_open_mtx );
+
+    return cache;
+}
+
+/*
+ * Stops using a cache whose contents do not fit the model and breaks its
+ * magic on disk, so the next load rebuilds it. The cache object itself is
+ * not const data; the lookup API only hands it out read-only.
+ */
+static void mark_stale( const mdl_model_cache_t *cache )
+{
+    mdl_model_cache_t *owner = ( mdl_model_cache_t * ) cache;
+    if ( atomic_exchange( &owner->stale, true ) )
+        return;
+
+    fprintf( stderr, "WARNING - Model cache '%s' does not match the model, decoding it instead\n", cache->path );
+
+#ifndef _WIN32
+    int fd = open( cache->path, O_WRONLY );
+    if ( fd >= 0 )
+    {
+        const int32_t magic = 0;
+        if ( pwrite( fd, &magic, sizeof( magic ), ( off_t ) offsetof( cache_header_t, magic ) ) != ( ssize_t ) sizeof( magic ) )
+        {
+            fprintf( stderr, "WARNING - Could not invalidate model cache '%s'\n", cache->path );
+        }
+        close( fd );
+    }
+#endif
+}
+
+// Every corner must name a vertex and normal of the submodel, every index a corner of the mesh
+static bool check_mesh( const cache_mesh_t *m, const mdl_tricmd_vertex_t *vertices, const unsigned int *indices, int num_verts, int num_norms )
+{
+    for ( int i = 0; i < m->num_vertices; ++i )
+    {
+        if ( vertices[i].vertex < 0 || vertices[i].vertex >= num_verts || vertices[i].normal < 0
+             || vertices[i].normal >= num_norms )
+            return false;
+    }
+
+    for ( int i = 0; i < m->num_indices; ++i )
+    {
+        if ( indices[i] >= ( unsigned int ) m->num_vertices )
+            return false;
+    }
+
+    return m->num_indices % 3 == 0;
+}
+
+bool mdl_cache_mesh(
+    const mdl_model_cache_t *cache,
+    const unsigned char     *data,
+    const mstudiomesh_t     *mesh,
+    int                      num_verts,
+    int                      num_norms,
+    mdl_cached_mesh_t       *out )
+{
+    if ( !cache || data != cache->model_data || atomic_load_explicit( &cache->stale, memory_order_relaxed ) )
+        return false;
+
+    const cache_mesh_t key   = { .mesh_offset = ( uint32_t ) ( ( const unsigned char * ) mesh - data ) };
+    const cache_mesh_t *found = bsearch(
+        &key, cache->meshes, ( size_t ) cache->header->num_meshes, sizeof( *cache->meshes ), compare_mesh_offsets );
+    if ( !found )
+        return false;
+
+    const mdl_tricmd_vertex_t *vertices = ( const mdl_tricmd_vertex_t * ) ( cache->mapping + found->vertices );
+    const unsigned int        *indices  = ( const unsigned int * ) ( cache->mapping + found->indices );
+    if ( !check_mesh( found, vertices, indices, num_verts, num_norms ) )
+    {
+        mark_stale( cache );
+        return false;
+    }
+
+    memset( out, 0, sizeof( *out ) );
+    out->vertices         = vertices;
+    out->indices          = indices;
+    out->num_vertices     = found->num_vertices;
+    out->num_indices      = found->num_indices;
+    out->before.triangles = found->triangles;
+    out->before.vertices  = found->before_vertices;
+    out->before.misses    = found->before_misses;
+    out->after.triangles  = found->triangles;
+    out->after.vertices   = found->after_vertices;
+    out->after.misses     = found->after_misses;
+    return true;
+}
+
+const unsigned char *mdl_cache_texture_rgba( const mdl_model_cache_t *cache, int index, int width, int height )
+{
+    if ( !cache || index < 0 || index >= cache->header->num_textures
+         || atomic_load_explicit( &cache->stale, memory_order_relaxed ) )
+        return NULL;
+
+    const cache_texture_t *t = &cache->textures[index];
+    if ( t->width == 0 || t->width != width || t->height != height )
+        return NULL;
+
+    return cache->mapping + t->rgba;
+}
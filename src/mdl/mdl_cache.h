@@ -0,0 +1,68 @@
+#ifndef MDL_CACHE_H
+#define MDL_CACHE_H
+
+#include "../studio.h"
+#include "mdl_loader.h"
+#include "mdl_mesh.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Compiled model cache.
+ *
+ * A model's startup work that only depends on its files - every submodel's
+ * mesh welded and reordered for the vertex cache, and every skin expanded to
+ * RGBA - is written once to <dir>/<hash of the source path>.lmc and mapped
+ * read-only on later loads. The renderer and mdl_load_textures() then copy
+ * or upload straight from the mapping instead of decoding again.
+ *
+ * A cache file is keyed by the source path and is only used while the size
+ * and content hash of the model and its T.mdl match; anything else rebuilds
+ * it. Cached meshes are still checked against the model before use.
+ */
+typedef struct mdl_model_cache_s mdl_model_cache_t;
+
+typedef struct {
+    const mdl_tricmd_vertex_t *vertices;        // welded, in fetch order
+    const unsigned int        *indices;         // triangle list, vertex cache order
+    int                        num_vertices;
+    int                        num_indices;
+    mdl_vcache_stats_t         before, after;   // triangles, vertices and misses only
+} mdl_cached_mesh_t;
+
+// Directory for cache files; NULL or "" disables the cache (the default)
+void mdl_cache_set_dir( const char *dir );
+
+const char *mdl_cache_get_dir( void );
+
+/*
+ * Maps the cache of a freshly loaded model, building it first when it is
+ * missing or stale. Returns NULL when caching is off or the file could not
+ * be written; *rebuilt tells a cold build from a hit.
+ */
+mdl_model_cache_t *mdl_cache_open( const char *model_path, const mdl_model_t *model, bool *rebuilt );
+
+void mdl_cache_close( mdl_model_cache_t *cache );
+
+// Cache of the loaded model whose main or texture file data is `data`, if any
+const mdl_model_cache_t *mdl_cache_find( const unsigned char *data );
+
+/*
+ * Cached mesh for `mesh` of the model file at `data`, whose submodel has
+ * `num_verts` vertices and `num_norms` normals. False if it is not cached or
+ * a corner or index is out of range; the cache is then marked stale, and
+ * the caller decodes the mesh itself.
+ */
+bool mdl_cache_mesh(
+    const mdl_model_cache_t *cache,
+    const unsigned char     *data,
+    const mstudiomesh_t     *mesh,
+    int                      num_verts,
+    int                      num_norms,
+    mdl_cached_mesh_t       *out );
+
+// RGBA8 pixels of texture `index`, or NULL unless the cache holds it at width x height
+const unsigned char *mdl_cache_texture_rgba( const mdl_model_cache_t *cache, int index, int width, int height );
+
+#endif    // MDL_CACHE_H
@@ -24,13 +24,70 @@
 #include "mdl_loader.h"
 
 #include "../studio.h"
+#include "../utils/job_system.h"
 #include "../utils/mdl_messages.h"
 #include "../utils/utils.h"
+#include "mdl_cache.h"
+#include "mdl_palette.h"
 
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static mdl_load_mode_t g_load_mode = MDL_LOAD_MODE_READ;
+
+void mdl_set_load_mode( mdl_load_mode_t mode )
+{
+    g_load_mode = mode;
+}
+
+mdl_load_mode_t mdl_get_load_mode( void )
+{
+    return g_load_mode;
+}
+
+static bool g_lazy_seqgroups = false;
+
+void mdl_set_lazy_seqgroups( bool lazy )
+{
+    g_lazy_seqgroups = lazy;
+}
+
+bool mdl_get_lazy_seqgroups( void )
+{
+    return g_lazy_seqgroups;
+}
+
+static bool g_load_messages = true;
+
+void mdl_set_load_messages( bool enabled )
+{
+    g_load_messages = enabled;
+}
+
+// Progress chatter on stdout; errors and warnings still go to stderr
+static void load_message( const char *fmt, ... )
+{
+    if ( !g_load_messages )
+        return;
+
+    va_list ap;
+    va_start( ap, fmt );
+    vprintf( fmt, ap );
+    va_end( ap );
+}
 
 mdl_result_t validate_mdl_magic( unsigned magic )
 {
@@ -77,6 +134,107 @@ mdl_result_t read_mdl_file( const char *filename, unsigned char **file_data, siz
     return MDL_SUCCESS;
 }
 
+mdl_result_t map_mdl_file( const char *filename, unsigned char **file_data, size_t *file_size )
+{
+#ifdef _WIN32
+    ( void ) filename;
+    ( void ) file_data;
+    ( void ) file_size;
+    return MDL_ERROR_NOT_IMPLEMENTED;
+#else
+    int fd = open( filename, O_RDONLY );
+    if ( fd < 0 )
+    {
+        fprintf( stderr, "ERROR - Failed to open the file '%s'. Invalid file name, file not found!\n", filename );
+        return MDL_ERROR_FILE_NOT_FOUND;
+    }
+
+    struct stat st;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        return MDL_ERROR_FILE_NOT_FOUND;
+    }
+
+    // Anything shorter than a sequence group header cannot be parsed, and
+    // touching past the end of a mapping raises SIGBUS instead of reading junk
+    if ( st.st_size < ( off_t ) sizeof( studioseqhdr_t ) )
+    {
+        close( fd );
+        return MDL_ERROR_FILE_TOO_SMALL;
+    }
+
+    size_t bytes_size = ( size_t ) st.st_size;
+    void  *mapping    = mmap( NULL, bytes_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );    // the mapping keeps its own reference to the file
+
+    if ( mapping == MAP_FAILED )
+    {
+        fprintf( stderr, "ERROR - Failed to map the file '%s' into memory.\n", filename );
+        return MDL_ERROR_MEMORY_ALLOCATION;
+    }
+
+    // Headers, bones and tricmds are parsed right away, so ask for read-ahead
+    madvise( mapping, bytes_size, MADV_WILLNEED );
+
+    *file_data = ( unsigned char * ) mapping;
+    *file_size = bytes_size;
+    return MDL_SUCCESS;
+#endif
+}
+
+void unmap_mdl_file( unsigned char *file_data, size_t file_size )
+{
+#ifndef _WIN32
+    if ( file_data )
+    {
+        munmap( file_data, file_size );
+    }
+#else
+    ( void ) file_data;
+    ( void ) file_size;
+#endif
+}
+
+/*
+ * Load a file using the requested mode. MMAP falls back to READ on
+ * platforms without mmap; *mapped tells the caller how to release it.
+ */
+static mdl_result_t
+open_mdl_file( const char *filename, mdl_load_mode_t mode, unsigned char **file_data, size_t *file_size, bool *mapped )
+{
+    *mapped = false;
+
+    if ( mode == MDL_LOAD_MODE_MMAP )
+    {
+        mdl_result_t r = map_mdl_file( filename, file_data, file_size );
+        if ( r != MDL_ERROR_NOT_IMPLEMENTED )
+        {
+            *mapped = ( r == MDL_SUCCESS );
+            return r;
+        }
+    }
+
+    return read_mdl_file( filename, file_data, file_size );
+}
+
+static void release_mdl_file( unsigned char *file_data, size_t file_size, bool mapped )
+{
+    if ( !file_data )
+    {
+        return;
+    }
+
+    if ( mapped )
+    {
+        unmap_mdl_file( file_data, file_size );
+    }
+    else
+    {
+        free( file_data );
+    }
+}
+
 mdl_result_t parse_mdl_header( const unsigned char *file_data, studiohdr_t **header )
 {
     if ( !file_data || !header )
@@ -148,22 +306,18 @@ char *generate_texture_filename( const char *model_filename )
     return texture_filename;
 }
 
-mdl_result_t load_model_with_textures(
-    const char     *model_path,
-    studiohdr_t   **main_header,
-    studiohdr_t   **texture_header,
-    unsigned char **main_data,
-    unsigned char **texture_data )
+static mdl_result_t load_model_files( const char *model_path, mdl_load_mode_t mode, mdl_model_t *model )
 {
-    size_t       main_size;
-    mdl_result_t r = read_mdl_file( model_path, main_data, &main_size );
+    bool         mapped = false;
+    mdl_result_t r      = open_mdl_file( model_path, mode, &model->data, &model->data_size, &mapped );
     if ( r != MDL_SUCCESS )
     {
         mdl_print_message( r, &( mdl_msg_ctx_t ) { .path = model_path } );
         return r;
     }
+    model->mapped = mapped;
 
-    r = parse_mdl_header( *main_data, main_header );
+    r = parse_mdl_header( model->data, &model->header );
     if ( r != MDL_SUCCESS )
     {
         if ( r == MDL_INFO_SEQUENCE_GROUP_FILE )
@@ -175,65 +329,94 @@ mdl_result_t load_model_with_textures(
         else if ( r == MDL_ERROR_INVALID_VERSION )
         {
             mdl_print_message(
-                r, &( mdl_msg_ctx_t ) { .path = model_path, .version = ( int ) ( *main_header )->version } );
+                r, &( mdl_msg_ctx_t ) { .path = model_path, .version = ( int ) model->header->version } );
         }
         else
         {
             mdl_print_message( r, &( mdl_msg_ctx_t ) { .path = model_path } );
         }
-        free( *main_data );
-        *main_data   = NULL;
-        *main_header = NULL;
+        release_mdl_file( model->data, model->data_size, mapped );
+        model->data      = NULL;
+        model->data_size = 0;
+        model->header    = NULL;
         return r;
     }
 
     // If main has no textures, try companion t.mdl
-    if ( ( *main_header )->numtextures == 0 )
+    if ( model->header->numtextures == 0 )
     {
         char *texture_path = generate_texture_filename( model_path );
         if ( !texture_path )
         {
-            free( *main_data );
-            *main_data   = NULL;
-            *main_header = NULL;
+            release_mdl_file( model->data, model->data_size, mapped );
+            model->data      = NULL;
+            model->data_size = 0;
+            model->header    = NULL;
             return MDL_ERROR_MEMORY_ALLOCATION;
         }
 
-        size_t       tex_size;
-        mdl_result_t tr = read_mdl_file( texture_path, texture_data, &tex_size );
+        // Both files share one release path, so the texture file must be
+        // loaded the same way the main file actually was
+        bool         tex_mapped = false;
+        mdl_result_t tr         = open_mdl_file(
+            texture_path, mapped ? MDL_LOAD_MODE_MMAP : MDL_LOAD_MODE_READ, &model->texture_data, &model->texture_size,
+            &tex_mapped );
         if ( tr == MDL_SUCCESS )
         {
-            tr = parse_mdl_header( *texture_data, texture_header );
+            tr = parse_mdl_header( model->texture_data, &model->texture_header );
             if ( tr != MDL_SUCCESS )
             {
                 mdl_print_message( tr, &( mdl_msg_ctx_t ) { .path = texture_path } );
-                free( *texture_data );
-                *texture_data   = NULL;
-                *texture_header = NULL;
+                release_mdl_file( model->texture_data, model->texture_size, tex_mapped );
+                model->texture_data   = NULL;
+                model->texture_size   = 0;
+                model->texture_header = NULL;
                 // Not fatal; continue without textures
             }
         }
         else
         {
             mdl_print_message( MDL_ERROR_MISSING_TEXTURE_FILE, &( mdl_msg_ctx_t ) { .path = model_path } );
-            *texture_data   = NULL;
-            *texture_header = NULL;
+            model->texture_data   = NULL;
+            model->texture_size   = 0;
+            model->texture_header = NULL;
         }
 
         free( texture_path );
     }
     else
     {
-        *texture_data   = NULL;
-        *texture_header = NULL;
+        model->texture_data   = NULL;
+        model->texture_size   = 0;
+        model->texture_header = NULL;
     }
 
     // Optional: on success, emit a friendly banner (console or GUI string)
-    fprintf( stderr, "SUCCESS: Model loaded completely!\n" );
+    if ( g_load_messages )
+        fprintf( stderr, "SUCCESS: Model loaded completely!\n" );
 
     return MDL_SUCCESS;
 }
 
+mdl_result_t load_model_with_textures(
+    const char     *model_path,
+    studiohdr_t   **main_header,
+    studiohdr_t   **texture_header,
+    unsigned char **main_data,
+    unsigned char **texture_data )
+{
+    // Legacy entry point: callers release these buffers with free(), so always read
+    mdl_model_t  files = { 0 };
+    mdl_result_t r     = load_model_files( model_path, MDL_LOAD_MODE_READ, &files );
+
+    *main_header    = files.header;
+    *main_data      = files.data;
+    *texture_header = files.texture_header;
+    *texture_data   = files.texture_data;
+
+    return r;
+}
+
 
 void print_texture_info( FILE *output, const studiohdr_t *texture_header, const unsigned char *texture_data )
 {
@@ -574,22 +757,10 @@ mdl_result_t extract_texture_rgb(
         return MDL_ERROR_MEMORY_ALLOCATION;
     }
 
-    for ( int i = 0; i < pixel_count; i++ )
-    {
-        unsigned char palette_index = indexed_pixels[i];
-
-        ( *rgb_output )[i * 3 + 0] = palette[palette_index * 3 + 0];
-        ( *rgb_output )[i * 3 + 1] = palette[palette_index * 3 + 1];
-        ( *rgb_output )[i * 3 + 2] = palette[palette_index * 3 + 2];
-
-        // TODO(Karlo): checking for transparent pixel
-        if ( palette_index == 255 )
-        {
-            ( *rgb_output )[i * 3 + 0] = 0;
-            ( *rgb_output )[i * 3 + 1] = 0;
-            ( *rgb_output )[i * 3 + 2] = 0;
-        }
-    }
+    // Transparent pixels (index 255) come out black
+    mdl_palette_lut_t lut;
+    mdl_palette_build_lut( palette, 256, false, &lut );
+    mdl_palette_expand_rgb( indexed_pixels, ( size_t ) pixel_count, &lut, *rgb_output );
 
     printf( "Extracted textures %d: %s (%dx%d)\n", texture_index, tex->name, tex->width, tex->height );
     return MDL_SUCCESS;
@@ -819,10 +990,355 @@ get_model_by_bodypart( studiohdr_t *header, unsigned char *main_data, int bodygr
 }
 
 
+/*
+ * Sequence group loader thread.
+ *
+ * Deferred groups are queued here by mdl_seqgroup_request() and read one at
+ * a time. The thread is started on the first request and joined again by
+ * free_sequences_groups() once nothing is left in flight, so a model that
+ * never touches an external group never spawns it.
+ */
+#define SEQGROUP_QUEUE_SIZE 64
+
+static struct
+{
+    pthread_mutex_t      mtx;
+    pthread_cond_t       wake;    // job queued or stop requested
+    pthread_cond_t       idle;    // current job finished
+    pthread_t            thread;
+    bool                 running;
+    bool                 stop;
+    mdl_seqgroup_blob_t *queue[SEQGROUP_QUEUE_SIZE];
+    int                  head;
+    int                  count;
+    mdl_seqgroup_blob_t *busy;
+} W = { .mtx = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER, .idle = PTHREAD_COND_INITIALIZER };
+
+
+static void print_missing_seqgroup( int index, const char *filename, const char *path )
+{
+    fprintf(stderr, "╔════════════════════════════════════════════════════╗\n");
+    fprintf(stderr, "║ WARNING - Missing Sequence Group File              ║\n");
+    fprintf(stderr, "╠════════════════════════════════════════════════════╣\n");
+    fprintf(stderr, "  Sequence Group: %d\n", index);
+    fprintf(stderr, "  Expected File:  %s\n", filename);
+    fprintf(stderr, "  Full Path:      %s\n", path);
+    fprintf(stderr, "╠════════════════════════════════════════════════════╣\n");
+    fprintf(stderr, "  IMPACT: Animations requiring this group will show  \n");
+    fprintf(stderr, "          the T-pose instead of playing.             \n");
+    fprintf(stderr, "╚════════════════════════════════════════════════════╝\n\n");
+}
+
+
+/*
+ * Reads and validates group->path. The data fields are filled in before the
+ * status is published, so a reader that sees READY also sees the data.
+ */
+static void load_sequence_group_file(mdl_seqgroup_blob_t *group)
+{
+    unsigned char *seq_group_data = NULL;
+    size_t group_size = 0;
+    bool seq_group_mapped = false;
+
+    mdl_result_t file_result = open_mdl_file(group->path, g_load_mode, &seq_group_data, &group_size, &seq_group_mapped);
+
+    if (file_result != MDL_SUCCESS)
+    {
+        atomic_store_explicit(&group->status, MDL_SEQGROUP_MISSING, memory_order_release);
+        return;
+    }
+
+    studioseqhdr_t *sequence_header = (studioseqhdr_t *)seq_group_data;
+
+    if (sequence_header->id != IDSEQGRPHEADER)
+    {
+        fprintf(stderr, "ERROR - Invalid sequence group file (wrong magic -> 0x%08X)\n", 
+                sequence_header->id);
+        release_mdl_file(seq_group_data, group_size, seq_group_mapped);
+        atomic_store_explicit(&group->status, MDL_SEQGROUP_FAILED, memory_order_release);
+        return;
+    }
+
+    if (sequence_header->version != STUDIO_VERSION)
+    {
+        fprintf(stderr, "ERROR - Wrong sequence group version (got %d, expected %d)\n",
+                sequence_header->version, STUDIO_VERSION);
+        release_mdl_file(seq_group_data, group_size, seq_group_mapped);
+        atomic_store_explicit(&group->status, MDL_SEQGROUP_FAILED, memory_order_release);
+        return;
+    }
+
+    group->sequence_header = sequence_header;
+    group->data = seq_group_data;
+    group->size = group_size;
+    group->mapped = seq_group_mapped;
+
+    atomic_store_explicit(&group->status, MDL_SEQGROUP_READY, memory_order_release);
+}
+
+
+static void *seqgroup_worker_main(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&W.mtx);
+
+    for (;;)
+    {
+        while (!W.stop && W.count == 0)
+        {
+            pthread_cond_wait(&W.wake, &W.mtx);
+        }
+
+        if (W.count == 0)
+        {
+            break;
+        }
+
+        mdl_seqgroup_blob_t *group = W.queue[W.head];
+        W.head = (W.head + 1) % SEQGROUP_QUEUE_SIZE;
+        W.count--;
+        W.busy = group;
+
+        atomic_store_explicit(&group->status, MDL_SEQGROUP_LOADING, memory_order_relaxed);
+        pthread_mutex_unlock(&W.mtx);
+
+        load_sequence_group_file(group);
+
+        if (atomic_load_explicit(&group->status, memory_order_relaxed) == MDL_SEQGROUP_READY)
+        {
+            load_message("  Loaded sequence group: %s (%zu bytes, deferred)\n", group->name, group->size);
+        }
+        else
+        {
+            fprintf(stderr, "WARNING - Deferred sequence group failed to load: %s\n", group->path);
+        }
+
+        pthread_mutex_lock(&W.mtx);
+        W.busy = NULL;
+        pthread_cond_broadcast(&W.idle);
+    }
+
+    pthread_mutex_unlock(&W.mtx);
+    return NULL;
+}
+
+
+mdl_seqgroup_status_t mdl_seqgroup_status(const mdl_seqgroup_blob_t *group)
+{
+    if (!group)
+    {
+        return MDL_SEQGROUP_MISSING;
+    }
+
+    return (mdl_seqgroup_status_t)atomic_load_explicit(
+        (atomic_int *)&group->status, memory_order_acquire);
+}
+
+
+mdl_seqgroup_status_t mdl_seqgroup_request(mdl_seqgroup_blob_t *group)
+{
+    mdl_seqgroup_status_t status = mdl_seqgroup_status(group);
+
+    if (status != MDL_SEQGROUP_UNLOADED)
+    {
+        return status;
+    }
+
+    pthread_mutex_lock(&W.mtx);
+
+    // Every step out of UNLOADED happens under W.mtx, so this caller owns the
+    // group only if it is still UNLOADED here
+    status = mdl_seqgroup_status(group);
+    bool load_here = false;
+
+    // Queue full: leave it UNLOADED, the next frame asks again
+    if (status == MDL_SEQGROUP_UNLOADED && W.count < SEQGROUP_QUEUE_SIZE)
+    {
+        if (!W.running)
+        {
+            W.stop = false;
+            W.running = (pthread_create(&W.thread, NULL, seqgroup_worker_main, NULL) == 0);
+        }
+
+        if (W.running)
+        {
+            W.queue[(W.head + W.count) % SEQGROUP_QUEUE_SIZE] = group;
+            W.count++;
+            atomic_store_explicit(&group->status, MDL_SEQGROUP_QUEUED, memory_order_relaxed);
+            status = MDL_SEQGROUP_QUEUED;
+            pthread_cond_signal(&W.wake);
+        }
+        else
+        {
+            // Claim it so other callers wait for this load instead of starting their own
+            atomic_store_explicit(&group->status, MDL_SEQGROUP_LOADING, memory_order_relaxed);
+            status = MDL_SEQGROUP_LOADING;
+            load_here = true;
+        }
+    }
+
+    pthread_mutex_unlock(&W.mtx);
+
+    // No thread available, load in place rather than never animating
+    if (load_here)
+    {
+        load_sequence_group_file(group);
+        status = mdl_seqgroup_status(group);
+    }
+
+    return status;
+}
+
+
+/*
+ * Drops queued jobs that point into groups[0..num_groups) and waits for the
+ * worker to finish one it may be loading, so the array can be freed. The
+ * thread itself is joined once its queue is empty.
+ */
+static void seqgroup_worker_release(mdl_seqgroup_blob_t *groups, int num_groups)
+{
+    pthread_mutex_lock(&W.mtx);
+
+    if (!W.running)
+    {
+        pthread_mutex_unlock(&W.mtx);
+        return;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < W.count; i++)
+    {
+        mdl_seqgroup_blob_t *job = W.queue[(W.head + i) % SEQGROUP_QUEUE_SIZE];
+
+        if (job >= groups && job < groups + num_groups)
+        {
+            atomic_store_explicit(&job->status, MDL_SEQGROUP_UNLOADED, memory_order_relaxed);
+            continue;
+        }
+
+        W.queue[(W.head + kept) % SEQGROUP_QUEUE_SIZE] = job;
+        kept++;
+    }
+    W.count = kept;
+
+    while (W.busy && W.busy >= groups && W.busy < groups + num_groups)
+    {
+        pthread_cond_wait(&W.idle, &W.mtx);
+    }
+
+    bool join = (W.count == 0 && !W.busy);
+    if (join)
+    {
+        W.stop = true;
+        pthread_cond_signal(&W.wake);
+    }
+
+    pthread_mutex_unlock(&W.mtx);
+
+    if (join)
+    {
+        pthread_join(W.thread, NULL);
+
+        pthread_mutex_lock(&W.mtx);
+        W.running = false;
+        pthread_mutex_unlock(&W.mtx);
+    }
+}
+
+
+// The file part of a sequence group's name, which may carry a '/' or '\\' path
+static const char *seqgroup_file_name(const char *name)
+{
+    const char *filename = strrchr(name, '/');
+    if (filename) {
+        return filename + 1; // Skip the '/' character
+    }
+    
+    // Try backslash (Windows)
+    filename = strrchr(name, '\\');
+    if (filename) {
+        return filename + 1; // Skip the '\\' character
+    }
+    
+    // No path separator, it's already just a filename
+    return name;
+}
+
+/*
+ * A trailing 't' or digits only mark a T.mdl companion or an NN.mdl group
+ * when the base model sits next to the file, so hgrunt.mdl or a model named
+ * after a number still counts.
+ */
+bool mdl_is_main_model_file(const char *dir, const char *name)
+{
+    size_t n = strlen(name);
+    if (n < 4 || strcasecmp(name + n - 4, ".mdl") != 0)
+    {
+        return false;
+    }
+
+    char base[512];
+    n -= 4;
+    if (n == 0 || n >= sizeof(base))
+    {
+        return false;
+    }
+
+    memcpy(base, name, n);
+    base[n] = '\0';
+
+    size_t stem = n;
+    if (base[stem - 1] == 't' || base[stem - 1] == 'T')
+    {
+        stem--;
+    }
+    else
+    {
+        while (stem > 0 && base[stem - 1] >= '0' && base[stem - 1] <= '9')
+        {
+            stem--;
+        }
+    }
+
+    if (stem == n || stem == 0)
+    {
+        return true;
+    }
+
+    char sibling[1024];
+    snprintf(sibling, sizeof(sibling), "%s/%.*s.mdl", dir, (int)stem, base);
+
+    FILE *fp = fopen(sibling, "rb");
+    if (fp)
+    {
+        fclose(fp);
+        return false;
+    }
+    return true;
+}
+
+
+// Job body for the eager path: groups [begin, end) of the array passed as arg
+static void load_sequence_group_range(void *arg, int begin, int end)
+{
+    mdl_seqgroup_blob_t *groups = arg;
+    
+    for (int i = begin; i < end; i++)
+    {
+        load_sequence_group_file(&groups[i]);
+    }
+}
+
+
 /*
  * Adding animations seqgroups files for opening
  * Since seqgroup == 0 only refers to data inside that current .mdl file
  * All other ones need to be accessed via external IDSQ containing mdl files
+ *
+ * With mdl_set_lazy_seqgroups(true) only the paths are resolved and checked
+ * for existence here; mdl_seqgroup_request() reads the file when an
+ * animation first needs it.
  */
 
 mdl_result_t load_sequence_groups(const char *model_path, studiohdr_t *header, unsigned char *main_data, mdl_seqgroup_blob_t **groups_out, int *num_groups_out) 
@@ -854,6 +1370,7 @@ mdl_result_t load_sequence_groups(const char *model_path, studiohdr_t *header, u
     
     groups[0].data = main_data;
     groups[0].size = header->length;
+    atomic_init(&groups[0].status, MDL_SEQGROUP_READY);
     
     strncpy(groups[0].name, "main", sizeof(groups[0].name) - 1);
     
@@ -881,77 +1398,60 @@ mdl_result_t load_sequence_groups(const char *model_path, studiohdr_t *header, u
             dir_path[dir_size] = '\0';
         }
         
-        const char *filename = strrchr(sq->name, '/');
-        if (filename) {
-            filename++; // Skip the '/' character
-        } else {
-            // Try backslash (Windows)
-            filename = strrchr(sq->name, '\\');
-            if (filename) {
-                filename++; // Skip the '\' character
-            } else {
-                // No path separator, it's already just a filename
-                filename = sq->name;
-            }
-        }        
+        const char *filename = seqgroup_file_name(sq->name);
         
         
         
         // NOTE(Karlo): Now we have the dir path name, now we need to build the full model path
-        unsigned char *seq_group_data = NULL;
-        size_t group_size = 0;
-         
-        char seqgroup_path[512]; 
-        snprintf(seqgroup_path, sizeof(seqgroup_path), "%s%s", dir_path, filename);
-        printf("Loading sequence group %d: trying '%s'...\n", i, seqgroup_path);   
-        
-        mdl_result_t file_result = read_mdl_file(seqgroup_path, &seq_group_data, &group_size);
+        snprintf(groups[i].path, sizeof(groups[i].path), "%s%s", dir_path, filename);
+        strncpy(groups[i].name, sq->name, sizeof(groups[i].name) - 1);
+        atomic_init(&groups[i].status, MDL_SEQGROUP_UNLOADED);
         
-        groups[i].sequence_header = (studioseqhdr_t *)seq_group_data;
-
-        if (groups[i].sequence_header->id != IDSEQGRPHEADER)
+        if (g_lazy_seqgroups)
         {
-            fprintf(stderr, "ERROR - Invalid sequence group file (wrong magic -> 0x%08X)\n", 
-                    groups[i].sequence_header->id);
-            free(seq_group_data);
-            continue;
+            // Only make sure it exists so the missing-file report stays up front
+            FILE *probe = fopen(groups[i].path, "rb");
+            if (!probe)
+            {
+                print_missing_seqgroup(i, filename, groups[i].path);
+                strncpy(groups[i].name, filename, sizeof(groups[i].name) - 1);
+                atomic_store(&groups[i].status, MDL_SEQGROUP_MISSING);
+                continue;
+            }
+            fclose(probe);
+            
+            load_message("Deferred sequence group %d: '%s'\n", i, groups[i].path);
         }
-
-        if (groups[i].sequence_header->version != STUDIO_VERSION)
-        {
-            fprintf(stderr, "ERROR - Wrong sequence group version (got %d, expected %d)\n",
-                    groups[i].sequence_header->version, STUDIO_VERSION);
-            free(seq_group_data);
-            continue;   
-        } 
-        
+    }
+    
+    if (!g_lazy_seqgroups && num_groups > 1)
+    {
+        // Read every group file at once on the job system, then report in order
+        job_parallel_for("seqgroup load", num_groups - 1, 1, load_sequence_group_range, &groups[1]);
         
-        // Check if loading failed
-        if (file_result != MDL_SUCCESS) 
+        for (int i = 1; i < num_groups; i++)
         {
-            fprintf(stderr, "╔════════════════════════════════════════════════════╗\n");
-            fprintf(stderr, "║ WARNING - Missing Sequence Group File              ║\n");
-            fprintf(stderr, "╠════════════════════════════════════════════════════╣\n");
-            fprintf(stderr, "  Sequence Group: %d\n", i);
-            fprintf(stderr, "  Expected File:  %s\n", filename);
-            fprintf(stderr, "  Full Path:      %s\n", seqgroup_path);
-            fprintf(stderr, "╠════════════════════════════════════════════════════╣\n");
-            fprintf(stderr, "  IMPACT: Animations requiring this group will show  \n");
-            fprintf(stderr, "          the T-pose instead of playing.             \n");
-            fprintf(stderr, "╚════════════════════════════════════════════════════╝\n\n");
+            mstudioseqgroup_t *sq = &seqgroup_descriptors[i];
+            const char *filename = seqgroup_file_name(sq->name);
             
-            groups[i].data = NULL;
-            groups[i].size = 0;
-            strncpy(groups[i].name, filename, sizeof(groups[i].name) - 1);
-            continue;
+            load_message("Loading sequence group %d: trying '%s'...\n", i, groups[i].path);   
+            
+            switch (mdl_seqgroup_status(&groups[i]))
+            {
+            case MDL_SEQGROUP_READY:
+                // SUCCESS!
+                load_message("  Loaded sequence group %d: %s (%zu bytes)\n", i, sq->name, groups[i].size);
+                break;
+                
+            case MDL_SEQGROUP_MISSING:
+                print_missing_seqgroup(i, filename, groups[i].path);
+                strncpy(groups[i].name, filename, sizeof(groups[i].name) - 1);
+                break;
+                
+            default:
+                break;
+            }
         }
-        
-        // SUCCESS!
-        groups[i].data = seq_group_data;
-        groups[i].size = group_size;
-        strncpy(groups[i].name, sq->name, sizeof(groups[i].name) - 1);
-        
-        printf("  Loaded sequence group %d: %s (%zu bytes)\n", i, sq->name, group_size);
     }
     
     
@@ -964,17 +1464,19 @@ mdl_result_t load_sequence_groups(const char *model_path, studiohdr_t *header, u
     
     for (int i = 0; i < num_groups; i++)
     {
-        if (groups[i].data != NULL)
+        mdl_seqgroup_status_t status = mdl_seqgroup_status(&groups[i]);
+        
+        if (status == MDL_SEQGROUP_READY)
         {
             loaded_count++;
         }
-        else if (i > 0)  // Don't count group 0
+        else if (status == MDL_SEQGROUP_MISSING || status == MDL_SEQGROUP_FAILED)
         {
             missing_count++;
         }
     }
     
-    if (missing_count > 0)
+    if (missing_count > 0 && g_load_messages)
     {   
         printf("\n\n");
         printf("┌────────────────────────────────────────────────────┐\n");
@@ -999,11 +1501,13 @@ void free_sequences_groups(mdl_seqgroup_blob_t *groups, int num_groups)
         return;
     }
     
+    seqgroup_worker_release(groups, num_groups);
+    
     for (int i = 1; i < num_groups; i++)
     {
         if (groups[i].data)
         {
-            free(groups[i].data);
+            release_mdl_file(groups[i].data, groups[i].size, groups[i].mapped);
             groups[i].data = NULL;
         }
     }
@@ -1030,12 +1534,7 @@ mdl_result_t create_mdl_model(const char *model_path, mdl_model_t **model_out)
     
     memset(model, 0, sizeof(mdl_model_t));
 
-    mdl_result_t result = load_model_with_textures(
-        model_path, 
-        &model->header, 
-        &model->texture_header, 
-        &model->data, 
-        &model->texture_data );
+    mdl_result_t result = load_model_files(model_path, g_load_mode, model);
     
     
     if (result != MDL_SUCCESS)
@@ -1045,7 +1544,7 @@ mdl_result_t create_mdl_model(const char *model_path, mdl_model_t **model_out)
         return result;
     }
     
-    printf("Loaded main model: '%s\n", model_path);
+    load_message("Loaded main model: '%s\n", model_path);
     
     result = load_sequence_groups(
         model_path, 
@@ -1060,13 +1559,27 @@ mdl_result_t create_mdl_model(const char *model_path, mdl_model_t **model_out)
         // we continue because some dont have them simply
     }
     
-    if (model->num_seqgroups > 1)
+    if (model->num_seqgroups > 1 && g_lazy_seqgroups)
+    {
+        load_message("     Found %d sequence groups (loaded on first use)\n", model->num_seqgroups - 1);
+    }
+    else if (model->num_seqgroups > 1)
     {
-        printf("     Loaded %d sequence groups\n", model->num_seqgroups - 1);
+        load_message("     Loaded %d sequence groups\n", model->num_seqgroups - 1);
     }
     else 
     {
-        printf("     No external sequence groups (animations in main file)\n");
+        load_message("     No external sequence groups (animations in main file)\n");
+    }
+    
+    if (mdl_cache_get_dir())
+    {
+        bool rebuilt = false;
+        model->cache = mdl_cache_open(model_path, model, &rebuilt);
+        if (model->cache)
+        {
+            load_message("     %s compiled model cache\n", rebuilt ? "Rebuilt" : "Using");
+        }
     }
     
     *model_out = model;
@@ -1083,6 +1596,10 @@ void free_model(mdl_model_t *model)
         return;
     }
     
+    // Unregister before the file data it is keyed by goes away
+    mdl_cache_close(model->cache);
+    model->cache = NULL;
+    
     if (model->seqgroups)
     {
         free_sequences_groups(model->seqgroups, model->num_seqgroups);
@@ -1091,19 +1608,19 @@ void free_model(mdl_model_t *model)
     
     if (model->data)
     {
-        free(model->data);
+        release_mdl_file(model->data, model->data_size, model->mapped);
         model->data = NULL;
     }
     
     if (model->texture_data)
     {
-        free(model->texture_data);
+        release_mdl_file(model->texture_data, model->texture_size, model->mapped);
         model->texture_data = NULL;
     }
     
     free(model);
     
-    printf("   Model Fully Freed!\n"); 
+    load_message("   Model Fully Freed!\n"); 
 }
 
 
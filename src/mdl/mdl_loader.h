@@ -4,16 +4,49 @@
 #include "../studio.h"
 #include "../utils/mdl_messages.h"
 
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 
 
+/*
+ * How model files are brought into memory.
+ *   READ - fopen/fread into a heap buffer (default)
+ *   MMAP - map the file read-only; headers point straight into the mapping
+ */
+typedef enum {
+    MDL_LOAD_MODE_READ = 0,
+    MDL_LOAD_MODE_MMAP
+} mdl_load_mode_t;
+
+
+/*
+ * Where an external sequence group (NN.mdl) is in its lifecycle. Group 0 is
+ * always READY. Lazily resolved groups go UNLOADED -> QUEUED -> LOADING ->
+ * READY/FAILED on the loader worker thread. MISSING means the file was not
+ * found on disk.
+ */
+typedef enum {
+    MDL_SEQGROUP_UNLOADED = 0,
+    MDL_SEQGROUP_QUEUED,
+    MDL_SEQGROUP_LOADING,
+    MDL_SEQGROUP_READY,
+    MDL_SEQGROUP_MISSING,
+    MDL_SEQGROUP_FAILED
+} mdl_seqgroup_status_t;
+
+
 // adding the necessary things for seqgroups problem
 typedef struct {
     studioseqhdr_t *sequence_header;
     unsigned char *data;
     size_t         size;
     char           name[64];
+    bool           mapped;    // data is an mmap view (unmap instead of free)
+
+    char           path[512]; // resolved file path, used for deferred loading
+    atomic_int     status;    // mdl_seqgroup_status_t, published after data/size
 
 } mdl_seqgroup_blob_t;
 
@@ -22,13 +55,19 @@ typedef struct {
     
     studiohdr_t   *header;
     unsigned char *data;
+    size_t         data_size;
      
     studiohdr_t   *texture_header;
     unsigned char *texture_data;
+    size_t         texture_size;
+
+    bool           mapped;    // data/texture_data were mapped, not malloc'd
 
     mdl_seqgroup_blob_t *seqgroups;
     int                  num_seqgroups;
 
+    struct mdl_model_cache_s *cache;    // compiled cache mapping, NULL when off (mdl_cache.h)
+
 } mdl_model_t;
 
 // Core loading functions
@@ -38,8 +77,35 @@ mdl_result_t validate_mdl_version( int version );
 
 mdl_result_t read_mdl_file( const char *filename, unsigned char **file_data, size_t *file_size );
 
+// Zero-copy alternative to read_mdl_file (returns MDL_ERROR_NOT_IMPLEMENTED where mmap is unavailable)
+mdl_result_t map_mdl_file( const char *filename, unsigned char **file_data, size_t *file_size );
+
+void unmap_mdl_file( unsigned char *file_data, size_t file_size );
+
+// Selects how create_mdl_model()/load_sequence_groups() read files from disk
+void mdl_set_load_mode( mdl_load_mode_t mode );
+
+mdl_load_mode_t mdl_get_load_mode( void );
+
+// When enabled, load_sequence_groups() only resolves NN.mdl paths; the files are read on first use
+void mdl_set_lazy_seqgroups( bool lazy );
+
+bool mdl_get_lazy_seqgroups( void );
+
+// Progress messages on stdout while loading and freeing (default on); errors are always printed
+void mdl_set_load_messages( bool enabled );
+
+mdl_seqgroup_status_t mdl_seqgroup_status( const mdl_seqgroup_blob_t *group );
+
+// Queues a deferred group on the loader thread (no-op unless UNLOADED) and returns its current status.
+// A full queue leaves it UNLOADED; it is only read in place if the loader thread cannot start
+mdl_seqgroup_status_t mdl_seqgroup_request( mdl_seqgroup_blob_t *group );
+
 mdl_result_t parse_mdl_h( const unsigned char *file_data, studiohdr_t **h );
 
+// True for a standalone model in `dir`, false for other files and for T.mdl/NN.mdl companions of one
+bool mdl_is_main_model_file( const char *dir, const char *name );
+
 mdl_result_t load_model_with_textures(
     const char     *model_path,
     studiohdr_t   **main_h,
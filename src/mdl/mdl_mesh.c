@@ -0,0 +1,475 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Triangle command decoding into renderable mesh topology
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "mdl_mesh.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int mdl_count_tricmd_corners( const unsigned char *data, const mstudiomesh_t *mesh )
+{
+    if ( !data || !mesh )
+    {
+        return 0;
+    }
+
+    const short *ptricmds = ( const short * ) ( data + mesh->triindex );
+    int          corners  = 0;
+    int          i;
+
+    while ( ( i = *( ptricmds++ ) ) )
+    {
+        if ( i < 0 )
+        {
+            i = -i;
+        }
+
+        if ( i > 2 )
+        {
+            corners += ( i - 2 ) * 3;
+        }
+
+        ptricmds += i * 4;
+    }
+
+    return corners;
+}
+
+static void read_tricmd_vertex( const short *cmd, int norm_base, mdl_tricmd_vertex_t *v )
+{
+    v->vertex = cmd[0];
+    v->seam   = ( cmd[1] & 0x8000 ) != 0;
+    v->normal = ( short ) ( ( cmd[1] & 0x7FFF ) + norm_base );
+    v->s      = cmd[2];
+    v->t      = cmd[3];
+}
+
+static bool tricmd_vertex_valid( const mdl_tricmd_vertex_t *v, int vertex_count, int normal_count )
+{
+    return v->vertex >= 0 && v->vertex < vertex_count && v->normal >= 0 && v->normal < normal_count;
+}
+
+int mdl_decode_tricmds(
+    const unsigned char *data,
+    const mstudiomesh_t *mesh,
+    int                  vertex_count,
+    int                  normal_count,
+    mdl_tricmd_vertex_t *out,
+    int                  max_out )
+{
+    if ( !data || !mesh || !out )
+    {
+        return 0;
+    }
+
+    const short *ptricmds  = ( const short * ) ( data + mesh->triindex );
+    const int    norm_base = mesh->normindex;
+    int          written   = 0;
+    int          i;
+
+    while ( ( i = *( ptricmds++ ) ) )
+    {
+        bool fan = ( i < 0 );
+        if ( fan )
+        {
+            i = -i;
+        }
+
+        mdl_tricmd_vertex_t v0, v1, v2;
+
+        if ( i < 3 )
+        {
+            ptricmds += i * 4;
+            continue;
+        }
+
+        read_tricmd_vertex( ptricmds, norm_base, &v0 );
+        ptricmds += 4;
+        read_tricmd_vertex( ptricmds, norm_base, &v1 );
+        ptricmds += 4;
+
+        for ( int j = 2; j < i; ++j )
+        {
+            read_tricmd_vertex( ptricmds, norm_base, &v2 );
+            ptricmds += 4;
+
+            if ( written + 3 <= max_out && tricmd_vertex_valid( &v0, vertex_count, normal_count )
+                 && tricmd_vertex_valid( &v1, vertex_count, normal_count )
+                 && tricmd_vertex_valid( &v2, vertex_count, normal_count ) )
+            {
+                // Odd strip triangles are flipped to keep a consistent winding
+                bool flip = !fan && ( ( j - 2 ) % 2 != 0 );
+
+                out[written++] = flip ? v1 : v0;
+                out[written++] = flip ? v0 : v1;
+                out[written++] = v2;
+            }
+
+            // roll forward (fans keep their hub vertex)
+            if ( !fan )
+            {
+                v0 = v1;
+            }
+            v1 = v2;
+        }
+    }
+
+    return written;
+}
+
+static uint32_t hash_tricmd_vertex( const mdl_tricmd_vertex_t *v )
+{
+    uint32_t h = 2166136261u;
+    h          = ( h ^ ( uint16_t ) v->vertex ) * 16777619u;
+    h          = ( h ^ ( uint16_t ) v->normal ) * 16777619u;
+    h          = ( h ^ ( uint16_t ) v->s ) * 16777619u;
+    h          = ( h ^ ( uint16_t ) v->t ) * 16777619u;
+    h          = ( h ^ ( uint32_t ) v->seam ) * 16777619u;
+    return h;
+}
+
+static bool tricmd_vertex_equal( const mdl_tricmd_vertex_t *a, const mdl_tricmd_vertex_t *b )
+{
+    return a->vertex == b->vertex && a->normal == b->normal && a->s == b->s && a->t == b->t && a->seam == b->seam;
+}
+
+int mdl_weld_tricmd_vertices(
+    const mdl_tricmd_vertex_t *corners,
+    int                        count,
+    mdl_tricmd_vertex_t       *unique_out,
+    unsigned int              *indices_out )
+{
+    if ( !corners || !unique_out || !indices_out || count <= 0 )
+    {
+        return 0;
+    }
+
+    // Open addressing, at most half full; slots hold unique index + 1 (0 = empty)
+    size_t capacity = 16;
+    while ( capacity < ( size_t ) count * 2 )
+    {
+        capacity <<= 1;
+    }
+
+    unsigned int *slots = calloc( capacity, sizeof( unsigned int ) );
+    if ( !slots )
+    {
+        return -1;
+    }
+
+    int num_unique = 0;
+
+    for ( int i = 0; i < count; ++i )
+    {
+        size_t slot = hash_tricmd_vertex( &corners[i] ) & ( capacity - 1 );
+
+        while ( slots[slot] && !tricmd_vertex_equal( &unique_out[slots[slot] - 1], &corners[i] ) )
+        {
+            slot = ( slot + 1 ) & ( capacity - 1 );
+        }
+
+        if ( !slots[slot] )
+        {
+            unique_out[num_unique] = corners[i];
+            slots[slot]            = ( unsigned int ) ++num_unique;
+        }
+
+        indices_out[i] = slots[slot] - 1;
+    }
+
+    free( slots );
+    return num_unique;
+}
+
+void mdl_analyze_vertex_cache(
+    const unsigned int *indices,
+    int                 index_count,
+    int                 vertex_count,
+    int                 cache_size,
+    mdl_vcache_stats_t *out )
+{
+    if ( !out )
+    {
+        return;
+    }
+
+    memset( out, 0, sizeof( *out ) );
+
+    if ( !indices || index_count < 3 || vertex_count <= 0 || cache_size <= 0 )
+    {
+        return;
+    }
+
+    // A vertex is in the FIFO if fewer than cache_size misses happened since it was pushed
+    int *pushed_at = malloc( ( size_t ) vertex_count * sizeof( int ) );
+    if ( !pushed_at )
+    {
+        return;
+    }
+
+    for ( int v = 0; v < vertex_count; ++v )
+    {
+        pushed_at[v] = -1;
+    }
+
+    for ( int i = 0; i < index_count; ++i )
+    {
+        unsigned int v = indices[i];
+
+        if ( pushed_at[v] < 0 )
+        {
+            out->vertices++;
+        }
+
+        if ( pushed_at[v] < 0 || out->misses - pushed_at[v] >= cache_size )
+        {
+            pushed_at[v] = out->misses++;
+        }
+    }
+
+    free( pushed_at );
+
+    out->triangles = index_count / 3;
+    out->acmr      = ( float ) out->misses / ( float ) out->triangles;
+    out->atvr      = out->vertices ? ( float ) out->misses / ( float ) out->vertices : 0.0f;
+}
+
+/*
+ * Tipsify picks the next fanning vertex among the vertices just emitted,
+ * preferring the one whose remaining triangles still fit in the cache and
+ * that entered it the longest ago. When none qualifies it backtracks through
+ * recently touched vertices, then falls back to a linear scan.
+ */
+static int tipsify_next_vertex(
+    const int *candidates,
+    int        num_candidates,
+    const int *live,
+    const int *cache_time,
+    int        time,
+    int        cache_size,
+    int       *dead_end,
+    int       *dead_end_top,
+    int       *cursor,
+    int        vertex_count )
+{
+    int best          = -1;
+    int best_priority = -1;
+
+    for ( int c = 0; c < num_candidates; ++c )
+    {
+        int v = candidates[c];
+
+        if ( live[v] > 0 )
+        {
+            int priority = 0;
+            if ( time - cache_time[v] + 2 * live[v] <= cache_size )
+            {
+                priority = time - cache_time[v];
+            }
+
+            if ( priority > best_priority )
+            {
+                best          = v;
+                best_priority = priority;
+            }
+        }
+    }
+
+    if ( best >= 0 )
+    {
+        return best;
+    }
+
+    while ( *dead_end_top > 0 )
+    {
+        int v = dead_end[--( *dead_end_top )];
+        if ( live[v] > 0 )
+        {
+            return v;
+        }
+    }
+
+    while ( *cursor < vertex_count )
+    {
+        if ( live[*cursor] > 0 )
+        {
+            return *cursor;
+        }
+        ( *cursor )++;
+    }
+
+    return -1;
+}
+
+bool mdl_optimize_vertex_cache( unsigned int *indices, int index_count, int vertex_count, int cache_size )
+{
+    if ( !indices || index_count < 6 || vertex_count <= 0 || cache_size <= 0 )
+    {
+        return true;
+    }
+
+    const int triangle_count = index_count / 3;
+
+    // Vertex -> triangle adjacency in CSR form; live[] doubles as the valence
+    int          *live       = calloc( ( size_t ) vertex_count, sizeof( int ) );
+    int          *offsets    = malloc( ( ( size_t ) vertex_count + 1 ) * sizeof( int ) );
+    int          *fill       = malloc( ( size_t ) vertex_count * sizeof( int ) );
+    int          *adjacency  = malloc( ( size_t ) triangle_count * 3 * sizeof( int ) );
+    int          *cache_time = calloc( ( size_t ) vertex_count, sizeof( int ) );
+    int          *dead_end   = malloc( ( size_t ) triangle_count * 3 * sizeof( int ) );
+    int          *candidates = malloc( ( size_t ) triangle_count * 3 * sizeof( int ) );
+    bool         *emitted    = calloc( ( size_t ) triangle_count, sizeof( bool ) );
+    unsigned int *output     = malloc( ( size_t ) triangle_count * 3 * sizeof( unsigned int ) );
+
+    bool ok = live && offsets && fill && adjacency && cache_time && dead_end && candidates && emitted && output;
+
+    if ( ok )
+    {
+        for ( int i = 0; i < triangle_count * 3; ++i )
+        {
+            live[indices[i]]++;
+        }
+
+        offsets[0] = 0;
+        for ( int v = 0; v < vertex_count; ++v )
+        {
+            offsets[v + 1] = offsets[v] + live[v];
+            fill[v]        = offsets[v];
+        }
+
+        for ( int i = 0; i < triangle_count * 3; ++i )
+        {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+
+        int written      = 0;
+        int time         = cache_size + 1;
+        int dead_end_top = 0;
+        int cursor       = 0;
+        int fanning      = 0;
+
+        while ( fanning >= 0 )
+        {
+            int num_candidates = 0;
+
+            for ( int a = offsets[fanning]; a < offsets[fanning + 1]; ++a )
+            {
+                int t = adjacency[a];
+                if ( emitted[t] )
+                {
+                    continue;
+                }
+
+                for ( int k = 0; k < 3; ++k )
+                {
+                    int v = ( int ) indices[t * 3 + k];
+
+                    output[written++]            = ( unsigned int ) v;
+                    dead_end[dead_end_top++]     = v;
+                    candidates[num_candidates++] = v;
+                    live[v]--;
+
+                    if ( time - cache_time[v] > cache_size )
+                    {
+                        cache_time[v] = time++;
+                    }
+                }
+
+                emitted[t] = true;
+            }
+
+            fanning = tipsify_next_vertex(
+                candidates,
+                num_candidates,
+                live,
+                cache_time,
+                time,
+                cache_size,
+                dead_end,
+                &dead_end_top,
+                &cursor,
+                vertex_count );
+        }
+
+        memcpy( indices, output, ( size_t ) written * sizeof( unsigned int ) );
+    }
+
+    free( live );
+    free( offsets );
+    free( fill );
+    free( adjacency );
+    free( cache_time );
+    free( dead_end );
+    free( candidates );
+    free( emitted );
+    free( output );
+
+    return ok;
+}
+
+bool mdl_optimize_vertex_fetch( mdl_tricmd_vertex_t *vertices, int vertex_count, unsigned int *indices, int index_count )
+{
+    if ( !vertices || !indices || vertex_count <= 0 || index_count <= 0 )
+    {
+        return true;
+    }
+
+    unsigned int        *remap    = malloc( ( size_t ) vertex_count * sizeof( unsigned int ) );
+    mdl_tricmd_vertex_t *original = malloc( ( size_t ) vertex_count * sizeof( mdl_tricmd_vertex_t ) );
+
+    if ( !remap || !original )
+    {
+        free( remap );
+        free( original );
+        return false;
+    }
+
+    memcpy( original, vertices, ( size_t ) vertex_count * sizeof( mdl_tricmd_vertex_t ) );
+    memset( remap, 0xFF, ( size_t ) vertex_count * sizeof( unsigned int ) );
+
+    unsigned int next = 0;
+
+    for ( int i = 0; i < index_count; ++i )
+    {
+        unsigned int v = indices[i];
+        if ( remap[v] == UINT32_MAX )
+        {
+            vertices[next] = original[v];
+            remap[v]       = next++;
+        }
+        indices[i] = remap[v];
+    }
+
+    for ( int v = 0; v < vertex_count; ++v )
+    {
+        if ( remap[v] == UINT32_MAX )
+        {
+            vertices[next++] = original[v];
+        }
+    }
+
+    free( remap );
+    free( original );
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef MDL_MESH_H
+#define MDL_MESH_H
+
+#include "../studio.h"
+
+#include <stdbool.h>
+
+/*
+ * One triangle corner decoded from a mesh's triangle commands. Indices are
+ * into the owning mstudiomodel_t's vertex/normal arrays (the mesh's
+ * normindex is already added). The on-seam bit is kept as a flag since
+ * applying it needs the texture width.
+ */
+typedef struct {
+    short vertex;
+    short normal;
+    short s;
+    short t;
+    bool  seam;
+} mdl_tricmd_vertex_t;
+
+// Number of triangle corners the mesh's fans/strips expand to (upper bound for mdl_decode_tricmds)
+int mdl_count_tricmd_corners( const unsigned char *data, const mstudiomesh_t *mesh );
+
+/*
+ * Expands the mesh's fans and strips into a triangle list, three corners per
+ * triangle, strip winding alternated. Triangles with out-of-range indices
+ * are dropped. Returns the number of corners written (at most max_out).
+ */
+int mdl_decode_tricmds(
+    const unsigned char *data,
+    const mstudiomesh_t *mesh,
+    int                  vertex_count,
+    int                  normal_count,
+    mdl_tricmd_vertex_t *out,
+    int                  max_out );
+
+/*
+ * Welds identical corners (same vertex, normal, s, t and seam flag) into a
+ * unique vertex list kept in first-use order. indices_out[i] receives the
+ * position of corners[i] in unique_out. Both outputs need room for `count`
+ * entries. Returns the number of unique vertices, or -1 if out of memory.
+ */
+int mdl_weld_tricmd_vertices(
+    const mdl_tricmd_vertex_t *corners,
+    int                        count,
+    mdl_tricmd_vertex_t       *unique_out,
+    unsigned int              *indices_out );
+
+/*
+ * Post-transform vertex cache. The optimizer and the ACMR/ATVR report both
+ * model a FIFO of this many entries, which is roughly what pre-unified
+ * hardware had and a safe lower bound for anything newer.
+ */
+#define MDL_VCACHE_SIZE 16
+
+typedef struct {
+    int   triangles;
+    int   vertices;    // distinct vertices referenced by the index list
+    int   misses;      // vertex shader invocations with a cold FIFO
+    float acmr;        // misses per triangle (0.5 ideal on closed meshes, 3.0 worst)
+    float atvr;        // misses per vertex (1.0 ideal)
+} mdl_vcache_stats_t;
+
+// Simulates a FIFO vertex cache of cache_size entries over a triangle list
+void mdl_analyze_vertex_cache(
+    const unsigned int *indices,
+    int                 index_count,
+    int                 vertex_count,
+    int                 cache_size,
+    mdl_vcache_stats_t *out );
+
+/*
+ * Reorders the triangles of an indexed triangle list in place for
+ * post-transform cache reuse (Tipsify, Sander et al. 2007). Every index must
+ * be below vertex_count. Returns false and leaves the list untouched if out
+ * of memory.
+ */
+bool mdl_optimize_vertex_cache( unsigned int *indices, int index_count, int vertex_count, int cache_size );
+
+/*
+ * Renumbers vertices in the order the index list first references them and
+ * permutes the vertex array to match, so vertex fetch walks memory forward.
+ * Vertices the list never references move to the end. Returns false and
+ * leaves both arrays untouched if out of memory.
+ */
+bool mdl_optimize_vertex_fetch( mdl_tricmd_vertex_t *vertices, int vertex_count, unsigned int *indices, int index_count );
+
+#endif    // MDL_MESH_H
@@ -0,0 +1,294 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Palette-to-RGBA lookup table expansion with runtime ISA dispatch
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "mdl_palette.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define MDL_PAL_X86 1
+#include <immintrin.h>
+#else
+#define MDL_PAL_X86 0
+#endif
+
+typedef void ( *pal_expand_fn )( const unsigned char *indices, size_t count, const uint32_t *lut, unsigned char *dst );
+
+typedef struct {
+    pal_expand_fn rgba;
+    pal_expand_fn rgb;
+} pal_kernels_t;
+
+void mdl_palette_build_lut(
+    const unsigned char *palette_rgb, int palette_size, bool keep_transparent_rgb, mdl_palette_lut_t *lut )
+{
+    for ( int i = 0; i < 256; ++i )
+    {
+        const unsigned char *rgb   = palette_rgb + ( i < palette_size ? i : 0 ) * 3;
+        unsigned char        px[4] = { rgb[0], rgb[1], rgb[2], 255 };
+
+        if ( i == 255 )
+        {
+            if ( !keep_transparent_rgb )
+                px[0] = px[1] = px[2] = 0;
+            px[3] = 0;
+        }
+
+        // Byte order, not host order, so the table can be copied out as pixels
+        memcpy( &lut->rgba[i], px, 4 );
+    }
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Scalar
+// ───────────────────────────────────────────────────────────────────────────
+
+static void expand_rgba_scalar( const unsigned char *indices, size_t count, const uint32_t *lut, unsigned char *dst )
+{
+    for ( size_t i = 0; i < count; ++i )
+    {
+        memcpy( dst + i * 4, &lut[indices[i]], 4 );
+    }
+}
+
+static void expand_rgb_scalar( const unsigned char *indices, size_t count, const uint32_t *lut, unsigned char *dst )
+{
+    for ( size_t i = 0; i < count; ++i )
+    {
+        memcpy( dst + i * 3, &lut[indices[i]], 3 );
+    }
+}
+
+static const pal_kernels_t g_kernels_scalar = { expand_rgba_scalar, expand_rgb_scalar };
+
+#if MDL_PAL_X86
+
+// ───────────────────────────────────────────────────────────────────────────
+//   SSSE3 (4 pixels per vector, shuffles pack RGB)
+// ───────────────────────────────────────────────────────────────────────────
+
+__attribute__( ( target( "ssse3" ) ) ) static inline __m128i lookup4(
+    const unsigned char *indices, const uint32_t *lut )
+{
+    return _mm_setr_epi32(
+        ( int ) lut[indices[0]], ( int ) lut[indices[1]], ( int ) lut[indices[2]], ( int ) lut[indices[3]] );
+}
+
+// 16 RGBA pixels in p0..p3 -> 48 bytes of RGB
+__attribute__( ( target( "ssse3" ) ) ) static inline void store_rgb16(
+    __m128i p0, __m128i p1, __m128i p2, __m128i p3, unsigned char *dst )
+{
+    const __m128i drop_alpha = _mm_setr_epi8( 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+
+    p0 = _mm_shuffle_epi8( p0, drop_alpha );
+    p1 = _mm_shuffle_epi8( p1, drop_alpha );
+    p2 = _mm_shuffle_epi8( p2, drop_alpha );
+    p3 = _mm_shuffle_epi8( p3, drop_alpha );
+
+    _mm_storeu_si128( ( __m128i * ) ( dst + 0 ), _mm_or_si128( p0, _mm_slli_si128( p1, 12 ) ) );
+    _mm_storeu_si128( ( __m128i * ) ( dst + 16 ), _mm_or_si128( _mm_srli_si128( p1, 4 ), _mm_slli_si128( p2, 8 ) ) );
+    _mm_storeu_si128( ( __m128i * ) ( dst + 32 ), _mm_or_si128( _mm_srli_si128( p2, 8 ), _mm_slli_si128( p3, 4 ) ) );
+}
+
+__attribute__( ( target( "ssse3" ) ) ) static void expand_rgba_ssse3(
+    const unsigned char *indices, size_t count, const uint32_t *lut, unsigned char *dst )
+{
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        _mm_storeu_si128( ( __m128i * ) ( dst + i * 4 ), lookup4( indices + i, lut ) );
+    }
+    expand_rgba_scalar( indices + i, count - i, lut, dst + i * 4 );
+}
+
+__attribute__( ( target( "ssse3" ) ) ) static void expand_rgb_ssse3(
+    const unsigned char *indices, size_t count, const uint32_t *lut, unsigned char *dst )
+{
+    size_t i = 0;
+    for ( ; i + 16 <= count; i += 16 )
+    {
+        store_rgb16(
+            lookup4( indices + i, lut ),
+            lookup4( indices + i + 4, lut ),
+            lookup4( indices + i + 8, lut ),
+            lookup4( indices + i + 12, lut ),
+            dst + i * 3 );
+    }
+    expand_rgb_scalar( indices + i, count - i, lut, dst + i * 3 );
+}
+
+static const pal_kernels_t g_kernels_ssse3 = { expand_rgba_ssse3, expand_rgb_ssse3 };
+
+// ───────────────────────────────────────────────────────────────────────────
+//   AVX2 (8 pixels per gather)
+// ───────────────────────────────────────────────────────────────────────────
+
+__attribute__( ( target( "avx2" ) ) ) static inline __m256i gather8( const unsigned char *indices, const uint32_t *lut )
+{
+    const __m256i index = _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i * ) indices ) );
+    return _mm256_i32gather_epi32( ( const int * ) lut, index, 4 );
+}
+
+__attribute__( ( target( "avx2" ) ) ) static void expand_rgba_avx2(
+    const unsigned char *indices, size_t count, const uint32_t *lut, unsigned char *dst )
+{
+    size_t i = 0;
+    for ( ; i + 16 <= count; i += 16 )
+    {
+        const __m256i a = gather8( indices + i, lut );
+        const __m256i b = gather8( indices + i + 8, lut );
+        _mm256_storeu_si256( ( __m256i * ) ( dst + i * 4 ), a );
+        _mm256_storeu_si256( ( __m256i * ) ( dst + i * 4 + 32 ), b );
+    }
+    expand_rgba_scalar( indices + i, count - i, lut, dst + i * 4 );
+}
+
+__attribute__( ( target( "avx2" ) ) ) static void expand_rgb_avx2(
+    const unsigned char *indices, size_t count, const uint32_t *lut, unsigned char *dst )
+{
+    size_t i = 0;
+    for ( ; i + 16 <= count; i += 16 )
+    {
+        const __m256i a = gather8( indices + i, lut );
+        const __m256i b = gather8( indices + i + 8, lut );
+        store_rgb16(
+            _mm256_castsi256_si128( a ),
+            _mm256_extracti128_si256( a, 1 ),
+            _mm256_castsi256_si128( b ),
+            _mm256_extracti128_si256( b, 1 ),
+            dst + i * 3 );
+    }
+    expand_rgb_scalar( indices + i, count - i, lut, dst + i * 3 );
+}
+
+static const pal_kernels_t g_kernels_avx2 = { expand_rgba_avx2, expand_rgb_avx2 };
+
+#endif    // MDL_PAL_X86
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Dispatch
+// ───────────────────────────────────────────────────────────────────────────
+
+static const pal_kernels_t *g_kernels = NULL;
+static mdl_pal_isa_t        g_isa     = MDL_PAL_ISA_SCALAR;
+
+static bool isa_supported( mdl_pal_isa_t isa )
+{
+    switch ( isa )
+    {
+        case MDL_PAL_ISA_SCALAR:
+            return true;
+#if MDL_PAL_X86
+        case MDL_PAL_ISA_SSSE3:
+            __builtin_cpu_init( );
+            return __builtin_cpu_supports( "ssse3" );
+        case MDL_PAL_ISA_AVX2:
+            __builtin_cpu_init( );
+            return __builtin_cpu_supports( "avx2" );
+#endif
+        default:
+            return false;
+    }
+}
+
+static pthread_once_t g_kernels_once = PTHREAD_ONCE_INIT;
+
+static void pick_default_kernels( void )
+{
+    if ( !g_kernels )
+    {
+        mdl_pal_set_isa( MDL_PAL_ISA_AUTO );
+    }
+}
+
+bool mdl_pal_set_isa( mdl_pal_isa_t isa )
+{
+    if ( isa == MDL_PAL_ISA_AUTO )
+    {
+        isa = isa_supported( MDL_PAL_ISA_AVX2 )    ? MDL_PAL_ISA_AVX2
+              : isa_supported( MDL_PAL_ISA_SSSE3 ) ? MDL_PAL_ISA_SSSE3
+                                                   : MDL_PAL_ISA_SCALAR;
+    }
+
+    if ( !isa_supported( isa ) )
+    {
+        return false;
+    }
+
+    switch ( isa )
+    {
+#if MDL_PAL_X86
+        case MDL_PAL_ISA_AVX2:
+            g_kernels = &g_kernels_avx2;
+            break;
+        case MDL_PAL_ISA_SSSE3:
+            g_kernels = &g_kernels_ssse3;
+            break;
+#endif
+        default:
+            g_kernels = &g_kernels_scalar;
+            break;
+    }
+
+    g_isa = isa;
+    return true;
+}
+
+mdl_pal_isa_t mdl_pal_get_isa( void )
+{
+    pthread_once( &g_kernels_once, pick_default_kernels );
+    return g_isa;
+}
+
+const char *mdl_pal_isa_name( mdl_pal_isa_t isa )
+{
+    switch ( isa )
+    {
+        case MDL_PAL_ISA_AUTO:
+            return "auto";
+        case MDL_PAL_ISA_SCALAR:
+            return "scalar";
+        case MDL_PAL_ISA_SSSE3:
+            return "ssse3";
+        case MDL_PAL_ISA_AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Expansion
+// ───────────────────────────────────────────────────────────────────────────
+
+void mdl_palette_expand_rgba( const unsigned char *indices, size_t count, const mdl_palette_lut_t *lut, unsigned char *dst )
+{
+    // Texture decode jobs may get here first from several threads at once
+    pthread_once( &g_kernels_once, pick_default_kernels );
+    g_kernels->rgba( indices, count, lut->rgba, dst );
+}
+
+void mdl_palette_expand_rgb( const unsigned char *indices, size_t count, const mdl_palette_lut_t *lut, unsigned char *dst )
+{
+    pthread_once( &g_kernels_once, pick_default_kernels );
+    g_kernels->rgb( indices, count, lut->rgba, dst );
+}
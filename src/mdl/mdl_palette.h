@@ -0,0 +1,51 @@
+#ifndef MDL_PALETTE_H
+#define MDL_PALETTE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 8-bit palette expansion shared by texture upload, the model cache and the
+ * texture dumps. The palette is first turned into a 256-entry table of RGBA
+ * pixels (transparency for index 255 baked in), so expanding an image is a
+ * plain table lookup per pixel with no branches. The lookup runs 8 pixels at
+ * a time with AVX2 gathers, 4 with SSSE3 (shuffles pack RGB output), or one
+ * at a time; the kernel is picked at runtime, and all of them write the same
+ * bytes.
+ */
+typedef enum {
+    MDL_PAL_ISA_AUTO = 0,
+    MDL_PAL_ISA_SCALAR,
+    MDL_PAL_ISA_SSSE3,
+    MDL_PAL_ISA_AVX2,
+} mdl_pal_isa_t;
+
+// Entries are R, G, B, A bytes in memory order
+typedef struct {
+    uint32_t rgba[256];
+} mdl_palette_lut_t;
+
+// Forces a kernel (AUTO = best available). Returns false if the CPU lacks it.
+bool mdl_pal_set_isa( mdl_pal_isa_t isa );
+
+mdl_pal_isa_t mdl_pal_get_isa( void );
+
+const char *mdl_pal_isa_name( mdl_pal_isa_t isa );
+
+/*
+ * Builds the table for a palette of `palette_size` RGB triplets (1-256).
+ * Indices past the palette use entry 0. Index 255 is GoldSrc's transparent
+ * colour: alpha 0, and black unless `keep_transparent_rgb` keeps the
+ * palette's colour under it.
+ */
+void mdl_palette_build_lut(
+    const unsigned char *palette_rgb, int palette_size, bool keep_transparent_rgb, mdl_palette_lut_t *lut );
+
+// dst[i * 4 .. i * 4 + 3] = lut[indices[i]] for `count` pixels
+void mdl_palette_expand_rgba( const unsigned char *indices, size_t count, const mdl_palette_lut_t *lut, unsigned char *dst );
+
+// Same without the alpha byte, 3 bytes per pixel
+void mdl_palette_expand_rgb( const unsigned char *indices, size_t count, const mdl_palette_lut_t *lut, unsigned char *dst );
+
+#endif    // MDL_PALETTE_H
@@ -24,7 +24,9 @@
 #include "mdl_report.h"
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef _WIN32
 #include <fcntl.h>
@@ -176,7 +178,7 @@ void print_sequence_group_info(FILE *output, const mdl_seqgroup_blob_t *groups,
             fprintf(output, "MAIN (embedded in model file)\n");
             fprintf(output, "      Size: %zu bytes\n", groups[i].size);
         }
-        else if (groups[i].sequence_header)
+        else if (mdl_seqgroup_status(&groups[i]) == MDL_SEQGROUP_READY && groups[i].sequence_header)
         {
             fprintf(output, "'%s'\n", groups[i].sequence_header->name);
             fprintf(output, "      Magic:   0x%08X (IDSQ)\n", groups[i].sequence_header->id);
@@ -190,6 +192,13 @@ void print_sequence_group_info(FILE *output, const mdl_seqgroup_blob_t *groups,
             fprintf(output, "      Size:   %zu bytes\n", groups[i].size);
             fprintf(output, "      Status: ⚠ LOADED (no validation)\n");
         }
+        else if (mdl_seqgroup_status(&groups[i]) != MDL_SEQGROUP_MISSING &&
+                 mdl_seqgroup_status(&groups[i]) != MDL_SEQGROUP_FAILED)
+        {
+            fprintf(output, "'%s'\n", groups[i].name);
+            fprintf(output, "      Path:   %s\n", groups[i].path);
+            fprintf(output, "      Status: … DEFERRED (loaded on first use)\n");
+        }
         else
         {
             fprintf(output, "'%s'\n", groups[i].name);
@@ -241,3 +250,104 @@ void print_extended_model_dump(
     printf("═══════════════════════════════════════════════════════════════\n\n");
 }
 
+
+void mdl_summarize_model( const mdl_model_t *model, mdl_model_summary_t *summary )
+{
+    memset( summary, 0, sizeof( *summary ) );
+    if ( !model || !model->header )
+        return;
+
+    const studiohdr_t   *header = model->header;
+    const unsigned char *data   = model->data;
+
+    summary->bones     = header->numbones;
+    summary->sequences = header->numseq;
+    summary->seqgroups = model->num_seqgroups > 1 ? model->num_seqgroups - 1 : 0;
+    summary->bodyparts = header->numbodyparts;
+    summary->textures  = model->texture_header ? model->texture_header->numtextures : header->numtextures;
+    summary->bytes     = model->data_size + model->texture_size;
+
+    for ( int i = 1; i < model->num_seqgroups; ++i )
+    {
+        if ( mdl_seqgroup_status( &model->seqgroups[i] ) == MDL_SEQGROUP_READY )
+            summary->bytes += model->seqgroups[i].size;
+    }
+
+    // Offsets come straight from the file, so every table is range-checked
+    // before it is walked; a broken model just reports what is readable
+    const mstudiobodyparts_t *bodyparts = ( const mstudiobodyparts_t * ) add_off( data, ( size_t ) header->bodypartindex );
+    if ( header->numbodyparts <= 0
+         || !in_range( data, model->data_size, bodyparts, ( size_t ) header->numbodyparts * sizeof( *bodyparts ) ) )
+        return;
+
+    for ( int bp = 0; bp < header->numbodyparts; ++bp )
+    {
+        const mstudiomodel_t *models = ( const mstudiomodel_t * ) add_off( data, ( size_t ) bodyparts[bp].modelindex );
+        if ( bodyparts[bp].nummodels <= 0
+             || !in_range( data, model->data_size, models, ( size_t ) bodyparts[bp].nummodels * sizeof( *models ) ) )
+            continue;
+
+        for ( int m = 0; m < bodyparts[bp].nummodels; ++m )
+        {
+            summary->submodels++;
+            summary->verts += models[m].numverts;
+
+            const mstudiomesh_t *meshes = ( const mstudiomesh_t * ) add_off( data, ( size_t ) models[m].meshindex );
+            if ( models[m].nummesh <= 0
+                 || !in_range( data, model->data_size, meshes, ( size_t ) models[m].nummesh * sizeof( *meshes ) ) )
+                continue;
+
+            for ( int k = 0; k < models[m].nummesh; ++k )
+            {
+                summary->tris += meshes[k].numtris;
+            }
+        }
+    }
+}
+
+// Paths are the only free-form strings in a record
+static void print_json_string( FILE *output, const char *s )
+{
+    fputc( '"', output );
+    for ( const unsigned char *c = ( const unsigned char * ) s; *c; ++c )
+    {
+        if ( *c == '"' || *c == '\\' )
+            fprintf( output, "\\%c", *c );
+        else if ( *c < 0x20 )
+            fprintf( output, "\\u%04x", *c );
+        else
+            fputc( *c, output );
+    }
+    fputc( '"', output );
+}
+
+void print_model_summary_json( FILE *output, const char *model_path, const mdl_model_summary_t *summary, double load_ms )
+{
+    if ( !output ) output = stdout;
+
+    fprintf( output, "{\"path\":" );
+    print_json_string( output, model_path );
+    fprintf(
+        output,
+        ",\"ok\":true,\"bones\":%d,\"sequences\":%d,\"seqgroups\":%d,\"bodyparts\":%d,\"submodels\":%d"
+        ",\"tris\":%d,\"verts\":%d,\"textures\":%d,\"bytes\":%zu,\"load_ms\":%.3f}\n",
+        summary->bones,
+        summary->sequences,
+        summary->seqgroups,
+        summary->bodyparts,
+        summary->submodels,
+        summary->tris,
+        summary->verts,
+        summary->textures,
+        summary->bytes,
+        load_ms );
+}
+
+void print_model_error_json( FILE *output, const char *model_path, mdl_result_t result, double load_ms )
+{
+    if ( !output ) output = stdout;
+
+    fprintf( output, "{\"path\":" );
+    print_json_string( output, model_path );
+    fprintf( output, ",\"ok\":false,\"error\":\"%s\",\"load_ms\":%.3f}\n", mdl_result_name( result ), load_ms );
+}
@@ -31,6 +31,31 @@ void print_studio_header_file(FILE *output, const char *title, const studiohdr_t
 
 void print_sequence_group_info(FILE *output, const mdl_seqgroup_blob_t *groups, int num_groups);
 
+/*
+ * One-line model summary for batch audits. Triangles and vertices are summed
+ * over every submodel of every bodypart, not only the default bodygroup;
+ * bytes counts the main file, the T.mdl companion and loaded sequence groups.
+ */
+typedef struct {
+    int    bones;
+    int    sequences;
+    int    seqgroups;    // external NN.mdl groups, the main file not included
+    int    bodyparts;
+    int    submodels;
+    int    tris;
+    int    verts;
+    int    textures;
+    size_t bytes;
+} mdl_model_summary_t;
+
+void mdl_summarize_model( const mdl_model_t *model, mdl_model_summary_t *summary );
+
+// Writes the summary as a single JSON object followed by a newline
+void print_model_summary_json( FILE *output, const char *model_path, const mdl_model_summary_t *summary, double load_ms );
+
+// Same record shape for a model that failed to load
+void print_model_error_json( FILE *output, const char *model_path, mdl_result_t result, double load_ms );
+
 void print_extended_model_dump(
     FILE *output,
     const char *model_path,
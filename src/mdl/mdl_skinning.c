@@ -0,0 +1,618 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Bone-bucketed SoA skinning kernels with runtime ISA dispatch
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "mdl_skinning.h"
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define MDL_SKIN_X86 1
+#include <immintrin.h>
+#else
+#define MDL_SKIN_X86 0
+#endif
+
+// Buckets are padded to this many entries so every kernel runs whole vectors
+#define SKIN_BUCKET_ALIGN 8
+#define SKIN_PLAN_SLOTS   64
+// Kernel output is staged per thread on the stack, this many slots at a time
+#define SKIN_STAGE_SLOTS  256
+
+/*
+ * One submodel's vertices (or normals) regrouped by bone. Padding entries
+ * have order[i] == -1 and zero components.
+ *
+ * Plans are read-only once built, so several threads (skinning jobs) can
+ * share one. Lookup and eviction are locked, and a plan in use is pinned so
+ * it cannot be rebuilt for another submodel underneath its users.
+ */
+typedef struct {
+    const void          *source;      // vertex or normal array in the model data
+    const unsigned char *bone_map;    // vertinfo or norminfo array
+    int                  count;
+    int                  numbones;
+    int                  padded;
+
+    int   *order;    // bucket slot -> original index
+    float *x, *y, *z;
+    int    bucket[MAXSTUDIOBONES + 1];    // bone b owns slots [bucket[b], bucket[b + 1])
+
+    unsigned int last_used;
+    int          users;
+} skin_plan_t;
+
+static skin_plan_t     g_plans[SKIN_PLAN_SLOTS];
+static unsigned int    g_plan_tick = 0;
+static pthread_mutex_t g_plan_mtx  = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Kernels take one bone's rows (row-major 3x4) and n slots, n a multiple of
+ * SKIN_BUCKET_ALIGN. All variants evaluate ((x*r0 + y*r1) + z*r2) + r3 in
+ * that order so they agree bit for bit.
+ */
+typedef void ( *skin_kernel_fn )(
+    const float *rows, const float *x, const float *y, const float *z, float *ox, float *oy, float *oz, int n );
+
+typedef struct {
+    skin_kernel_fn points;
+    skin_kernel_fn normals;
+} skin_kernels_t;
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Scalar
+// ───────────────────────────────────────────────────────────────────────────
+
+static void skin_points_scalar(
+    const float *r, const float *x, const float *y, const float *z, float *ox, float *oy, float *oz, int n )
+{
+    for ( int i = 0; i < n; ++i )
+    {
+        ox[i] = x[i] * r[0] + y[i] * r[1] + z[i] * r[2] + r[3];
+        oy[i] = x[i] * r[4] + y[i] * r[5] + z[i] * r[6] + r[7];
+        oz[i] = x[i] * r[8] + y[i] * r[9] + z[i] * r[10] + r[11];
+    }
+}
+
+static void skin_normals_scalar(
+    const float *r, const float *x, const float *y, const float *z, float *ox, float *oy, float *oz, int n )
+{
+    for ( int i = 0; i < n; ++i )
+    {
+        float nx = x[i] * r[0] + y[i] * r[1] + z[i] * r[2];
+        float ny = x[i] * r[4] + y[i] * r[5] + z[i] * r[6];
+        float nz = x[i] * r[8] + y[i] * r[9] + z[i] * r[10];
+
+        // Same degenerate rule as glm_vec3_normalize
+        float len = sqrtf( nx * nx + ny * ny + nz * nz );
+        if ( len < FLT_EPSILON )
+        {
+            ox[i] = oy[i] = oz[i] = 0.0f;
+            continue;
+        }
+
+        float inv = 1.0f / len;
+        ox[i]     = nx * inv;
+        oy[i]     = ny * inv;
+        oz[i]     = nz * inv;
+    }
+}
+
+static const skin_kernels_t g_kernels_scalar = { skin_points_scalar, skin_normals_scalar };
+
+#if MDL_SKIN_X86
+
+// ───────────────────────────────────────────────────────────────────────────
+//   SSE4.1 (4 wide)
+// ───────────────────────────────────────────────────────────────────────────
+
+__attribute__( ( target( "sse4.1" ) ) ) static void skin_points_sse41(
+    const float *r, const float *x, const float *y, const float *z, float *ox, float *oy, float *oz, int n )
+{
+    __m128 m[12];
+    for ( int k = 0; k < 12; ++k )
+    {
+        m[k] = _mm_set1_ps( r[k] );
+    }
+
+    for ( int i = 0; i < n; i += 4 )
+    {
+        __m128 vx = _mm_loadu_ps( x + i );
+        __m128 vy = _mm_loadu_ps( y + i );
+        __m128 vz = _mm_loadu_ps( z + i );
+
+        for ( int row = 0; row < 3; ++row )
+        {
+            __m128 acc = _mm_add_ps( _mm_mul_ps( vx, m[row * 4 + 0] ), _mm_mul_ps( vy, m[row * 4 + 1] ) );
+            acc        = _mm_add_ps( acc, _mm_mul_ps( vz, m[row * 4 + 2] ) );
+            acc        = _mm_add_ps( acc, m[row * 4 + 3] );
+            _mm_storeu_ps( ( row == 0 ? ox : row == 1 ? oy : oz ) + i, acc );
+        }
+    }
+}
+
+__attribute__( ( target( "sse4.1" ) ) ) static void skin_normals_sse41(
+    const float *r, const float *x, const float *y, const float *z, float *ox, float *oy, float *oz, int n )
+{
+    const __m128 eps  = _mm_set1_ps( FLT_EPSILON );
+    const __m128 one  = _mm_set1_ps( 1.0f );
+    const __m128 zero = _mm_setzero_ps( );
+
+    __m128 m[12];
+    for ( int k = 0; k < 12; ++k )
+    {
+        m[k] = _mm_set1_ps( r[k] );
+    }
+
+    for ( int i = 0; i < n; i += 4 )
+    {
+        __m128 vx = _mm_loadu_ps( x + i );
+        __m128 vy = _mm_loadu_ps( y + i );
+        __m128 vz = _mm_loadu_ps( z + i );
+
+        __m128 nx = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vx, m[0] ), _mm_mul_ps( vy, m[1] ) ), _mm_mul_ps( vz, m[2] ) );
+        __m128 ny = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vx, m[4] ), _mm_mul_ps( vy, m[5] ) ), _mm_mul_ps( vz, m[6] ) );
+        __m128 nz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vx, m[8] ), _mm_mul_ps( vy, m[9] ) ), _mm_mul_ps( vz, m[10] ) );
+
+        __m128 dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, nx ), _mm_mul_ps( ny, ny ) ), _mm_mul_ps( nz, nz ) );
+        __m128 len = _mm_sqrt_ps( dot );
+        __m128 inv = _mm_div_ps( one, len );
+
+        // Degenerate normals come out as +0 (not inf/NaN or -0), like the scalar path
+        __m128 tiny = _mm_cmplt_ps( len, eps );
+
+        _mm_storeu_ps( ox + i, _mm_blendv_ps( _mm_mul_ps( nx, inv ), zero, tiny ) );
+        _mm_storeu_ps( oy + i, _mm_blendv_ps( _mm_mul_ps( ny, inv ), zero, tiny ) );
+        _mm_storeu_ps( oz + i, _mm_blendv_ps( _mm_mul_ps( nz, inv ), zero, tiny ) );
+    }
+}
+
+static const skin_kernels_t g_kernels_sse41 = { skin_points_sse41, skin_normals_sse41 };
+
+// ───────────────────────────────────────────────────────────────────────────
+//   AVX2 (8 wide, deliberately no FMA so results match the other kernels)
+// ───────────────────────────────────────────────────────────────────────────
+
+__attribute__( ( target( "avx2" ) ) ) static void skin_points_avx2(
+    const float *r, const float *x, const float *y, const float *z, float *ox, float *oy, float *oz, int n )
+{
+    __m256 m[12];
+    for ( int k = 0; k < 12; ++k )
+    {
+        m[k] = _mm256_set1_ps( r[k] );
+    }
+
+    for ( int i = 0; i < n; i += 8 )
+    {
+        __m256 vx = _mm256_loadu_ps( x + i );
+        __m256 vy = _mm256_loadu_ps( y + i );
+        __m256 vz = _mm256_loadu_ps( z + i );
+
+        for ( int row = 0; row < 3; ++row )
+        {
+            __m256 acc = _mm256_add_ps( _mm256_mul_ps( vx, m[row * 4 + 0] ), _mm256_mul_ps( vy, m[row * 4 + 1] ) );
+            acc        = _mm256_add_ps( acc, _mm256_mul_ps( vz, m[row * 4 + 2] ) );
+            acc        = _mm256_add_ps( acc, m[row * 4 + 3] );
+            _mm256_storeu_ps( ( row == 0 ? ox : row == 1 ? oy : oz ) + i, acc );
+        }
+    }
+}
+
+__attribute__( ( target( "avx2" ) ) ) static void skin_normals_avx2(
+    const float *r, const float *x, const float *y, const float *z, float *ox, float *oy, float *oz, int n )
+{
+    const __m256 eps  = _mm256_set1_ps( FLT_EPSILON );
+    const __m256 one  = _mm256_set1_ps( 1.0f );
+    const __m256 zero = _mm256_setzero_ps( );
+
+    __m256 m[12];
+    for ( int k = 0; k < 12; ++k )
+    {
+        m[k] = _mm256_set1_ps( r[k] );
+    }
+
+    for ( int i = 0; i < n; i += 8 )
+    {
+        __m256 vx = _mm256_loadu_ps( x + i );
+        __m256 vy = _mm256_loadu_ps( y + i );
+        __m256 vz = _mm256_loadu_ps( z + i );
+
+        __m256 nx = _mm256_add_ps(
+            _mm256_add_ps( _mm256_mul_ps( vx, m[0] ), _mm256_mul_ps( vy, m[1] ) ), _mm256_mul_ps( vz, m[2] ) );
+        __m256 ny = _mm256_add_ps(
+            _mm256_add_ps( _mm256_mul_ps( vx, m[4] ), _mm256_mul_ps( vy, m[5] ) ), _mm256_mul_ps( vz, m[6] ) );
+        __m256 nz = _mm256_add_ps(
+            _mm256_add_ps( _mm256_mul_ps( vx, m[8] ), _mm256_mul_ps( vy, m[9] ) ), _mm256_mul_ps( vz, m[10] ) );
+
+        __m256 dot = _mm256_add_ps(
+            _mm256_add_ps( _mm256_mul_ps( nx, nx ), _mm256_mul_ps( ny, ny ) ), _mm256_mul_ps( nz, nz ) );
+        __m256 len = _mm256_sqrt_ps( dot );
+        __m256 inv = _mm256_div_ps( one, len );
+
+        __m256 tiny = _mm256_cmp_ps( len, eps, _CMP_LT_OQ );
+
+        _mm256_storeu_ps( ox + i, _mm256_blendv_ps( _mm256_mul_ps( nx, inv ), zero, tiny ) );
+        _mm256_storeu_ps( oy + i, _mm256_blendv_ps( _mm256_mul_ps( ny, inv ), zero, tiny ) );
+        _mm256_storeu_ps( oz + i, _mm256_blendv_ps( _mm256_mul_ps( nz, inv ), zero, tiny ) );
+    }
+}
+
+static const skin_kernels_t g_kernels_avx2 = { skin_points_avx2, skin_normals_avx2 };
+
+#endif    // MDL_SKIN_X86
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Dispatch
+// ───────────────────────────────────────────────────────────────────────────
+
+static const skin_kernels_t *g_kernels = NULL;
+static mdl_skin_isa_t        g_isa     = MDL_SKIN_ISA_SCALAR;
+
+static bool isa_supported( mdl_skin_isa_t isa )
+{
+    switch ( isa )
+    {
+        case MDL_SKIN_ISA_SCALAR:
+            return true;
+#if MDL_SKIN_X86
+        case MDL_SKIN_ISA_SSE41:
+            __builtin_cpu_init( );
+            return __builtin_cpu_supports( "sse4.1" );
+        case MDL_SKIN_ISA_AVX2:
+            __builtin_cpu_init( );
+            return __builtin_cpu_supports( "avx2" );
+#endif
+        default:
+            return false;
+    }
+}
+
+static pthread_once_t g_kernels_once = PTHREAD_ONCE_INIT;
+
+static void pick_default_kernels( void )
+{
+    if ( !g_kernels )
+    {
+        mdl_skin_set_isa( MDL_SKIN_ISA_AUTO );
+    }
+}
+
+bool mdl_skin_set_isa( mdl_skin_isa_t isa )
+{
+    if ( isa == MDL_SKIN_ISA_AUTO )
+    {
+        isa = isa_supported( MDL_SKIN_ISA_AVX2 )    ? MDL_SKIN_ISA_AVX2
+              : isa_supported( MDL_SKIN_ISA_SSE41 ) ? MDL_SKIN_ISA_SSE41
+                                                    : MDL_SKIN_ISA_SCALAR;
+    }
+
+    if ( !isa_supported( isa ) )
+    {
+        return false;
+    }
+
+    switch ( isa )
+    {
+#if MDL_SKIN_X86
+        case MDL_SKIN_ISA_AVX2:
+            g_kernels = &g_kernels_avx2;
+            break;
+        case MDL_SKIN_ISA_SSE41:
+            g_kernels = &g_kernels_sse41;
+            break;
+#endif
+        default:
+            g_kernels = &g_kernels_scalar;
+            break;
+    }
+
+    g_isa = isa;
+    return true;
+}
+
+mdl_skin_isa_t mdl_skin_get_isa( void )
+{
+    if ( !g_kernels )
+    {
+        mdl_skin_set_isa( MDL_SKIN_ISA_AUTO );
+    }
+    return g_isa;
+}
+
+const char *mdl_skin_isa_name( mdl_skin_isa_t isa )
+{
+    switch ( isa )
+    {
+        case MDL_SKIN_ISA_AUTO:
+            return "auto";
+        case MDL_SKIN_ISA_SCALAR:
+            return "scalar";
+        case MDL_SKIN_ISA_SSE41:
+            return "sse4.1";
+        case MDL_SKIN_ISA_AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Bone buckets
+// ───────────────────────────────────────────────────────────────────────────
+
+static void free_plan( skin_plan_t *plan )
+{
+    free( plan->order );    // single block, see build_plan
+    memset( plan, 0, sizeof( *plan ) );
+}
+
+void mdl_skin_plans_clear( void )
+{
+    pthread_mutex_lock( &g_plan_mtx );
+    for ( int i = 0; i < SKIN_PLAN_SLOTS; ++i )
+    {
+        if ( g_plans[i].users == 0 )
+        {
+            free_plan( &g_plans[i] );
+        }
+        else
+        {
+            // Still skinning: unkey it so nothing finds it again; release_plan() frees it
+            g_plans[i].source   = NULL;
+            g_plans[i].bone_map = NULL;
+        }
+    }
+    pthread_mutex_unlock( &g_plan_mtx );
+}
+
+static bool build_plan(
+    skin_plan_t *plan, const vec3_t *source, const unsigned char *bone_map, int count, int numbones )
+{
+    int sizes[MAXSTUDIOBONES] = { 0 };
+
+    for ( int i = 0; i < count; ++i )
+    {
+        int bone = bone_map[i] < numbones ? bone_map[i] : 0;
+        sizes[bone]++;
+    }
+
+    int padded = 0;
+    for ( int b = 0; b < numbones; ++b )
+    {
+        plan->bucket[b] = padded;
+        padded += ( sizes[b] + SKIN_BUCKET_ALIGN - 1 ) & ~( SKIN_BUCKET_ALIGN - 1 );
+    }
+    plan->bucket[numbones] = padded;
+
+    // order[] first, then the three float streams, all in one allocation
+    size_t bytes = ( size_t ) padded * ( sizeof( int ) + 3 * sizeof( float ) );
+    void  *block = calloc( 1, bytes > 0 ? bytes : 1 );
+    if ( !block )
+    {
+        return false;
+    }
+
+    plan->order = block;
+    plan->x     = ( float * ) ( plan->order + padded );
+    plan->y     = plan->x + padded;
+    plan->z     = plan->y + padded;
+
+    for ( int s = 0; s < padded; ++s )
+    {
+        plan->order[s] = -1;
+    }
+
+    int fill[MAXSTUDIOBONES];
+    memcpy( fill, plan->bucket, sizeof( fill[0] ) * ( size_t ) numbones );
+
+    for ( int i = 0; i < count; ++i )
+    {
+        int bone = bone_map[i] < numbones ? bone_map[i] : 0;
+        int slot = fill[bone]++;
+
+        plan->order[slot] = i;
+        plan->x[slot]     = source[i][0];
+        plan->y[slot]     = source[i][1];
+        plan->z[slot]     = source[i][2];
+    }
+
+    plan->source   = source;
+    plan->bone_map = bone_map;
+    plan->count    = count;
+    plan->numbones = numbones;
+    plan->padded   = padded;
+    return true;
+}
+
+// Finds or builds the plan and pins it; every acquire_plan() needs a release_plan()
+static skin_plan_t *acquire_plan( const vec3_t *source, const unsigned char *bone_map, int count, int numbones )
+{
+    pthread_mutex_lock( &g_plan_mtx );
+
+    skin_plan_t *found  = NULL;
+    skin_plan_t *victim = NULL;
+
+    for ( int i = 0; i < SKIN_PLAN_SLOTS && !found; ++i )
+    {
+        skin_plan_t *plan = &g_plans[i];
+
+        if ( plan->order && plan->source == source && plan->bone_map == bone_map && plan->count == count
+             && plan->numbones == numbones )
+        {
+            found = plan;
+        }
+        else if ( plan->users == 0
+                  && ( !victim || !plan->order || ( victim->order && plan->last_used < victim->last_used ) ) )
+        {
+            victim = plan;
+        }
+    }
+
+    // Each thread pins one plan at a time and there are more slots than job threads
+    if ( !found && victim )
+    {
+        free_plan( victim );
+        if ( build_plan( victim, source, bone_map, count, numbones ) )
+        {
+            found = victim;
+        }
+    }
+
+    if ( found )
+    {
+        found->last_used = ++g_plan_tick;
+        found->users++;
+    }
+
+    pthread_mutex_unlock( &g_plan_mtx );
+    return found;
+}
+
+static void release_plan( skin_plan_t *plan )
+{
+    pthread_mutex_lock( &g_plan_mtx );
+    if ( --plan->users == 0 && !plan->source )
+    {
+        free_plan( plan );    // cleared while in use
+    }
+    pthread_mutex_unlock( &g_plan_mtx );
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Skinning
+// ───────────────────────────────────────────────────────────────────────────
+
+static void skin_stream(
+    const vec3_t        *source,
+    const unsigned char *bone_map,
+    int                  count,
+    int                  numbones,
+    const mat4          *bones,
+    bool                 normals,
+    vec3                *out )
+{
+    if ( count <= 0 )
+    {
+        return;
+    }
+
+    if ( numbones <= 0 )
+    {
+        numbones = 1;
+    }
+    if ( numbones > MAXSTUDIOBONES )
+    {
+        numbones = MAXSTUDIOBONES;
+    }
+
+    // Skinning jobs may get here first from several threads at once
+    pthread_once( &g_kernels_once, pick_default_kernels );
+
+    skin_plan_t *plan = acquire_plan( source, bone_map, count, numbones );
+    if ( !plan )
+    {
+        return;
+    }
+
+    const skin_kernel_fn kernel = normals ? g_kernels->normals : g_kernels->points;
+
+    float ox[SKIN_STAGE_SLOTS], oy[SKIN_STAGE_SLOTS], oz[SKIN_STAGE_SLOTS];
+
+    for ( int b = 0; b < numbones; ++b )
+    {
+        const int first = plan->bucket[b];
+        const int last  = plan->bucket[b + 1];
+        if ( first == last )
+        {
+            continue;
+        }
+
+        // cglm is column-major: row r of the affine part is m[0..3][r]
+        float rows[12];
+        for ( int r = 0; r < 3; ++r )
+        {
+            rows[r * 4 + 0] = bones[b][0][r];
+            rows[r * 4 + 1] = bones[b][1][r];
+            rows[r * 4 + 2] = bones[b][2][r];
+            rows[r * 4 + 3] = bones[b][3][r];
+        }
+
+        // Buckets and stages are both whole multiples of SKIN_BUCKET_ALIGN
+        for ( int start = first; start < last; start += SKIN_STAGE_SLOTS )
+        {
+            const int n = ( last - start < SKIN_STAGE_SLOTS ) ? last - start : SKIN_STAGE_SLOTS;
+
+            kernel( rows, plan->x + start, plan->y + start, plan->z + start, ox, oy, oz, n );
+
+            for ( int k = 0; k < n; ++k )
+            {
+                const int i = plan->order[start + k];
+                if ( i >= 0 )
+                {
+                    out[i][0] = ox[k];
+                    out[i][1] = oy[k];
+                    out[i][2] = oz[k];
+                }
+            }
+        }
+    }
+
+    release_plan( plan );
+}
+
+void mdl_skin_positions(
+    const studiohdr_t *header, const unsigned char *data, const mstudiomodel_t *model, const mat4 *bones, vec3 *out )
+{
+    if ( !header || !data || !model || !bones || !out )
+    {
+        return;
+    }
+
+    skin_stream(
+        ( const vec3_t * ) ( data + model->vertindex ),
+        data + model->vertinfoindex,
+        model->numverts,
+        header->numbones,
+        bones,
+        false,
+        out );
+}
+
+void mdl_skin_normals(
+    const studiohdr_t *header, const unsigned char *data, const mstudiomodel_t *model, const mat4 *bones, vec3 *out )
+{
+    if ( !header || !data || !model || !bones || !out )
+    {
+        return;
+    }
+
+    skin_stream(
+        ( const vec3_t * ) ( data + model->normindex ),
+        data + model->norminfoindex,
+        model->numnorms,
+        header->numbones,
+        bones,
+        true,
+        out );
+}
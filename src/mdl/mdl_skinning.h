@@ -0,0 +1,45 @@
+#ifndef MDL_SKINNING_H
+#define MDL_SKINNING_H
+
+#include "../studio.h"
+
+#include <cglm/cglm.h>
+#include <stdbool.h>
+
+/*
+ * Rigid (one bone per vertex) skinning kernels. Vertices are bucketed by bone
+ * once per model into structure-of-arrays copies, then each bucket is pushed
+ * through its bone's 3x4 affine matrix 4 or 8 at a time. The instruction set
+ * is picked at runtime from what the CPU supports; every variant produces the
+ * same results as the scalar one (no FMA, exact sqrt/div for normals).
+ */
+typedef enum {
+    MDL_SKIN_ISA_AUTO = 0,
+    MDL_SKIN_ISA_SCALAR,
+    MDL_SKIN_ISA_SSE41,
+    MDL_SKIN_ISA_AVX2,
+} mdl_skin_isa_t;
+
+// Forces a kernel (AUTO = best available). Returns false if the CPU lacks it.
+bool mdl_skin_set_isa( mdl_skin_isa_t isa );
+
+mdl_skin_isa_t mdl_skin_get_isa( void );
+
+const char *mdl_skin_isa_name( mdl_skin_isa_t isa );
+
+// out[i] = bones[vertinfo[i]] * vertices[i] for every vertex of the submodel
+void mdl_skin_positions(
+    const studiohdr_t *header, const unsigned char *data, const mstudiomodel_t *model, const mat4 *bones, vec3 *out );
+
+// out[i] = normalize( rot( bones[norminfo[i]] ) * normals[i] ) for every normal of the submodel
+void mdl_skin_normals(
+    const studiohdr_t *header, const unsigned char *data, const mstudiomodel_t *model, const mat4 *bones, vec3 *out );
+
+/*
+ * The bone buckets are cached per submodel and point into the model data.
+ * Call once the renderer is done with a model, before freeing its data; a
+ * plan still in use is only dropped from the lookup and freed on release.
+ */
+void mdl_skin_plans_clear( void );
+
+#endif    // MDL_SKINNING_H
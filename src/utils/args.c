@@ -24,7 +24,9 @@
 
 #include "../version.h"
 
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // Styling constants
@@ -107,7 +109,8 @@ void print_banner( void )
 void print_usage( const char *program_name )
 {
     printf( "USAGE:\n" );
-    printf( "  %s <model.mdl> [OPTIONS]\n\n", program_name );
+    printf( "  %s <model.mdl> [OPTIONS]\n", program_name );
+    printf( "  %s --batch <dir> [--threads <N>] [--mmap]\n\n", program_name );
 
     printf( "OPTIONS:\n" );
     printf( "  --dump, -d\n" );
@@ -119,6 +122,54 @@ void print_usage( const char *program_name )
     printf( "  --dump-only\n" );
     printf( "      Dump structure and exit (no viewer window)\n\n" );
 
+    printf( "  --batch <dir>\n" );
+    printf( "      Load every model under <dir> (recursively, skipping T.mdl and NN.mdl files) in parallel\n" );
+    printf( "      and print one JSON line per model to stdout: bones, sequences, tris, verts, textures,\n" );
+    printf( "      bytes and load time. No viewer window is opened\n\n" );
+
+    printf( "  --mmap\n" );
+    printf( "      Memory-map model files read-only instead of copying them (zero-copy load)\n\n" );
+
+    printf( "  --cache <dir>\n" );
+    printf( "      Keep compiled models (welded meshes, RGBA skins) in <dir> and map them on later loads;\n" );
+    printf( "      stale entries are rebuilt automatically\n\n" );
+
+    printf( "  --anim-cache <MB>\n" );
+    printf( "      Budget for pre-decoded animation tracks (default 64, 0 disables)\n\n" );
+
+    printf( "  --no-index\n" );
+    printf( "      Draw fully expanded triangles instead of the deduplicated indexed mesh\n\n" );
+
+    printf( "  --gpu-skinning\n" );
+    printf( "      Skin vertices in the vertex shader; only bone matrices are uploaded per frame\n\n" );
+
+    printf( "  --palette-textures\n" );
+    printf( "      Keep skins as 8-bit indices plus a 256-colour palette on the GPU (a quarter of the\n" );
+    printf( "      RGBA memory and upload); the fragment shader does the palette lookup\n\n" );
+
+    printf( "  --atlas\n" );
+    printf( "      Pack all of a model's skins into one texture so each model (or crowd variant) draws\n" );
+    printf( "      in a single call; ignored with --palette-textures\n\n" );
+
+    printf( "  --no-vcache-opt\n" );
+    printf( "      Keep the triangle order from the model file instead of reordering for the vertex cache\n\n" );
+
+    printf( "  --skin <N>\n" );
+    printf( "      Start with skin family N (0 = default); K cycles through the families while viewing\n\n" );
+
+    printf( "  --instances <N>\n" );
+    printf( "      Draw N copies of the model with their own sequence, frame, bodygroup and skin (instanced)\n\n" );
+
+    printf( "  --grid\n" );
+    printf( "      Lay the --instances crowd out on a grid instead of at the origin\n\n" );
+
+    printf( "  --threads <N>\n" );
+    printf( "      Threads for loading, texture decode, animation and skinning, main thread included\n" );
+    printf( "      (default 0 = one per core, 1 = run everything on the main thread)\n\n" );
+
+    printf( "  --continuous\n" );
+    printf( "      Redraw every frame even when nothing changed (default: sleep until input or the next animation frame)\n\n" );
+
     printf( "  --quiet, -q\n" );
     printf( "      Quiet mode - only show errors\n\n" );
 
@@ -131,6 +182,14 @@ void print_usage( const char *program_name )
     printf( "  --log-file <path>\n" );
     printf( "      Write logs to specified file\n\n" );
 
+    printf( "  --log-binary <path>\n" );
+    printf( "      Write the log file as compact binary records instead of text lines;\n" );
+    printf( "      read it back with log_decode [--json] <path>\n\n" );
+
+    printf( "  --log-sync\n" );
+    printf( "      Write log file lines on the logging thread instead of a background writer\n" );
+    printf( "      thread (slower; nothing is lost if the viewer crashes)\n\n" );
+
     printf( "  --version, -v\n" );
     printf( "      Show detailed version information\n\n" );
 
@@ -159,6 +218,9 @@ void print_usage( const char *program_name )
     printf( "  # Dump to file with trace logging\n" );
     printf( "  %s scientist.mdl --dump-only --trace --log-file debug.log > report.txt\n\n", program_name );
 
+    printf( "  # Audit a whole model tree on 8 threads\n" );
+    printf( "  %s --batch ../models --threads 8 > audit.jsonl\n\n", program_name );
+
     printf( "  # Show version information\n" );
     printf( "  %s --version\n\n", program_name );
 }
@@ -170,14 +232,30 @@ void print_usage( const char *program_name )
 int parse_args( int argc, const char *argv[], app_args_t *args )
 {
     // Initialize with defaults
-    args->model_path   = NULL;
-    args->dump_level   = DUMP_NONE;
-    args->dump_only    = false;
-    args->quiet        = false;
-    args->log_level    = LOG_LEVEL_NORMAL;    // Default to normal
-    args->log_file     = NULL;
-    args->show_help    = false;
-    args->show_version = false;
+    args->model_path    = NULL;
+    args->batch_dir     = NULL;
+    args->dump_level    = DUMP_NONE;
+    args->dump_only     = false;
+    args->use_mmap      = false;
+    args->cache_dir     = NULL;
+    args->anim_cache_mb = 64;
+    args->no_index      = false;
+    args->no_vcache_opt = false;
+    args->gpu_skinning  = false;
+    args->palette_textures = false;
+    args->atlas_textures = false;
+    args->continuous    = false;
+    args->skin          = 0;
+    args->instances     = 0;
+    args->grid          = false;
+    args->threads       = 0;
+    args->quiet         = false;
+    args->log_level     = LOG_LEVEL_NORMAL;    // Default to normal
+    args->log_file      = NULL;
+    args->log_binary    = NULL;
+    args->log_sync      = false;
+    args->show_help     = false;
+    args->show_version  = false;
 
     // No arguments = show help
     if ( argc < 2 )
@@ -216,6 +294,90 @@ int parse_args( int argc, const char *argv[], app_args_t *args )
         {
             args->dump_only = true;
         }
+        else if ( strcmp( arg, "--mmap" ) == 0 )
+        {
+            args->use_mmap = true;
+        }
+        else if ( strcmp( arg, "--no-index" ) == 0 )
+        {
+            args->no_index = true;
+        }
+        else if ( strcmp( arg, "--gpu-skinning" ) == 0 )
+        {
+            args->gpu_skinning = true;
+        }
+        else if ( strcmp( arg, "--palette-textures" ) == 0 )
+        {
+            args->palette_textures = true;
+        }
+        else if ( strcmp( arg, "--atlas" ) == 0 )
+        {
+            args->atlas_textures = true;
+        }
+        else if ( strcmp( arg, "--no-vcache-opt" ) == 0 )
+        {
+            args->no_vcache_opt = true;
+        }
+        else if ( strcmp( arg, "--continuous" ) == 0 )
+        {
+            args->continuous = true;
+        }
+        else if ( strcmp( arg, "--grid" ) == 0 )
+        {
+            args->grid = true;
+        }
+        else if ( strcmp( arg, "--skin" ) == 0 )
+        {
+            char *end  = NULL;
+            long  skin = ( i + 1 < argc ) ? strtol( argv[i + 1], &end, 10 ) : -1;
+
+            if ( i + 1 >= argc || *end != '\0' || skin < 0 || skin > INT_MAX )
+            {
+                fprintf( stderr, "ERROR: --skin requires a skin family number (0 = the default skin)\n" );
+                return -1;
+            }
+            args->skin = ( int ) skin;
+            i++;
+        }
+        else if ( strcmp( arg, "--instances" ) == 0 )
+        {
+            char *end   = NULL;
+            long  count = ( i + 1 < argc ) ? strtol( argv[i + 1], &end, 10 ) : -1;
+
+            if ( i + 1 >= argc || *end != '\0' || count < 1 || count > 10000 )
+            {
+                fprintf( stderr, "ERROR: --instances requires a count between 1 and 10000\n" );
+                return -1;
+            }
+            args->instances = ( int ) count;
+            i++;
+        }
+        else if ( strcmp( arg, "--threads" ) == 0 )
+        {
+            char *end     = NULL;
+            long  threads = ( i + 1 < argc ) ? strtol( argv[i + 1], &end, 10 ) : -1;
+
+            if ( i + 1 >= argc || *end != '\0' || threads < 0 || threads > 32 )
+            {
+                fprintf( stderr, "ERROR: --threads requires a count between 0 and 32 (0 = one per core)\n" );
+                return -1;
+            }
+            args->threads = ( int ) threads;
+            i++;
+        }
+        else if ( strcmp( arg, "--anim-cache" ) == 0 )
+        {
+            char *end = NULL;
+            long  mb  = ( i + 1 < argc ) ? strtol( argv[i + 1], &end, 10 ) : -1;
+
+            if ( i + 1 >= argc || *end != '\0' || mb < 0 || mb > 65536 )
+            {
+                fprintf( stderr, "ERROR: --anim-cache requires a size in MB (0 disables the cache)\n" );
+                return -1;
+            }
+            args->anim_cache_mb = ( int ) mb;
+            i++;
+        }
         // Logging flags
         else if ( strcmp( arg, "--quiet" ) == 0 || strcmp( arg, "-q" ) == 0 )
         {
@@ -230,6 +392,24 @@ int parse_args( int argc, const char *argv[], app_args_t *args )
         {
             args->log_level = LOG_LEVEL_TRACE;
         }
+        else if ( strcmp( arg, "--cache" ) == 0 )
+        {
+            if ( i + 1 >= argc )
+            {
+                fprintf( stderr, "ERROR: --cache requires a directory argument\n" );
+                return -1;
+            }
+            args->cache_dir = argv[++i];
+        }
+        else if ( strcmp( arg, "--batch" ) == 0 )
+        {
+            if ( i + 1 >= argc )
+            {
+                fprintf( stderr, "ERROR: --batch requires a directory argument\n" );
+                return -1;
+            }
+            args->batch_dir = argv[++i];
+        }
         else if ( strcmp( arg, "--log-file" ) == 0 )
         {
             if ( i + 1 >= argc )
@@ -239,6 +419,19 @@ int parse_args( int argc, const char *argv[], app_args_t *args )
             }
             args->log_file = argv[++i];
         }
+        else if ( strcmp( arg, "--log-binary" ) == 0 )
+        {
+            if ( i + 1 >= argc )
+            {
+                fprintf( stderr, "ERROR: --log-binary requires a path argument\n" );
+                return -1;
+            }
+            args->log_binary = argv[++i];
+        }
+        else if ( strcmp( arg, "--log-sync" ) == 0 )
+        {
+            args->log_sync = true;
+        }
         // Model path (doesn't start with -)
         else if ( arg[0] != '-' )
         {
@@ -262,8 +455,14 @@ int parse_args( int argc, const char *argv[], app_args_t *args )
         }
     }
 
+    if (args->batch_dir && args->model_path) {
+        fprintf(stderr, "ERROR: --batch analyses a directory and cannot be combined with a model file\n");
+        fprintf(stderr, "       Use --help for usage information\n");
+        return -1;
+    }
+
     // Validate: must have model path if not showing help or version
-    if (!args->show_help && !args->show_version && args->model_path == NULL) {
+    if (!args->show_help && !args->show_version && args->model_path == NULL && args->batch_dir == NULL) {
         fprintf(stderr, "ERROR: No model file specified\n");
         fprintf(stderr, "       Use --help for usage information\n");
         return -1;
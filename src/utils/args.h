@@ -49,11 +49,27 @@ typedef enum {
  */
 typedef struct {
     const char  *model_path;    // Path to .mdl file
+    const char  *batch_dir;     // Analyse every model under this directory (JSON lines, no viewer)
     dump_level_t dump_level;    // Dump detail level
     bool         dump_only;     // Exit after dump (no viewer)
+    bool         use_mmap;      // Map model files instead of reading them into heap buffers
+    const char  *cache_dir;     // Compiled model cache directory (NULL = no cache)
+    int          anim_cache_mb; // Decoded animation cache budget in MB (0 = decode RLE every frame)
+    bool         no_index;      // Draw expanded triangles (glDrawArrays) instead of the welded indexed mesh
+    bool         no_vcache_opt; // Skip the vertex cache / vertex fetch reorder of indexed meshes
+    bool         gpu_skinning;  // Skin in skinned.vert from a bone UBO instead of on the CPU
+    bool         palette_textures; // Upload skins as 8-bit indices + palette, looked up in the shader
+    bool         atlas_textures; // Pack all skins into one atlas so a model draws in one call
+    bool         continuous;    // Redraw every loop iteration instead of only when something changed
+    int          skin;          // Skin family to start with (K cycles through them)
+    int          instances;     // Instanced crowd size (0 = draw the model once)
+    bool         grid;          // Spread the crowd on a grid instead of stacking it at the origin
+    int          threads;       // Job system threads including the main thread (0 = one per core, 1 = no workers)
     bool         quiet;         // Suppress all non-error output (deprecated, use log_level)
     log_detail_t log_level;     // Logging verbosity
     const char  *log_file;      // Optional log file path
+    const char  *log_binary;    // Optional binary log file path (replaces log_file)
+    bool         log_sync;      // Write the log file on the logging thread instead of the background writer
     bool         show_help;     // Show usage
     bool         show_version;  // Show version information
 } app_args_t;
@@ -0,0 +1,567 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Work-stealing job system
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "job_system.h"
+
+#include "logger.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Per-thread deque capacity; a push into a full deque runs the job in place
+#define JOB_DEQUE_SIZE  1024
+#define JOB_STATS_SLOTS 64
+
+/*
+ * One thread's jobs. The owner pushes and pops at `bottom`, thieves take
+ * from `top`. The jobs are coarse (a texture, a submodel, a run of crowd
+ * members), so a mutex per deque is cheap enough and keeps this simple.
+ */
+typedef struct {
+    pthread_mutex_t mtx;
+    job_t          *slots[JOB_DEQUE_SIZE];
+    unsigned int    top;
+    unsigned int    bottom;
+} job_deque_t;
+
+typedef struct job_stats_s {
+    const char          *name;
+    atomic_uint_fast64_t count;
+    atomic_uint_fast64_t total_ns;
+    atomic_uint_fast64_t max_ns;
+} job_stats_t;
+
+static struct {
+    bool        started;
+    int         num_threads;    // deques, the main thread's included
+    int         num_workers;    // threads actually started
+    pthread_t   threads[JOB_SYSTEM_MAX_THREADS];
+    job_deque_t deques[JOB_SYSTEM_MAX_THREADS];
+
+    atomic_int  queued;    // jobs sitting in any deque
+    atomic_bool stop;
+    atomic_uint next_foreign;
+    atomic_uint_fast64_t steals;
+
+    pthread_mutex_t sleep_mtx;
+    pthread_cond_t  sleep_cond;
+    int             sleepers;
+
+    pthread_mutex_t stats_mtx;
+    job_stats_t     stats[JOB_STATS_SLOTS];
+    atomic_int      num_stats;
+} J = { .num_threads = 1, .sleep_mtx = PTHREAD_MUTEX_INITIALIZER, .sleep_cond = PTHREAD_COND_INITIALIZER,
+        .stats_mtx = PTHREAD_MUTEX_INITIALIZER };
+
+// Deque index of the calling thread, -1 outside the pool
+static _Thread_local int t_worker = -1;
+
+static uint64_t now_ns( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( uint64_t ) ts.tv_sec * 1000000000u + ( uint64_t ) ts.tv_nsec;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Timing
+// ───────────────────────────────────────────────────────────────────────────
+
+/*
+ * Slots are only ever appended, so the common case - a name that was seen
+ * before, passed as the same literal - is found without taking the lock.
+ * Once the table is full every new name shares the last slot.
+ */
+static job_stats_t *stats_for( const char *name )
+{
+    if ( !name )
+    {
+        name = "job";
+    }
+
+    int count = atomic_load_explicit( &J.num_stats, memory_order_acquire );
+    for ( int i = 0; i < count; ++i )
+    {
+        if ( J.stats[i].name == name )
+        {
+            return &J.stats[i];
+        }
+    }
+
+    pthread_mutex_lock( &J.stats_mtx );
+
+    job_stats_t *slot = NULL;
+    count             = atomic_load_explicit( &J.num_stats, memory_order_relaxed );
+
+    for ( int i = 0; i < count && !slot; ++i )
+    {
+        if ( J.stats[i].name == name || strcmp( J.stats[i].name, name ) == 0 )
+        {
+            slot = &J.stats[i];
+        }
+    }
+
+    if ( !slot && count < JOB_STATS_SLOTS - 1 )
+    {
+        slot       = &J.stats[count];
+        slot->name = name;
+        atomic_store_explicit( &J.num_stats, count + 1, memory_order_release );
+    }
+    else if ( !slot )
+    {
+        slot       = &J.stats[JOB_STATS_SLOTS - 1];
+        slot->name = "(other)";
+        atomic_store_explicit( &J.num_stats, JOB_STATS_SLOTS, memory_order_release );
+    }
+
+    pthread_mutex_unlock( &J.stats_mtx );
+    return slot;
+}
+
+static void stats_add( job_stats_t *stats, uint64_t ns )
+{
+    atomic_fetch_add_explicit( &stats->count, 1, memory_order_relaxed );
+    atomic_fetch_add_explicit( &stats->total_ns, ns, memory_order_relaxed );
+
+    uint64_t max = atomic_load_explicit( &stats->max_ns, memory_order_relaxed );
+    while ( ns > max
+            && !atomic_compare_exchange_weak_explicit( &stats->max_ns, &max, ns, memory_order_relaxed, memory_order_relaxed ) )
+    {
+    }
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Deques
+// ───────────────────────────────────────────────────────────────────────────
+
+static void run_job( job_t *job );
+
+static void wake_one( void )
+{
+    pthread_mutex_lock( &J.sleep_mtx );
+    if ( J.sleepers > 0 )
+    {
+        pthread_cond_signal( &J.sleep_cond );
+    }
+    pthread_mutex_unlock( &J.sleep_mtx );
+}
+
+static void push_job( job_t *job )
+{
+    if ( !J.started )
+    {
+        run_job( job );
+        return;
+    }
+
+    // Threads outside the pool (e.g. the sequence group loader) spread their jobs round-robin
+    int index = t_worker;
+    if ( index < 0 )
+    {
+        index = ( int ) ( atomic_fetch_add_explicit( &J.next_foreign, 1, memory_order_relaxed ) % ( unsigned ) J.num_threads );
+    }
+
+    job_deque_t *deque = &J.deques[index];
+
+    pthread_mutex_lock( &deque->mtx );
+    if ( deque->bottom - deque->top >= JOB_DEQUE_SIZE )
+    {
+        pthread_mutex_unlock( &deque->mtx );
+        run_job( job );
+        return;
+    }
+    deque->slots[deque->bottom % JOB_DEQUE_SIZE] = job;
+    deque->bottom++;
+    pthread_mutex_unlock( &deque->mtx );
+
+    atomic_fetch_add_explicit( &J.queued, 1, memory_order_release );
+    wake_one( );
+}
+
+static job_t *pop_bottom( job_deque_t *deque )
+{
+    job_t *job = NULL;
+
+    pthread_mutex_lock( &deque->mtx );
+    if ( deque->bottom != deque->top )
+    {
+        deque->bottom--;
+        job = deque->slots[deque->bottom % JOB_DEQUE_SIZE];
+    }
+    pthread_mutex_unlock( &deque->mtx );
+
+    return job;
+}
+
+static job_t *steal_top( job_deque_t *deque )
+{
+    job_t *job = NULL;
+
+    pthread_mutex_lock( &deque->mtx );
+    if ( deque->bottom != deque->top )
+    {
+        job = deque->slots[deque->top % JOB_DEQUE_SIZE];
+        deque->top++;
+    }
+    pthread_mutex_unlock( &deque->mtx );
+
+    return job;
+}
+
+// Own deque first (newest job), then the oldest job of the next busy thread
+static job_t *find_job( int self )
+{
+    if ( !J.started || atomic_load_explicit( &J.queued, memory_order_acquire ) <= 0 )
+    {
+        return NULL;
+    }
+
+    job_t *job = ( self >= 0 ) ? pop_bottom( &J.deques[self] ) : NULL;
+
+    for ( int i = 1; !job && i <= J.num_threads; ++i )
+    {
+        int victim = ( self + i + J.num_threads ) % J.num_threads;
+        if ( victim != self )
+        {
+            job = steal_top( &J.deques[victim] );
+            if ( job )
+            {
+                atomic_fetch_add_explicit( &J.steals, 1, memory_order_relaxed );
+            }
+        }
+    }
+
+    if ( job )
+    {
+        atomic_fetch_sub_explicit( &J.queued, 1, memory_order_relaxed );
+    }
+    return job;
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Jobs
+// ───────────────────────────────────────────────────────────────────────────
+
+static void run_job( job_t *job )
+{
+    uint64_t t0 = now_ns( );
+    job->fn( job->arg );
+    stats_add( job->stats, now_ns( ) - t0 );
+
+    job_t *dependents[JOB_MAX_DEPENDENTS];
+    int    num_dependents = job->num_dependents;
+    memcpy( dependents, job->dependents, sizeof( dependents[0] ) * ( size_t ) num_dependents );
+
+    // Last touch: the owner may release the job as soon as it sees this. Done
+    // before the dependents are released, so waiting on the last job of a
+    // graph also covers everything it depends on.
+    atomic_store_explicit( &job->done, true, memory_order_release );
+
+    for ( int i = 0; i < num_dependents; ++i )
+    {
+        if ( atomic_fetch_sub_explicit( &dependents[i]->pending, 1, memory_order_acq_rel ) == 1 )
+        {
+            push_job( dependents[i] );
+        }
+    }
+}
+
+static void init_job( job_t *job, job_stats_t *stats, job_fn fn, void *arg )
+{
+    job->fn             = fn;
+    job->arg            = arg;
+    job->stats          = stats;
+    job->num_dependents = 0;
+    atomic_init( &job->pending, 1 );
+    atomic_init( &job->done, false );
+}
+
+void job_init( job_t *job, const char *name, job_fn fn, void *arg )
+{
+    init_job( job, stats_for( name ), fn, arg );
+}
+
+bool job_add_dependency( job_t *job, job_t *prerequisite )
+{
+    if ( prerequisite->num_dependents >= JOB_MAX_DEPENDENTS )
+    {
+        return false;
+    }
+
+    prerequisite->dependents[prerequisite->num_dependents++] = job;
+    atomic_fetch_add_explicit( &job->pending, 1, memory_order_relaxed );
+    return true;
+}
+
+void job_submit( job_t *job )
+{
+    if ( atomic_fetch_sub_explicit( &job->pending, 1, memory_order_acq_rel ) == 1 )
+    {
+        push_job( job );
+    }
+}
+
+void job_wait( job_t *job )
+{
+    while ( !atomic_load_explicit( &job->done, memory_order_acquire ) )
+    {
+        job_t *other = find_job( t_worker );
+        if ( other )
+        {
+            run_job( other );
+        }
+        else
+        {
+            sched_yield( );
+        }
+    }
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Parallel for
+// ───────────────────────────────────────────────────────────────────────────
+
+typedef struct {
+    job_t        job;
+    job_range_fn fn;
+    void        *arg;
+    int          begin;
+    int          end;
+} range_job_t;
+
+static void run_range( void *arg )
+{
+    range_job_t *range = arg;
+    range->fn( range->arg, range->begin, range->end );
+}
+
+void job_parallel_for( const char *name, int count, int grain, job_range_fn fn, void *arg )
+{
+    if ( count <= 0 || !fn )
+    {
+        return;
+    }
+    if ( grain < 1 )
+    {
+        grain = 1;
+    }
+
+    // A few chunks per thread so stealing can even out uneven items
+    int chunks     = ( count + grain - 1 ) / grain;
+    int max_chunks = J.started ? J.num_threads * 4 : 1;
+    if ( max_chunks > JOB_PARALLEL_FOR_CHUNKS )
+    {
+        max_chunks = JOB_PARALLEL_FOR_CHUNKS;
+    }
+    if ( chunks > max_chunks )
+    {
+        chunks = max_chunks;
+    }
+
+    const int    size  = ( count + chunks - 1 ) / chunks;
+    job_stats_t *stats = stats_for( name );
+
+    range_job_t ranges[JOB_PARALLEL_FOR_CHUNKS];
+    int         used = 0;
+
+    for ( int begin = 0; begin < count; begin += size )
+    {
+        range_job_t *range = &ranges[used++];
+        range->fn          = fn;
+        range->arg         = arg;
+        range->begin       = begin;
+        range->end         = ( begin + size < count ) ? begin + size : count;
+
+        init_job( &range->job, stats, run_range, range );
+    }
+
+    for ( int c = 1; c < used; ++c )
+    {
+        job_submit( &ranges[c].job );
+    }
+
+    job_submit( &ranges[0].job );
+
+    for ( int c = 0; c < used; ++c )
+    {
+        job_wait( &ranges[c].job );
+    }
+}
+
+// ───────────────────────────────────────────────────────────────────────────
+//   Pool
+// ───────────────────────────────────────────────────────────────────────────
+
+static void *worker_main( void *arg )
+{
+    t_worker = ( int ) ( intptr_t ) arg;
+
+    for ( ;; )
+    {
+        job_t *job = find_job( t_worker );
+        if ( job )
+        {
+            run_job( job );
+            continue;
+        }
+
+        pthread_mutex_lock( &J.sleep_mtx );
+        while ( atomic_load_explicit( &J.queued, memory_order_acquire ) <= 0
+                && !atomic_load_explicit( &J.stop, memory_order_relaxed ) )
+        {
+            J.sleepers++;
+            pthread_cond_wait( &J.sleep_cond, &J.sleep_mtx );
+            J.sleepers--;
+        }
+        pthread_mutex_unlock( &J.sleep_mtx );
+
+        if ( atomic_load_explicit( &J.stop, memory_order_relaxed )
+             && atomic_load_explicit( &J.queued, memory_order_acquire ) <= 0 )
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+void job_system_init( int threads )
+{
+    if ( J.started )
+    {
+        return;
+    }
+
+    if ( threads <= 0 )
+    {
+#ifdef _SC_NPROCESSORS_ONLN
+        long cores = sysconf( _SC_NPROCESSORS_ONLN );
+        threads    = cores > 0 ? ( int ) cores : 1;
+#else
+        threads = 1;
+#endif
+    }
+    if ( threads > JOB_SYSTEM_MAX_THREADS )
+    {
+        threads = JOB_SYSTEM_MAX_THREADS;
+    }
+
+    t_worker      = 0;
+    J.num_threads = threads;
+    J.num_workers = 0;
+    atomic_store( &J.stop, false );
+    atomic_store( &J.queued, 0 );
+
+    for ( int i = 0; i < threads; ++i )
+    {
+        pthread_mutex_init( &J.deques[i].mtx, NULL );
+        J.deques[i].top    = 0;
+        J.deques[i].bottom = 0;
+    }
+
+    // Set before any worker exists; a deque whose thread failed to start is simply stolen from
+    J.started = threads > 1;
+
+    for ( int i = 1; i < threads; ++i )
+    {
+        if ( pthread_create( &J.threads[J.num_workers + 1], NULL, worker_main, ( void * ) ( intptr_t ) i ) != 0 )
+        {
+            LOG_WARNF( "jobs", "Could only start %d of %d job threads", J.num_workers + 1, threads );
+            break;
+        }
+        J.num_workers++;
+    }
+
+    if ( J.num_workers == 0 )
+    {
+        J.started     = false;
+        J.num_threads = 1;
+    }
+
+    LOG_INFOF( "jobs", "Job system: %d thread%s", J.num_workers + 1, J.num_workers == 0 ? "" : "s" );
+}
+
+int job_system_threads( void )
+{
+    return J.num_workers + 1;
+}
+
+void job_system_shutdown( void )
+{
+    if ( J.started )
+    {
+        pthread_mutex_lock( &J.sleep_mtx );
+        atomic_store( &J.stop, true );
+        pthread_cond_broadcast( &J.sleep_cond );
+        pthread_mutex_unlock( &J.sleep_mtx );
+
+        for ( int i = 1; i <= J.num_workers; ++i )
+        {
+            pthread_join( J.threads[i], NULL );
+        }
+
+        for ( int i = 0; i < J.num_threads; ++i )
+        {
+            pthread_mutex_destroy( &J.deques[i].mtx );
+        }
+    }
+
+    int count = atomic_load( &J.num_stats );
+    if ( count > 0 )
+    {
+        LOG_INFOF(
+            "jobs",
+            "Jobs on %d thread%s (%llu stolen):",
+            J.num_workers + 1,
+            J.num_workers == 0 ? "" : "s",
+            ( unsigned long long ) atomic_load( &J.steals ) );
+
+        for ( int i = 0; i < count; ++i )
+        {
+            job_stats_t *stats = &J.stats[i];
+            uint64_t     runs  = atomic_load( &stats->count );
+            if ( runs == 0 )
+            {
+                continue;
+            }
+
+            double total_ms = ( double ) atomic_load( &stats->total_ns ) / 1e6;
+            LOG_INFOF(
+                "jobs",
+                "  %-20s %8llu runs %10.2f ms total %9.1f us avg %9.1f us max",
+                stats->name,
+                ( unsigned long long ) runs,
+                total_ms,
+                total_ms * 1000.0 / ( double ) runs,
+                ( double ) atomic_load( &stats->max_ns ) / 1e3 );
+        }
+    }
+
+    J.started     = false;
+    J.num_threads = 1;
+    J.num_workers = 0;
+    t_worker      = -1;
+}
@@ -0,0 +1,108 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Work-stealing job system
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+/*
+ * A small work-stealing thread pool shared by the loader, texture decode,
+ * animation and skinning.
+ *
+ * Every thread of the pool, the one that called job_system_init() included,
+ * owns a deque. Jobs submitted from a pool thread go to the bottom of its own
+ * deque and are popped back from there (newest first, still hot in cache);
+ * idle threads steal the oldest job from the top of someone else's. A thread
+ * waiting in job_wait() keeps running jobs instead of blocking, so jobs may
+ * submit and wait on further jobs.
+ *
+ * Jobs are caller-owned (usually on the stack) and must stay alive until
+ * job_wait() returns for them, or for a job that depends on them: a job is
+ * only started after its prerequisites have let go of their job_t. Until
+ * job_system_init() is called, or with a single thread, job_submit() simply
+ * runs the job in place, so code written against the job system works
+ * unchanged in tools that never start it.
+ */
+#define JOB_SYSTEM_MAX_THREADS  32
+#define JOB_MAX_DEPENDENTS      8
+#define JOB_PARALLEL_FOR_CHUNKS 64
+
+typedef void ( *job_fn )( void *arg );
+
+// Runs [begin, end) of a job_parallel_for() range
+typedef void ( *job_range_fn )( void *arg, int begin, int end );
+
+struct job_stats_s;
+
+typedef struct job_s {
+    job_fn              fn;
+    void               *arg;
+    struct job_stats_s *stats;     // per-name timing slot
+
+    atomic_int    pending;         // unfinished prerequisites, +1 until submitted
+    atomic_bool   done;
+    struct job_s *dependents[JOB_MAX_DEPENDENTS];
+    int           num_dependents;
+} job_t;
+
+/*
+ * Starts the pool with `threads` threads including the calling one (0 = one
+ * per online core, 1 = no workers, everything runs in place). The calling
+ * thread becomes the pool's main thread.
+ */
+void job_system_init( int threads );
+
+// Joins the workers and logs the per-job timing table
+void job_system_shutdown( void );
+
+// Threads that run jobs, the main thread included (1 when not started)
+int job_system_threads( void );
+
+/*
+ * Prepares a job. `name` must be a string literal (or otherwise outlive the
+ * pool); jobs with the same name share one timing entry.
+ */
+void job_init( job_t *job, const char *name, job_fn fn, void *arg );
+
+/*
+ * `job` will not start before `prerequisite` finished. Both must be
+ * initialized and neither submitted yet. Returns false if the prerequisite
+ * already has JOB_MAX_DEPENDENTS dependents.
+ */
+bool job_add_dependency( job_t *job, job_t *prerequisite );
+
+// Queues the job; it runs as soon as all of its prerequisites are done
+void job_submit( job_t *job );
+
+// Runs other jobs until `job` is done
+void job_wait( job_t *job );
+
+/*
+ * Calls fn over [0, count) in chunks of at least `grain` items, spread over
+ * the pool, and returns when all of them are done. The calling thread runs
+ * the first chunk itself.
+ */
+void job_parallel_for( const char *name, int count, int grain, job_range_fn fn, void *arg );
+
+#endif    // JOB_SYSTEM_H
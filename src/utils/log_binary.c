@@ -0,0 +1,809 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Binary log records - argument packing, writing and decoding
+ * ═══════════════════════════════════════════════════════════════════════════
+ */
+
+#include "log_binary.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum { LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T, LEN_BIG_L } t_length;
+
+// One conversion of a format string
+typedef struct {
+    const char *start;        // the '%'
+    const char *conv;         // the conversion character
+    int         type;         // LOG_ARG_* (| LOG_ARG_SIGNED), 0 for "%%"
+    int         stars;        // '*' width/precision arguments in front of the value
+    bool        supported;
+} t_spec;
+
+static bool is_digit( char c )
+{
+    return c >= '0' && c <= '9';
+}
+
+// Parses the conversion starting at `p` ('%'); returns the character after it, NULL if cut short
+static const char *parse_spec( const char *p, t_spec *spec )
+{
+    spec->start     = p++;
+    spec->type      = 0;
+    spec->stars     = 0;
+    spec->supported = true;
+
+    while ( *p && strchr( "-+ #0'", *p ) )
+        p++;
+
+    if ( *p == '*' )
+    {
+        spec->stars++;
+        p++;
+    }
+    else
+    {
+        while ( is_digit( *p ) )
+            p++;
+        if ( *p == '$' )
+            spec->supported = false;    // positional arguments
+    }
+
+    if ( *p == '.' )
+    {
+        p++;
+        if ( *p == '*' )
+        {
+            spec->stars++;
+            p++;
+        }
+        else
+        {
+            while ( is_digit( *p ) )
+                p++;
+        }
+    }
+
+    t_length len = LEN_NONE;
+    switch ( *p )
+    {
+    case 'h':
+        len = ( p[1] == 'h' ) ? LEN_HH : LEN_H;
+        p += ( len == LEN_HH ) ? 2 : 1;
+        break;
+    case 'l':
+        len = ( p[1] == 'l' ) ? LEN_LL : LEN_L;
+        p += ( len == LEN_LL ) ? 2 : 1;
+        break;
+    case 'q':
+        len = LEN_LL;
+        p++;
+        break;
+    case 'j':
+        len = LEN_J;
+        p++;
+        break;
+    case 'z':
+        len = LEN_Z;
+        p++;
+        break;
+    case 't':
+        len = LEN_T;
+        p++;
+        break;
+    case 'L':
+        len = LEN_BIG_L;
+        p++;
+        break;
+    default:
+        break;
+    }
+
+    if ( !*p )
+    {
+        return NULL;
+    }
+
+    spec->conv = p;
+    switch ( *p )
+    {
+    case '%':
+        break;
+
+    case 'd':
+    case 'i':
+        spec->type = LOG_ARG_SIGNED;
+        // fall through
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        switch ( len )
+        {
+        case LEN_NONE:
+        case LEN_HH:
+        case LEN_H:
+            spec->type |= LOG_ARG_INT;
+            break;
+        case LEN_L:
+            spec->type |= LOG_ARG_LONG;
+            break;
+        case LEN_LL:
+            spec->type |= LOG_ARG_LLONG;
+            break;
+        case LEN_J:
+            spec->type |= LOG_ARG_INTMAX;
+            break;
+        case LEN_Z:
+            spec->type |= LOG_ARG_SIZE;
+            break;
+        case LEN_T:
+            spec->type |= LOG_ARG_PTRDIFF;
+            break;
+        default:
+            spec->supported = false;
+            break;
+        }
+        break;
+
+    case 'c':
+        spec->type      = LOG_ARG_INT;
+        spec->supported = spec->supported && len == LEN_NONE;    // no wide characters
+        break;
+
+    case 's':
+        spec->type      = LOG_ARG_STRING;
+        spec->supported = spec->supported && len == LEN_NONE;    // no wide strings
+        break;
+
+    case 'p':
+        spec->type = LOG_ARG_POINTER;
+        break;
+
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        spec->type = ( len == LEN_BIG_L ) ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+        break;
+
+    default:    // %n and anything unknown
+        spec->supported = false;
+        break;
+    }
+
+    return p + 1;
+}
+
+int log_bin_parse_format( const char *fmt, unsigned char *types, int max )
+{
+    int count = 0;
+
+    for ( const char *p = fmt ? fmt : ""; *p; )
+    {
+        if ( *p != '%' )
+        {
+            p++;
+            continue;
+        }
+
+        t_spec spec;
+        p = parse_spec( p, &spec );
+        if ( !p || !spec.supported )
+        {
+            return -1;
+        }
+        if ( spec.type == 0 )
+        {
+            continue;
+        }
+
+        if ( count + spec.stars + 1 > max )
+        {
+            return -1;
+        }
+        for ( int i = 0; i < spec.stars; i++ )
+        {
+            types[count++] = LOG_ARG_INT | LOG_ARG_SIGNED;
+        }
+        types[count++] = ( unsigned char ) spec.type;
+    }
+
+    return count;
+}
+
+// Bytes an argument takes besides string contents
+static size_t fixed_size( unsigned char type )
+{
+    switch ( type & ~LOG_ARG_SIGNED )
+    {
+    case LOG_ARG_INT:
+        return 4;
+    case LOG_ARG_STRING:
+        return 2;
+    default:
+        return 8;
+    }
+}
+
+size_t log_bin_pack_args( const unsigned char *types, int count, va_list ap, unsigned char *out, size_t cap )
+{
+    size_t fixed_left = 0;
+    for ( int i = 0; i < count; i++ )
+    {
+        fixed_left += fixed_size( types[i] );
+    }
+
+    size_t used = 0;
+    for ( int i = 0; i < count; i++ )
+    {
+        const bool sign = ( types[i] & LOG_ARG_SIGNED ) != 0;
+        const int  type = types[i] & ~LOG_ARG_SIGNED;
+        fixed_left -= fixed_size( types[i] );
+
+        if ( used + fixed_size( types[i] ) > cap )
+        {
+            break;
+        }
+
+        uint64_t bits = 0;
+        switch ( type )
+        {
+        case LOG_ARG_INT:
+        {
+            int32_t v = va_arg( ap, int );
+            memcpy( out + used, &v, 4 );
+            used += 4;
+            continue;
+        }
+        case LOG_ARG_LONG:
+            bits = sign ? ( uint64_t ) ( int64_t ) va_arg( ap, long ) : ( uint64_t ) va_arg( ap, unsigned long );
+            break;
+        case LOG_ARG_LLONG:
+            bits = sign ? ( uint64_t ) ( int64_t ) va_arg( ap, long long ) : ( uint64_t ) va_arg( ap, unsigned long long );
+            break;
+        case LOG_ARG_SIZE:
+        {
+            size_t v = va_arg( ap, size_t );
+            bits     = sign ? ( uint64_t ) ( int64_t ) ( ptrdiff_t ) v : ( uint64_t ) v;
+            break;
+        }
+        case LOG_ARG_PTRDIFF:
+        {
+            ptrdiff_t v = va_arg( ap, ptrdiff_t );
+            bits        = sign ? ( uint64_t ) ( int64_t ) v : ( uint64_t ) ( size_t ) v;
+            break;
+        }
+        case LOG_ARG_INTMAX:
+            bits = sign ? ( uint64_t ) ( int64_t ) va_arg( ap, intmax_t ) : ( uint64_t ) va_arg( ap, uintmax_t );
+            break;
+        case LOG_ARG_DOUBLE:
+        {
+            double v = va_arg( ap, double );
+            memcpy( &bits, &v, 8 );
+            break;
+        }
+        case LOG_ARG_LDOUBLE:
+        {
+            double v = ( double ) va_arg( ap, long double );
+            memcpy( &bits, &v, 8 );
+            break;
+        }
+        case LOG_ARG_POINTER:
+            bits = ( uint64_t ) ( uintptr_t ) va_arg( ap, void * );
+            break;
+        case LOG_ARG_STRING:
+        {
+            const char *s = va_arg( ap, const char * );
+            if ( !s )
+            {
+                s = "(null)";
+            }
+
+            // Cut the string so the arguments after it still fit
+            size_t n    = strlen( s );
+            size_t room = cap - used - 2;
+            room        = room > fixed_left ? room - fixed_left : 0;
+            if ( n > room )
+                n = room;
+            if ( n > UINT16_MAX )
+                n = UINT16_MAX;
+
+            uint16_t len = ( uint16_t ) n;
+            memcpy( out + used, &len, 2 );
+            memcpy( out + used + 2, s, n );
+            used += 2 + n;
+            continue;
+        }
+        default:
+            continue;
+        }
+
+        memcpy( out + used, &bits, 8 );
+        used += 8;
+    }
+
+    return used;
+}
+
+// Reads `n` bytes of packed arguments, zeros past the end of a cut record
+static void take( const unsigned char **args, const unsigned char *end, void *dst, size_t n )
+{
+    size_t have = ( size_t ) ( end - *args );
+    if ( have < n )
+    {
+        memset( dst, 0, n );
+        n = have;
+    }
+    memcpy( dst, *args, n );
+    *args += n;
+}
+
+size_t log_bin_render( const char *fmt, const unsigned char *args, size_t size, char *out, size_t cap )
+{
+    const unsigned char *end = args + size;
+    size_t               pos = 0;
+
+    if ( cap == 0 )
+    {
+        return 0;
+    }
+
+    for ( const char *p = fmt ? fmt : ""; *p && pos + 1 < cap; )
+    {
+        if ( *p != '%' )
+        {
+            out[pos++] = *p++;
+            continue;
+        }
+
+        t_spec      spec;
+        const char *next = parse_spec( p, &spec );
+        if ( !next || !spec.supported || spec.conv - spec.start > 40 )
+        {
+            out[pos++] = *p++;    // print it as it is
+            continue;
+        }
+        p = next;
+
+        if ( spec.type == 0 )
+        {
+            out[pos++] = '%';
+            continue;
+        }
+
+        // Rebuild the conversion with '*' filled in and a length that fits the stored value
+        const int type = spec.type & ~LOG_ARG_SIGNED;
+        char      piece[96];
+        int       k = 0;
+        piece[k++]  = '%';
+        for ( const char *q = spec.start + 1; q < spec.conv; q++ )
+        {
+            if ( *q == '*' )
+            {
+                int32_t v;
+                take( &args, end, &v, 4 );
+                if ( v < 0 && k > 0 && piece[k - 1] == '.' )
+                    k--;    // negative precision means none
+                else
+                    k += snprintf( piece + k, sizeof( piece ) - k, "%d", ( int ) v );
+            }
+            else if ( strchr( "hljztLq", *q ) == NULL || type == LOG_ARG_INT )
+            {
+                piece[k++] = *q;
+            }
+        }
+        if ( type != LOG_ARG_INT && type != LOG_ARG_DOUBLE && type != LOG_ARG_LDOUBLE && type != LOG_ARG_STRING
+             && type != LOG_ARG_POINTER )
+        {
+            piece[k++] = 'l';
+            piece[k++] = 'l';
+        }
+        piece[k++] = *spec.conv;
+        piece[k]   = '\0';
+
+        int n = 0;
+        switch ( type )
+        {
+        case LOG_ARG_INT:
+        {
+            int32_t v;
+            take( &args, end, &v, 4 );
+            n = snprintf( out + pos, cap - pos, piece, ( int ) v );
+            break;
+        }
+        case LOG_ARG_DOUBLE:
+        case LOG_ARG_LDOUBLE:
+        {
+            double v;
+            take( &args, end, &v, 8 );
+            n = snprintf( out + pos, cap - pos, piece, v );
+            break;
+        }
+        case LOG_ARG_POINTER:
+        {
+            uint64_t v;
+            take( &args, end, &v, 8 );
+            n = snprintf( out + pos, cap - pos, piece, ( void * ) ( uintptr_t ) v );
+            break;
+        }
+        case LOG_ARG_STRING:
+        {
+            uint16_t len = 0;
+            take( &args, end, &len, 2 );
+            if ( ( size_t ) len > ( size_t ) ( end - args ) )
+                len = ( uint16_t ) ( end - args );
+
+            char s[LOG_BIN_MAX_ARG_DATA + 1];
+            if ( len > LOG_BIN_MAX_ARG_DATA )
+                len = LOG_BIN_MAX_ARG_DATA;
+            take( &args, end, s, len );
+            s[len] = '\0';
+            n      = snprintf( out + pos, cap - pos, piece, s );
+            break;
+        }
+        default:
+        {
+            uint64_t v;
+            take( &args, end, &v, 8 );
+            if ( spec.type & LOG_ARG_SIGNED )
+                n = snprintf( out + pos, cap - pos, piece, ( long long ) ( int64_t ) v );
+            else
+                n = snprintf( out + pos, cap - pos, piece, ( unsigned long long ) v );
+            break;
+        }
+        }
+
+        if ( n > 0 )
+        {
+            pos += ( size_t ) n < cap - pos ? ( size_t ) n : cap - pos - 1;
+        }
+    }
+
+    out[pos] = '\0';
+    return pos;
+}
+
+static size_t put_u8( unsigned char *out, unsigned v )
+{
+    out[0] = ( unsigned char ) v;
+    return 1;
+}
+
+static size_t put_u16( unsigned char *out, uint16_t v )
+{
+    memcpy( out, &v, 2 );
+    return 2;
+}
+
+static size_t put_u32( unsigned char *out, uint32_t v )
+{
+    memcpy( out, &v, 4 );
+    return 4;
+}
+
+static size_t put_u64( unsigned char *out, uint64_t v )
+{
+    memcpy( out, &v, 8 );
+    return 8;
+}
+
+static size_t put_str( unsigned char *out, const char *s, size_t max )
+{
+    size_t n = s ? strlen( s ) : 0;
+    if ( n > max )
+        n = max;
+    put_u16( out, ( uint16_t ) n );
+    if ( n )
+        memcpy( out + 2, s, n );
+    return 2 + n;
+}
+
+size_t log_bin_write_header( unsigned char *out )
+{
+    memcpy( out, LOG_BIN_MAGIC, 8 );
+    put_u32( out + 8, LOG_BIN_BYTE_ORDER );
+    return LOG_BIN_HEADER_SIZE;
+}
+
+size_t log_bin_write_format(
+    unsigned char *out, uint32_t id, const char *category, const char *file, int line, const char *func, const char *fmt )
+{
+    size_t n = put_u8( out, LOG_BIN_FORMAT );
+    n += put_u32( out + n, id );
+    n += put_str( out + n, category, LOG_BIN_MAX_STRING );
+    n += put_str( out + n, file, LOG_BIN_MAX_STRING );
+    n += put_u32( out + n, ( uint32_t ) line );
+    n += put_str( out + n, func, LOG_BIN_MAX_STRING );
+    n += put_str( out + n, fmt, LOG_BIN_MAX_STRING );
+    return n;
+}
+
+size_t log_bin_write_record(
+    unsigned char *out, uint32_t id, int level, uint64_t time_ns, const unsigned char *args, size_t size )
+{
+    if ( size > LOG_BIN_MAX_ARG_DATA )
+        size = LOG_BIN_MAX_ARG_DATA;
+
+    size_t n = put_u8( out, LOG_BIN_RECORD );
+    n += put_u32( out + n, id );
+    n += put_u8( out + n, ( unsigned ) level );
+    n += put_u64( out + n, time_ns );
+    n += put_u16( out + n, ( uint16_t ) size );
+    memcpy( out + n, args, size );
+    return n + size;
+}
+
+size_t log_bin_write_text(
+    unsigned char *out,
+    int            level,
+    uint64_t       time_ns,
+    const char    *category,
+    const char    *file,
+    int            line,
+    const char    *func,
+    const char    *message )
+{
+    size_t n = put_u8( out, LOG_BIN_TEXT );
+    n += put_u8( out + n, ( unsigned ) level );
+    n += put_u64( out + n, time_ns );
+    n += put_str( out + n, category, LOG_BIN_MAX_STRING );
+    n += put_str( out + n, file, LOG_BIN_MAX_STRING );
+    n += put_u32( out + n, ( uint32_t ) line );
+    n += put_str( out + n, func, LOG_BIN_MAX_STRING );
+    n += put_str( out + n, message, LOG_BIN_MAX_MESSAGE - 1 );
+    return n;
+}
+
+// ─── Reading ─────────────────────────────────────────────────────────────
+
+typedef struct {
+    char *category;
+    char *file;
+    char *func;
+    char *format;
+    int   line;
+} t_bin_format;
+
+struct log_bin_reader {
+    FILE         *fp;
+    t_bin_format *formats;    // indexed by id
+    uint32_t      format_count;
+
+    // TEXT record strings
+    char category[LOG_BIN_MAX_STRING + 1];
+    char file[LOG_BIN_MAX_STRING + 1];
+    char func[LOG_BIN_MAX_STRING + 1];
+
+    unsigned char args[LOG_BIN_MAX_ARG_DATA];
+};
+
+// IDs count up from 1 in each writing process; anything far past that is damage
+#define LOG_BIN_MAX_FORMAT_ID ( 1u << 20 )
+
+static bool read_bytes( FILE *fp, void *dst, size_t n )
+{
+    return fread( dst, 1, n, fp ) == n;
+}
+
+static bool read_u8( FILE *fp, unsigned *v )
+{
+    unsigned char b;
+    if ( !read_bytes( fp, &b, 1 ) )
+        return false;
+    *v = b;
+    return true;
+}
+
+// Reads a `str` into `dst` (cap bytes with the terminator)
+static bool read_str( FILE *fp, char *dst, size_t cap )
+{
+    uint16_t len;
+    if ( !read_bytes( fp, &len, 2 ) || len >= cap )
+        return false;
+    if ( !read_bytes( fp, dst, len ) )
+        return false;
+    dst[len] = '\0';
+    return true;
+}
+
+static char *read_str_dup( FILE *fp )
+{
+    char buf[LOG_BIN_MAX_STRING + 1];
+    if ( !read_str( fp, buf, sizeof( buf ) ) )
+        return NULL;
+
+    size_t n   = strlen( buf ) + 1;
+    char  *dup = ( char * ) malloc( n );
+    if ( dup )
+        memcpy( dup, buf, n );
+    return dup;
+}
+
+static void free_format( t_bin_format *f )
+{
+    free( f->category );
+    free( f->file );
+    free( f->func );
+    free( f->format );
+    memset( f, 0, sizeof( *f ) );
+}
+
+t_log_bin_reader *log_bin_open( const char *path )
+{
+    FILE *fp = fopen( path, "rb" );
+    if ( !fp )
+    {
+        return NULL;
+    }
+
+    unsigned char header[LOG_BIN_HEADER_SIZE];
+    uint32_t      order;
+    if ( !read_bytes( fp, header, sizeof( header ) ) || memcmp( header, LOG_BIN_MAGIC, 8 ) != 0 )
+    {
+        fclose( fp );
+        return NULL;
+    }
+    memcpy( &order, header + 8, 4 );
+    if ( order != LOG_BIN_BYTE_ORDER )
+    {
+        fclose( fp );
+        return NULL;
+    }
+
+    t_log_bin_reader *reader = ( t_log_bin_reader * ) calloc( 1, sizeof( *reader ) );
+    if ( !reader )
+    {
+        fclose( fp );
+        return NULL;
+    }
+    reader->fp = fp;
+    return reader;
+}
+
+static int read_format( t_log_bin_reader *r )
+{
+    uint32_t id, line;
+    if ( !read_bytes( r->fp, &id, 4 ) || id >= LOG_BIN_MAX_FORMAT_ID )
+        return -1;
+
+    if ( id >= r->format_count )
+    {
+        uint32_t count = r->format_count ? r->format_count : 256;
+        while ( count <= id )
+            count *= 2;
+
+        t_bin_format *grown = ( t_bin_format * ) realloc( r->formats, count * sizeof( *grown ) );
+        if ( !grown )
+            return -1;
+        memset( grown + r->format_count, 0, ( count - r->format_count ) * sizeof( *grown ) );
+        r->formats      = grown;
+        r->format_count = count;
+    }
+
+    t_bin_format *f = &r->formats[id];
+    free_format( f );    // an appended session reuses IDs
+    f->category = read_str_dup( r->fp );
+    f->file     = read_str_dup( r->fp );
+    if ( !read_bytes( r->fp, &line, 4 ) )
+        return -1;
+    f->line   = ( int ) line;
+    f->func   = read_str_dup( r->fp );
+    f->format = read_str_dup( r->fp );
+
+    return ( f->category && f->file && f->func && f->format ) ? 0 : -1;
+}
+
+int log_bin_next( t_log_bin_reader *r, t_log_bin_entry *e )
+{
+    for ( ;; )
+    {
+        int tag = fgetc( r->fp );
+        if ( tag == EOF )
+        {
+            return 0;
+        }
+
+        unsigned level;
+        uint64_t ns;
+
+        switch ( tag )
+        {
+        case LOG_BIN_FORMAT:
+            if ( read_format( r ) != 0 )
+                return -1;
+            continue;
+
+        case LOG_BIN_RECORD:
+        {
+            uint32_t id;
+            uint16_t size;
+            if ( !read_bytes( r->fp, &id, 4 ) || !read_u8( r->fp, &level ) || !read_bytes( r->fp, &ns, 8 )
+                 || !read_bytes( r->fp, &size, 2 ) || size > LOG_BIN_MAX_ARG_DATA
+                 || !read_bytes( r->fp, r->args, size ) )
+                return -1;
+
+            e->level   = ( int ) level;
+            e->time_ns = ns;
+            if ( id < r->format_count && r->formats[id].format )
+            {
+                const t_bin_format *f = &r->formats[id];
+                e->category           = f->category;
+                e->file               = f->file;
+                e->line               = f->line;
+                e->func               = f->func;
+                e->format             = f->format;
+                log_bin_render( f->format, r->args, size, e->message, sizeof( e->message ) );
+            }
+            else
+            {
+                e->category = e->file = e->func = "?";
+                e->line                         = 0;
+                e->format                       = NULL;
+                snprintf( e->message, sizeof( e->message ), "(record with undefined format %u)", id );
+            }
+            return 1;
+        }
+
+        case LOG_BIN_TEXT:
+        {
+            uint32_t line;
+            if ( !read_u8( r->fp, &level ) || !read_bytes( r->fp, &ns, 8 )
+                 || !read_str( r->fp, r->category, sizeof( r->category ) )
+                 || !read_str( r->fp, r->file, sizeof( r->file ) ) || !read_bytes( r->fp, &line, 4 )
+                 || !read_str( r->fp, r->func, sizeof( r->func ) )
+                 || !read_str( r->fp, e->message, sizeof( e->message ) ) )
+                return -1;
+
+            e->level    = ( int ) level;
+            e->time_ns  = ns;
+            e->category = r->category;
+            e->file     = r->file;
+            e->line     = ( int ) line;
+            e->func     = r->func;
+            e->format   = NULL;
+            return 1;
+        }
+
+        default:
+            return -1;
+        }
+    }
+}
+
+void log_bin_close( t_log_bin_reader *r )
+{
+    if ( !r )
+    {
+        return;
+    }
+
+    for ( uint32_t i = 0; i < r->format_count; i++ )
+    {
+        free_format( &r->formats[i] );
+    }
+    free( r->formats );
+    fclose( r->fp );
+    free( r );
+}
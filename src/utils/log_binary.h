@@ -0,0 +1,117 @@
+#ifndef LOG_BINARY_H
+#define LOG_BINARY_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary log format, written by the logger (t_log_options.binary) and read
+ * back by tools/log_decode.c.
+ *
+ * A callsite's constant parts - category, file, line, function and format
+ * string - are written once as a FORMAT record under a numeric ID. After
+ * that each log call only writes a RECORD: the ID, level, timestamp and the
+ * raw bytes of its arguments. No printf() runs while logging; the decoder
+ * renders the message later with the stored format string. Calls whose
+ * format uses something the encoding does not cover (%n, wide strings) and
+ * calls without a callsite (logger_log() with a category name) are written
+ * as TEXT records holding the finished message.
+ *
+ * File:    "LMBLOG01" | u32 0x01020304 (byte order check)
+ * FORMAT:  'F' | u32 id | str category | str file | u32 line | str func | str format
+ * RECORD:  'R' | u32 id | u8 level | u64 ns since the epoch | u16 size | arguments
+ * TEXT:    'T' | u8 level | u64 ns | str category | str file | u32 line | str func | str message
+ *
+ * `str` is a u16 length and that many bytes, integers are in the writer's
+ * byte order. Arguments are packed in format order: 4 bytes for int-sized
+ * and '*' width/precision arguments, 8 for wider integers, pointers and
+ * floating point (long double is stored as double), and `str` for %s.
+ * A new logger session appending to a file defines its IDs again before
+ * using them.
+ */
+#define LOG_BIN_MAGIC      "LMBLOG01"
+#define LOG_BIN_BYTE_ORDER 0x01020304u
+#define LOG_BIN_HEADER_SIZE 12
+
+#define LOG_BIN_FORMAT 'F'
+#define LOG_BIN_RECORD 'R'
+#define LOG_BIN_TEXT   'T'
+
+#define LOG_BIN_MAX_ARGS     32      // arguments per format, '*' included
+#define LOG_BIN_MAX_ARG_DATA 2048    // argument bytes per record, long strings are cut
+#define LOG_BIN_MAX_STRING   1024    // longest category/file/function/format string kept
+#define LOG_BIN_MAX_MESSAGE  2048    // longest rendered or TEXT message
+
+// Largest FORMAT, RECORD or TEXT record
+#define LOG_BIN_MAX_RECORD ( 16 + 4 * ( 2 + LOG_BIN_MAX_STRING ) + 2 + LOG_BIN_MAX_MESSAGE )
+
+// How a conversion's argument is stored; the high bit marks signed integers
+typedef enum {
+    LOG_ARG_INT = 1,    // int and smaller, '*'
+    LOG_ARG_LONG,
+    LOG_ARG_LLONG,
+    LOG_ARG_SIZE,
+    LOG_ARG_PTRDIFF,
+    LOG_ARG_INTMAX,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER,
+} t_log_arg_type;
+
+#define LOG_ARG_SIGNED 0x80
+
+/*
+ * Argument types of a printf format, in order, into `types`. Returns the
+ * count, or -1 if the format needs a TEXT record instead (unsupported
+ * conversion or more than `max` arguments).
+ */
+int log_bin_parse_format( const char *fmt, unsigned char *types, int max );
+
+// Packs the arguments described by `types` from `ap`; returns the bytes used (at most `cap`)
+size_t log_bin_pack_args( const unsigned char *types, int count, va_list ap, unsigned char *out, size_t cap );
+
+// Renders `fmt` with packed arguments into `out` (always terminated); returns the length
+size_t log_bin_render( const char *fmt, const unsigned char *args, size_t size, char *out, size_t cap );
+
+// Record writers: each fills `out` (LOG_BIN_MAX_RECORD bytes) and returns the record's size
+size_t log_bin_write_header( unsigned char *out );
+size_t log_bin_write_format(
+    unsigned char *out, uint32_t id, const char *category, const char *file, int line, const char *func, const char *fmt );
+size_t log_bin_write_record(
+    unsigned char *out, uint32_t id, int level, uint64_t time_ns, const unsigned char *args, size_t size );
+size_t log_bin_write_text(
+    unsigned char *out,
+    int            level,
+    uint64_t       time_ns,
+    const char    *category,
+    const char    *file,
+    int            line,
+    const char    *func,
+    const char    *message );
+
+// One decoded entry; the strings stay valid until the next log_bin_next()/log_bin_close()
+typedef struct {
+    int         level;
+    uint64_t    time_ns;
+    const char *category;
+    const char *file;
+    int         line;
+    const char *func;
+    const char *format;    // NULL for TEXT records
+    char        message[LOG_BIN_MAX_MESSAGE];
+} t_log_bin_entry;
+
+typedef struct log_bin_reader t_log_bin_reader;
+
+// NULL if the file cannot be opened or is not a binary log of this machine's byte order
+t_log_bin_reader *log_bin_open( const char *path );
+
+// 1 with the next entry, 0 at the end of the file, -1 on a damaged or truncated record
+int log_bin_next( t_log_bin_reader *reader, t_log_bin_entry *entry );
+
+void log_bin_close( t_log_bin_reader *reader );
+
+#endif    // LOG_BINARY_H
@@ -22,6 +22,7 @@
 
 
 #include "logger.h"
+#include "log_binary.h"
 
 #include <math.h>
 #include <stdarg.h>
@@ -39,22 +40,18 @@
 #define fileno _fileno
 #else
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #endif
 
-typedef struct category_level {
-    char name[48];
-    int  level;
-    int  in_use;
-} t_category_level;
+#define LOG_MESSAGE_MAX 2048    // longest message, longer ones are cut
 
 // need to ensure one thread only writes to our .log file
 static struct {
-    t_log_options    opt;
-    FILE            *fp;
-    size_t           bytes;
-    int              default_level;
-    t_category_level cats[LOG_MAX_CATEGORIES];
+    t_log_options opt;
+    FILE         *fp;
+    size_t        bytes;
+    int           default_level;
 
 #ifdef _WIN32
     CRITICAL_SECTION mtx;    // mutex for Windows
@@ -65,6 +62,126 @@ static struct {
     int vt_enabled;     //  enabling ANSI colors for the terminal
 } G;
 
+/*
+ * Interned categories. A name is registered once and referred to by its
+ * index from then on; the LOG_* macros cache that index per callsite. Names
+ * are only ever appended and outlive logger_init()/logger_shutdown(), so a
+ * cached handle stays valid and its name can be read without a lock.
+ * Handle 0 is LOG_CAT_DEFAULT, which also takes names past the table.
+ *
+ * logger_cat_levels holds each handle's effective level (its own, or the
+ * global level if it has none) and logger_min_level the lowest of them. Both
+ * are recomputed whenever a level changes, so a disabled call costs the
+ * macros one relaxed load and compare.
+ */
+static struct {
+    char       names[LOG_MAX_CATEGORIES][48];
+    int        level[LOG_MAX_CATEGORIES];
+    bool       has_level[LOG_MAX_CATEGORIES];    // false: follows the global level
+    atomic_int count;
+} C = { .names = { LOG_CAT_DEFAULT }, .count = 1 };
+
+#ifdef _WIN32
+static SRWLOCK cat_lock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t cat_mtx = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+atomic_int logger_cat_levels[LOG_MAX_CATEGORIES];
+atomic_int logger_min_level;
+
+/*
+ * Binary file formats, one per callsite, made on its first record and never
+ * freed (like the category names). `written_gen` is the logger session that
+ * last put the FORMAT record in the file; only whoever writes the file -
+ * the writer thread, or a caller holding the logger lock - touches it.
+ */
+typedef struct log_format {
+    uint32_t      id;
+    int           category;
+    int           line;
+    const char   *file;
+    const char   *func;
+    const char   *fmt;
+    int           nargs;    // -1: the format needs TEXT records
+    unsigned char types[LOG_BIN_MAX_ARGS];
+    unsigned      written_gen;
+} t_log_format;
+
+static uint32_t binary_next_id;    // under cat_lock
+static unsigned binary_gen;        // bumped by every logger_init()
+
+#ifndef _WIN32
+/*
+ * Async mode.
+ *
+ * File records go into one bounded lock-free queue (Vyukov's array queue:
+ * each slot's sequence number says whether it is free for the producer at
+ * that position or filled for the consumer), shared by every logging thread
+ * and drained by a single writer thread. A caller only formats its message -
+ * the arguments cannot outlive the call - and copies it into a slot; the
+ * timestamp text, line assembly, file writes and the flush all happen on the
+ * writer, one flush per batch instead of per line. For a binary file the
+ * caller does not even format: it copies the raw arguments. Console lines are not
+ * queued: stdout is shared with printf() output all over the viewer, so the
+ * caller writes them itself to keep them in order.
+ *
+ * On a full queue, records below async_block_level are dropped (counted and
+ * reported by the writer) and the rest spin until a slot frees up, so
+ * warnings and errors are never lost. The writer sleeps on a condition
+ * variable when the queue is empty; producers only signal it when it says
+ * it is asleep.
+ */
+#define LOG_ASYNC_DEFAULT_CAPACITY 4096
+#define LOG_ASYNC_INLINE_MESSAGE   224
+#define LOG_BATCH_BYTES            ( 64 * 1024 )
+
+typedef struct log_record {
+    struct timespec ts;
+    int             level;
+    int             line;
+    int             category;    // interned handle
+    const char     *file;
+    const char     *func;
+    t_log_format   *format;          // binary file: the message holds `size` packed argument bytes
+    size_t          size;
+    char           *long_message;    // heap copy when the message does not fit inline
+    char            message[LOG_ASYNC_INLINE_MESSAGE];
+} t_log_record;
+
+typedef struct log_slot {
+    atomic_size_t seq;
+    t_log_record  record;
+} t_log_slot;
+
+static struct {
+    t_log_slot *slots;
+    size_t      mask;
+    bool        running;
+
+    _Alignas( 64 ) atomic_size_t tail;    // next position a producer claims
+    _Alignas( 64 ) size_t head;           // next position the writer reads (writer only)
+    atomic_size_t  written;               // positions below this are written and flushed
+    atomic_uint_fast64_t dropped;
+    uint64_t       dropped_reported;      // writer only
+
+    atomic_bool     sleeping;
+    atomic_bool     stop;
+    pthread_t       thread;
+    pthread_mutex_t wake_mtx;
+    pthread_cond_t  wake_cond;
+
+    // Writer-side batch and the last formatted second of the timestamp
+    char   file_batch[LOG_BATCH_BYTES];
+    size_t file_used;
+    time_t stamp_second;
+    char   stamp_prefix[32];
+} Q;
+
+static void async_start( void );
+static void async_stop( void );
+#endif
+
 static int is_tty_terminal( void )
 {
     return isatty( fileno( stdout ) );
@@ -88,6 +205,57 @@ static void unlock_( void )
 #endif
 }
 
+static void cat_lock_( void )
+{
+#ifdef _WIN32
+    AcquireSRWLockExclusive( &cat_lock );
+#else
+    pthread_mutex_lock( &cat_mtx );
+#endif
+}
+
+static void cat_unlock_( void )
+{
+#ifdef _WIN32
+    ReleaseSRWLockExclusive( &cat_lock );
+#else
+    pthread_mutex_unlock( &cat_mtx );
+#endif
+}
+
+// Lock-free: published names never change
+static int cat_find( const char *name )
+{
+    const int count = atomic_load_explicit( &C.count, memory_order_acquire );
+    for ( int i = 0; i < count; i++ )
+    {
+        if ( strcmp( C.names[i], name ) == 0 )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Publishes every handle's effective level and the lowest of them; call with cat_lock held
+static void cat_update_levels( void )
+{
+    const int count     = atomic_load_explicit( &C.count, memory_order_relaxed );
+    int       min_level = G.default_level;
+
+    for ( int i = 0; i < count; i++ )
+    {
+        int level = C.has_level[i] ? C.level[i] : G.default_level;
+        atomic_store_explicit( &logger_cat_levels[i], level, memory_order_relaxed );
+        if ( level < min_level )
+        {
+            min_level = level;
+        }
+    }
+
+    atomic_store_explicit( &logger_min_level, min_level, memory_order_relaxed );
+}
+
 int logger_init( const t_log_options *opt )
 {
     memset( &G, 0, sizeof( G ) );
@@ -98,6 +266,13 @@ int logger_init( const t_log_options *opt )
     }
 
     G.default_level = LOG_DEFAULT_LEVEL;
+    binary_gen++;    // a new file, or a new session appending to one, defines its formats again
+
+    // Handles survive, their levels do not
+    cat_lock_( );
+    memset( C.has_level, 0, sizeof( C.has_level ) );
+    cat_update_levels( );
+    cat_unlock_( );
 
 #ifdef _WIN32
     InitializeCriticalSection( &G.mtx );
@@ -111,11 +286,22 @@ int logger_init( const t_log_options *opt )
         G.opt.console_level = G.default_level;
     }
 
+#ifndef _WIN32
+    if ( G.opt.async && G.opt.file_path && G.opt.file_path[0] )
+    {
+        async_start( );
+    }
+#endif
+
     return 0;
 }
 
 void logger_shutdown( void )
 {
+#ifndef _WIN32
+    async_stop( );
+#endif
+
     lock_( );
     if ( G.fp )
     {
@@ -132,33 +318,41 @@ void logger_shutdown( void )
 #endif
 }
 
-static int cat_find( const char *name )
+int logger_category( const char *name )
 {
-    for ( int i = 0; i < LOG_MAX_CATEGORIES; i++ )
+    if ( !name || !name[0] )
     {
-        if ( G.cats[i].in_use && strcmp( G.cats[i].name, name ) == 0 )
-        {
-            return i;
-        }
+        return 0;
     }
-    return -1;
-}
 
-static int cat_alloc( const char *name )
-{
-    for ( int i = 0; i < LOG_MAX_CATEGORIES; i++ )
+    int i = cat_find( name );
+    if ( i >= 0 )
+    {
+        return i;
+    }
+
+    cat_lock_( );
+    i = cat_find( name );    // someone else may have added it meanwhile
+    if ( i < 0 )
     {
-        if ( !G.cats[i].in_use )
+        const int count = atomic_load_explicit( &C.count, memory_order_relaxed );
+        if ( count < LOG_MAX_CATEGORIES )
         {
-            strncpy( G.cats[i].name, name, sizeof( G.cats[i].name ) - 1 );
-            G.cats[i].name[sizeof( G.cats[i].name ) - 1] = '\0';
-            G.cats[i].level                              = G.default_level;    //  start with default level
-            G.cats[i].in_use                             = 1;
-            return i;
+            i = count;
+            strncpy( C.names[i], name, sizeof( C.names[i] ) - 1 );
+            C.names[i][sizeof( C.names[i] ) - 1] = '\0';
+            C.has_level[i]                       = false;    //  start with default level
+            atomic_store_explicit( &logger_cat_levels[i], G.default_level, memory_order_relaxed );
+            atomic_store_explicit( &C.count, count + 1, memory_order_release );
+        }
+        else
+        {
+            i = 0;
         }
     }
+    cat_unlock_( );
 
-    return -1;
+    return i;
 }
 
 int logger_set_category_level( const char *category, int level )
@@ -168,21 +362,19 @@ int logger_set_category_level( const char *category, int level )
         return -1;
     }
 
-    lock_( );
-    int i = cat_find( category );
-    if ( i < 0 )
-    {
-        i = cat_alloc( category );
-    }
-
-    if ( i >= 0 )
+    int i = logger_category( category );
+    if ( i == 0 && strcmp( category, LOG_CAT_DEFAULT ) != 0 )
     {
-        G.cats[i].level = level;
+        return -2;    // table full
     }
 
-    unlock_( );
+    cat_lock_( );
+    C.level[i]     = level;
+    C.has_level[i] = true;
+    cat_update_levels( );
+    cat_unlock_( );
 
-    return ( i >= 0 ) ? 0 : -2;
+    return 0;
 }
 
 int logger_get_category_level( const char *category, int *out_level )
@@ -193,9 +385,9 @@ int logger_get_category_level( const char *category, int *out_level )
     }
 
     int i = cat_find( category );
-    if ( i >= 0 )
+    if ( i >= 0 && C.has_level[i] )
     {
-        *out_level = G.cats[i].level;
+        *out_level = C.level[i];
         return 0;
     }
 
@@ -215,37 +407,33 @@ int logger_is_tty( void )
 
 bool logger_should_log( int message_level, const char *category )
 {
-    int min_level = G.default_level;
-    int cat_level;
-    if ( category && logger_get_category_level( category, &cat_level ) == 0 )
+    int i = category ? cat_find( category ) : 0;
+    if ( i < 0 )
     {
-        min_level = cat_level;
+        return message_level >= G.default_level;
     }
 
-    return message_level >= min_level;
+    return message_level >= atomic_load_explicit( &logger_cat_levels[i], memory_order_relaxed );
 }
 
-static void wall_time_iso8601( char *buf, size_t n )
+static void wall_time_now( struct timespec *ts )
 {
 #ifdef _WIN32
-    struct timespec ts;
-    timespec_get( &ts, TIME_UTC );
-    time_t    sec = ts.tv_sec;
+    timespec_get( ts, TIME_UTC );
+#else
+    clock_gettime( CLOCK_REALTIME, ts );
+#endif
+}
+
+static void format_second( time_t sec, char *buf, size_t n )
+{
     struct tm tmv;
+#ifdef _WIN32
     localtime_s( &tmv, &sec );
 #else
-    struct timespec ts;
-    clock_gettime( CLOCK_REALTIME, &ts );
-    time_t    sec = ts.tv_sec;
-    struct tm tmv;
     localtime_r( &sec, &tmv );
-
 #endif
-
     strftime( buf, n, "%Y-%m-%dT%H:%M:%S", &tmv );
-
-    size_t len = strlen( buf );
-    snprintf( buf + len, n - len, ".%03d", ( int ) ( ts.tv_nsec / 1000000 ) );
 }
 
 uint64_t logger_now_ms( void )
@@ -269,8 +457,10 @@ int logger_get_global_level( )
 
 void logger_set_global_level( int level )
 {
+    cat_lock_( );
     G.default_level = level;
-    return;
+    cat_update_levels( );
+    cat_unlock_( );
 }
 
 static void write_console( const char *s, size_t n, int level )
@@ -284,6 +474,30 @@ static void write_console( const char *s, size_t n, int level )
     fflush( stdout );
 }
 
+static bool binary_file( void )
+{
+    return G.opt.binary && G.opt.file_path && G.opt.file_path[0];
+}
+
+// Opens the log file on first use; a new binary file starts with its header
+static FILE *open_log_file( void )
+{
+    if ( !G.fp )
+    {
+        G.fp = fopen( G.opt.file_path, "ab" );    // appending, binary
+        if ( G.fp && G.opt.binary )
+        {
+            fseek( G.fp, 0, SEEK_END );
+            if ( ftell( G.fp ) == 0 )
+            {
+                unsigned char header[LOG_BIN_HEADER_SIZE];
+                fwrite( header, 1, log_bin_write_header( header ), G.fp );
+            }
+        }
+    }
+    return G.fp;
+}
+
 static void write_file( const char *s, size_t n )
 {
     if ( !G.opt.file_path || !G.opt.file_path[0] )
@@ -291,13 +505,9 @@ static void write_file( const char *s, size_t n )
         return;
     }
 
-    if ( !G.fp )
+    if ( !open_log_file( ) )
     {
-        G.fp = fopen( G.opt.file_path, "ab" );    // appending, binary
-        if ( !G.fp )
-        {
-            return;
-        }
+        return;
     }
 
     fwrite( s, 1, n, G.fp );
@@ -307,73 +517,681 @@ static void write_file( const char *s, size_t n )
 
 static const char *LEVEL_NAME[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
 
-void logger_logv(
-    int level, const char *category, const char *file, int line, const char *func, const char *fmt, va_list ap )
+// Copies `s` into out[pos..], leaving the last two bytes for "\n\0"
+static size_t append_str( char *out, size_t pos, size_t cap, const char *s )
 {
-    if ( !logger_should_log( level, category ) )
+    size_t room = cap - 2 - pos;
+    size_t n    = strlen( s );
+    if ( n > room )
     {
-        return;
+        n = room;
     }
+    memcpy( out + pos, s, n );
+    return pos + n;
+}
+
+static size_t append_int( char *out, size_t pos, size_t cap, int value, int min_digits )
+{
+    char         digits[12];
+    int          n = 0;
+    unsigned int v = value < 0 ? 0u - ( unsigned int ) value : ( unsigned int ) value;
+
+    do
+    {
+        digits[n++] = ( char ) ( '0' + v % 10 );
+        v /= 10;
+    } while ( v || n < min_digits );
+    if ( value < 0 )
+    {
+        digits[n++] = '-';
+    }
+
+    while ( n > 0 && pos < cap - 2 )
+    {
+        out[pos++] = digits[--n];
+    }
+    return pos;
+}
+
+/*
+ * One log line: "<time> [LEVEL] category | file.c:line (func) | message\n".
+ * `prefix` is the timestamp down to the second. The pieces are copied in
+ * directly rather than through snprintf(), which was most of the writer
+ * thread's time per line. Returns the length, truncated to fit `out`.
+ */
+static size_t format_line(
+    char                  *out,
+    size_t                 cap,
+    const char            *prefix,
+    const struct timespec *ts,
+    int                    level,
+    int                    category,
+    const char            *file,
+    int                    line,
+    const char            *func,
+    const char            *msg )
+{
+    const char *cat = C.names[category];
 
-    if ( level < LOG_TRACE )
-        level = LOG_TRACE;
-    if ( level > LOG_FATAL )
-        level = LOG_FATAL;
-    const char *cat      = ( category && category[0] ) ? category : LOG_CAT_DEFAULT;
-    
     // CRITICAL FIX: Extract just the filename from full path
     const char *src_file = "?";
-    if (file) {
+    if ( file )
+    {
         // Find last '/' or '\\' to get filename only
-        const char *slash = strrchr(file, '/');
-        if (!slash) {
-            slash = strrchr(file, '\\');
+        const char *slash = strrchr( file, '/' );
+        if ( !slash )
+        {
+            slash = strrchr( file, '\\' );
         }
-        src_file = slash ? (slash + 1) : file;
+        src_file = slash ? ( slash + 1 ) : file;
     }
-    
+
     const char *src_func = func ? func : "?";
+
+    size_t pos = 0;
+    pos        = append_str( out, pos, cap, prefix );
+    pos        = append_str( out, pos, cap, "." );
+    pos        = append_int( out, pos, cap, ( int ) ( ts->tv_nsec / 1000000 ), 3 );
+    pos        = append_str( out, pos, cap, " [" );
+    pos        = append_str( out, pos, cap, LEVEL_NAME[level] );
+    pos        = append_str( out, pos, cap, "] " );
+    pos        = append_str( out, pos, cap, cat );
+    pos        = append_str( out, pos, cap, " | " );
+    pos        = append_str( out, pos, cap, src_file );
+    pos        = append_str( out, pos, cap, ":" );
+    pos        = append_int( out, pos, cap, line, 1 );
+    pos        = append_str( out, pos, cap, " (" );
+    pos        = append_str( out, pos, cap, src_func );
+    pos        = append_str( out, pos, cap, ") | " );
+    pos        = append_str( out, pos, cap, msg );
+
+    out[pos++] = '\n';
+    out[pos]   = '\0';
+    return pos;
+}
+
+/*
+ * The callsite's binary format, made on its first record. NULL when the
+ * format string has to go out as TEXT records (see log_bin_parse_format()).
+ */
+static t_log_format *site_format(
+    t_log_site *site, int category, const char *file, int line, const char *func, const char *fmt )
+{
+    t_log_format *format = atomic_load_explicit( &site->format, memory_order_acquire );
+
+    if ( !format )
+    {
+        cat_lock_( );
+        format = atomic_load_explicit( &site->format, memory_order_relaxed );
+        if ( !format && ( format = ( t_log_format * ) calloc( 1, sizeof( *format ) ) ) != NULL )
+        {
+            format->id       = ++binary_next_id;
+            format->category = category;
+            format->file     = file;
+            format->line     = line;
+            format->func     = func;
+            format->fmt      = fmt;
+            format->nargs    = strlen( fmt ) <= LOG_BIN_MAX_STRING
+                                   ? log_bin_parse_format( fmt, format->types, LOG_BIN_MAX_ARGS )
+                                   : -1;
+            atomic_store_explicit( &site->format, format, memory_order_release );
+        }
+        cat_unlock_( );
+    }
+
+    return ( format && format->nargs >= 0 ) ? format : NULL;
+}
+
+/*
+ * Hands one record to `emit` in the binary encoding: a RECORD with the
+ * packed arguments in `data`, preceded by the callsite's FORMAT the first
+ * time this session writes it, or a TEXT record when there is no format and
+ * `data` is the message.
+ */
+static void emit_binary(
+    void ( *emit )( const char *, size_t ),
+    const struct timespec *ts,
+    int                    level,
+    int                    category,
+    const char            *file,
+    int                    line,
+    const char            *func,
+    t_log_format          *format,
+    const void            *data,
+    size_t                 size )
+{
+    unsigned char  out[LOG_BIN_MAX_RECORD];
+    const uint64_t ns = ( uint64_t ) ts->tv_sec * 1000000000ULL + ( uint64_t ) ts->tv_nsec;
+
+    if ( !format )
+    {
+        emit( ( const char * ) out,
+              log_bin_write_text( out, level, ns, C.names[category], file, line, func, ( const char * ) data ) );
+        return;
+    }
+
+    if ( format->written_gen != binary_gen )
+    {
+        emit( ( const char * ) out,
+              log_bin_write_format(
+                  out, format->id, C.names[format->category], format->file, format->line, format->func, format->fmt ) );
+        format->written_gen = binary_gen;
+    }
+    emit( ( const char * ) out, log_bin_write_record( out, format->id, level, ns, ( const unsigned char * ) data, size ) );
+}
+
+#ifndef _WIN32
+static void wake_writer( void )
+{
+    pthread_mutex_lock( &Q.wake_mtx );
+    pthread_cond_signal( &Q.wake_cond );
+    pthread_mutex_unlock( &Q.wake_mtx );
+}
+
+/*
+ * Queues a record for the file. With a binary `format` the arguments are
+ * packed into the slot and nothing is formatted. Otherwise `msg` is the
+ * message when the caller already formatted it for the console, or it is
+ * formatted from `fmt` straight into the slot. Either way this only happens
+ * once a slot is claimed, so a dropped record costs next to nothing.
+ */
+static void async_enqueue(
+    const struct timespec *ts,
+    int                    level,
+    int                    category,
+    const char            *file,
+    int                    line,
+    const char            *func,
+    t_log_format          *format,
+    const char            *msg,
+    const char            *fmt,
+    va_list                ap )
+{
+    size_t      pos = atomic_load_explicit( &Q.tail, memory_order_relaxed );
+    t_log_slot *slot;
+
+    for ( ;; )
+    {
+        slot           = &Q.slots[pos & Q.mask];
+        size_t    seq  = atomic_load_explicit( &slot->seq, memory_order_acquire );
+        ptrdiff_t diff = ( ptrdiff_t ) ( seq - pos );
+
+        if ( diff == 0 )
+        {
+            if ( atomic_compare_exchange_weak_explicit(
+                     &Q.tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed ) )
+            {
+                break;
+            }
+        }
+        else if ( diff < 0 )
+        {
+            // Full: the writer has not freed this slot from the previous lap yet
+            if ( level < G.opt.async_block_level )
+            {
+                atomic_fetch_add_explicit( &Q.dropped, 1, memory_order_relaxed );
+                return;
+            }
+            wake_writer( );
+            sched_yield( );
+            pos = atomic_load_explicit( &Q.tail, memory_order_relaxed );
+        }
+        else
+        {
+            pos = atomic_load_explicit( &Q.tail, memory_order_relaxed );
+        }
+    }
+
+    t_log_record *rec = &slot->record;
+    rec->ts           = *ts;
+    rec->level        = level;
+    rec->line         = line;
+    rec->category     = category;
+    rec->file         = file;
+    rec->func         = func;
+    rec->format       = format;
+    rec->size         = 0;
+    rec->long_message = NULL;
+
+    if ( format )
+    {
+        unsigned char args[LOG_BIN_MAX_ARG_DATA];
+        rec->size = log_bin_pack_args( format->types, format->nargs, ap, args, sizeof( args ) );
+        if ( rec->size > sizeof( rec->message ) && ( rec->long_message = ( char * ) malloc( rec->size ) ) == NULL )
+        {
+            rec->size = sizeof( rec->message );    // the decoder shows the rest as zeros
+        }
+        memcpy( rec->long_message ? rec->long_message : rec->message, args, rec->size );
+    }
+    else if ( msg )
+    {
+        size_t n = strlen( msg );
+        if ( n < sizeof( rec->message ) )
+        {
+            memcpy( rec->message, msg, n + 1 );
+        }
+        else if ( ( rec->long_message = ( char * ) malloc( n + 1 ) ) != NULL )
+        {
+            memcpy( rec->long_message, msg, n + 1 );
+        }
+        else
+        {
+            snprintf( rec->message, sizeof( rec->message ), "%s", msg );
+        }
+    }
+    else
+    {
+        va_list again;
+        va_copy( again, ap );
+        int n = vsnprintf( rec->message, sizeof( rec->message ), fmt, ap );
+        if ( n >= ( int ) sizeof( rec->message ) )
+        {
+            size_t cap = ( size_t ) n + 1 < LOG_MESSAGE_MAX ? ( size_t ) n + 1 : LOG_MESSAGE_MAX;
+            rec->long_message = ( char * ) malloc( cap );
+            if ( rec->long_message )
+            {
+                vsnprintf( rec->long_message, cap, fmt, again );
+            }
+        }
+        va_end( again );
+    }
+
+    // Publish, then wake the writer if it went to sleep before seeing it
+    atomic_store_explicit( &slot->seq, pos + 1, memory_order_seq_cst );
+    if ( atomic_load_explicit( &Q.sleeping, memory_order_seq_cst ) )
+    {
+        wake_writer( );
+    }
+}
+
+static void flush_batch( void )
+{
+    if ( Q.file_used )
+    {
+        if ( open_log_file( ) )
+        {
+            fwrite( Q.file_batch, 1, Q.file_used, G.fp );
+            fflush( G.fp );
+            G.bytes += Q.file_used;
+        }
+        Q.file_used = 0;
+    }
+}
+
+// Appends one finished line or binary record to the file batch
+static void batch_line( const char *line, size_t len )
+{
+    if ( Q.file_used + len > sizeof( Q.file_batch ) )
+    {
+        flush_batch( );
+    }
+
+    memcpy( Q.file_batch + Q.file_used, line, len );
+    Q.file_used += len;
+}
+
+static void write_record( const t_log_record *rec )
+{
+    if ( G.opt.binary )
+    {
+        emit_binary(
+            batch_line,
+            &rec->ts,
+            rec->level,
+            rec->category,
+            rec->file,
+            rec->line,
+            rec->func,
+            rec->format,
+            rec->long_message ? rec->long_message : rec->message,
+            rec->size );
+        return;
+    }
+
+    // localtime_r() and strftime() only run when the second changes
+    if ( rec->ts.tv_sec != Q.stamp_second || !Q.stamp_prefix[0] )
+    {
+        Q.stamp_second = rec->ts.tv_sec;
+        format_second( rec->ts.tv_sec, Q.stamp_prefix, sizeof( Q.stamp_prefix ) );
+    }
+
+    char   line[2300];
+    size_t len = format_line(
+        line,
+        sizeof( line ),
+        Q.stamp_prefix,
+        &rec->ts,
+        rec->level,
+        rec->category,
+        rec->file,
+        rec->line,
+        rec->func,
+        rec->long_message ? rec->long_message : rec->message );
+
+    batch_line( line, len );
+}
+
+static void report_dropped( void )
+{
+    uint64_t dropped = atomic_load_explicit( &Q.dropped, memory_order_relaxed );
+    if ( dropped == Q.dropped_reported )
+    {
+        return;
+    }
+
+    t_log_record rec;
+    memset( &rec, 0, sizeof( rec ) );
+    wall_time_now( &rec.ts );
+    rec.level = LOG_WARN;
+    rec.line  = __LINE__;
+    rec.file  = __FILE__;
+    rec.func  = __func__;
+    rec.category = logger_category( "logger" );
+    snprintf(
+        rec.message,
+        sizeof( rec.message ),
+        "Log queue full - dropped %llu records",
+        ( unsigned long long ) ( dropped - Q.dropped_reported ) );
+
+    Q.dropped_reported = dropped;
+    write_record( &rec );
+}
+
+static void *writer_main( void *arg )
+{
+    ( void ) arg;
+
+    for ( ;; )
+    {
+        t_log_slot *slot = &Q.slots[Q.head & Q.mask];
+
+        if ( atomic_load_explicit( &slot->seq, memory_order_acquire ) == Q.head + 1 )
+        {
+            write_record( &slot->record );
+            free( slot->record.long_message );
+
+            // Hand the slot to the producer one lap ahead
+            atomic_store_explicit( &slot->seq, Q.head + Q.mask + 1, memory_order_release );
+            Q.head++;
+            continue;
+        }
+
+        // Caught up: write the batch out and publish how far we got
+        report_dropped( );
+        flush_batch( );
+        atomic_store_explicit( &Q.written, Q.head, memory_order_release );
+
+        if ( atomic_load( &Q.stop ) && atomic_load( &Q.tail ) == Q.head )
+        {
+            break;
+        }
+
+        pthread_mutex_lock( &Q.wake_mtx );
+        atomic_store_explicit( &Q.sleeping, true, memory_order_seq_cst );
+        if ( atomic_load_explicit( &slot->seq, memory_order_seq_cst ) != Q.head + 1 && !atomic_load( &Q.stop ) )
+        {
+            // The timeout only covers a producer that claimed a slot and is still filling it
+            struct timespec until;
+            clock_gettime( CLOCK_REALTIME, &until );
+            until.tv_nsec += 20 * 1000000L;
+            if ( until.tv_nsec >= 1000000000L )
+            {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait( &Q.wake_cond, &Q.wake_mtx, &until );
+        }
+        atomic_store_explicit( &Q.sleeping, false, memory_order_relaxed );
+        pthread_mutex_unlock( &Q.wake_mtx );
+    }
+
+    return NULL;
+}
+
+static void async_start( void )
+{
+    size_t capacity = G.opt.async_capacity > 0 ? ( size_t ) G.opt.async_capacity : LOG_ASYNC_DEFAULT_CAPACITY;
+    size_t slots    = 2;
+    while ( slots < capacity )
+    {
+        slots *= 2;
+    }
+
+    Q.slots = ( t_log_slot * ) calloc( slots, sizeof( *Q.slots ) );
+    if ( !Q.slots )
+    {
+        fprintf( stderr, "WARNING - No memory for the log queue, logging synchronously\n" );
+        return;
+    }
+
+    Q.mask = slots - 1;
+    for ( size_t i = 0; i < slots; i++ )
+    {
+        atomic_init( &Q.slots[i].seq, i );
+    }
+    atomic_init( &Q.tail, 0 );
+    atomic_init( &Q.written, 0 );
+    atomic_init( &Q.dropped, 0 );
+    atomic_init( &Q.sleeping, false );
+    atomic_init( &Q.stop, false );
+    Q.head             = 0;
+    Q.dropped_reported = 0;
+    Q.file_used        = 0;
+    Q.stamp_prefix[0]  = '\0';
+
+    pthread_mutex_init( &Q.wake_mtx, NULL );
+    pthread_cond_init( &Q.wake_cond, NULL );
+
+    if ( pthread_create( &Q.thread, NULL, writer_main, NULL ) != 0 )
+    {
+        fprintf( stderr, "WARNING - Could not start the log writer thread, logging synchronously\n" );
+        pthread_cond_destroy( &Q.wake_cond );
+        pthread_mutex_destroy( &Q.wake_mtx );
+        free( Q.slots );
+        Q.slots = NULL;
+        return;
+    }
+
+    Q.running = true;
+}
+
+// Drains the queue and joins the writer; later records are written synchronously
+static void async_stop( void )
+{
+    if ( !Q.running )
+    {
+        return;
+    }
+
+    atomic_store( &Q.stop, true );
+    wake_writer( );
+    pthread_join( Q.thread, NULL );
+    Q.running = false;
+
+    pthread_cond_destroy( &Q.wake_cond );
+    pthread_mutex_destroy( &Q.wake_mtx );
+    free( Q.slots );
+    Q.slots = NULL;
+}
+#endif
+
+void logger_flush( void )
+{
+#ifndef _WIN32
+    if ( Q.running )
+    {
+        const size_t target = atomic_load( &Q.tail );
+        while ( atomic_load_explicit( &Q.written, memory_order_acquire ) < target )
+        {
+            wake_writer( );
+            sched_yield( );
+        }
+        return;
+    }
+#endif
+
+    lock_( );
+    fflush( stdout );
+    if ( G.fp )
+    {
+        fflush( G.fp );
+    }
+    unlock_( );
+}
+
+uint64_t logger_dropped( void )
+{
+#ifndef _WIN32
+    return atomic_load_explicit( &Q.dropped, memory_order_relaxed );
+#else
+    return 0;
+#endif
+}
+
+// Everything a record goes through; `site` is NULL for calls that did not come from a LOG_* macro
+static void log_core(
+    t_log_site *site, int level, int category, const char *file, int line, const char *func, const char *fmt, va_list ap )
+{
+    if ( category < 0 || category >= atomic_load_explicit( &C.count, memory_order_acquire ) )
+    {
+        category = 0;
+    }
+    if ( level < atomic_load_explicit( &logger_cat_levels[category], memory_order_relaxed ) )
+    {
+        return;
+    }
+
+    if ( level < LOG_TRACE )
+        level = LOG_TRACE;
+    if ( level > LOG_FATAL )
+        level = LOG_FATAL;
     if ( !fmt )
         fmt = "";    // avoid null format
 
-    char msg[2048];
-    vsnprintf( msg, sizeof( msg ), fmt, ap );
-
-    char ts[64];
+    t_log_format *format = ( site && binary_file( ) ) ? site_format( site, category, file, line, func, fmt ) : NULL;
 
-    wall_time_iso8601( ts, sizeof( ts ) );
+    struct timespec ts;
+    wall_time_now( &ts );
 
-    // Final assembly
+    char msg[LOG_MESSAGE_MAX];
+    char prefix[32];
     char linebuf[2300];
-    int  n = snprintf(
-        linebuf,
-        sizeof( linebuf ),
-        "%s [%s] %s | %s:%d (%s) | %s\n",
-        ts,
-        LEVEL_NAME[level],
-        cat,
-        src_file,
-        line,
-        src_func,
-        msg );
 
-    if ( n < 0 )
+#ifndef _WIN32
+    if ( Q.running )
     {
+        const char *console_msg = NULL;
+        if ( level >= G.opt.console_level )
+        {
+            va_list again;
+            va_copy( again, ap );
+            vsnprintf( msg, sizeof( msg ), fmt, again );
+            va_end( again );
+
+            format_second( ts.tv_sec, prefix, sizeof( prefix ) );
+            size_t len = format_line( linebuf, sizeof( linebuf ), prefix, &ts, level, category, file, line, func, msg );
+
+            lock_( );
+            write_console( linebuf, len, level );
+            unlock_( );
+            console_msg = msg;
+        }
+
+        async_enqueue( &ts, level, category, file, line, func, format, console_msg, fmt, ap );
+
+        // A fatal record is usually the last thing before the process goes down
+        if ( level == LOG_FATAL )
+        {
+            logger_flush( );
+        }
         return;
     }
+#endif
 
-    size_t len = ( size_t ) n;
-    if ( len >= sizeof( linebuf ) )
+    if ( binary_file( ) )
     {
-        len = sizeof( linebuf ) - 1;
+        unsigned char args[LOG_BIN_MAX_ARG_DATA];
+        size_t        size = 0;
+        if ( format )
+        {
+            va_list again;
+            va_copy( again, ap );
+            size = log_bin_pack_args( format->types, format->nargs, again, args, sizeof( args ) );
+            va_end( again );
+        }
+
+        size_t len = 0;
+        if ( !format || level >= G.opt.console_level )
+        {
+            vsnprintf( msg, sizeof( msg ), fmt, ap );
+            format_second( ts.tv_sec, prefix, sizeof( prefix ) );
+            len = format_line( linebuf, sizeof( linebuf ), prefix, &ts, level, category, file, line, func, msg );
+        }
+
+        lock_( );
+        if ( len )
+        {
+            write_console( linebuf, len, level );
+        }
+        if ( format )
+        {
+            emit_binary( write_file, &ts, level, category, file, line, func, format, args, size );
+        }
+        else
+        {
+            emit_binary( write_file, &ts, level, category, file, line, func, NULL, msg, 0 );
+        }
+        unlock_( );
+        return;
     }
 
+    vsnprintf( msg, sizeof( msg ), fmt, ap );
+    format_second( ts.tv_sec, prefix, sizeof( prefix ) );
+
+    // Final assembly
+    size_t len = format_line( linebuf, sizeof( linebuf ), prefix, &ts, level, category, file, line, func, msg );
+
     lock_( );
     write_console( linebuf, len, level );
     write_file( linebuf, len );
     unlock_( );
 }
 
+void logger_logv_cat(
+    int level, int category, const char *file, int line, const char *func, const char *fmt, va_list ap )
+{
+    log_core( NULL, level, category, file, line, func, fmt, ap );
+}
+
+void logger_log_cat( int level, int category, const char *file, int line, const char *func, const char *fmt, ... )
+{
+    va_list ap;
+    va_start( ap, fmt );
+    logger_logv_cat( level, category, file, line, func, fmt, ap );
+    va_end( ap );
+}
+
+void logger_log_site( t_log_site *site, int level, const char *file, int line, const char *func, const char *fmt, ... )
+{
+    const int category = atomic_load_explicit( &site->category, memory_order_relaxed ) - 1;
+
+    va_list ap;
+    va_start( ap, fmt );
+    log_core( site, level, category < 0 ? 0 : category, file, line, func, fmt, ap );
+    va_end( ap );
+}
+
+void logger_logv(
+    int level, const char *category, const char *file, int line, const char *func, const char *fmt, va_list ap )
+{
+    if ( !logger_should_log( level, category ) )
+    {
+        return;
+    }
+
+    logger_logv_cat( level, logger_category( category ), file, line, func, fmt, ap );
+}
+
 void logger_log( int level, const char *category, const char *file, int line, const char *func, const char *fmt, ... )
 {
     va_list ap;
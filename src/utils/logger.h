@@ -8,6 +8,7 @@
 #pragma once
 
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -47,25 +48,84 @@ typedef struct log_options {
     bool        use_colors;       // colored console output
     bool        json_lines;       // write each record as a JSON line
     int         console_level;    // minimum level printed to console
-    
+
+    // Async mode: file records are queued and a writer thread assembles and
+    // writes them in batches. Console lines are still written by the caller,
+    // in order with the program's own stdout output
+    bool async;                // background file writer (needs file_path, ignored on Windows)
+    int  async_capacity;       // records the queue holds (0 = 4096), rounded up to a power of two
+    int  async_block_level;    // on a full queue, records below this level are dropped, the rest wait
+
+    // Binary file: each callsite's format is written once, then every record
+    // is its ID, timestamp and raw argument bytes (src/utils/log_binary.h).
+    // tools/log_decode turns it back into text or JSON lines
+    bool binary;
+
 } t_log_options;
 
 int  logger_init( const t_log_options *opt );
 void logger_shutdown( void );
 
+// Returns once every record logged so far has been written and flushed
+void logger_flush( void );
+
+// Records dropped on a full async queue since logger_init()
+uint64_t logger_dropped( void );
+
 void logger_set_global_level( int level );
 int  logger_get_global_level( void );
 
 int logger_set_category_level( const char *category, int level );
 int logger_get_category_level( const char *category, int *out_level );
 
+/*
+ * Category handles. logger_category() interns a name once and returns its
+ * handle for the rest of the process (0 is LOG_CAT_DEFAULT, which also takes
+ * any name past LOG_MAX_CATEGORIES). The LOG_* macros keep the handle in a
+ * static per callsite and test the level before evaluating any arguments.
+ */
+int logger_category( const char *name );
+
+// Effective level per handle and the lowest of them, kept by the logger; read-only outside it
+extern atomic_int logger_cat_levels[LOG_MAX_CATEGORIES];
+extern atomic_int logger_min_level;
+
+struct log_format;
+
+// What a LOG_* callsite keeps in its static, filled in on first use
+typedef struct log_site {
+    atomic_int category;                      // handle + 1, 0 until looked up
+    _Atomic( struct log_format * ) format;    // binary format ID and argument types
+} t_log_site;
+
+static inline int logger_site_category( t_log_site *site, const char *name )
+{
+    int h = atomic_load_explicit( &site->category, memory_order_acquire );
+    if ( h == 0 )
+    {
+        h = logger_category( name ) + 1;
+        atomic_store_explicit( &site->category, h, memory_order_release );
+    }
+    return h - 1;
+}
+
 void logger_set_console_level( int level );
 int logger_is_tty( void );
 
+// `file` and `func` are kept by pointer until written: pass literals, as the macros do
 void logger_logv(
     int level, const char *category, const char *file, int line, const char *func, const char *fmt, va_list ap );
 void logger_log( int level, const char *category, const char *file, int line, const char *func, const char *fmt, ... );
 
+// Same with a category handle
+void logger_logv_cat(
+    int level, int category, const char *file, int line, const char *func, const char *fmt, va_list ap );
+void logger_log_cat( int level, int category, const char *file, int line, const char *func, const char *fmt, ... );
+
+// What the LOG_* macros call: the site caches the category and, for a binary file,
+// the format ID. `fmt` is kept by pointer and must be the same at every call
+void logger_log_site( t_log_site *site, int level, const char *file, int line, const char *func, const char *fmt, ... );
+
 void logger_hexdump(
     int         level,
     const char *category,
@@ -97,9 +157,24 @@ bool logger_should_log( int level, const char *category );
 #define LOG_VA_COMMA( ... ) , ##__VA_ARGS__
 #endif
 
-// base macro: send everything with auto file/line/func
+// base macro: send everything with auto file/line/func. A level below every
+// category's costs one load and compare; the arguments are only evaluated
+// once the callsite's own category lets the record through. CAT must be the
+// same at every pass of a callsite (a literal, as everywhere in the viewer).
 #define LOG_AT( LVL, CAT, FMT, ... )                                                                                   \
-    logger_log( ( LVL ), ( CAT ), __FILE__, __LINE__, __func__, ( FMT ) LOG_VA_COMMA( __VA_ARGS__ ) )
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if ( ( LVL ) >= atomic_load_explicit( &logger_min_level, memory_order_relaxed ) )                              \
+        {                                                                                                              \
+            static t_log_site _log_site;                                                                               \
+            const int         _log_cat = logger_site_category( &_log_site, ( CAT ) );                                  \
+            if ( ( LVL ) >= atomic_load_explicit( &logger_cat_levels[_log_cat], memory_order_relaxed ) )               \
+            {                                                                                                          \
+                logger_log_site(                                                                                       \
+                    &_log_site, ( LVL ), __FILE__, __LINE__, __func__, ( FMT ) LOG_VA_COMMA( __VA_ARGS__ ) );          \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while ( 0 )
 
 // convenience per-level macros
 #define LOG_TRACEF( CAT, FMT, ... ) LOG_AT( LOG_TRACE, ( CAT ), ( FMT ), __VA_ARGS__ )
@@ -132,7 +207,8 @@ bool logger_should_log( int level, const char *category );
 // timing a block: logs "<LABEL>: Xms" at INFO after the block runs
 #define LOG_TIME_BLOCK( LABEL, CAT )                                                                                   \
     for ( uint64_t _t0 = logger_now_ms( ), _once = 1; _once;                                                           \
-          LOG_INFOF( ( CAT ), "%s: %llums", ( LABEL ), ( unsigned long long ) ( logger_now_ms( ) - _t0 ) ),            \
+          logger_log( LOG_INFO, ( CAT ), __FILE__, __LINE__, __func__, "%s: %llums", ( LABEL ),                      \
+                      ( unsigned long long ) ( logger_now_ms( ) - _t0 ) ),                                               \
                    _once = 0 )
 
 #else    // LOG_ENABLE == 0  → compile out everything
@@ -13,6 +13,7 @@
 #define LOG_CAT_BONES    "bones"       // skeleton setup, transforms
 #define LOG_CAT_BODYPART "bodypart"    // selection/variants/skin families
 #define LOG_CAT_SHADERS  "shaders"     // shader loading, defines, uniforms
+#define LOG_CAT_JOBS     "jobs"        // job system threads, per-job timing
 #define LOG_CAT_UI       "ui"          // future: Qt/SDL UI
 
 #endif
@@ -0,0 +1,191 @@
+/*
+ * ═══════════════════════════════════════════════════════════════════════════
+ *   Half-Life Model Viewer/Editor ~ Lambda
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Copyright (c) 1996-2002, Valve LLC. All rights reserved.
+ *
+ *   This product contains software technology licensed from Id
+ *   Software, Inc. ("Id Technology"). Id Technology (c) 1996 Id Software, Inc.
+ *   All Rights Reserved.
+ *
+ *   Use, distribution, and modification of this source code and/or resulting
+ *   object code is restricted to non-commercial enhancements to products from
+ *   Valve LLC. All other use, distribution, or modification is prohibited
+ *   without written permission from Valve LLC.
+ *
+ * ───────────────────────────────────────────────────────────────────────────
+ *   Author: Karlo Siric
+ *   Purpose: Binary log decoder - turns a --log-binary file into text or JSON
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ *   Usage: log_decode [--json] <file>
+ *
+ *   Text output is the same line the logger writes to a text log file. With
+ *   --json every record is one JSON object per line:
+ *
+ *     {"time":"2026-10-17T12:00:00.123","ns":...,"level":"INFO",
+ *      "category":"app","file":"main.c","line":42,"func":"main","message":"..."}
+ *
+ *   Must run on a machine with the writer's byte order (the header says so).
+ */
+
+#include "utils/log_binary.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char *LEVEL_NAME[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
+
+static const char *level_name( int level )
+{
+    return ( level >= 0 && level < 6 ) ? LEVEL_NAME[level] : "?";
+}
+
+// Source file without its directories, as the text log shows it
+static const char *base_name( const char *path )
+{
+    const char *slash = strrchr( path, '/' );
+    if ( !slash )
+    {
+        slash = strrchr( path, '\\' );
+    }
+    return slash ? slash + 1 : path;
+}
+
+// Local time down to the millisecond, like the logger's timestamps
+static void format_time( uint64_t ns, char *buf, size_t n )
+{
+    time_t    sec = ( time_t ) ( ns / 1000000000ULL );
+    struct tm tmv;
+#ifdef _WIN32
+    localtime_s( &tmv, &sec );
+#else
+    localtime_r( &sec, &tmv );
+#endif
+    size_t len = strftime( buf, n, "%Y-%m-%dT%H:%M:%S", &tmv );
+    snprintf( buf + len, n - len, ".%03u", ( unsigned ) ( ns / 1000000ULL % 1000ULL ) );
+}
+
+static void put_json_string( const char *s )
+{
+    putchar( '"' );
+    for ( const unsigned char *p = ( const unsigned char * ) s; *p; p++ )
+    {
+        switch ( *p )
+        {
+        case '"':
+            fputs( "\\\"", stdout );
+            break;
+        case '\\':
+            fputs( "\\\\", stdout );
+            break;
+        case '\n':
+            fputs( "\\n", stdout );
+            break;
+        case '\r':
+            fputs( "\\r", stdout );
+            break;
+        case '\t':
+            fputs( "\\t", stdout );
+            break;
+        default:
+            if ( *p < 0x20 )
+                printf( "\\u%04x", *p );
+            else
+                putchar( *p );
+            break;
+        }
+    }
+    putchar( '"' );
+}
+
+static void print_text( const t_log_bin_entry *e, const char *stamp )
+{
+    printf(
+        "%s [%s] %s | %s:%d (%s) | %s\n",
+        stamp,
+        level_name( e->level ),
+        e->category,
+        base_name( e->file ),
+        e->line,
+        e->func,
+        e->message );
+}
+
+static void print_json( const t_log_bin_entry *e, const char *stamp )
+{
+    fputs( "{\"time\":", stdout );
+    put_json_string( stamp );
+    printf( ",\"ns\":%llu,\"level\":\"%s\",\"category\":", ( unsigned long long ) e->time_ns, level_name( e->level ) );
+    put_json_string( e->category );
+    fputs( ",\"file\":", stdout );
+    put_json_string( base_name( e->file ) );
+    printf( ",\"line\":%d,\"func\":", e->line );
+    put_json_string( e->func );
+    fputs( ",\"message\":", stdout );
+    put_json_string( e->message );
+    fputs( "}\n", stdout );
+}
+
+int main( int argc, char **argv )
+{
+    const char *path = NULL;
+    bool        json = false;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[i], "--json" ) == 0 )
+        {
+            json = true;
+        }
+        else if ( !path && argv[i][0] != '-' )
+        {
+            path = argv[i];
+        }
+        else
+        {
+            path = NULL;
+            break;
+        }
+    }
+
+    if ( !path )
+    {
+        fprintf( stderr, "USAGE: %s [--json] <file>\n", argv[0] );
+        return 1;
+    }
+
+    t_log_bin_reader *reader = log_bin_open( path );
+    if ( !reader )
+    {
+        fprintf( stderr, "ERROR - %s is not a binary log file (or was written with another byte order)\n", path );
+        return 1;
+    }
+
+    static t_log_bin_entry entry;
+    long                   count = 0;
+    int                    status;
+    char                   stamp[48];
+
+    while ( ( status = log_bin_next( reader, &entry ) ) == 1 )
+    {
+        format_time( entry.time_ns, stamp, sizeof( stamp ) );
+        if ( json )
+            print_json( &entry, stamp );
+        else
+            print_text( &entry, stamp );
+        count++;
+    }
+
+    log_bin_close( reader );
+
+    if ( status < 0 )
+    {
+        fprintf( stderr, "WARNING - %s: damaged or truncated record after %ld records\n", path, count );
+        return 2;
+    }
+    return 0;
+}